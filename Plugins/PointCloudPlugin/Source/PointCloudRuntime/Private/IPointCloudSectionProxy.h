@@ -4,6 +4,7 @@
 
 struct FMeshBatch;
 class UMaterialInterface;
+struct FPointCloudScalarRamp;
 
 /** Interface for the section proxy  */
 class IPointCloudSectionProxy
@@ -15,5 +16,7 @@ public:
 	virtual bool NeedsRendering() = 0;
 	virtual void ComputeAndSetLOD(float ScreenSize) = 0;
 	virtual int32 GetLOD() const = 0;
+	virtual void UpdateVertexBuffer(const TArray<uint8>& InVertexData, const TArray<uint8>& InScalarData) = 0;
+	virtual void SetScalarRamp(const FPointCloudScalarRamp& InScalarRamp) = 0;
 };
 
@@ -5,6 +5,7 @@
 #include "PointCloudHelper.h"
 #include "PointCloudShared.h"
 #include "Misc/ScopedSlowTask.h"
+#include "Async/ParallelFor.h"
 #include "ConstructorHelpers.h"
 #include "Materials/MaterialInstance.h"
 #include "Materials/MaterialInstanceDynamic.h"
@@ -71,6 +72,7 @@ void UPointCloudImportSettings::LoadFileHeader(const FString& Filename)
 UPointCloud::UPointCloud(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
 	//, bPreloadVertexBuffer(true)
+	, bDynamicVertexBuffer(false)
 	, LODBias(0)
 	, LODCount(10)
 	, LODReduction(0.35f)
@@ -88,6 +90,7 @@ UPointCloud::UPointCloud(const FObjectInitializer& ObjectInitializer)
 	, bDirty(true)
 	, bTransformDirty(true)
 	, bReductionDirty(true)
+	, bReductionApplied(false)
 	, bSectionDirty(true)
 	, bVBDirty(false)
 	, bIBDirty(false)
@@ -220,6 +223,7 @@ void UPointCloud::Serialize(FArchive& Ar)
 		bTransformDirty = !bCooked;
 		bSectionDirty = true;
 		bReductionDirty = false;
+		bReductionApplied = true;
 		bDirty = true;
 	}
 }
@@ -387,6 +391,12 @@ void UPointCloud::ApplyRenderingParameters()
 			DynMaterial->SetScalarParameterValue("PC__UseMask", SpriteMask == EPointCloudSpriteMask::Texture);
 			DynMaterial->SetVectorParameterValue("PC__Bounds", BoundsSize);
 			DynMaterial->SetScalarParameterValue("PC__UseTexture", IsValid(SpriteTexture));
+			DynMaterial->SetScalarParameterValue("PC__ScalarIndex", ScalarRamp.ScalarIndex);
+			DynMaterial->SetScalarParameterValue("PC__ScalarMin", ScalarRamp.Min);
+			DynMaterial->SetScalarParameterValue("PC__ScalarMax", ScalarRamp.Max);
+			DynMaterial->SetVectorParameterValue("PC__ScalarLowColor", ScalarRamp.LowColor);
+			DynMaterial->SetVectorParameterValue("PC__ScalarMidColor", ScalarRamp.MidColor);
+			DynMaterial->SetVectorParameterValue("PC__ScalarHighColor", ScalarRamp.HighColor);
 			if (SpriteTexture)
 			{
 				DynMaterial->SetTextureParameterValue("PC__Texture", SpriteTexture);
@@ -395,6 +405,13 @@ void UPointCloud::ApplyRenderingParameters()
 			DynMaterial->BasePropertyOverrides = Overrides;
 		}
 	}
+
+	// The ramp is read by the vertex factory, the material parameters above are only kept for custom materials
+	if (ScalarRamp != AppliedScalarRamp)
+	{
+		AppliedScalarRamp = ScalarRamp;
+		OnScalarRampChangedEvent.Broadcast();
+	}
 }
 
 int32 UPointCloud::GetPointCount(bool bCountOnlyEnabled) const
@@ -434,7 +451,7 @@ void UPointCloud::Rebuild(bool bForced)
 			{
 				Points[i].Location = Points[i].OriginalLocation;
 			}
-			if (bReductionDirty)
+			if (bReductionDirty && bReductionApplied)
 			{
 				Points[i].bEnabled = true;
 			}
@@ -462,10 +479,19 @@ void UPointCloud::Rebuild(bool bForced)
 	if (bReductionDirty)
 	{
 		Progress.EnterProgressFrame(1.f, LOCTEXT("RebuildDensity", "Reducing Density"));
+		double ReductionStartTime = FPlatformTime::Seconds();
 		FPointCloudHelper::DensityReduction(Points, DensityReductionDistance);
+		double DensityReductionTime = FPlatformTime::Seconds() - ReductionStartTime;
+
 		Progress.EnterProgressFrame(1.f, LOCTEXT("RebuildNoise", "Reducing Noise"));
+		ReductionStartTime = FPlatformTime::Seconds();
 		FPointCloudHelper::NoiseReduction(Points, NoiseReductionDistance, NoiseReductionDensity);
+		double NoiseReductionTime = FPlatformTime::Seconds() - ReductionStartTime;
+
+		// The wall time depends on the distances and the density of the cloud, so it is reported for each rebuild
+		UE_LOG(LogTemp, Log, TEXT("%s: density reduction took %.3f s, noise reduction took %.3f s for %d points"), *GetName(), DensityReductionTime, NoiseReductionTime, Points.Num());
 		bReductionDirty = false;
+		bReductionApplied = DensityReductionDistance > 0 || NoiseReductionDistance > 0;
 	}
 	
 	if (bSectionDirty)
@@ -482,9 +508,15 @@ void UPointCloud::Rebuild(bool bForced)
 		Sections.AddUninitialized(sections.Num());
 		for (int32 i = 0; i < sections.Num(); i++)
 		{
-			Sections[i] = new FPointCloudSection(this, sections[i]);
+			// Materials have to be created on the game thread, buffers are built in parallel below
+			Sections[i] = new FPointCloudSection(this, sections[i], false);
 		}
 
+		ParallelFor(Sections.Num(), [&](int32 i)
+		{
+			Sections[i]->Rebuild(true, true);
+		});
+
 		// CHANGED
 		//ClearSectionData();
 		//Sections.AddUninitialized(1);
@@ -502,10 +534,10 @@ void UPointCloud::Rebuild(bool bForced)
 	{
 		Progress.EnterProgressFrame(1.f, LOCTEXT("RebuildSections", "Building Sections"));
 
-		for (FPointCloudSection *Section : Sections)
+		ParallelFor(Sections.Num(), [&](int32 i)
 		{
-			Section->Rebuild(bVBDirty, bIBDirty);
-		}
+			Sections[i]->Rebuild(bVBDirty, bIBDirty);
+		});
 
 		bVBDirty = bIBDirty = false;;
 	}
@@ -550,6 +582,9 @@ void UPointCloud::Bake()
 		}
 	}
 	Points = NewPoints;
+
+	// Scalars are indexed like the points
+	Scalars.Empty();
 	
 	// More memory efficient, but very slow
 	//int32 RemoveStart = -1;
@@ -631,6 +666,10 @@ void UPointCloud::SetCustomMaterial(UMaterialInterface *InCustomMaterial, bool b
 void UPointCloud::SetPointCloudData(TArray<FPointCloudPoint> &InPoints, bool bRebuildCloud)
 {
 	Points = InPoints;
+	Scalars.Empty();
+
+	// Points disabled by the caller stay disabled
+	bReductionApplied = false;
 
 	if (bRebuildCloud)
 	{
@@ -638,6 +677,118 @@ void UPointCloud::SetPointCloudData(TArray<FPointCloudPoint> &InPoints, bool bRe
 	}
 }
 
+bool UPointCloud::UpdatePointCloudData(TArray<FPointCloudPoint> &InPoints)
+{
+	return UpdatePointCloudData(InPoints, TArray<FVector4>());
+}
+
+bool UPointCloud::UpdatePointCloudData(TArray<FPointCloudPoint> &InPoints, const TArray<FVector4> &InScalars)
+{
+	bool bHasScalars = InScalars.Num() > 0 && InScalars.Num() == InPoints.Num();
+
+	// Adding or removing the scalars changes the Vertex Factory
+	bool bCanUpdate = !bDirty && bDynamicVertexBuffer && Sections.Num() > 0 && InPoints.Num() == Points.Num() && DensityReductionDistance <= 0 && NoiseReductionDistance <= 0 && bHasScalars == (Scalars.Num() > 0);
+
+	if (!bCanUpdate)
+	{
+		SetPointCloudData(InPoints, false);
+
+		if (bHasScalars)
+		{
+			Scalars = InScalars;
+		}
+
+		Rebuild(true);
+		return false;
+	}
+
+	// Copy in place, sections keep pointers into the array. No reduction runs here, so the points keep the enabled state of the caller
+	FMemory::Memcpy(Points.GetData(), InPoints.GetData(), Points.Num() * sizeof(FPointCloudPoint));
+
+	if (bHasScalars)
+	{
+		FMemory::Memcpy(Scalars.GetData(), InScalars.GetData(), Scalars.Num() * sizeof(FVector4));
+	}
+
+	// Re-apply the transformation of the last rebuild, so the cloud does not jump if the offset depends on the data
+	FVector CorrectedScale = FVector(-AppliedScale.X, AppliedScale.Y, AppliedScale.Z);
+	bool bLowPrecision = UsesLowPrecision();
+
+	for (FPointCloudPoint& Point : Points)
+	{
+		Point.Location = (Point.OriginalLocation + AppliedOffset) * CorrectedScale;
+
+		if (bLowPrecision)
+		{
+			Point.Location = FVector((FFloat16)Point.Location.X, (FFloat16)Point.Location.Y, (FFloat16)Point.Location.Z);
+		}
+	}
+
+	// Sections whose number of enabled points changed only rebuild their own buffers, the split into sections is kept
+	bool bSectionsRebuilt = false;
+	for (FPointCloudSection *Section : Sections)
+	{
+		if (!Section->UpdateVB())
+		{
+			Section->Rebuild(true, true);
+			bSectionsRebuilt = true;
+		}
+	}
+
+	FBox BoundingBox = FPointCloudHelper::CalculateBounds(Points);
+	LocalBounds.BoxExtent = BoundingBox.GetExtent();
+	LocalBounds.Origin = BoundingBox.GetCenter();
+	LocalBounds.SphereRadius = LocalBounds.BoxExtent.Size();
+
+	if (bSectionsRebuilt)
+	{
+		// The components have to create new render buffers of the new size
+		OnPointCloudRebuiltEvent.Broadcast();
+		return false;
+	}
+
+	OnPointCloudUpdatedEvent.Broadcast();
+
+	return true;
+}
+
+bool UPointCloud::UpdatePointCloudVertices(const FPointCloudVertex* InVertices, int32 NumVertices, const FVector4* InScalars)
+{
+	bool bCanUpdate = !bDirty && bDynamicVertexBuffer && Sections.Num() > 0 && NumVertices == Points.Num() && DensityReductionDistance <= 0 && NoiseReductionDistance <= 0 && !UsesLowPrecision() && (InScalars != nullptr) == (Scalars.Num() > 0);
+
+	if (!bCanUpdate)
+	{
+		return false;
+	}
+
+	if (InScalars)
+	{
+		FMemory::Memcpy(Scalars.GetData(), InScalars, Scalars.Num() * sizeof(FVector4));
+	}
+
+	// Re-apply the transformation of the last rebuild, same as UpdatePointCloudData
+	FVector CorrectedScale = FVector(-AppliedScale.X, AppliedScale.Y, AppliedScale.Z);
+	FBox BoundingBox(ForceInit);
+
+	for (FPointCloudSection *Section : Sections)
+	{
+		if (!Section->UpdateVB(InVertices, AppliedOffset, CorrectedScale))
+		{
+			return false;
+		}
+
+		BoundingBox += Section->GetLocalBounds().GetBox();
+	}
+
+	LocalBounds.BoxExtent = BoundingBox.GetExtent();
+	LocalBounds.Origin = BoundingBox.GetCenter();
+	LocalBounds.SphereRadius = LocalBounds.BoxExtent.Size();
+
+	OnPointCloudUpdatedEvent.Broadcast();
+
+	return true;
+}
+
 void UPointCloud::SetSettings(UPointCloudSettings *Settings)
 {
 	if (Settings)
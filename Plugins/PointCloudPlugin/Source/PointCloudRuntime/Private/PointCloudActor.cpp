@@ -32,6 +32,8 @@ void APointCloudActor::SetPointCloud(UPointCloud *InPointCloud)
 	if (PointCloud && PointCloud->IsValidLowLevel())
 	{
 		PointCloud->OnPointCloudRebuilt().RemoveAll(this);
+		PointCloud->OnPointCloudUpdated().RemoveAll(this);
+		PointCloud->OnScalarRampChanged().RemoveAll(this);
 	}
 
 	PointCloud = InPointCloud;
@@ -39,6 +41,8 @@ void APointCloudActor::SetPointCloud(UPointCloud *InPointCloud)
 	if (PointCloud)
 	{
 		PointCloud->OnPointCloudRebuilt().AddUObject(this, &APointCloudActor::OnPointCloudRebuilt);
+		PointCloud->OnPointCloudUpdated().AddUObject(this, &APointCloudActor::OnPointCloudUpdated);
+		PointCloud->OnScalarRampChanged().AddUObject(this, &APointCloudActor::OnScalarRampChanged);
 	}
 
 	RebuildComponents();
@@ -79,6 +83,8 @@ void APointCloudActor::PostLoad()
 	if (PointCloud)
 	{
 		PointCloud->OnPointCloudRebuilt().AddUObject(this, &APointCloudActor::OnPointCloudRebuilt);
+		PointCloud->OnPointCloudUpdated().AddUObject(this, &APointCloudActor::OnPointCloudUpdated);
+		PointCloud->OnScalarRampChanged().AddUObject(this, &APointCloudActor::OnScalarRampChanged);
 	}
 }
 
@@ -91,6 +97,8 @@ void APointCloudActor::PreEditChange(UProperty* PropertyThatWillChange)
 		if (PointCloud)
 		{
 			PointCloud->OnPointCloudRebuilt().RemoveAll(this);
+			PointCloud->OnPointCloudUpdated().RemoveAll(this);
+			PointCloud->OnScalarRampChanged().RemoveAll(this);
 		}
 	}
 }
@@ -105,6 +113,8 @@ void APointCloudActor::PostEditChangeProperty(FPropertyChangedEvent& PropertyCha
 			if (PointCloud)
 			{
 				PointCloud->OnPointCloudRebuilt().AddUObject(this, &APointCloudActor::OnPointCloudRebuilt);
+				PointCloud->OnPointCloudUpdated().AddUObject(this, &APointCloudActor::OnPointCloudUpdated);
+				PointCloud->OnScalarRampChanged().AddUObject(this, &APointCloudActor::OnScalarRampChanged);
 			}
 
 			RebuildComponents();
@@ -150,4 +160,33 @@ void APointCloudActor::RebuildComponents()
 void APointCloudActor::OnPointCloudRebuilt()
 {
 	RebuildComponents();
+}
+
+void APointCloudActor::OnPointCloudUpdated()
+{
+	// The sections are kept during the update, so existing components only need new vertex data
+	if (!PointCloud || PCCs.Num() != PointCloud->Sections.Num())
+	{
+		RebuildComponents();
+		return;
+	}
+
+	for (UPointCloudComponent* Component : PCCs)
+	{
+		if (IsValid(Component))
+		{
+			Component->UpdateSectionData();
+		}
+	}
+}
+
+void APointCloudActor::OnScalarRampChanged()
+{
+	for (UPointCloudComponent* Component : PCCs)
+	{
+		if (IsValid(Component))
+		{
+			Component->UpdateScalarRamp(PointCloud->ScalarRamp);
+		}
+	}
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "PointCloudComponent.h"
 #include "Engine/CollisionProfile.h"
 #include "PointCloudSection.h"
+#include "PointCloudShared.h"
 #include "IPointCloudSectionProxy.h"
 #include "PrimitiveSceneProxy.h"
 #include "MeshBatch.h"
@@ -86,6 +87,22 @@ public:
 		return Result;
 	}
 
+	void UpdateVertexBuffer(const TArray<uint8>& InVertexData, const TArray<uint8>& InScalarData)
+	{
+		if (Section)
+		{
+			Section->UpdateVertexBuffer(InVertexData, InScalarData);
+		}
+	}
+
+	void SetScalarRamp(const FPointCloudScalarRamp& InScalarRamp)
+	{
+		if (Section)
+		{
+			Section->SetScalarRamp(InScalarRamp);
+		}
+	}
+
 	virtual bool CanBeOccluded() const override { return !MaterialRelevance.bDisableDepthTest; }
 
 	virtual uint32 GetMemoryFootprint(void) const override { return(sizeof(*this) + GetAllocatedSize()); }
@@ -122,6 +139,50 @@ void UPointCloudComponent::SetSection(FPointCloudSection *InSection)
 	UpdateBounds();
 }
 
+void UPointCloudComponent::UpdateSectionData()
+{
+	if (Section && SceneProxy)
+	{
+		// Copy the data, the game thread may write the next update before the render thread has uploaded this one
+		TArray<uint8> VertexData;
+		VertexData.AddUninitialized(Section->GetVertexBufferSize());
+		FMemory::Memcpy(VertexData.GetData(), Section->GetVertexBufferData(), Section->GetVertexBufferSize());
+
+		TArray<uint8> ScalarData;
+		if (Section->GetScalarBufferData())
+		{
+			ScalarData.AddUninitialized(Section->GetScalarBufferSize());
+			FMemory::Memcpy(ScalarData.GetData(), Section->GetScalarBufferData(), Section->GetScalarBufferSize());
+		}
+
+		ENQUEUE_UNIQUE_RENDER_COMMAND_THREEPARAMETER(
+			UpdatePointCloudVertexBuffer,
+			FPointCloudSceneProxy*, PointCloudSceneProxy, (FPointCloudSceneProxy*)SceneProxy,
+			TArray<uint8>, VertexData, VertexData,
+			TArray<uint8>, ScalarData, ScalarData,
+			{
+				PointCloudSceneProxy->UpdateVertexBuffer(VertexData, ScalarData);
+			});
+	}
+
+	UpdateBounds();
+	MarkRenderTransformDirty();
+}
+
+void UPointCloudComponent::UpdateScalarRamp(const FPointCloudScalarRamp& ScalarRamp)
+{
+	if (SceneProxy)
+	{
+		ENQUEUE_UNIQUE_RENDER_COMMAND_TWOPARAMETER(
+			UpdatePointCloudScalarRamp,
+			FPointCloudSceneProxy*, PointCloudSceneProxy, (FPointCloudSceneProxy*)SceneProxy,
+			FPointCloudScalarRamp, ScalarRamp, ScalarRamp,
+			{
+				PointCloudSceneProxy->SetScalarRamp(ScalarRamp);
+			});
+	}
+}
+
 FPrimitiveSceneProxy* UPointCloudComponent::CreateSceneProxy()
 {
 	FPrimitiveSceneProxy* Proxy = NULL;
@@ -5,11 +5,15 @@
 #include "PointCloud.h"
 #include "Async/Async.h"
 #include "Async/Future.h"
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
 #include "Materials/Material.h"
 #include "Materials/MaterialInterface.h"
 #include "FileManager.h"
 #include "FileHelper.h"
 #include "Package.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Async/MappedFileHandle.h"
 
 #if WITH_EDITOR
 #include "Materials/MaterialInstance.h"
@@ -80,136 +84,309 @@ bool FPointCloudHelper::ImportAsLAS(const uint8*& Buffer, TArray<FPointCloudPoin
 	return false;
 }
 
-bool FPointCloudHelper::ImportAsText(const FString& Filename, TArray<FPointCloudPoint>& OutPoints, EPointCloudColorMode &ColorMode, uint32 FirstIndex, uint32 LastIndex, FPointCloudFileHeader PointCloudFileHeader)
+namespace
 {
-	// Modified FFileHelper::LoadFileToString, FFileHelper::LoadFileToStringArray and String::ParseIntoArray
-	//@Todo: Add multithreading support
-	TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*Filename));
-	if (Reader)
+	/** Provides read access to the whole file. Memory maps it if the platform supports it, otherwise loads it into memory. */
+	struct FPointCloudFileData
 	{
-		int64 Size = Reader->TotalSize();
+		TUniquePtr<IMappedFileHandle> MappedHandle;
+		TUniquePtr<IMappedFileRegion> MappedRegion;
+		uint8* LoadedData = nullptr;
 
-		uint8* Data = (uint8*)FMemory::Malloc(Size);
-		Reader->Serialize(Data, Size);
-		Reader->Close();
-		Reader = nullptr;
-		uint8 *DataPtr = Data;
+		const uint8* Data = nullptr;
+		int64 Size = 0;
 
-		float *TempFloats = new float[PointCloudFileHeader.SelectedColumns.Num()]();
-		uint8 Iterator = 0;
-		bool bEndOfLine = false;
+		~FPointCloudFileData()
+		{
+			// The region has to be released before its handle
+			MappedRegion.Reset();
+			MappedHandle.Reset();
 
-		// Determine which values to use for Min/Max
-		bool SampleChannel[] = { (PointCloudFileHeader.SelectedColumns[3] > -1), (PointCloudFileHeader.SelectedColumns[4] > -1), (PointCloudFileHeader.SelectedColumns[5] > -1) };
+			if (LoadedData)
+			{
+				FMemory::Free(LoadedData);
+			}
+		}
 
-		// Check Data Usage
-		uint8 NumExpectedColumns = 3 + (SampleChannel[0] + SampleChannel[1] + SampleChannel[2]);
-		switch (NumExpectedColumns)
+		bool Open(const FString& Filename)
 		{
-		case 4:
-			ColorMode = EPointCloudColorMode::Intensity;
-			break;
+			MappedHandle.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Filename));
+			if (MappedHandle)
+			{
+				MappedRegion.Reset(MappedHandle->MapRegion());
+				if (MappedRegion)
+				{
+					Data = MappedRegion->GetMappedPtr();
+					Size = MappedRegion->GetMappedSize();
+					return true;
+				}
+			}
 
-		case 5:
-		case 6:
-			ColorMode = EPointCloudColorMode::RGB;
-			break;
+			TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*Filename));
+			if (Reader)
+			{
+				Size = Reader->TotalSize();
+				LoadedData = (uint8*)FMemory::Malloc(Size);
+				Reader->Serialize(LoadedData, Size);
+				Reader->Close();
+				Data = LoadedData;
+				return true;
+			}
 
-		default:
-			ColorMode = EPointCloudColorMode::None;
-			break;
+			return false;
 		}
-		
-		// If the range has not been set, set it now
-		if (FMath::IsNearlyZero(PointCloudFileHeader.RGBRange.X) && FMath::IsNearlyZero(PointCloudFileHeader.RGBRange.Y))
+	};
+
+	FORCEINLINE bool IsLineEnd(const uint8* Ptr, const uint8* End)
+	{
+		// CRLF counts as a single line end
+		return *Ptr == '\n' || (*Ptr == '\r' && (Ptr + 1 == End || Ptr[1] != '\n'));
+	}
+
+	/** Splits the data into roughly equal chunks of whole lines. Returns the start offsets of the chunks followed by the size of the data. */
+	TArray<int64> SplitIntoLineChunks(const uint8* Data, int64 Size)
+	{
+		// At least 1MB per chunk
+		int32 NumChunks = FPointCloudHelper::CalculateNumBatches((int32)FMath::Min(Size >> 10, (int64)MAX_int32), 1024);
+
+		TArray<int64> Offsets;
+		Offsets.Add(0);
+
+		for (int32 i = 1; i < NumChunks; i++)
+		{
+			int64 Offset = FMath::Max(Size * i / NumChunks, Offsets.Last());
+
+			while (Offset > 0 && Offset < Size && !IsLineEnd(Data + Offset - 1, Data + Size))
+			{
+				Offset++;
+			}
+
+			Offsets.Add(Offset);
+		}
+
+		Offsets.Add(Size);
+
+		return Offsets;
+	}
+
+	/** Counts the lines the same way the parsers do, a trailing line without line end only counts at the end of the data */
+	int64 CountLines(const uint8* DataPtr, const uint8* DataEnd, bool bEndOfData)
+	{
+		int64 NumLines = 0;
+
+		for (const uint8* Ptr = DataPtr; Ptr < DataEnd; Ptr++)
+		{
+			if (IsLineEnd(Ptr, DataEnd))
+			{
+				NumLines++;
+			}
+		}
+
+		if (bEndOfData && DataEnd > DataPtr && DataEnd[-1] != '\n' && DataEnd[-1] != '\r')
 		{
-			PointCloudFileHeader.RGBRange = ReadFileMinMaxColumns(DataPtr, PointCloudFileHeader.Delimiter[0], { PointCloudFileHeader.SelectedColumns[3] , PointCloudFileHeader.SelectedColumns[4] , PointCloudFileHeader.SelectedColumns[5] });
+			NumLines++;
 		}
 
-		float RGBMulti = 1 / (PointCloudFileHeader.RGBRange.Y - PointCloudFileHeader.RGBRange.X);
+		return NumLines;
+	}
+
+	/** The data is not null terminated, so the value is copied before conversion */
+	FORCEINLINE float ParseFloat(const uint8* Start, const uint8* End)
+	{
+		char Buffer[64];
+		int32 Length = FMath::Min((int32)(End - Start), 63);
+		FMemory::Memcpy(Buffer, Start, Length);
+		Buffer[Length] = 0;
+		return (float)atof(Buffer);
+	}
 
-		OutPoints.Reset();
+	/**
+	 * Parses the lines of a single chunk, LineIndex being the index of its first line.
+	 * Only lines inside [RangeStart, RangeEnd) are converted. Returns the number of points written to OutPoints.
+	 */
+	int32 ParseTextChunk(const uint8* DataPtr, const uint8* DataEnd, int64 LineIndex, int64 RangeStart, int64 RangeEnd, const FPointCloudFileHeader& Header, uint8 NumExpectedColumns, float RGBMulti, FPointCloudPoint* OutPoints)
+	{
+		const uint8 Delimiter = Header.Delimiter[0];
 
-		FirstIndex += PointCloudFileHeader.LinesToSkip;
-		LastIndex += PointCloudFileHeader.LinesToSkip;
+		TArray<float> TempFloats;
+		TempFloats.SetNumZeroed(Header.SelectedColumns.Num());
 
+		uint8 Iterator = 0;
 		uint8 LoadedColumns = 0;
+		int32 NumPoints = 0;
 
-		for (uint32 LineIndex = 0; *DataPtr != 0;)
+		while (DataPtr < DataEnd && LineIndex < RangeEnd)
 		{
-			const char* ChunkStart = (char*)DataPtr;
-			while (*DataPtr != 0 && *DataPtr != '\r' && *DataPtr != '\n' && *DataPtr != PointCloudFileHeader.Delimiter[0])
+			const uint8* ChunkStart = DataPtr;
+			while (DataPtr < DataEnd && *DataPtr != '\r' && *DataPtr != '\n' && *DataPtr != Delimiter)
 			{
 				DataPtr++;
 			}
 
 			// Don't parse until the first index specified
-			if (LineIndex >= FirstIndex)
+			if (LineIndex >= RangeStart)
 			{
-				if (LastIndex == PointCloudFileHeader.LinesToSkip || LastIndex < FirstIndex || LineIndex <= LastIndex)
-				{
-					int32 ColumnIndex = PointCloudFileHeader.SelectedColumns.IndexOfByKey(Iterator++);
-					
-					// Is the column assigned to anything?
-					if (ColumnIndex != INDEX_NONE)
-					{
-						LoadedColumns++;
-						TempFloats[ColumnIndex] = (float)atof(ChunkStart);
-					}
-				}
-				else
+				int32 ColumnIndex = Header.SelectedColumns.IndexOfByKey(Iterator++);
+
+				// Is the column assigned to anything?
+				if (ColumnIndex != INDEX_NONE)
 				{
-					// Stop parsing after the last line specified
-					break;
+					LoadedColumns++;
+					TempFloats[ColumnIndex] = ParseFloat(ChunkStart, DataPtr);
 				}
 			}
 
-			if (*DataPtr == PointCloudFileHeader.Delimiter[0])
+			bool bEndOfLine = false;
+
+			if (DataPtr < DataEnd && *DataPtr == Delimiter)
 			{
 				DataPtr++;
 			}
-			if (*DataPtr == '\r')
+			if (DataPtr < DataEnd && *DataPtr == '\r')
 			{
 				DataPtr++;
 				bEndOfLine = true;
 			}
-			if (*DataPtr == '\n')
+			if (DataPtr < DataEnd && *DataPtr == '\n')
 			{
 				DataPtr++;
 				bEndOfLine = true;
 			}
-			if (*DataPtr == 0)
+			if (DataPtr == DataEnd)
 			{
 				bEndOfLine = true;
 			}
 
 			if (bEndOfLine)
 			{
-				if (LoadedColumns == NumExpectedColumns)
+				if (LineIndex >= RangeStart && LoadedColumns == NumExpectedColumns)
 				{
-					float R = FMath::Clamp((TempFloats[3] - PointCloudFileHeader.RGBRange.X) * RGBMulti, 0.0f, 1.0f);
-					float G = FMath::Clamp((TempFloats[4] - PointCloudFileHeader.RGBRange.X) * RGBMulti, 0.0f, 1.0f);
-					float B = FMath::Clamp((TempFloats[5] - PointCloudFileHeader.RGBRange.X) * RGBMulti, 0.0f, 1.0f);
-					OutPoints.Emplace(TempFloats[0], TempFloats[1], TempFloats[2], R, G, B);
+					float R = FMath::Clamp((TempFloats[3] - Header.RGBRange.X) * RGBMulti, 0.0f, 1.0f);
+					float G = FMath::Clamp((TempFloats[4] - Header.RGBRange.X) * RGBMulti, 0.0f, 1.0f);
+					float B = FMath::Clamp((TempFloats[5] - Header.RGBRange.X) * RGBMulti, 0.0f, 1.0f);
+					OutPoints[NumPoints++] = FPointCloudPoint(TempFloats[0], TempFloats[1], TempFloats[2], R, G, B);
 				}
 
 				LineIndex++;
 				Iterator = 0;
-				bEndOfLine = false;
 				LoadedColumns = 0;
 			}
 		}
 
-		delete[] TempFloats;
-		TempFloats = NULL;
-		FMemory::Free(Data);
-		Data = NULL;
-		DataPtr = NULL;
+		return NumPoints;
+	}
+}
 
-		return true;
+bool FPointCloudHelper::ImportAsText(const FString& Filename, TArray<FPointCloudPoint>& OutPoints, EPointCloudColorMode &ColorMode, uint32 FirstIndex, uint32 LastIndex, FPointCloudFileHeader PointCloudFileHeader)
+{
+	// The file is split into chunks of whole lines, which are parsed in parallel directly into the output array
+	FPointCloudFileData File;
+	if (!File.Open(Filename))
+	{
+		return false;
 	}
 
-	return false;
+	// Determine which values to use for Min/Max
+	bool SampleChannel[] = { (PointCloudFileHeader.SelectedColumns[3] > -1), (PointCloudFileHeader.SelectedColumns[4] > -1), (PointCloudFileHeader.SelectedColumns[5] > -1) };
+
+	// Check Data Usage
+	uint8 NumExpectedColumns = 3 + (SampleChannel[0] + SampleChannel[1] + SampleChannel[2]);
+	switch (NumExpectedColumns)
+	{
+	case 4:
+		ColorMode = EPointCloudColorMode::Intensity;
+		break;
+
+	case 5:
+	case 6:
+		ColorMode = EPointCloudColorMode::RGB;
+		break;
+
+	default:
+		ColorMode = EPointCloudColorMode::None;
+		break;
+	}
+	
+	// If the range has not been set, set it now
+	if (FMath::IsNearlyZero(PointCloudFileHeader.RGBRange.X) && FMath::IsNearlyZero(PointCloudFileHeader.RGBRange.Y))
+	{
+		PointCloudFileHeader.RGBRange = ReadFileMinMaxColumns(File.Data, File.Size, PointCloudFileHeader.Delimiter[0], { PointCloudFileHeader.SelectedColumns[3] , PointCloudFileHeader.SelectedColumns[4] , PointCloudFileHeader.SelectedColumns[5] });
+	}
+
+	float RGBMulti = 1 / (PointCloudFileHeader.RGBRange.Y - PointCloudFileHeader.RGBRange.X);
+
+	TArray<int64> ChunkOffsets = SplitIntoLineChunks(File.Data, File.Size);
+	int32 NumChunks = ChunkOffsets.Num() - 1;
+
+	// Index of the first line of each chunk
+	TArray<int64> ChunkLines;
+	ChunkLines.SetNumZeroed(NumChunks + 1);
+
+	ParallelFor(NumChunks, [&](int32 c)
+	{
+		ChunkLines[c + 1] = CountLines(File.Data + ChunkOffsets[c], File.Data + ChunkOffsets[c + 1], ChunkOffsets[c + 1] == File.Size);
+	});
+
+	for (int32 c = 0; c < NumChunks; c++)
+	{
+		ChunkLines[c + 1] += ChunkLines[c];
+	}
+
+	int64 NumLines = ChunkLines.Last();
+	int64 RangeStart = FMath::Min((int64)FirstIndex + PointCloudFileHeader.LinesToSkip, NumLines);
+	int64 RangeEnd = NumLines;
+
+	if (LastIndex > 0 && LastIndex >= FirstIndex)
+	{
+		RangeEnd = FMath::Min((int64)LastIndex + PointCloudFileHeader.LinesToSkip + 1, NumLines);
+	}
+
+	// TArray is indexed by int32, so larger ranges have to be imported in parts with FirstIndex and LastIndex
+	if (RangeEnd - RangeStart > MAX_int32)
+	{
+		PC_ERROR("%s has %lld lines in range, at most %d can be imported at once", *Filename, RangeEnd - RangeStart, MAX_int32);
+		return false;
+	}
+
+	// Reserves a point for every line in range, invalid lines are compacted afterwards
+	OutPoints.Reset();
+	OutPoints.AddUninitialized(FMath::Max(RangeEnd - RangeStart, (int64)0));
+
+	TArray<int32> ChunkPoints;
+	ChunkPoints.SetNumZeroed(NumChunks);
+
+	ParallelFor(NumChunks, [&](int32 c)
+	{
+		if (ChunkLines[c + 1] <= RangeStart || ChunkLines[c] >= RangeEnd)
+		{
+			return;
+		}
+
+		FPointCloudPoint* ChunkOutput = OutPoints.GetData() + (FMath::Max(ChunkLines[c], RangeStart) - RangeStart);
+		ChunkPoints[c] = ParseTextChunk(File.Data + ChunkOffsets[c], File.Data + ChunkOffsets[c + 1], ChunkLines[c], RangeStart, RangeEnd, PointCloudFileHeader, NumExpectedColumns, RGBMulti, ChunkOutput);
+	});
+
+	// Concatenate
+	int32 NumPoints = 0;
+	for (int32 c = 0; c < NumChunks; c++)
+	{
+		if (ChunkPoints[c] > 0)
+		{
+			int64 ChunkStart = FMath::Max(ChunkLines[c], RangeStart) - RangeStart;
+
+			if (ChunkStart != NumPoints)
+			{
+				FMemory::Memmove(OutPoints.GetData() + NumPoints, OutPoints.GetData() + ChunkStart, ChunkPoints[c] * sizeof(FPointCloudPoint));
+			}
+
+			NumPoints += ChunkPoints[c];
+		}
+	}
+
+	// Avoid reallocating, usually only a few header lines are dropped
+	OutPoints.SetNum(NumPoints, false);
+
+	return true;
 }
 
 FPointCloudFileHeader FPointCloudHelper::ReadFileHeader(const FString& Filename)
@@ -351,181 +528,312 @@ FVector2D FPointCloudHelper::ReadFileMinMaxColumns(const FString& Filename, TArr
 	FPointCloudFileHeader Header = ReadFileHeader(Filename);
 	FVector2D Result;
 
-	TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*Filename));
-	if (Reader)
+	FPointCloudFileData File;
+	if (File.Open(Filename))
 	{
-		int64 Size = Reader->TotalSize();
-
-		uint8* Data = (uint8*)FMemory::Malloc(Size);
-		Reader->Serialize(Data, Size);
-		Reader->Close();
-		Reader = nullptr;
-
-		Result = ReadFileMinMaxColumns(Data, Header.Delimiter[0], Columns);
-
-		FMemory::Free(Data);
-		Data = NULL;
+		Result = ReadFileMinMaxColumns(File.Data, File.Size, Header.Delimiter[0], Columns);
 	}
 
 	return Result;
 }
 FVector2D FPointCloudHelper::ReadFileMinMaxColumns(const uint8 *DataPtr, uint8 Delimiter, TArray<int32> Columns)
 {
-	FVector2D Result = FVector2D(FLT_MAX, -FLT_MAX);
-	float Tmp = 0;
+	return ReadFileMinMaxColumns(DataPtr, FCStringAnsi::Strlen((const ANSICHAR*)DataPtr), Delimiter, Columns);
+}
+FVector2D FPointCloudHelper::ReadFileMinMaxColumns(const uint8 *Data, int64 Size, uint8 Delimiter, TArray<int32> Columns)
+{
+	TArray<int64> ChunkOffsets = SplitIntoLineChunks(Data, Size);
+	int32 NumChunks = ChunkOffsets.Num() - 1;
 
-	uint8 Iterator = 0;
-	bool bEndOfLine = false;
+	TArray<FVector2D> ChunkResults;
+	ChunkResults.Init(FVector2D(FLT_MAX, -FLT_MAX), NumChunks);
 
-	for (; *DataPtr != 0;)
+	ParallelFor(NumChunks, [&](int32 c)
 	{
-		const char* ChunkStart = (char*)DataPtr;
-		while (*DataPtr != 0 && *DataPtr != '\r' && *DataPtr != '\n' && *DataPtr != Delimiter)
-		{
-			DataPtr++;
-		}
+		const uint8* DataPtr = Data + ChunkOffsets[c];
+		const uint8* DataEnd = Data + ChunkOffsets[c + 1];
+		FVector2D& Result = ChunkResults[c];
+		float Tmp = 0;
 
-		if (Columns.Contains(Iterator++))
-		{
-			Tmp = (float)atof(ChunkStart);
-			Result.X = FMath::Min(Result.X, Tmp);
-			Result.Y = FMath::Max(Result.Y, Tmp);
-		}
+		uint8 Iterator = 0;
+		bool bEndOfLine = false;
 
-		if (*DataPtr == Delimiter)
+		while (DataPtr < DataEnd)
 		{
-			DataPtr++;
-		}
-		if (*DataPtr == '\r')
-		{
-			DataPtr++;
-			bEndOfLine = true;
-		}
-		if (*DataPtr == '\n')
-		{
-			DataPtr++;
-			bEndOfLine = true;
-		}
+			const uint8* ChunkStart = DataPtr;
+			while (DataPtr < DataEnd && *DataPtr != '\r' && *DataPtr != '\n' && *DataPtr != Delimiter)
+			{
+				DataPtr++;
+			}
 
-		if (bEndOfLine)
-		{
-			Iterator = 0;
-			bEndOfLine = false;
+			if (Columns.Contains(Iterator++))
+			{
+				Tmp = ParseFloat(ChunkStart, DataPtr);
+				Result.X = FMath::Min(Result.X, Tmp);
+				Result.Y = FMath::Max(Result.Y, Tmp);
+			}
+
+			if (DataPtr < DataEnd && *DataPtr == Delimiter)
+			{
+				DataPtr++;
+			}
+			if (DataPtr < DataEnd && *DataPtr == '\r')
+			{
+				DataPtr++;
+				bEndOfLine = true;
+			}
+			if (DataPtr < DataEnd && *DataPtr == '\n')
+			{
+				DataPtr++;
+				bEndOfLine = true;
+			}
+
+			if (bEndOfLine)
+			{
+				Iterator = 0;
+				bEndOfLine = false;
+			}
 		}
+	});
+
+	FVector2D Result = FVector2D(FLT_MAX, -FLT_MAX);
+
+	for (const FVector2D& ChunkResult : ChunkResults)
+	{
+		Result.X = FMath::Min(Result.X, ChunkResult.X);
+		Result.Y = FMath::Max(Result.Y, ChunkResult.Y);
 	}
 
 	return Result;
 }
 
-void FPointCloudHelper::DensityReduction(TArray<FPointCloudPoint>& Points, const float MinDistanceBetweenPoints)
+namespace
 {
-	if (MinDistanceBetweenPoints > 0)
-	{	
-		FVector CellSize = CalculateBounds(Points).GetSize() * 0.101;
-		for (int32 pass = 0; pass < 2; pass++)
+	/**
+	 * Uniform grid over the enabled points, stored as point indices sorted by cell.
+	 * Only occupied cells are stored, so the memory does not depend on the extent of the cloud.
+	 * Building is O(N log N), querying the 3x3x3 block around a cell is O(K) with K being the number of points in these cells.
+	 */
+	struct FPointCloudGrid
+	{
+		/** Maximum amount of cells per axis, which still fit into the key */
+		static const int32 MaxCellsPerAxis = 1 << 20;
+
+		FVector Origin;
+		float CellSize;
+
+		/** Indices of the points, sorted by their cell */
+		TArray<int32> Indices;
+
+		/** Range of each cell inside Indices, followed by the total number of indices */
+		TArray<int32> CellStarts;
+		TArray<FIntVector> CellCoords;
+		TMap<uint64, int32> CellLookup;
+
+		/** Cells grouped by their position inside a 3x3x3 block. Cells of the same group never share a neighbor */
+		TArray<int32> CellGroups[27];
+
+		FPointCloudGrid(const TArray<FPointCloudPoint>& Points, float MinCellSize)
 		{
-			TArray<TArray<FPointCloudPoint*>> Sections = SplitIntoSections(Points, CellSize, 10, 2800);
+			FBox Bounds = FPointCloudHelper::CalculateBounds(Points);
+			Origin = Bounds.Min;
+
+			// Large clouds with small distances would overflow the key
+			CellSize = FMath::Max(MinCellSize, Bounds.GetSize().GetMax() / (MaxCellsPerAxis - 1));
+
+			TArray<TPair<uint64, int32>> Keys;
+			Keys.SetNumUninitialized(Points.Num());
+
+			ParallelFor(Points.Num(), [&](int32 i)
+			{
+				// Disabled points are moved to the end
+				Keys[i] = TPair<uint64, int32>(Points[i].bEnabled ? CalculateKey(CalculateCoords(Points[i].Location)) : MAX_uint64, i);
+			});
+
+			// Sorting by index as well keeps the original order of the points inside each cell
+			Keys.Sort([](const TPair<uint64, int32>& A, const TPair<uint64, int32>& B)
+			{
+				return A.Key < B.Key || (A.Key == B.Key && A.Value < B.Value);
+			});
+
+			int32 NumEnabled = Keys.Num();
+			while (NumEnabled > 0 && Keys[NumEnabled - 1].Key == MAX_uint64)
+			{
+				NumEnabled--;
+			}
 
-			int32 NumThreads = Sections.Num();
-			TFuture<bool> *Results = new TFuture<bool>[NumThreads];
+			Indices.SetNumUninitialized(NumEnabled);
 
-			// Fire threads
-			for (int32 i = 0; i < NumThreads; i++)
+			for (int32 i = 0; i < NumEnabled; i++)
 			{
-				Results[i] = Async<bool>(EAsyncExecution::ThreadPool, [i, &Sections, &MinDistanceBetweenPoints]
+				Indices[i] = Keys[i].Value;
+
+				if (i == 0 || Keys[i].Key != Keys[i - 1].Key)
 				{
-					TArray<FPointCloudPoint*>& Section = Sections[i];
+					FIntVector Coords = CalculateCoords(Points[Indices[i]].Location);
 
-					for (int32 j = 0; j < Section.Num(); j++)
-					{
-						if (!Section[j]->bEnabled)
-						{
-							continue;
-						}
+					CellLookup.Add(Keys[i].Key, CellCoords.Num());
+					CellGroups[(Coords.X % 3) + (Coords.Y % 3) * 3 + (Coords.Z % 3) * 9].Add(CellCoords.Num());
+					CellStarts.Add(i);
+					CellCoords.Add(Coords);
+				}
+			}
 
-						for (int32 k = 0; k < Section.Num(); k++)
-						{
-							if (j == k || !Section[k]->bEnabled)
-								continue;
+			CellStarts.Add(NumEnabled);
+		}
+
+		FORCEINLINE FIntVector CalculateCoords(const FVector& Location) const
+		{
+			FVector Coords = (Location - Origin) / CellSize;
+			return FIntVector(FMath::Clamp(FMath::FloorToInt(Coords.X), 0, MaxCellsPerAxis - 1), FMath::Clamp(FMath::FloorToInt(Coords.Y), 0, MaxCellsPerAxis - 1), FMath::Clamp(FMath::FloorToInt(Coords.Z), 0, MaxCellsPerAxis - 1));
+		}
+
+		FORCEINLINE static uint64 CalculateKey(const FIntVector& Coords)
+		{
+			return ((uint64)Coords.Z << 40) | ((uint64)Coords.Y << 20) | (uint64)Coords.X;
+		}
 
-							Section[k]->bEnabled = Section[j]->GridDistance(Section[k]) > MinDistanceBetweenPoints;
+		/** Calls the function with the index of every point inside the 3x3x3 block of cells around the given cell */
+		template<typename NeighborFunction>
+		FORCEINLINE void ForEachNeighbor(int32 Cell, const NeighborFunction& Function) const
+		{
+			const FIntVector& Coords = CellCoords[Cell];
+
+			for (int32 z = FMath::Max(Coords.Z - 1, 0); z <= FMath::Min(Coords.Z + 1, MaxCellsPerAxis - 1); z++)
+			{
+				for (int32 y = FMath::Max(Coords.Y - 1, 0); y <= FMath::Min(Coords.Y + 1, MaxCellsPerAxis - 1); y++)
+				{
+					for (int32 x = FMath::Max(Coords.X - 1, 0); x <= FMath::Min(Coords.X + 1, MaxCellsPerAxis - 1); x++)
+					{
+						if (const int32* NeighborCell = CellLookup.Find(CalculateKey(FIntVector(x, y, z))))
+						{
+							for (int32 i = CellStarts[*NeighborCell]; i < CellStarts[*NeighborCell + 1]; i++)
+							{
+								Function(Indices[i]);
+							}
 						}
 					}
-
-					return true;
-				});
+				}
 			}
+		}
+
+		/** Like ForEachNeighbor, but stops as soon as the function returns true. Returns whether it did */
+		template<typename NeighborFunction>
+		FORCEINLINE bool FindNeighbor(int32 Cell, const NeighborFunction& Function) const
+		{
+			const FIntVector& Coords = CellCoords[Cell];
 
-			// Sync
-			for (int32 i = 0; i < NumThreads; i++)
+			for (int32 z = FMath::Max(Coords.Z - 1, 0); z <= FMath::Min(Coords.Z + 1, MaxCellsPerAxis - 1); z++)
 			{
-				if (Results[i].Get()) {}
+				for (int32 y = FMath::Max(Coords.Y - 1, 0); y <= FMath::Min(Coords.Y + 1, MaxCellsPerAxis - 1); y++)
+				{
+					for (int32 x = FMath::Max(Coords.X - 1, 0); x <= FMath::Min(Coords.X + 1, MaxCellsPerAxis - 1); x++)
+					{
+						if (const int32* NeighborCell = CellLookup.Find(CalculateKey(FIntVector(x, y, z))))
+						{
+							for (int32 i = CellStarts[*NeighborCell]; i < CellStarts[*NeighborCell + 1]; i++)
+							{
+								if (Function(Indices[i]))
+								{
+									return true;
+								}
+							}
+						}
+					}
+				}
 			}
 
-			delete[] Results;
-
-			CellSize *= 0.75;
+			return false;
 		}
-	}
+	};
 }
 
-void FPointCloudHelper::NoiseReduction(TArray<FPointCloudPoint>& Points, const float MaxDistanceBetweenPoints, const int32 MinPointDensity)
+void FPointCloudHelper::DensityReduction(TArray<FPointCloudPoint>& Points, const float MinDistanceBetweenPoints)
 {
-	if (MaxDistanceBetweenPoints <= 0 || MinPointDensity <= 0)
+	if (MinDistanceBetweenPoints <= 0)
 	{
 		return;
 	}
 
-	TArray<TArray<FPointCloudPoint*>> Sections = SplitIntoSections(Points, CalculateBounds(Points).GetSize() * 0.101, 1, 2800);
+	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("FPointCloudHelper::DensityReduction"), STAT_PointCloud_DensityReduction, STATGROUP_LoadTime);
 
-	int32 NumThreads = Sections.Num();
-	TFuture<bool> *Results = new TFuture<bool>[NumThreads];
+	// Cells are at least as large as the distance, so all points in range are inside the neighboring cells
+	FPointCloudGrid Grid(Points, MinDistanceBetweenPoints);
 
-	// Fire threads
-	for (int32 i = 0; i < NumThreads; i++)
+	// Each point keeps the points within range from being enabled, in order of the points inside a cell.
+	// Cells of the same group do not share neighbors and can be processed in parallel, the groups are processed in sequence to keep the result deterministic.
+	for (const TArray<int32>& CellGroup : Grid.CellGroups)
 	{
-		Results[i] = Async<bool>(EAsyncExecution::ThreadPool, [i, &Sections, &MaxDistanceBetweenPoints, &MinPointDensity]
+		ParallelFor(CellGroup.Num(), [&](int32 c)
 		{
-			TArray<FPointCloudPoint*>& Section = Sections[i];
-			
-			for (int32 j = 0; j < Section.Num(); j++)
-			{				
-				if (!Section[j]->bEnabled)
+			int32 Cell = CellGroup[c];
+
+			for (int32 i = Grid.CellStarts[Cell]; i < Grid.CellStarts[Cell + 1]; i++)
+			{
+				FPointCloudPoint& Point = Points[Grid.Indices[i]];
+
+				if (!Point.bEnabled)
 				{
 					continue;
 				}
 
-				int32 Neighbors = 0;
-				Section[j]->bEnabled = false;
-
-				for (int32 k = 0; k < Section.Num(); k++)
+				Grid.ForEachNeighbor(Cell, [&](int32 NeighborIndex)
 				{
-					if (j == k || !Section[k]->bEnabled)
-						continue;
+					FPointCloudPoint& Neighbor = Points[NeighborIndex];
 
-					if (Section[j]->GridDistance(Section[k]) <= MaxDistanceBetweenPoints)
+					if (&Neighbor != &Point && Neighbor.bEnabled && Point.GridDistance(&Neighbor) <= MinDistanceBetweenPoints)
 					{
-						// If minimum density reached, no need to check this point further
-						if (++Neighbors >= MinPointDensity)
-						{
-							Section[j]->bEnabled = true;
-							break;
-						}
+						Neighbor.bEnabled = false;
 					}
-				}
+				});
 			}
-
-			return true;
 		});
 	}
+}
 
-	// Sync
-	for (int32 i = 0; i < NumThreads; i++)
+void FPointCloudHelper::NoiseReduction(TArray<FPointCloudPoint>& Points, const float MaxDistanceBetweenPoints, const int32 MinPointDensity)
+{
+	if (MaxDistanceBetweenPoints <= 0 || MinPointDensity <= 0)
 	{
-		if (Results[i].Get()) {}
+		return;
 	}
 
-	delete[] Results;
+	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("FPointCloudHelper::NoiseReduction"), STAT_PointCloud_NoiseReduction, STATGROUP_LoadTime);
+
+	FPointCloudGrid Grid(Points, MaxDistanceBetweenPoints);
+
+	// Neighbors are counted among the points enabled before the pass, which makes the result independent of the processing order
+	TArray<bool> IsNoise;
+	IsNoise.SetNumZeroed(Points.Num());
+
+	ParallelFor(Grid.CellCoords.Num(), [&](int32 Cell)
+	{
+		for (int32 i = Grid.CellStarts[Cell]; i < Grid.CellStarts[Cell + 1]; i++)
+		{
+			const int32 Index = Grid.Indices[i];
+			FPointCloudPoint& Point = Points[Index];
+
+			int32 Neighbors = 0;
+
+			// If minimum density reached, no need to check this point further
+			IsNoise[Index] = !Grid.FindNeighbor(Cell, [&](int32 NeighborIndex)
+			{
+				if (NeighborIndex != Index && Point.GridDistance(&Points[NeighborIndex]) <= MaxDistanceBetweenPoints)
+				{
+					Neighbors++;
+				}
+				return Neighbors >= MinPointDensity;
+			});
+		}
+	});
+
+	ParallelFor(Points.Num(), [&](int32 i)
+	{
+		if (IsNoise[i])
+		{
+			Points[i].bEnabled = false;
+		}
+	});
 }
 
 FVector FPointCloudHelper::Transform(TArray<FPointCloudPoint>& Points, const EPointCloudOffset Offset, const FVector Translation, const FVector Scale, bool bUseLowPrecision)
@@ -570,10 +878,10 @@ TArray<TArray<FPointCloudPoint*>> FPointCloudHelper::SplitIntoSections(TArray<FP
 {
 	TArray<FPointCloudPoint*> PointsPtr;
 	PointsPtr.AddUninitialized(Points.Num());
-	for (int32 i = 0; i < Points.Num(); i++)
+	ParallelFor(Points.Num(), [&](int32 i)
 	{
 		PointsPtr[i] = &Points[i];
-	}
+	});
 
 	return SplitIntoSections(PointsPtr, SectionSize, MinSectionCount, MaxSectionCount);
 }
@@ -602,63 +910,67 @@ TArray<TArray<FPointCloudPoint*>> FPointCloudHelper::SplitIntoSections(TArray<FP
 	int32 StrideY = CellsX;
 	int32 StrideZ = CellsX * CellsY;
 
+	int32 NumCells = CellsX * CellsY * CellsZ;
 	int32 NumPoints = Points.Num();
+	int32 NumBatches = CalculateNumBatches(NumPoints);
 	int32 *Assignments = new int32[NumPoints];
-	int32 PerBatch = 5000;
-	int32 NumThreads = FMath::CeilToInt(((float)Points.Num()) / PerBatch);
-	TFuture<bool> *Results = new TFuture<bool>[NumThreads];
 
-	for (int32 i = 0; i < NumPoints; i++)
-	{
-		Assignments[i] = -1;
-	}
+	// Holds the number of points per cell for each batch, later turned into write offsets
+	TArray<int32> BatchOffsets;
+	BatchOffsets.SetNumZeroed(NumBatches * NumCells);
 
-	for (int32 b = 0; b < NumThreads; b++)
+	ParallelFor(NumBatches, [&](int32 b)
 	{
-		Results[b] = Async<bool>(EAsyncExecution::ThreadPool, [b, &PerBatch, &NumPoints, &Assignments, &Points, &Bounds, &InvertedSectionSize, &CellsX, &CellsY, &CellsZ, &StrideY, &StrideZ]
+		int32 *Counts = BatchOffsets.GetData() + b * NumCells;
+
+		for (int32 idx = (int64)NumPoints * b / NumBatches, End = (int64)NumPoints * (b + 1) / NumBatches; idx < End; idx++)
 		{
-			for (int32 i = 0, idx = b * PerBatch; i < PerBatch && idx < NumPoints; i++, idx++)
+			if (!Points[idx]->bEnabled)
 			{
-				if (!Points[idx]->bEnabled)
-				{
-					continue;
-				}
-
-				FVector v = (Points[idx]->Location - Bounds.Min) * InvertedSectionSize;
-				Assignments[idx] = FMath::Min((int32)v.X, CellsX - 1) + FMath::Min((int32)v.Y, CellsY - 1) * StrideY + FMath::Min((int32)v.Z, CellsZ - 1) * StrideZ;
+				Assignments[idx] = -1;
+				continue;
 			}
-				
-			return true;
-		});
-	}
 
-	// Sync
-	for (int32 i = 0; i < NumThreads; i++)
+			FVector v = (Points[idx]->Location - Bounds.Min) * InvertedSectionSize;
+			Assignments[idx] = FMath::Min((int32)v.X, CellsX - 1) + FMath::Min((int32)v.Y, CellsY - 1) * StrideY + FMath::Min((int32)v.Z, CellsZ - 1) * StrideZ;
+			Counts[Assignments[idx]]++;
+		}
+	});
+
+	// Preserves the original order of points inside each section
+	ParallelFor(NumCells, [&](int32 c)
 	{
-		if (Results[i].Get()) {}
-	}
+		int32 Offset = 0;
+
+		for (int32 b = 0; b < NumBatches; b++)
+		{
+			int32 Count = BatchOffsets[b * NumCells + c];
+			BatchOffsets[b * NumCells + c] = Offset;
+			Offset += Count;
+		}
+
+		Chunks[c].AddUninitialized(Offset);
+	});
 
 	// Assign
-	for (int32 i = 0; i < NumPoints; i++)
+	ParallelFor(NumBatches, [&](int32 b)
 	{
-		if (Assignments[i] >= 0)
+		int32 *Offsets = BatchOffsets.GetData() + b * NumCells;
+
+		for (int32 idx = (int64)NumPoints * b / NumBatches, End = (int64)NumPoints * (b + 1) / NumBatches; idx < End; idx++)
 		{
-			Chunks[Assignments[i]].Add(Points[i]);
+			if (Assignments[idx] >= 0)
+			{
+				Chunks[Assignments[idx]][Offsets[Assignments[idx]]++] = Points[idx];
+			}
 		}
-	}
+	});
 
-	delete[] Results;
 	delete[] Assignments;
 	
 	// Remove Empty Sections
 	MinSectionCount = FMath::Max(MinSectionCount, 1);
-	for (int32 i = 0; i < Chunks.Num(); i++)
-	{
-		if (Chunks[i].Num() < MinSectionCount)
-		{
-			Chunks.RemoveAt(i--);
-		}
-	}
+	Chunks.RemoveAll([MinSectionCount](const TArray<FPointCloudPoint*>& Chunk) { return Chunk.Num() < MinSectionCount; });
 
 	// Further divide if needed
 	if (MaxSectionCount > 0)
@@ -745,17 +1057,45 @@ TArray<FPointCloudPoint*> FPointCloudHelper::GetEnabledPoints(const TArray<FPoin
 	return EnabledPoints;
 }
 
+namespace
+{
+	/** Calculates the bounds in parallel batches. AddPoint extends the given box by the point at the given index. */
+	template<typename AddPointFunction>
+	FBox CalculateBoundsParallel(int32 NumPoints, const AddPointFunction& AddPoint)
+	{
+		int32 NumBatches = FPointCloudHelper::CalculateNumBatches(NumPoints);
+
+		TArray<FBox> BatchBounds;
+		BatchBounds.Init(FBox(ForceInit), NumBatches);
+
+		ParallelFor(NumBatches, [&](int32 b)
+		{
+			for (int32 Index = (int64)NumPoints * b / NumBatches, End = (int64)NumPoints * (b + 1) / NumBatches; Index < End; Index++)
+			{
+				AddPoint(BatchBounds[b], Index);
+			}
+		});
+
+		FBox BoundingBox(ForceInit);
+
+		for (const FBox& Box : BatchBounds)
+		{
+			BoundingBox += Box;
+		}
+
+		return BoundingBox;
+	}
+}
+
 FBox FPointCloudHelper::CalculateBounds(const TArray<FPointCloudPoint*>& Points, const FTransform& Transform)
 {
-	FBox BoundingBox(ForceInit);
-	
-	for (int32 Index = 0; Index < Points.Num(); Index++)
+	FBox BoundingBox = CalculateBoundsParallel(Points.Num(), [&](FBox& Box, int32 Index)
 	{
 		if (Points[Index] && Points[Index]->bEnabled)
 		{
-			BoundingBox += Transform.TransformPosition(Points[Index]->Location);
+			Box += Transform.TransformPosition(Points[Index]->Location);
 		}
-	}
+	});
 
 	AdjustBounds(BoundingBox);
 
@@ -763,17 +1103,13 @@ FBox FPointCloudHelper::CalculateBounds(const TArray<FPointCloudPoint*>& Points,
 }
 FBox FPointCloudHelper::CalculateBounds(const TArray<FPointCloudPoint>& Points, const FTransform& Transform)
 {
-	FBox BoundingBox(ForceInit);
-
-	for (int32 Index = 0; Index < Points.Num(); Index++)
+	FBox BoundingBox = CalculateBoundsParallel(Points.Num(), [&](FBox& Box, int32 Index)
 	{
-		if (!Points[Index].bEnabled)
+		if (Points[Index].bEnabled)
 		{
-			continue;
+			Box += Transform.TransformPosition(Points[Index].Location);
 		}
-
-		BoundingBox += Transform.TransformPosition(Points[Index].Location);
-	}
+	});
 
 	AdjustBounds(BoundingBox);
 
@@ -781,15 +1117,13 @@ FBox FPointCloudHelper::CalculateBounds(const TArray<FPointCloudPoint>& Points,
 }
 FBox FPointCloudHelper::CalculateBounds(const TArray<FPointCloudPoint*>& Points)
 {
-	FBox BoundingBox(ForceInit);
-
-	for (int32 Index = 0; Index < Points.Num(); Index++)
+	FBox BoundingBox = CalculateBoundsParallel(Points.Num(), [&](FBox& Box, int32 Index)
 	{
 		if (Points[Index] && Points[Index]->bEnabled)
 		{
-			BoundingBox += Points[Index]->Location;
+			Box += Points[Index]->Location;
 		}
-	}
+	});
 
 	AdjustBounds(BoundingBox);
 
@@ -797,23 +1131,25 @@ FBox FPointCloudHelper::CalculateBounds(const TArray<FPointCloudPoint*>& Points)
 }
 FBox FPointCloudHelper::CalculateBounds(const TArray<FPointCloudPoint>& Points)
 {
-	FBox BoundingBox(ForceInit);
-
-	for (int32 Index = 0; Index < Points.Num(); Index++)
+	FBox BoundingBox = CalculateBoundsParallel(Points.Num(), [&](FBox& Box, int32 Index)
 	{
-		if (!Points[Index].bEnabled)
+		if (Points[Index].bEnabled)
 		{
-			continue;
+			Box += Points[Index].Location;
 		}
-
-		BoundingBox += Points[Index].Location;
-	}
+	});
 
 	AdjustBounds(BoundingBox);
 
 	return BoundingBox;
 }
 
+int32 FPointCloudHelper::CalculateNumBatches(int32 NumItems, int32 MinBatchSize /*= 5000*/)
+{
+	int32 MaxBatches = FTaskGraphInterface::Get().GetNumWorkerThreads() + 1;
+	return FMath::Clamp(FMath::DivideAndRoundUp(NumItems, FMath::Max(MinBatchSize, 1)), 1, MaxBatches);
+}
+
 int32 FPointCloudHelper::CalculatePointSize(UPointCloud *PointCloud, bool bIncludeIB)
 {
 	// HalfPrecision only really uses 3 with the 4th being reserved for color
@@ -5,10 +5,24 @@
 #include "PointCloudShared.h"
 #include "PointCloudHelper.h"
 #include "VertexFactory.h"
+#include "ShaderParameterUtils.h"
 #include "IPointCloudSectionProxy.h"
 #include "MaterialShared.h"
 #include "Materials/MaterialInterface.h"
 #include "Materials/MaterialInstanceDynamic.h"
+#include "Async/ParallelFor.h"
+
+/** Vertex layout of the low precision Vertex Buffer, must match the vertex factory. The full precision FPointCloudVertex is in PointCloudShared.h */
+struct FPointCloudVertexLow
+{
+	FFloat16 X;
+	FFloat16 Y;
+	FFloat16 Z;
+	uint16 Color;
+};
+
+static_assert(sizeof(FPointCloudVertex) == 16, "FPointCloudVertex must match the stride of FPointCloudVertexFactory");
+static_assert(sizeof(FPointCloudVertexLow) == 8, "FPointCloudVertexLow must match the stride of FPointCloudVertexFactoryLow");
 
 ////////////////////////////////////////////////////////////
 // FPointCloudVertexBuffer
@@ -18,6 +32,7 @@ class FPointCloudVertexBuffer : public FVertexBuffer
 public:
 	uint8 *Data;
 	uint32 DataSize;
+	bool bDynamic;
 
 	virtual void InitRHI() override
 	{
@@ -25,11 +40,22 @@ public:
 		{
 			FRHIResourceCreateInfo CreateInfo;
 			void* Buffer = nullptr;
-			VertexBufferRHI = RHICreateAndLockVertexBuffer(DataSize, BUF_Static, CreateInfo, Buffer);
+			VertexBufferRHI = RHICreateAndLockVertexBuffer(DataSize, bDynamic ? BUF_Dynamic : BUF_Static, CreateInfo, Buffer);
 			FMemory::Memcpy(Buffer, Data, DataSize);
 			RHIUnlockVertexBuffer(VertexBufferRHI);
 		}
 	}
+
+	/** Uploads new data to the existing buffer. Must be called from the rendering thread. */
+	void Update(const uint8* InData, uint32 InDataSize)
+	{
+		if (VertexBufferRHI.IsValid() && InDataSize == DataSize)
+		{
+			void* Buffer = RHILockVertexBuffer(VertexBufferRHI, 0, DataSize, RLM_WriteOnly);
+			FMemory::Memcpy(Buffer, InData, DataSize);
+			RHIUnlockVertexBuffer(VertexBufferRHI);
+		}
+	}
 };
 
 ////////////////////////////////////////////////////////////
@@ -44,6 +70,7 @@ public:
 	{
 		FVertexStreamComponent PositionComponent;
 		FVertexStreamComponent ColorComponent;
+		FVertexStreamComponent ScalarComponent;	// Only used by FPointCloudVertexFactoryScalars
 	};
 
 	FPointCloudVertexFactory(ERHIFeatureLevel::Type InFeatureLevel)
@@ -103,6 +130,103 @@ protected:
 
 IMPLEMENT_VERTEX_FACTORY_TYPE(FPointCloudVertexFactory, "/Plugin/PointCloudPlugin/Private/PointCloudVertexFactory.ush", /* bUsedWithMaterials */ true, /* bSupportsStaticLighting */ false, /* bSupportsDynamicLighting */ true, /* bPrecisePrevWorldPos */ false, /* bSupportsPositionOnly */ true);
 
+////////////////////////////////////////////////////////////
+// FPointCloudVertexFactoryScalars
+
+/** Adds a second stream with the scalar attributes of the points, which are colored by the ramp in the vertex shader */
+class FPointCloudVertexFactoryScalars : public FPointCloudVertexFactory
+{
+	DECLARE_VERTEX_FACTORY_TYPE(FPointCloudVertexFactoryScalars);
+
+public:
+	/** Set on the render thread when the ramp of the cloud changes, see FPointCloudSectionProxy::SetScalarRamp */
+	FPointCloudScalarRamp ScalarRamp;
+
+	FPointCloudVertexFactoryScalars(ERHIFeatureLevel::Type InFeatureLevel, const FPointCloudVertexBuffer* InScalarBuffer)
+		: FPointCloudVertexFactory(InFeatureLevel)
+		, ScalarBuffer(InScalarBuffer)
+	{
+	}
+
+	virtual void InitRHI() override
+	{
+		FVertexDeclarationElementList Elements;
+		Elements.Add(AccessStreamComponent(Data.PositionComponent, 0));
+		Elements.Add(AccessStreamComponent(Data.ColorComponent, 1));
+		Elements.Add(AccessStreamComponent(Data.ScalarComponent, 2));
+		InitDeclaration(Elements);
+	}
+
+	static FVertexFactoryShaderParameters* ConstructShaderParameters(EShaderFrequency ShaderFrequency);
+	static bool ShouldCache(EShaderPlatform Platform, const class FMaterial* Material, const class FShaderType* ShaderType) { return FPointCloudVertexFactory::ShouldCache(Platform, Material, ShaderType); }
+	static bool ShouldCompilePermutation(EShaderPlatform Platform, const class FMaterial* Material, const class FShaderType* ShaderType) { return true; }
+	static void ModifyCompilationEnvironment(EShaderPlatform Platform, const FMaterial* Material, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		OutEnvironment.SetDefine(TEXT("USE_SCALARS"), TEXT("1"));
+	}
+
+protected:
+	const FPointCloudVertexBuffer* ScalarBuffer;
+
+	virtual FDataType GetDataType(const FPointCloudVertexBuffer* VertexBuffer) override
+	{
+		FDataType DataType = FPointCloudVertexFactory::GetDataType(VertexBuffer);
+		DataType.ScalarComponent = FVertexStreamComponent(ScalarBuffer, 0, sizeof(FVector4), VET_Float4);
+		return DataType;
+	}
+};
+
+/** Passes the scalar ramp to the vertex shader */
+class FPointCloudVertexFactoryScalarsShaderParameters : public FVertexFactoryShaderParameters
+{
+public:
+	virtual void Bind(const FShaderParameterMap& ParameterMap) override
+	{
+		ScalarIndex.Bind(ParameterMap, TEXT("PointCloudScalarIndex"));
+		ScalarRange.Bind(ParameterMap, TEXT("PointCloudScalarRange"));
+		LowColor.Bind(ParameterMap, TEXT("PointCloudScalarLowColor"));
+		MidColor.Bind(ParameterMap, TEXT("PointCloudScalarMidColor"));
+		HighColor.Bind(ParameterMap, TEXT("PointCloudScalarHighColor"));
+	}
+
+	virtual void Serialize(FArchive& Ar) override
+	{
+		Ar << ScalarIndex;
+		Ar << ScalarRange;
+		Ar << LowColor;
+		Ar << MidColor;
+		Ar << HighColor;
+	}
+
+	virtual void SetMesh(FRHICommandList& RHICmdList, FShader* Shader, const FVertexFactory* VertexFactory, const FSceneView& View, const FMeshBatchElement& BatchElement, uint32 DataFlags) const override
+	{
+		const FPointCloudScalarRamp& Ramp = ((const FPointCloudVertexFactoryScalars*)VertexFactory)->ScalarRamp;
+		FVertexShaderRHIParamRef VertexShader = Shader->GetVertexShader();
+
+		SetShaderValue(RHICmdList, VertexShader, ScalarIndex, Ramp.ScalarIndex);
+		SetShaderValue(RHICmdList, VertexShader, ScalarRange, FVector2D(Ramp.Min, Ramp.Max));
+		SetShaderValue(RHICmdList, VertexShader, LowColor, Ramp.LowColor);
+		SetShaderValue(RHICmdList, VertexShader, MidColor, Ramp.MidColor);
+		SetShaderValue(RHICmdList, VertexShader, HighColor, Ramp.HighColor);
+	}
+
+	virtual uint32 GetSize() const override { return sizeof(*this); }
+
+private:
+	FShaderParameter ScalarIndex;
+	FShaderParameter ScalarRange;
+	FShaderParameter LowColor;
+	FShaderParameter MidColor;
+	FShaderParameter HighColor;
+};
+
+FVertexFactoryShaderParameters* FPointCloudVertexFactoryScalars::ConstructShaderParameters(EShaderFrequency ShaderFrequency)
+{
+	return ShaderFrequency == SF_Vertex ? new FPointCloudVertexFactoryScalarsShaderParameters() : NULL;
+}
+
+IMPLEMENT_VERTEX_FACTORY_TYPE(FPointCloudVertexFactoryScalars, "/Plugin/PointCloudPlugin/Private/PointCloudVertexFactory.ush", /* bUsedWithMaterials */ true, /* bSupportsStaticLighting */ false, /* bSupportsDynamicLighting */ true, /* bPrecisePrevWorldPos */ false, /* bSupportsPositionOnly */ true);
+
 #if WITH_LOW_PRECISION
 class FPointCloudVertexFactoryLow : public FPointCloudVertexFactory
 {
@@ -172,9 +296,11 @@ class FPointCloudSectionProxy : public IPointCloudSectionProxy
 {
 private:
 	FPointCloudVertexBuffer VertexBuffer;
+	FPointCloudVertexBuffer ScalarBuffer;
 	FPointCloudIndexBuffer IndexBuffer;
 	FPointCloudIndexBuffer IndexBufferSpecial;
 	FPointCloudVertexFactory* VertexFactory;
+	FPointCloudVertexFactoryScalars* ScalarVertexFactory;	// Same as VertexFactory, if the section has scalars
 
 	UMaterialInterface *Material;
 	UMaterialInstanceDynamic *MID;
@@ -189,8 +315,9 @@ private:
 	TArray<uint32> NumPrimitives;
 
 public:
-	FPointCloudSectionProxy(uint8* InIndexBuffer, uint8* InIndexBufferSpecial, uint32 InIndexBufferSize, uint8* InVertexBuffer, uint32 InVertexBufferSize, const bool bUseSprites, uint32 VertexCount, UMaterialInterface* Material, TArray<uint32> NumPrimitives, uint32 MinPointCount, TArray<float> ScreenSizes, const bool bUseLowPrecision, int32 LODBias)
-		: Material(Material)
+	FPointCloudSectionProxy(uint8* InIndexBuffer, uint8* InIndexBufferSpecial, uint32 InIndexBufferSize, uint8* InVertexBuffer, uint32 InVertexBufferSize, uint8* InScalarBuffer, uint32 InScalarBufferSize, const bool bUseSprites, uint32 VertexCount, UMaterialInterface* Material, TArray<uint32> NumPrimitives, uint32 MinPointCount, TArray<float> ScreenSizes, const bool bUseLowPrecision, int32 LODBias, const bool bDynamicVB, const FPointCloudScalarRamp& ScalarRamp)
+		: ScalarVertexFactory(nullptr)
+		, Material(Material)
 		, MID(Cast<UMaterialInstanceDynamic>(Material))
 		, RenderMode(bUseSprites ? PT_TriangleList : PT_PointList)
 		, VertexCount(VertexCount)
@@ -206,6 +333,10 @@ public:
 		IndexBufferSpecial.DataSize = bUseSprites ? InIndexBufferSize / 6 : InIndexBufferSize;
 		VertexBuffer.Data = InVertexBuffer;
 		VertexBuffer.DataSize = InVertexBufferSize;
+		VertexBuffer.bDynamic = bDynamicVB;
+		ScalarBuffer.Data = InScalarBuffer;
+		ScalarBuffer.DataSize = InScalarBufferSize;
+		ScalarBuffer.bDynamic = bDynamicVB;
 
 #if WITH_LOW_PRECISION
 		if (bUseLowPrecision)
@@ -214,6 +345,12 @@ public:
 		}
 		else
 #endif
+		if (InScalarBuffer)
+		{
+			VertexFactory = ScalarVertexFactory = new FPointCloudVertexFactoryScalars(ERHIFeatureLevel::SM4, &ScalarBuffer);
+			ScalarVertexFactory->ScalarRamp = ScalarRamp;
+		}
+		else
 		{
 			VertexFactory = new FPointCloudVertexFactory(ERHIFeatureLevel::SM4);
 		}
@@ -222,6 +359,7 @@ public:
 
 		// Enqueue initialization of render resource
 		BeginInitResource(&VertexBuffer);
+		BeginInitResource(&ScalarBuffer);
 		BeginInitResource(&IndexBuffer);
 		BeginInitResource(&IndexBufferSpecial);
 		BeginInitResource(VertexFactory);
@@ -229,6 +367,7 @@ public:
 	virtual ~FPointCloudSectionProxy()
 	{
 		VertexBuffer.ReleaseResource();
+		ScalarBuffer.ReleaseResource();
 		IndexBuffer.ReleaseResource();
 		IndexBufferSpecial.ReleaseResource();
 		VertexFactory->ReleaseResource();
@@ -257,6 +396,18 @@ public:
 
 	virtual UMaterialInterface* GetMaterial() const override { return Material; }
 	virtual int32 GetLOD() const override { return CurrentLOD; }
+	virtual void UpdateVertexBuffer(const TArray<uint8>& InVertexData, const TArray<uint8>& InScalarData) override
+	{
+		VertexBuffer.Update(InVertexData.GetData(), InVertexData.Num());
+		ScalarBuffer.Update(InScalarData.GetData(), InScalarData.Num());
+	}
+	virtual void SetScalarRamp(const FPointCloudScalarRamp& InScalarRamp) override
+	{
+		if (ScalarVertexFactory)
+		{
+			ScalarVertexFactory->ScalarRamp = InScalarRamp;
+		}
+	}
 	virtual bool NeedsRendering() override { return NumPrimitives[CurrentLOD] >= MinPointCount; }
 	virtual void ComputeAndSetLOD(float ScreenSize) override
 	{
@@ -292,10 +443,12 @@ public:
 ////////////////////////////////////////////////////////////
 // FPointCloudSection
 
-FPointCloudSection::FPointCloudSection(UPointCloud *InCloud, const TArray<FPointCloudPoint*> InPoints)
+FPointCloudSection::FPointCloudSection(UPointCloud *InCloud, const TArray<FPointCloudPoint*> InPoints, bool bBuildBuffers /*= true*/)
 	: Cloud(InCloud)
 	, Points(InPoints)
 	, VertexBuffer(nullptr)
+	, ScalarBuffer(nullptr)
+	, ScalarBufferSize(0)
 	, IndexBuffer(nullptr)
 	, IndexBufferSpecial(nullptr)
 	, VertexCount(0)
@@ -306,7 +459,11 @@ FPointCloudSection::FPointCloudSection(UPointCloud *InCloud, const TArray<FPoint
 	if (Cloud)
 	{
 		Material = UMaterialInstanceDynamic::Create(Cloud->GetMaterial(), nullptr);
-		Rebuild(true, true);
+
+		if (bBuildBuffers)
+		{
+			Rebuild(true, true);
+		}
 	}
 }
 
@@ -317,7 +474,7 @@ FPointCloudSection::~FPointCloudSection()
 
 IPointCloudSectionProxy* FPointCloudSection::BuildProxy()
 {
-	return (!GetMaterial()) ? NULL : new FPointCloudSectionProxy(IndexBuffer, IndexBufferSpecial, IndexBufferSize, VertexBuffer, VertexBufferSize, Cloud->UsesSprites(), VertexCount, GetMaterial(), NumPrimitives, Cloud->MinimumSectionPointCount, ScreenSizes, Cloud->UsesLowPrecision(), Cloud->LODBias);
+	return (!GetMaterial()) ? NULL : new FPointCloudSectionProxy(IndexBuffer, IndexBufferSpecial, IndexBufferSize, VertexBuffer, VertexBufferSize, ScalarBuffer, ScalarBufferSize, Cloud->UsesSprites(), VertexCount, GetMaterial(), NumPrimitives, Cloud->MinimumSectionPointCount, ScreenSizes, Cloud->UsesLowPrecision(), Cloud->LODBias, Cloud->bDynamicVertexBuffer, Cloud->ScalarRamp);
 }
 
 void FPointCloudSection::Rebuild(bool bBuildVB, bool bBuildIB)
@@ -343,6 +500,13 @@ void FPointCloudSection::Dispose(bool bVB, bool bIB)
 		VertexBuffer = nullptr;
 	}
 
+	if (bVB && ScalarBuffer)
+	{
+		delete[] ScalarBuffer;
+		ScalarBuffer = nullptr;
+		ScalarBufferSize = 0;
+	}
+
 	if (bIB)
 	{
 		if (IndexBuffer)
@@ -373,120 +537,255 @@ FBoxSphereBounds FPointCloudSection::CalcBounds(const FTransform& Transform /*=
 
 void FPointCloudSection::BuildVB()
 {
-	bool bUseSprites = Cloud->UsesSprites();
-
 	TArray<FPointCloudPoint*> EnabledPoints = FPointCloudHelper::GetEnabledPoints(Points);
 
 	VertexCount = (uint32)EnabledPoints.Num();
 	VertexBufferSize = VertexCount * FPointCloudHelper::CalculatePointSize(Cloud, false);
 	VertexBuffer = new uint8[VertexBufferSize];
-	uint8* DataPtr = VertexBuffer;
 
-	for (uint32 idx = 0; idx < VertexCount; idx++)
+	WriteVB(EnabledPoints);
+
+	if (Cloud->UsesScalars())
+	{
+		ScalarBufferSize = VertexCount * (Cloud->UsesSprites() ? 4 : 1) * sizeof(FVector4);
+		ScalarBuffer = new uint8[ScalarBufferSize];
+
+		WriteScalars(EnabledPoints);
+	}
+}
+
+bool FPointCloudSection::UpdateVB()
+{
+	TArray<FPointCloudPoint*> EnabledPoints = FPointCloudHelper::GetEnabledPoints(Points);
+
+	if (!VertexBuffer || (uint32)EnabledPoints.Num() != VertexCount || (ScalarBuffer != nullptr) != Cloud->UsesScalars())
 	{
-		for (uint8 u = 0; u < (bUseSprites ? 4 : 1); u++)
+		return false;
+	}
+
+	// Points may have moved, LOD screen sizes are kept until the next rebuild
+	LocalBounds = CalcBounds();
+	WriteVB(EnabledPoints);
+
+	if (ScalarBuffer)
+	{
+		WriteScalars(EnabledPoints);
+	}
+
+	return true;
+}
+
+bool FPointCloudSection::UpdateVB(const FPointCloudVertex* InVertices, const FVector& Offset, const FVector& Scale)
+{
+	if (!VertexBuffer || Cloud->UsesLowPrecision() || (uint32)Points.Num() != VertexCount || (ScalarBuffer != nullptr) != Cloud->UsesScalars())
+	{
+		return false;
+	}
+
+	const FPointCloudPoint* FirstPoint = Cloud->GetPointCloudData().GetData();
+	int32 VerticesPerPoint = Cloud->UsesSprites() ? 4 : 1;
+	FPointCloudVertex* Vertices = (FPointCloudVertex*)VertexBuffer;
+
+	ParallelFor(VertexCount, [&](int32 idx)
+	{
+		FPointCloudPoint* Point = Points[idx];
+		FPointCloudVertex Vertex = InVertices[Point - FirstPoint];
+
+		// Keep the points in sync, so a later rebuild shows the same data
+		Point->OriginalLocation = Vertex.Location;
+		Point->Location = (Vertex.Location + Offset) * Scale;
+		Point->Color = Vertex.Color;
+
+		Vertex.Location = Point->Location;
+
+		for (int32 u = 0; u < VerticesPerPoint; u++)
+		{
+			Vertices[idx * VerticesPerPoint + u] = Vertex;
+		}
+	});
+
+	LocalBounds = CalcBounds();
+
+	// The cloud has already taken over the new scalars
+	if (ScalarBuffer)
+	{
+		WriteScalars(Points);
+	}
+
+	return true;
+}
+
+void FPointCloudSection::WriteVB(const TArray<FPointCloudPoint*>& EnabledPoints)
+{
+	int32 VerticesPerPoint = Cloud->UsesSprites() ? 4 : 1;
+
+	if (Cloud->UsesLowPrecision())
+	{
+		FPointCloudVertexLow* Vertices = (FPointCloudVertexLow*)VertexBuffer;
+
+		ParallelFor(VertexCount, [&](int32 idx)
 		{
-			if (Cloud->UsesLowPrecision())
+			const FPointCloudPoint* Point = EnabledPoints[idx];
+			FPointCloudVertexLow Vertex;
+
+			// Converting into 16 bit RGB
+			uint16 r = ((Point->Color.R & 0xF8) << 8) & 0xF800;
+			uint16 g = ((Point->Color.G & 0xFC) << 3) & 0x07E0;
+			uint16 b = ((Point->Color.B & 0xF8) >> 3) & 0x001F;
+
+			Vertex.X = FFloat16(Point->Location.X);
+			Vertex.Y = FFloat16(Point->Location.Y);
+			Vertex.Z = FFloat16(Point->Location.Z);
+			Vertex.Color = r | g | b;
+
+			for (int32 u = 0; u < VerticesPerPoint; u++)
 			{
-				// Converting into 16 bit RGB
-				uint16 r = ((EnabledPoints[idx]->Color.R & 0xF8) << 8) & 0xF800;
-				uint16 g = ((EnabledPoints[idx]->Color.G & 0xFC) << 3) & 0x07E0;
-				uint16 b = ((EnabledPoints[idx]->Color.B & 0xF8) >> 3) & 0x001F;
-				uint16 rgb = r | g | b;
-
-				FFloat16 X(EnabledPoints[idx]->Location.X), Y(EnabledPoints[idx]->Location.Y), Z(EnabledPoints[idx]->Location.Z);
-
-				FMemory::Memcpy(DataPtr, &X, sizeof(FFloat16));
-				DataPtr += sizeof(FFloat16);
-				FMemory::Memcpy(DataPtr, &Y, sizeof(FFloat16));
-				DataPtr += sizeof(FFloat16);
-				FMemory::Memcpy(DataPtr, &Z, sizeof(FFloat16));
-				DataPtr += sizeof(FFloat16);
-				FMemory::Memcpy(DataPtr, &rgb, sizeof(uint16));
-				DataPtr += sizeof(uint16);
+				Vertices[idx * VerticesPerPoint + u] = Vertex;
 			}
-			else
+		});
+	}
+	else
+	{
+		FPointCloudVertex* Vertices = (FPointCloudVertex*)VertexBuffer;
+
+		ParallelFor(VertexCount, [&](int32 idx)
+		{
+			const FPointCloudPoint* Point = EnabledPoints[idx];
+			FPointCloudVertex Vertex;
+			Vertex.Location = Point->Location;
+			Vertex.Color = Point->Color;
+
+			for (int32 u = 0; u < VerticesPerPoint; u++)
 			{
-				FMemory::Memcpy(DataPtr, &EnabledPoints[idx]->Location, sizeof(FVector));
-				DataPtr += sizeof(FVector);
-				FMemory::Memcpy(DataPtr, &EnabledPoints[idx]->Color, sizeof(FColor));
-				DataPtr += sizeof(FColor);
+				Vertices[idx * VerticesPerPoint + u] = Vertex;
 			}
-		}
+		});
 	}
+}
+
+void FPointCloudSection::WriteScalars(const TArray<FPointCloudPoint*>& EnabledPoints)
+{
+	int32 VerticesPerPoint = Cloud->UsesSprites() ? 4 : 1;
+	const FPointCloudPoint* FirstPoint = Cloud->GetPointCloudData().GetData();
+	const FVector4* InScalars = Cloud->GetScalarData().GetData();
+	FVector4* Scalars = (FVector4*)ScalarBuffer;
+
+	ParallelFor(VertexCount, [&](int32 idx)
+	{
+		const FVector4& Scalar = InScalars[EnabledPoints[idx] - FirstPoint];
 
-	DataPtr = nullptr;
+		for (int32 u = 0; u < VerticesPerPoint; u++)
+		{
+			Scalars[idx * VerticesPerPoint + u] = Scalar;
+		}
+	});
 }
 
 void FPointCloudSection::BuildIBAndLOD()
 {
 	bool bUseSprites = Cloud->UsesSprites();
-	bool *UniqueCheck = new bool[VertexCount];
-	FMemory::Memset(UniqueCheck, 0, VertexCount);
+	int32 LODCount = Cloud->LODCount;
 
 	IndexBufferSize = VertexCount * sizeof(uint32) * (bUseSprites ? 6 : 1);
 	IndexBuffer = new uint8[IndexBufferSize];
-	uint8* DataPtr = IndexBuffer;
 	IndexBufferSpecial = new uint8[VertexCount * sizeof(uint32)];
-	uint8* DataPtrSpecial = IndexBufferSpecial;
 
 	ScreenSizes.Empty();
-	ScreenSizes.AddUninitialized(Cloud->LODCount);
+	ScreenSizes.AddUninitialized(LODCount);
 	NumPrimitives.Empty();
-	NumPrimitives.AddUninitialized(Cloud->LODCount);
+	NumPrimitives.AddUninitialized(LODCount);
 
 	float aggr = 1 / Cloud->LODAggressiveness;
 
-	uint32 numPrimitives = 0;
-	for (int32 l = Cloud->LODCount - 1; l >= 0; l--)
+	// The coarsest LOD each point is part of, finer LODs only add the points not used yet
+	TArray<int32> PointLOD;
+	PointLOD.Init(-1, VertexCount);
+
+	for (int32 l = LODCount - 1; l >= 0; l--)
 	{
 		double Skip = CalculateSkip(l);
+		int32 NumSteps = FMath::Max(FMath::CeilToInt(VertexCount / Skip), VertexCount > 0 ? 1 : 0);
 
-		for (double PointIdx = 0; PointIdx < VertexCount; PointIdx += Skip)
+		// Skip is at least 1, so every step picks a different point
+		ParallelFor(NumSteps, [&](int32 Step)
 		{
-			if (PointIdx >= 0)
+			uint32 idx = Step > 0 ? (uint32)(Step * Skip) : 0;
+
+			if (idx < VertexCount && PointLOD[idx] < 0)
 			{
-				uint32 idx = (uint32)PointIdx;
+				PointLOD[idx] = l;
+			}
+		});
+	}
 
-				if (!UniqueCheck[idx])
-				{
-					UniqueCheck[idx] = true;
-
-					if (bUseSprites)
-					{
-						uint32 idx0 = idx * 4;
-						uint32 idx1 = idx0 + 1;
-						uint32 idx2 = idx0 + 2;
-						uint32 idx3 = idx0 + 3;
-
-						FMemory::Memcpy(DataPtr, &idx0, sizeof(uint32)); DataPtr += sizeof(uint32);
-						FMemory::Memcpy(DataPtr, &idx1, sizeof(uint32)); DataPtr += sizeof(uint32);
-						FMemory::Memcpy(DataPtr, &idx2, sizeof(uint32)); DataPtr += sizeof(uint32);
-						FMemory::Memcpy(DataPtr, &idx0, sizeof(uint32)); DataPtr += sizeof(uint32);
-						FMemory::Memcpy(DataPtr, &idx2, sizeof(uint32)); DataPtr += sizeof(uint32);
-						FMemory::Memcpy(DataPtr, &idx3, sizeof(uint32)); DataPtr += sizeof(uint32);
-
-						numPrimitives += 2;
-
-						// Special buffer
-						FMemory::Memcpy(DataPtrSpecial, &idx0, sizeof(uint32));
-						DataPtrSpecial += sizeof(uint32);
-					}
-					else
-					{
-						FMemory::Memcpy(DataPtr, &idx, sizeof(uint32));
-						DataPtr += sizeof(uint32);
-						numPrimitives++;
-					}
-				}
+	// Count the points of each LOD per batch and turn the counts into write offsets.
+	// The buffer is ordered from the coarsest to the finest LOD and by point inside each LOD.
+	int32 NumBatches = FPointCloudHelper::CalculateNumBatches(VertexCount);
+	TArray<uint32> BatchOffsets;
+	BatchOffsets.SetNumZeroed(NumBatches * LODCount);
+
+	ParallelFor(NumBatches, [&](int32 b)
+	{
+		uint32 *Counts = BatchOffsets.GetData() + b * LODCount;
+
+		for (uint32 idx = (uint64)VertexCount * b / NumBatches, End = (uint64)VertexCount * (b + 1) / NumBatches; idx < End; idx++)
+		{
+			if (PointLOD[idx] >= 0)
+			{
+				Counts[PointLOD[idx]]++;
 			}
 		}
+	});
+
+	uint32 numPoints = 0;
+	for (int32 l = LODCount - 1; l >= 0; l--)
+	{
+		for (int32 b = 0; b < NumBatches; b++)
+		{
+			uint32 Count = BatchOffsets[b * LODCount + l];
+			BatchOffsets[b * LODCount + l] = numPoints;
+			numPoints += Count;
+		}
 
-		NumPrimitives[l] = numPrimitives;
+		NumPrimitives[l] = bUseSprites ? numPoints * 2 : numPoints;
 		ScreenSizes[l] = FMath::Square(ComputeBoundsScreenSize(FVector::ZeroVector, LocalBounds.SphereRadius, FVector(0.0f, 0.0f, (FMath::Pow(aggr, l) + 1) * LocalBounds.SphereRadius), ProjectionMatrix) * 0.5f);
 	}
 
-	delete[] UniqueCheck;
-	DataPtr = nullptr;
-	DataPtrSpecial = nullptr;
+	uint32* Indices = (uint32*)IndexBuffer;
+	uint32* IndicesSpecial = (uint32*)IndexBufferSpecial;
+
+	ParallelFor(NumBatches, [&](int32 b)
+	{
+		uint32 *Offsets = BatchOffsets.GetData() + b * LODCount;
+
+		for (uint32 idx = (uint64)VertexCount * b / NumBatches, End = (uint64)VertexCount * (b + 1) / NumBatches; idx < End; idx++)
+		{
+			if (PointLOD[idx] < 0)
+			{
+				continue;
+			}
+
+			uint32 Position = Offsets[PointLOD[idx]]++;
+
+			if (bUseSprites)
+			{
+				uint32 idx0 = idx * 4;
+				uint32* Quad = Indices + Position * 6;
+
+				Quad[0] = idx0;
+				Quad[1] = idx0 + 1;
+				Quad[2] = idx0 + 2;
+				Quad[3] = idx0;
+				Quad[4] = idx0 + 2;
+				Quad[5] = idx0 + 3;
+
+				// Special buffer
+				IndicesSpecial[Position] = idx0;
+			}
+			else
+			{
+				Indices[Position] = idx;
+			}
+		}
+	});
 }
@@ -0,0 +1,517 @@
+// Copyright 2018 Michal Cieciura. All Rights Reserved.
+
+#include "PointCloudSurfaceComponent.h"
+#include "PointCloudShared.h"
+#include "Engine/TextureRenderTarget2D.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "Camera/PlayerCameraManager.h"
+#include "GlobalShader.h"
+#include "ShaderParameterUtils.h"
+#include "RHIStaticStates.h"
+#include "Async/ParallelFor.h"
+
+namespace
+{
+	const int32 ThreadGroupSize1D = 64;
+	const int32 ThreadGroupSize2D = 8;
+
+	/** Bits of FLT_MAX, positive floats keep their order if compared as integers */
+	const uint32 EmptyDepth = 0x7F7FFFFF;
+	const int32 MaxSplatRadius = 32;
+
+	/** View settings shared by the GPU passes and the CPU fallback */
+	struct FPointCloudSurfaceView
+	{
+		/** View space with X right, Y up and Z forward */
+		FMatrix WorldToView;
+		float ProjectionScale;
+		FIntPoint Size;
+		float ParticleRadius;
+		int32 FilterRadius;
+		float DepthFalloff;
+	};
+
+	FORCEINLINE uint32 AsUint(float Value)
+	{
+		uint32 Result;
+		FMemory::Memcpy(&Result, &Value, sizeof(float));
+		return Result;
+	}
+
+	FORCEINLINE float AsFloat(uint32 Value)
+	{
+		float Result;
+		FMemory::Memcpy(&Result, &Value, sizeof(float));
+		return Result;
+	}
+}
+
+////////////////////////////////////////////////////////////
+// Shaders
+
+class FPointCloudSurfaceCS : public FGlobalShader
+{
+public:
+	FPointCloudSurfaceCS() {}
+	FPointCloudSurfaceCS(const FGlobalShaderType::CompiledShaderInitializerType& Initializer) : FGlobalShader(Initializer)
+	{
+		Positions.Bind(Initializer.ParameterMap, TEXT("Positions"));
+		NumPositions.Bind(Initializer.ParameterMap, TEXT("NumPositions"));
+		WorldToView.Bind(Initializer.ParameterMap, TEXT("WorldToView"));
+		ProjectionScale.Bind(Initializer.ParameterMap, TEXT("ProjectionScale"));
+		SurfaceSize.Bind(Initializer.ParameterMap, TEXT("SurfaceSize"));
+		ParticleRadius.Bind(Initializer.ParameterMap, TEXT("ParticleRadius"));
+		FilterRadius.Bind(Initializer.ParameterMap, TEXT("FilterRadius"));
+		DepthFalloff.Bind(Initializer.ParameterMap, TEXT("DepthFalloff"));
+		RWDepth.Bind(Initializer.ParameterMap, TEXT("RWDepth"));
+		InDepth.Bind(Initializer.ParameterMap, TEXT("InDepth"));
+		OutSurface.Bind(Initializer.ParameterMap, TEXT("OutSurface"));
+	}
+
+	static bool ShouldCache(EShaderPlatform Platform)
+	{
+		return IsFeatureLevelSupported(Platform, ERHIFeatureLevel::SM5);
+	}
+
+	static void ModifyCompilationEnvironment(EShaderPlatform Platform, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FGlobalShader::ModifyCompilationEnvironment(Platform, OutEnvironment);
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE_1D"), ThreadGroupSize1D);
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE_2D"), ThreadGroupSize2D);
+	}
+
+	virtual bool Serialize(FArchive& Ar) override
+	{
+		bool bShaderHasOutdatedParameters = FGlobalShader::Serialize(Ar);
+		Ar << Positions << NumPositions << WorldToView << ProjectionScale << SurfaceSize << ParticleRadius << FilterRadius << DepthFalloff << RWDepth << InDepth << OutSurface;
+		return bShaderHasOutdatedParameters;
+	}
+
+	/** Sets all parameters used by the pass, unused ones are not bound and skipped */
+	void SetParameters(FRHICommandList& RHICmdList, const FPointCloudSurfaceView& View, FShaderResourceViewRHIParamRef PositionsSRV, int32 InNumPositions, FUnorderedAccessViewRHIParamRef DepthUAV, FTextureRHIParamRef DepthTexture, FUnorderedAccessViewRHIParamRef SurfaceUAV)
+	{
+		FComputeShaderRHIParamRef ComputeShaderRHI = GetComputeShader();
+
+		SetSRVParameter(RHICmdList, ComputeShaderRHI, Positions, PositionsSRV);
+		SetShaderValue(RHICmdList, ComputeShaderRHI, NumPositions, (uint32)InNumPositions);
+		SetShaderValue(RHICmdList, ComputeShaderRHI, WorldToView, View.WorldToView);
+		SetShaderValue(RHICmdList, ComputeShaderRHI, ProjectionScale, View.ProjectionScale);
+		SetShaderValue(RHICmdList, ComputeShaderRHI, SurfaceSize, View.Size);
+		SetShaderValue(RHICmdList, ComputeShaderRHI, ParticleRadius, View.ParticleRadius);
+		SetShaderValue(RHICmdList, ComputeShaderRHI, FilterRadius, View.FilterRadius);
+		SetShaderValue(RHICmdList, ComputeShaderRHI, DepthFalloff, View.DepthFalloff);
+		SetUAVParameter(RHICmdList, ComputeShaderRHI, RWDepth, DepthUAV);
+		SetTextureParameter(RHICmdList, ComputeShaderRHI, InDepth, DepthTexture);
+		SetUAVParameter(RHICmdList, ComputeShaderRHI, OutSurface, SurfaceUAV);
+	}
+
+	void UnbindBuffers(FRHICommandList& RHICmdList)
+	{
+		FComputeShaderRHIParamRef ComputeShaderRHI = GetComputeShader();
+
+		SetSRVParameter(RHICmdList, ComputeShaderRHI, Positions, FShaderResourceViewRHIParamRef());
+		SetUAVParameter(RHICmdList, ComputeShaderRHI, RWDepth, FUnorderedAccessViewRHIParamRef());
+		SetUAVParameter(RHICmdList, ComputeShaderRHI, OutSurface, FUnorderedAccessViewRHIParamRef());
+	}
+
+private:
+	FShaderResourceParameter Positions;
+	FShaderParameter NumPositions;
+	FShaderParameter WorldToView;
+	FShaderParameter ProjectionScale;
+	FShaderParameter SurfaceSize;
+	FShaderParameter ParticleRadius;
+	FShaderParameter FilterRadius;
+	FShaderParameter DepthFalloff;
+	FShaderResourceParameter RWDepth;
+	FShaderResourceParameter InDepth;
+	FShaderResourceParameter OutSurface;
+};
+
+class FPointCloudSurfaceClearCS : public FPointCloudSurfaceCS
+{
+	DECLARE_SHADER_TYPE(FPointCloudSurfaceClearCS, Global);
+
+public:
+	FPointCloudSurfaceClearCS() {}
+	FPointCloudSurfaceClearCS(const ShaderMetaType::CompiledShaderInitializerType& Initializer) : FPointCloudSurfaceCS(Initializer) {}
+};
+
+class FPointCloudSurfaceSplatCS : public FPointCloudSurfaceCS
+{
+	DECLARE_SHADER_TYPE(FPointCloudSurfaceSplatCS, Global);
+
+public:
+	FPointCloudSurfaceSplatCS() {}
+	FPointCloudSurfaceSplatCS(const ShaderMetaType::CompiledShaderInitializerType& Initializer) : FPointCloudSurfaceCS(Initializer) {}
+};
+
+class FPointCloudSurfaceFilterCS : public FPointCloudSurfaceCS
+{
+	DECLARE_SHADER_TYPE(FPointCloudSurfaceFilterCS, Global);
+
+public:
+	FPointCloudSurfaceFilterCS() {}
+	FPointCloudSurfaceFilterCS(const ShaderMetaType::CompiledShaderInitializerType& Initializer) : FPointCloudSurfaceCS(Initializer) {}
+};
+
+IMPLEMENT_SHADER_TYPE(, FPointCloudSurfaceClearCS, TEXT("/Plugin/PointCloudPlugin/Private/PointCloudSurface.usf"), TEXT("ClearCS"), SF_Compute);
+IMPLEMENT_SHADER_TYPE(, FPointCloudSurfaceSplatCS, TEXT("/Plugin/PointCloudPlugin/Private/PointCloudSurface.usf"), TEXT("SplatCS"), SF_Compute);
+IMPLEMENT_SHADER_TYPE(, FPointCloudSurfaceFilterCS, TEXT("/Plugin/PointCloudPlugin/Private/PointCloudSurface.usf"), TEXT("FilterCS"), SF_Compute);
+
+////////////////////////////////////////////////////////////
+// FPointCloudSurfaceResources
+
+/** Render thread side of the component, only accessed from the render thread */
+class FPointCloudSurfaceResources
+{
+private:
+	FStructuredBufferRHIRef PositionBuffer;
+	FShaderResourceViewRHIRef PositionSRV;
+	int32 Capacity;
+	int32 NumPositions;
+
+	FTexture2DRHIRef DepthTexture;
+	FUnorderedAccessViewRHIRef DepthUAV;
+	FTexture2DRHIRef SurfaceTexture;
+	FUnorderedAccessViewRHIRef SurfaceUAV;
+	FIntPoint Size;
+
+public:
+	FPointCloudSurfaceResources() : Capacity(0), NumPositions(0), Size(0, 0) {}
+
+	void UpdatePositions(const TArray<FVector>& InPositions)
+	{
+		NumPositions = InPositions.Num();
+
+		if (NumPositions == 0)
+		{
+			return;
+		}
+
+		// Only grows, so the buffer is not recreated every time a few particles are added
+		if (NumPositions > Capacity)
+		{
+			Capacity = FMath::RoundUpToPowerOfTwo(NumPositions);
+
+			FRHIResourceCreateInfo CreateInfo;
+			PositionBuffer = RHICreateStructuredBuffer(sizeof(FVector), Capacity * sizeof(FVector), BUF_Dynamic | BUF_ShaderResource, CreateInfo);
+			PositionSRV = RHICreateShaderResourceView(PositionBuffer);
+		}
+
+		void* Buffer = RHILockStructuredBuffer(PositionBuffer, 0, NumPositions * sizeof(FVector), RLM_WriteOnly);
+		FMemory::Memcpy(Buffer, InPositions.GetData(), NumPositions * sizeof(FVector));
+		RHIUnlockStructuredBuffer(PositionBuffer);
+	}
+
+	void Render(FRHICommandListImmediate& RHICmdList, const FPointCloudSurfaceView& View, FTextureRenderTargetResource* Target)
+	{
+		if (View.Size.X <= 0 || View.Size.Y <= 0)
+		{
+			return;
+		}
+
+		if (View.Size != Size)
+		{
+			Size = View.Size;
+
+			FRHIResourceCreateInfo CreateInfo;
+			DepthTexture = RHICreateTexture2D(Size.X, Size.Y, PF_R32_UINT, 1, 1, TexCreate_ShaderResource | TexCreate_UAV, CreateInfo);
+			DepthUAV = RHICreateUnorderedAccessView(DepthTexture);
+			SurfaceTexture = RHICreateTexture2D(Size.X, Size.Y, PF_R32_FLOAT, 1, 1, TexCreate_ShaderResource | TexCreate_UAV, CreateInfo);
+			SurfaceUAV = RHICreateUnorderedAccessView(SurfaceTexture);
+		}
+
+		TShaderMap<FGlobalShaderType>* ShaderMap = GetGlobalShaderMap(ERHIFeatureLevel::SM5);
+		const int32 GroupsX = FMath::DivideAndRoundUp(Size.X, ThreadGroupSize2D);
+		const int32 GroupsY = FMath::DivideAndRoundUp(Size.Y, ThreadGroupSize2D);
+
+		// Clear
+		TShaderMapRef<FPointCloudSurfaceClearCS> ClearCS(ShaderMap);
+		RHICmdList.SetComputeShader(ClearCS->GetComputeShader());
+		ClearCS->SetParameters(RHICmdList, View, nullptr, 0, DepthUAV, nullptr, nullptr);
+		DispatchComputeShader(RHICmdList, *ClearCS, GroupsX, GroupsY, 1);
+		ClearCS->UnbindBuffers(RHICmdList);
+
+		RHICmdList.TransitionResource(EResourceTransitionAccess::ERWBarrier, EResourceTransitionPipeline::EComputeToCompute, DepthUAV);
+
+		// Splat
+		if (NumPositions > 0)
+		{
+			TShaderMapRef<FPointCloudSurfaceSplatCS> SplatCS(ShaderMap);
+			RHICmdList.SetComputeShader(SplatCS->GetComputeShader());
+			SplatCS->SetParameters(RHICmdList, View, PositionSRV, NumPositions, DepthUAV, nullptr, nullptr);
+			DispatchComputeShader(RHICmdList, *SplatCS, FMath::DivideAndRoundUp(NumPositions, ThreadGroupSize1D), 1, 1);
+			SplatCS->UnbindBuffers(RHICmdList);
+		}
+
+		RHICmdList.TransitionResource(EResourceTransitionAccess::EReadable, EResourceTransitionPipeline::EComputeToCompute, DepthUAV);
+
+		// Filter
+		TShaderMapRef<FPointCloudSurfaceFilterCS> FilterCS(ShaderMap);
+		RHICmdList.SetComputeShader(FilterCS->GetComputeShader());
+		FilterCS->SetParameters(RHICmdList, View, nullptr, 0, nullptr, DepthTexture, SurfaceUAV);
+		DispatchComputeShader(RHICmdList, *FilterCS, GroupsX, GroupsY, 1);
+		FilterCS->UnbindBuffers(RHICmdList);
+
+		RHICmdList.TransitionResource(EResourceTransitionAccess::EReadable, EResourceTransitionPipeline::EComputeToGfx, SurfaceUAV);
+
+		if (Target)
+		{
+			RHICmdList.CopyToResolveTarget(SurfaceTexture, Target->GetRenderTargetTexture(), FResolveParams());
+		}
+	}
+};
+
+////////////////////////////////////////////////////////////
+// CPU Fallback
+
+namespace
+{
+	/** Same as SplatCS, uses compare exchange instead of InterlockedMin */
+	void SplatOnCPU(const TArray<FVector>& Positions, const FPointCloudSurfaceView& View, TArray<uint32>& OutDepth)
+	{
+		OutDepth.Init(EmptyDepth, View.Size.X * View.Size.Y);
+
+		ParallelFor(Positions.Num(), [&](int32 i)
+		{
+			FVector ViewPosition = View.WorldToView.TransformPosition(Positions[i]);
+
+			if (ViewPosition.Z <= View.ParticleRadius)
+			{
+				return;
+			}
+
+			FVector2D Center = FVector2D(View.Size.X, View.Size.Y) * 0.5f + FVector2D(ViewPosition.X, -ViewPosition.Y) * View.ProjectionScale / ViewPosition.Z;
+			float PixelRadius = View.ParticleRadius * View.ProjectionScale / ViewPosition.Z;
+			int32 Radius = FMath::Min(FMath::CeilToInt(PixelRadius), MaxSplatRadius);
+
+			for (int32 y = (int32)Center.Y - Radius; y <= (int32)Center.Y + Radius; y++)
+			{
+				for (int32 x = (int32)Center.X - Radius; x <= (int32)Center.X + Radius; x++)
+				{
+					if (x < 0 || y < 0 || x >= View.Size.X || y >= View.Size.Y)
+					{
+						continue;
+					}
+
+					FVector2D Offset = (FVector2D(x + 0.5f, y + 0.5f) - Center) / PixelRadius;
+					float DistanceSquared = Offset.SizeSquared();
+
+					if (DistanceSquared <= 1)
+					{
+						int32 Depth = (int32)AsUint(ViewPosition.Z - View.ParticleRadius * FMath::Sqrt(1 - DistanceSquared));
+						int32* Pixel = (int32*)&OutDepth[y * View.Size.X + x];
+
+						for (int32 Current = *Pixel; Depth < Current;)
+						{
+							int32 Previous = FPlatformAtomics::InterlockedCompareExchange(Pixel, Depth, Current);
+							if (Previous == Current)
+							{
+								break;
+							}
+							Current = Previous;
+						}
+					}
+				}
+			}
+		});
+	}
+
+	/** Same as FilterCS */
+	void FilterOnCPU(const TArray<uint32>& Depth, const FPointCloudSurfaceView& View, TArray<float>& OutSurface)
+	{
+		OutSurface.SetNumUninitialized(View.Size.X * View.Size.Y);
+
+		const float SpatialFactor = 2.0f / FMath::Max(View.FilterRadius * View.FilterRadius, 1);
+		const float RangeFactor = 0.5f / FMath::Max(View.DepthFalloff * View.DepthFalloff, 1e-6f);
+
+		ParallelFor(View.Size.Y, [&](int32 y)
+		{
+			for (int32 x = 0; x < View.Size.X; x++)
+			{
+				uint32 CenterDepth = Depth[y * View.Size.X + x];
+
+				if (CenterDepth == EmptyDepth)
+				{
+					OutSurface[y * View.Size.X + x] = 0;
+					continue;
+				}
+
+				float Sum = 0;
+				float WeightSum = 0;
+
+				for (int32 j = -View.FilterRadius; j <= View.FilterRadius; j++)
+				{
+					for (int32 i = -View.FilterRadius; i <= View.FilterRadius; i++)
+					{
+						uint32 SampleDepth = Depth[FMath::Clamp(y + j, 0, View.Size.Y - 1) * View.Size.X + FMath::Clamp(x + i, 0, View.Size.X - 1)];
+
+						if (SampleDepth != EmptyDepth)
+						{
+							float Difference = AsFloat(SampleDepth) - AsFloat(CenterDepth);
+							float Weight = FMath::Exp(-(i * i + j * j) * SpatialFactor - Difference * Difference * RangeFactor);
+
+							Sum += AsFloat(SampleDepth) * Weight;
+							WeightSum += Weight;
+						}
+					}
+				}
+
+				OutSurface[y * View.Size.X + x] = Sum / WeightSum;
+			}
+		});
+	}
+}
+
+////////////////////////////////////////////////////////////
+// UPointCloudSurfaceComponent
+
+UPointCloudSurfaceComponent::UPointCloudSurfaceComponent(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+	, SurfaceTarget(nullptr)
+	, Resolution(1280, 720)
+	, ParticleRadius(5)
+	, FilterRadius(6)
+	, DepthFalloff(10)
+	, bRenderFromPlayerView(true)
+	, bForceCPUFallback(false)
+	, Resources(nullptr)
+{
+	PrimaryComponentTick.bCanEverTick = true;
+}
+
+void UPointCloudSurfaceComponent::SetPositions(const FVector* InPositions, int32 NumPositions)
+{
+	if (UsesCPUFallback())
+	{
+		Positions.SetNumUninitialized(NumPositions, false);
+		FMemory::Memcpy(Positions.GetData(), InPositions, NumPositions * sizeof(FVector));
+	}
+	else if (Resources)
+	{
+		// Copy the data, the game thread may write the next update before the render thread has uploaded this one
+		TArray<FVector> PositionData;
+		PositionData.AddUninitialized(NumPositions);
+		FMemory::Memcpy(PositionData.GetData(), InPositions, NumPositions * sizeof(FVector));
+
+		ENQUEUE_UNIQUE_RENDER_COMMAND_TWOPARAMETER(
+			UpdatePointCloudSurfacePositions,
+			FPointCloudSurfaceResources*, SurfaceResources, Resources,
+			TArray<FVector>, PositionData, PositionData,
+			{
+				SurfaceResources->UpdatePositions(PositionData);
+			});
+	}
+}
+
+void UPointCloudSurfaceComponent::RenderSurface(const FTransform& ViewTransform, float FOV)
+{
+	FPointCloudSurfaceView View;
+	View.WorldToView = ViewTransform.ToMatrixNoScale().Inverse() * FMatrix(FPlane(0, 0, 1, 0), FPlane(1, 0, 0, 0), FPlane(0, 1, 0, 0), FPlane(0, 0, 0, 1));
+	View.Size = GetSurfaceSize();
+	View.ProjectionScale = View.Size.X * 0.5f / FMath::Tan(FMath::DegreesToRadians(FMath::Clamp(FOV, 1.0f, 170.0f) * 0.5f));
+	View.ParticleRadius = ParticleRadius;
+	View.FilterRadius = FMath::Clamp(FilterRadius, 0, 16);
+	View.DepthFalloff = DepthFalloff;
+
+	if (UsesCPUFallback())
+	{
+		TArray<uint32> Depth;
+		SplatOnCPU(Positions, View, Depth);
+		FilterOnCPU(Depth, View, SurfaceDepth);
+
+		if (SurfaceTarget && !GUsingNullRHI)
+		{
+			TArray<float> SurfaceData = SurfaceDepth;
+
+			ENQUEUE_UNIQUE_RENDER_COMMAND_THREEPARAMETER(
+				UploadPointCloudSurface,
+				FTextureRenderTargetResource*, Target, SurfaceTarget->GameThread_GetRenderTargetResource(),
+				FIntPoint, Size, View.Size,
+				TArray<float>, SurfaceData, SurfaceData,
+				{
+					RHIUpdateTexture2D(Target->GetRenderTargetTexture(), 0, FUpdateTextureRegion2D(0, 0, 0, 0, Size.X, Size.Y), Size.X * sizeof(float), (const uint8*)SurfaceData.GetData());
+				});
+		}
+	}
+	else if (Resources && SurfaceTarget)
+	{
+		ENQUEUE_UNIQUE_RENDER_COMMAND_THREEPARAMETER(
+			RenderPointCloudSurface,
+			FPointCloudSurfaceResources*, SurfaceResources, Resources,
+			FPointCloudSurfaceView, View, View,
+			FTextureRenderTargetResource*, Target, SurfaceTarget->GameThread_GetRenderTargetResource(),
+			{
+				SurfaceResources->Render(RHICmdList, View, Target);
+			});
+	}
+}
+
+bool UPointCloudSurfaceComponent::UsesCPUFallback() const
+{
+	return bForceCPUFallback || GUsingNullRHI || GMaxRHIFeatureLevel < ERHIFeatureLevel::SM5;
+}
+
+FIntPoint UPointCloudSurfaceComponent::GetSurfaceSize() const
+{
+	return SurfaceTarget ? FIntPoint(SurfaceTarget->SizeX, SurfaceTarget->SizeY) : Resolution;
+}
+
+void UPointCloudSurfaceComponent::OnRegister()
+{
+	Super::OnRegister();
+
+	if (!Resources)
+	{
+		Resources = new FPointCloudSurfaceResources();
+	}
+
+	// The copy from the surface texture requires a matching format
+	if (SurfaceTarget && SurfaceTarget->GetFormat() != PF_R32_FLOAT)
+	{
+		PC_ERROR("Surface Target of %s has to use the R32f format", *GetName());
+		SurfaceTarget = nullptr;
+	}
+
+	if (!SurfaceTarget && !GUsingNullRHI)
+	{
+		SurfaceTarget = NewObject<UTextureRenderTarget2D>(this, NAME_None, RF_Transient);
+		SurfaceTarget->InitCustomFormat(Resolution.X, Resolution.Y, PF_R32_FLOAT, true);
+	}
+}
+
+void UPointCloudSurfaceComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	if (bRenderFromPlayerView && GetWorld())
+	{
+		APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+
+		if (PlayerController && PlayerController->PlayerCameraManager)
+		{
+			APlayerCameraManager* CameraManager = PlayerController->PlayerCameraManager;
+			RenderSurface(FTransform(CameraManager->GetCameraRotation(), CameraManager->GetCameraLocation()), CameraManager->GetFOVAngle());
+		}
+	}
+}
+
+void UPointCloudSurfaceComponent::BeginDestroy()
+{
+	Super::BeginDestroy();
+
+	if (Resources)
+	{
+		// Queued behind all commands still using the resources
+		ENQUEUE_UNIQUE_RENDER_COMMAND_ONEPARAMETER(
+			DeletePointCloudSurfaceResources,
+			FPointCloudSurfaceResources*, SurfaceResources, Resources,
+			{
+				delete SurfaceResources;
+			});
+
+		Resources = nullptr;
+	}
+}
@@ -158,6 +158,13 @@ public:
 	//UPROPERTY(EditAnywhere, BlueprintReadWrite, AdvancedDisplay, Category = "Performance")
 	//bool bPreloadVertexBuffer;
 
+	/**
+	 * Creates the Vertex Buffers as dynamic, which allows UpdatePointCloudData to upload new locations and colors without a full rebuild.
+	 * Useful for data which changes every frame, like simulations. Static buffers can be faster to render.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, AdvancedDisplay, Category = "Performance")
+	bool bDynamicVertexBuffer;
+
 	/**
 	 * Will shift LOD for each tile by the provided value.
 	 * Positive values will degrade density, negative values will increase it.
@@ -207,6 +214,14 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Rendering")
 	EPointCloudColorOverride ColorOverride;
 
+	/**
+	 * Colors the points by their scalar attributes on the GPU, if scalars were provided with the point data.
+	 * Applied with the other rendering parameters, so changing it requires no rebuild or upload of the points.
+	 * Has no effect in low precision, which drops the scalars, see UsesScalars.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Rendering")
+	FPointCloudScalarRamp ScalarRamp;
+
 	/** Minimum and Maximum sizes of the sprite */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Rendering|Sprite")
 	FVector2D SpriteSize;
@@ -269,6 +284,9 @@ private:
 	/** Flags that the Density or Noise Reduction parameters have changed and will re-run them during next Rebuild. */
 	bool bReductionDirty;
 
+	/** Flags that the last reduction may have disabled points, which are enabled again before the next one. Points disabled in the data set by the caller are kept. */
+	bool bReductionApplied;
+
 	/** Flags that the Section split parameters have changed and will re-run it during next Rebuild. */
 	bool bSectionDirty;
 
@@ -282,6 +300,9 @@ private:
 	//UPROPERTY()
 	TArray<FPointCloudPoint> Points;
 
+	/** Optional scalar attributes, one per point. Empty if the points only have colors */
+	TArray<FVector4> Scalars;
+
 	UPROPERTY(Transient)
 	UMaterialInterface *Material;
 	UPROPERTY(Transient)
@@ -305,6 +326,8 @@ public:
 
 	virtual FOnPointCloudChanged& OnPointCloudRebuilt() { return OnPointCloudRebuiltEvent; }
 	virtual FOnPointCloudChanged& OnPointCloudChanged() { return OnPointCloudChangedEvent; }
+	virtual FOnPointCloudChanged& OnPointCloudUpdated() { return OnPointCloudUpdatedEvent; }
+	virtual FOnPointCloudChanged& OnScalarRampChanged() { return OnScalarRampChangedEvent; }
 
 	UFUNCTION(BlueprintPure, Category = "Rendering")
 	FORCEINLINE bool UsesSprites() const { return bUsesSprites; }
@@ -372,6 +395,31 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Point Cloud")
 	void SetPointCloudData(UPARAM(ref) TArray<FPointCloudPoint> &InPoints, bool bRebuildCloud = true);
 
+	/**
+	 * Replaces the locations, colors and enabled states of the points, keeping the existing sections and index buffers.
+	 * Requires dynamic vertex buffers, an unchanged point count and disabled density and noise reduction,
+	 * otherwise falls back to a full rebuild. Sections whose number of enabled points changed rebuild only their buffers.
+	 * Returns true if the data could be updated in place.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Point Cloud")
+	bool UpdatePointCloudData(UPARAM(ref) TArray<FPointCloudPoint> &InPoints);
+
+	/** Same as UpdatePointCloudData, also replacing the scalar attributes colored by the ScalarRamp. InScalars needs one element per point. */
+	bool UpdatePointCloudData(TArray<FPointCloudPoint> &InPoints, const TArray<FVector4> &InScalars);
+
+	/**
+	 * Replaces the locations and colors of the points with vertices already in the layout of the Vertex Buffer, in a single pass per section.
+	 * Has the requirements of UpdatePointCloudData and full precision. Returns false without rebuilding if the data cannot be updated in place.
+	 * InScalars has to be provided, with one element per vertex, if and only if the cloud was built with scalars.
+	 */
+	bool UpdatePointCloudVertices(const FPointCloudVertex* InVertices, int32 NumVertices, const FVector4* InScalars = nullptr);
+
+	/** Return the scalar attributes of the points, empty if there are none */
+	FORCEINLINE const TArray<FVector4>& GetScalarData() const { return Scalars; }
+
+	/** Returns true if the Vertex Buffers carry scalar attributes. Requires full precision, the low precision layout has no room for them. */
+	FORCEINLINE bool UsesScalars() { return Scalars.Num() > 0 && Scalars.Num() == Points.Num() && !UsesLowPrecision(); }
+
 	/** Bulk sets the new settings from the ones provided */
 	void SetSettings(UPointCloudSettings *Settings);
 
@@ -381,4 +429,9 @@ private:
 
 	FOnPointCloudChanged OnPointCloudChangedEvent;
 	FOnPointCloudChanged OnPointCloudRebuiltEvent;
+	FOnPointCloudChanged OnPointCloudUpdatedEvent;
+	FOnPointCloudChanged OnScalarRampChangedEvent;
+
+	/** Last ramp sent to the render thread, so it is only sent again when it changes */
+	FPointCloudScalarRamp AppliedScalarRamp;
 };
\ No newline at end of file
@@ -53,4 +53,6 @@ public:
 protected:
 	void RebuildComponents();
 	void OnPointCloudRebuilt();
+	void OnPointCloudUpdated();
+	void OnScalarRampChanged();
 };
\ No newline at end of file
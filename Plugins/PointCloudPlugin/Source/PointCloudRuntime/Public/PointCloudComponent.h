@@ -9,6 +9,7 @@
 
 class FPointCloudSceneProxy;
 class FPointCloudSection;
+struct FPointCloudScalarRamp;
 
 /** Component that allows you to render specified point cloud section */
 UCLASS(ClassGroup=Rendering, hidecategories = (Object, LOD, Physics, Collision, Materials))
@@ -23,6 +24,12 @@ public:
 	FPointCloudSection* GetSection() const { return Section; }
 	void SetSection(FPointCloudSection *InSection);
 
+	/** Uploads the current vertex data of the section to the existing render resources, without recreating the render state */
+	void UpdateSectionData();
+
+	/** Passes the scalar ramp to the existing render resources, new ones take it from the cloud */
+	void UpdateScalarRamp(const FPointCloudScalarRamp& ScalarRamp);
+
 	// Begin UActorComponent Interface
 	virtual void DestroyComponent(bool bPromoteChildren = false) override;
 	// End UActorComponent Interface
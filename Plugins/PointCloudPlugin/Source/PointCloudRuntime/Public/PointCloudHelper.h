@@ -34,6 +34,7 @@ public:
 	/**
 	 * Attempts to parse the given data as Text input.
 	 * Outputs arrays for Locations and Colors (if available).
+	 * The file is memory mapped if supported and parsed in parallel chunks of lines.
 	 * Returns true if the parsing was successful.
 	 */
 	static bool ImportAsText(const FString& Filename, TArray<FPointCloudPoint>& OutPoints, EPointCloudColorMode &ColorMode, uint32 FirstIndex, uint32 LastIndex, FPointCloudFileHeader PointCloudFileHeader);
@@ -45,11 +46,19 @@ public:
 	static FVector2D ReadFileMinMaxColumn(const FString& Filename, int32 ColumnIndex);
 	static FVector2D ReadFileMinMaxColumns(const FString& Filename, TArray<int32> Columns);
 	static FVector2D ReadFileMinMaxColumns(const uint8 *DataPtr, uint8 Delimiter, TArray<int32> Columns);
+	static FVector2D ReadFileMinMaxColumns(const uint8 *Data, int64 Size, uint8 Delimiter, TArray<int32> Columns);
 
-	/** Reduces the density of the points using provided settings. */
+	/**
+	 * Reduces the density of the points using provided settings.
+	 * Uses a uniform grid with the cell size of the distance, O(N log N) for the grid and O(N * K) for the reduction, with K being the number of points in the surrounding cells.
+	 * UPointCloud::Rebuild logs the wall time of both reductions.
+	 */
 	static void DensityReduction(TArray<FPointCloudPoint>& Points, const float MinDistanceBetweenPoints);
 
-	/** Attempts to reduce the noise in the point cloud using settings provided. */
+	/**
+	 * Attempts to reduce the noise in the point cloud using settings provided.
+	 * Uses the same grid as DensityReduction, the neighbor search stops as soon as MinPointDensity neighbors are found.
+	 */
 	static void NoiseReduction(TArray<FPointCloudPoint>& Points, const float MaxDistanceBetweenPoints, const int32 MinPointDensity);
 
 	/**
@@ -82,6 +91,12 @@ public:
 	static FBox CalculateBounds(const TArray<FPointCloudPoint*>& Points, const FTransform& Transform);
 	static FBox CalculateBounds(const TArray<FPointCloudPoint>& Points, const FTransform& Transform);
 
+	/**
+	 * Returns the number of batches to split the given amount of items into for parallel processing.
+	 * Uses at most one batch per worker thread and at least MinBatchSize items per batch.
+	 */
+	static int32 CalculateNumBatches(int32 NumItems, int32 MinBatchSize = 5000);
+
 	/** Returns VRAM used by a single point, in bytes */
 	static int32 CalculatePointSize(UPointCloud *PointCloud, bool bIncludeIB = true);
 
@@ -7,6 +7,7 @@
 class UPointCloud;
 class UMaterialInterface;
 struct FPointCloudPoint;
+struct FPointCloudVertex;
 class IPointCloudSectionProxy;
 
 class FPointCloudSection 
@@ -25,6 +26,8 @@ private:
 	/** Holds raw data for the buffers */
 	uint8* VertexBuffer;
 	uint32 VertexBufferSize;
+	uint8* ScalarBuffer;	// Only if the cloud uses scalars, one FVector4 per vertex
+	uint32 ScalarBufferSize;
 	uint8* IndexBuffer;
 	uint8* IndexBufferSpecial;	// For view mode overrides if using sprites
 	uint32 IndexBufferSize;
@@ -38,7 +41,8 @@ private:
 	FMatrix ProjectionMatrix;
 
 public:
-	FPointCloudSection(UPointCloud *InCloud, const TArray<FPointCloudPoint*> InPoints);
+	/** Buffers can be built later with Rebuild, which allows building multiple sections in parallel */
+	FPointCloudSection(UPointCloud *InCloud, const TArray<FPointCloudPoint*> InPoints, bool bBuildBuffers = true);
 	~FPointCloudSection();
 
 	IPointCloudSectionProxy* BuildProxy();
@@ -52,6 +56,21 @@ public:
 
 	void Rebuild(bool bBuildVB, bool bBuildIB);
 
+	/** Rewrites the existing Vertex Buffer with the current point data. Returns false if the amount of vertices has changed. */
+	bool UpdateVB();
+
+	/**
+	 * Rewrites the existing Vertex Buffer from vertices indexed like the points of the cloud, applying the given offset and scale.
+	 * Requires full precision and all points of the section to be enabled, returns false otherwise.
+	 */
+	bool UpdateVB(const FPointCloudVertex* InVertices, const FVector& Offset, const FVector& Scale);
+
+	/** Returns the raw vertex data, used to upload it to the existing render resources */
+	FORCEINLINE const uint8* GetVertexBufferData() const { return VertexBuffer; }
+	FORCEINLINE uint32 GetVertexBufferSize() const { return VertexBufferSize; }
+	FORCEINLINE const uint8* GetScalarBufferData() const { return ScalarBuffer; }
+	FORCEINLINE uint32 GetScalarBufferSize() const { return ScalarBufferSize; }
+
 private:
 	void Dispose(bool bVB, bool bIB);
 
@@ -60,5 +79,7 @@ private:
 	FORCEINLINE double CalculateSkip(int32 LODLevel) const { return ((double)1) / FMath::Pow(1 - FMath::Clamp(Cloud->LODReduction, 0.0f, 1.0f), LODLevel); }
 
 	void BuildVB();
+	void WriteVB(const TArray<FPointCloudPoint*>& EnabledPoints);
+	void WriteScalars(const TArray<FPointCloudPoint*>& EnabledPoints);
 	void BuildIBAndLOD();
 };
@@ -15,6 +15,9 @@
 #define PC_LOG(Format, ...) UE_LOG(LogTemp, Warning, TEXT(Format), __VA_ARGS__)
 #define PC_ERROR(Format, ...) UE_LOG(LogTemp, Error, TEXT(Format), __VA_ARGS__)
 
+/** Scalar attribute value of points which are not colored by the scalar ramp, these keep their own color */
+#define PC_NO_SCALAR (-MAX_FLT)
+
 UENUM(BlueprintType)
 enum class EPointCloudOffset : uint8
 {
@@ -88,6 +91,66 @@ struct POINTCLOUDRUNTIME_API FPointCloudPoint
 	FORCEINLINE FString ToString() { return FString::Printf(TEXT("E: %s, OL: %s, L: %s, C: %s"), BOOL2STR(bEnabled), *OriginalLocation.ToString(), *Location.ToString(), *Color.ToString()); }
 };
 
+/**
+ * Vertex layout of the full precision Vertex Buffer, must match the vertex factory.
+ * Data kept in this layout can be uploaded with UPointCloud::UpdatePointCloudVertices without converting it to points first.
+ */
+struct POINTCLOUDRUNTIME_API FPointCloudVertex
+{
+	FVector Location;
+	FColor Color;
+
+	FPointCloudVertex() {}
+	FPointCloudVertex(const FVector& InLocation, const FColor& InColor)
+		: Location(InLocation)
+		, Color(InColor)
+	{}
+};
+
+/**
+ * Colors points by one of their four scalar attributes in the vertex factory, so switching the attribute or its limits does not touch the point data.
+ * Scalars below Min map to LowColor, above Max to HighColor, with MidColor halfway in between.
+ */
+USTRUCT(BlueprintType)
+struct POINTCLOUDRUNTIME_API FPointCloudScalarRamp
+{
+	GENERATED_BODY()
+
+	/** Component of the scalar attributes to color by, INDEX_NONE keeps the colors of the points */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Scalar Ramp", meta = (ClampMin = "-1", ClampMax = "3"))
+	int32 ScalarIndex;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Scalar Ramp")
+	float Min;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Scalar Ramp")
+	float Max;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Scalar Ramp")
+	FLinearColor LowColor;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Scalar Ramp")
+	FLinearColor MidColor;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Scalar Ramp")
+	FLinearColor HighColor;
+
+	FPointCloudScalarRamp()
+		: ScalarIndex(INDEX_NONE)
+		, Min(0)
+		, Max(1)
+		, LowColor(FLinearColor::White)
+		, MidColor(1, 0.5f, 0.5f)
+		, HighColor(FLinearColor::Red)
+	{}
+
+	bool operator==(const FPointCloudScalarRamp& Other) const
+	{
+		return ScalarIndex == Other.ScalarIndex && Min == Other.Min && Max == Other.Max && LowColor == Other.LowColor && MidColor == Other.MidColor && HighColor == Other.HighColor;
+	}
+	bool operator!=(const FPointCloudScalarRamp& Other) const { return !(*this == Other); }
+};
+
 /** Used for importing text-based files. */
 USTRUCT(BlueprintType)
 struct POINTCLOUDRUNTIME_API FPointCloudFileHeader
@@ -0,0 +1,87 @@
+// Copyright 2018 Michal Cieciura. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/SceneComponent.h"
+#include "PointCloudSurfaceComponent.generated.h"
+
+class UTextureRenderTarget2D;
+class FPointCloudSurfaceResources;
+
+/**
+ * Renders a liquid surface directly from raw positions, without building point cloud sections.
+ * Positions are uploaded once per update to a structured buffer, splatted as spheres into a depth buffer and smoothed with a bilateral filter.
+ * The result is the view space depth of the surface (0 where there is none) in SurfaceTarget, to be shaded by a post process material.
+ * Without compute shader support (e.g. NullRHI) the same passes run on the CPU.
+ */
+UCLASS(ClassGroup=Rendering, meta = (BlueprintSpawnableComponent))
+class POINTCLOUDRUNTIME_API UPointCloudSurfaceComponent : public USceneComponent
+{
+	GENERATED_UCLASS_BODY()
+
+public:
+	/** Receives the smoothed surface depth. Created with the given Resolution if not set. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Surface")
+	UTextureRenderTarget2D* SurfaceTarget;
+
+	/** Resolution of the surface, if the SurfaceTarget is created automatically or not available. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Surface")
+	FIntPoint Resolution;
+
+	/** Radius of the spheres splatted for each position. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Surface", meta = (ClampMin = "0.01"))
+	float ParticleRadius;
+
+	/** Radius of the smoothing filter, in pixels. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Surface", meta = (ClampMin = "0", ClampMax = "16"))
+	int32 FilterRadius;
+
+	/** Depth difference at which neighboring pixels stop being smoothed together, keeps separate layers of liquid apart. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Surface", meta = (ClampMin = "0.01"))
+	float DepthFalloff;
+
+	/** If enabled, the surface is rendered from the view of the first player camera every tick. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Surface")
+	bool bRenderFromPlayerView;
+
+	/** Runs the passes on the CPU even if compute shaders are supported. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, AdvancedDisplay, Category = "Surface")
+	bool bForceCPUFallback;
+
+private:
+	FPointCloudSurfaceResources *Resources;
+
+	/** Copy of the positions, only kept for the CPU fallback */
+	TArray<FVector> Positions;
+
+	/** Result of the CPU fallback */
+	TArray<float> SurfaceDepth;
+
+public:
+	/** Uploads the given world space positions, replacing the previous ones. */
+	void SetPositions(const FVector* InPositions, int32 NumPositions);
+
+	/** Renders the surface as seen from the given view. */
+	UFUNCTION(BlueprintCallable, Category = "Surface")
+	void RenderSurface(const FTransform& ViewTransform, float FOV = 90);
+
+	/** Returns true if the passes run on the CPU. */
+	UFUNCTION(BlueprintPure, Category = "Surface")
+	bool UsesCPUFallback() const;
+
+	/** Returns the size of the surface in pixels. */
+	FIntPoint GetSurfaceSize() const;
+
+	/** Returns the result of the last CPU fallback render, row by row. */
+	const TArray<float>& GetSurfaceDepth() const { return SurfaceDepth; }
+
+	// Begin UActorComponent Interface
+	virtual void OnRegister() override;
+	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction) override;
+	// End UActorComponent Interface
+
+	// Begin UObject Interface.
+	virtual void BeginDestroy() override;
+	// End UObject Interface.
+};
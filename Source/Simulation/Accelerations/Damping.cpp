@@ -21,6 +21,9 @@ void UDamping::ApplyAcceleration(UParticleContext * particleContext)
 	for (UFluid * fluid : particleContext->GetFluids()) {
 		ParallelFor(fluid->Particles->size(), [&](int32 i) {
 			Particle& particle = fluid->Particles->at(i);
+			if (!particle.IsActiveInStep) {
+				return;
+			}
 			particle.Acceleration += -DampingFactor * particle.Velocity / particle.Mass;
 		});
 	}
@@ -22,6 +22,9 @@ void UPointGravity::ApplyAcceleration(UParticleContext * particleContext)
 	for (UFluid * fluid : particleContext->GetFluids()) {
 		ParallelFor(fluid->Particles->size(), [&](int32 i) {
 			Particle& particle = fluid->Particles->at(i);
+			if (!particle.IsActiveInStep) {
+				return;
+			}
 			particle.Acceleration += (Midpoint - particle.Position).Normalized() * Magnitude;
 		});
 	}
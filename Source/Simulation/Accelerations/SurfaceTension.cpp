@@ -21,9 +21,13 @@ void USurfaceTension::ApplyAcceleration(UParticleContext * particleContext)
 	for (UFluid * fluid : particleContext->GetFluids()) {
 		ParallelFor(fluid->Particles->size(), [&](int32 i) {
 			Particle& f = fluid->Particles->at(i);
+			if (!f.IsActiveInStep) {
+				return;
+			}
 			for (const Particle& ff : f.FluidNeighbors) {
-				if ((ff.Position - f.Position).Size() > particleContext->GetParticleDistance()) {
-					f.Acceleration += -SurfaceTensionFactor * ff.Mass * (f.Position - ff.Position).Normalized() * GetKernel()->ComputeValue(f, ff);
+				Vector3D xij = GetKernel()->GetDistanceVector(f.Position, ff.Position);
+				if (xij.Size() > particleContext->GetParticleDistance()) {
+					f.Acceleration += -SurfaceTensionFactor * ff.Mass * xij.Normalized() * GetKernel()->ComputeValue(f, ff);
 				}
 			}
 		});
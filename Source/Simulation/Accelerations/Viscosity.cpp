@@ -20,13 +20,16 @@ void UViscosity::ApplyAcceleration(UParticleContext * particleContext)
 	for (UFluid * fluid : particleContext->GetFluids()) {
 		ParallelFor(fluid->Particles->size(), [&](int32 i) {
 			Particle& f = fluid->Particles->at(i);
+			if (!f.IsActiveInStep) {
+				return;
+			}
 
 			Vector3D sum = { 0, 0, 0 };
 
 			for (const Particle& ff : f.FluidNeighbors) {
 
 				Vector3D vij = f.Velocity - ff.Velocity;
-				Vector3D xij = f.Position - ff.Position;
+				Vector3D xij = GetKernel()->GetDistanceVector(f.Position, ff.Position);
 				sum += ff.Fluid->GetViscosity() * ff.Mass / ff.Fluid->GetRestDensity() * vij * (xij * GetKernel()->ComputeGradient(f, ff)) / ((xij* xij) + 0.01 * pow(GetKernel()->GetParticleSpacing(), 2));
 
 			}
@@ -35,7 +38,7 @@ void UViscosity::ApplyAcceleration(UParticleContext * particleContext)
 
 				// Mimic ghost velocities
 				Vector3D vij = f.Velocity - fb.Velocity;
-				Vector3D xij = f.Position - fb.Position;
+				Vector3D xij = GetKernel()->GetDistanceVector(f.Position, fb.Position);
 				sum += fb.Border->BorderFriction * fb.Mass / f.Fluid->GetRestDensity() * vij * (xij * GetKernel()->ComputeGradient(f, fb)) / ((xij* xij) + 0.01 * pow(GetKernel()->GetParticleSpacing(), 2));
 			}
 
@@ -12,7 +12,7 @@
 
 
 template <typename Item, typename Value>
-inline Value ParallelSum(const std::vector<Item>& vector, std::function<Value(Item)> valueGetter) {
+inline Value ParallelSum(const std::vector<Item>& vector, std::function<Value(const Item&)> valueGetter) {
 
 	// Determine total size.
 	const unsigned int size = vector.size();
@@ -29,7 +29,7 @@ inline Value ParallelSum(const std::vector<Item>& vector, std::function<Value(It
 		const auto partSize = (size * i + size) / parts - (size * i) / parts;
 
 		futures.emplace_back(Async<Value>(EAsyncExecution::TaskGraph, [first, partSize, &valueGetter]() -> Value {
-			return std::accumulate(first, std::next(first, partSize), 0.0, [&valueGetter](const Value prev, const Item next) -> Value { return prev + valueGetter(next); });
+			return std::accumulate(first, std::next(first, partSize), 0.0, [&valueGetter](const Value prev, const Item& next) -> Value { return prev + valueGetter(next); });
 		}));
 		std::advance(first, partSize);
 	}
@@ -42,17 +42,17 @@ inline Value ParallelSum(const std::vector<Item>& vector, std::function<Value(It
 
 template <typename Item>
 inline Item ParallelSum(const std::vector<Item>& vector) {
-	return ParallelSum<Item, Item>(vector, [&](Item item) { return item; });
+	return ParallelSum<Item, Item>(vector, [&](const Item& item) { return item; });
 }
 
 template <typename Item, typename Value>
-inline Value ParallelMax(const std::vector<Item>& vector, std::function<Value(Item)> valueGetter, int minElementsForParallel = 10000) {
+inline Value ParallelMax(const std::vector<Item>& vector, std::function<Value(const Item&)> valueGetter, int minElementsForParallel = 10000) {
 
 	if (vector.size() == 0)
 		throw("Vector shall not be empty");
 
 	if (vector.size() < minElementsForParallel || std::thread::hardware_concurrency() >= vector.size()) {
-		return valueGetter(*std::max_element(std::begin(vector), std::end(vector), [&valueGetter](Item p1, Item p2) -> bool { return valueGetter(p1) < valueGetter(p2); }));
+		return valueGetter(*std::max_element(std::begin(vector), std::end(vector), [&valueGetter](const Item& p1, const Item& p2) -> bool { return valueGetter(p1) < valueGetter(p2); }));
 	}
 
 	// Determine how many parts the work shall be split into.
@@ -69,7 +69,7 @@ inline Value ParallelMax(const std::vector<Item>& vector, std::function<Value(It
 		futures.emplace_back(std::async(std::launch::async, [first, partSize, &vector, &valueGetter]() -> Value {
 
 			std::vector<Item>::const_iterator end = std::next(first, partSize);
-			return valueGetter(*std::max_element(first, end, [&valueGetter](Item p1, Item p2) -> bool { return valueGetter(p1) < valueGetter(p2);
+			return valueGetter(*std::max_element(first, end, [&valueGetter](const Item& p1, const Item& p2) -> bool { return valueGetter(p1) < valueGetter(p2);
 			}));
 		}));
 
@@ -86,17 +86,17 @@ inline Item ParallelMax(const std::vector<Item>& vector) {
 	if (vector.size() == 0) 
 		throw("Cant find maximum element in empty vector");
 
-	return ParallelMax<Item, Item>(vector, [](Item item) { return item; });
+	return ParallelMax<Item, Item>(vector, [](const Item& item) { return item; });
 }
 
 template <typename Item, typename Value>
-inline Value ParallelMin(const std::vector<Item>& vector, std::function<Value(Item)> valueGetter, int minElementsForParallel = 10000) {
+inline Value ParallelMin(const std::vector<Item>& vector, std::function<Value(const Item&)> valueGetter, int minElementsForParallel = 10000) {
 
 	if (vector.size() == 0)
 		throw("Vector shall not be empty");
 
 	if (vector.size() < minElementsForParallel || std::thread::hardware_concurrency() >= vector.size()) {
-		return valueGetter(*std::min_element(std::begin(vector), std::end(vector), [&valueGetter](Item p1, Item p2) -> bool { return valueGetter(p1) < valueGetter(p2); }));
+		return valueGetter(*std::min_element(std::begin(vector), std::end(vector), [&valueGetter](const Item& p1, const Item& p2) -> bool { return valueGetter(p1) < valueGetter(p2); }));
 	}
 
 	// Determine how many parts the work shall be split into.
@@ -113,7 +113,7 @@ inline Value ParallelMin(const std::vector<Item>& vector, std::function<Value(It
 		futures.emplace_back(std::async(std::launch::async, [first, partSize, &vector, &valueGetter]() -> Value {
 
 			std::vector<Item>::const_iterator end = std::next(first, partSize);
-			return valueGetter(*std::min_element(first, end, [&valueGetter](Item p1, Item p2) -> bool { return valueGetter(p1) < valueGetter(p2);
+			return valueGetter(*std::min_element(first, end, [&valueGetter](const Item& p1, const Item& p2) -> bool { return valueGetter(p1) < valueGetter(p2);
 			}));
 		}));
 
@@ -130,11 +130,11 @@ inline Item ParallelMin(const std::vector<Item>& vector) {
 	if (vector.size() == 0)
 		throw("Cant find maximum element in empty vector");
 
-	return ParallelMin<Item, Item>(vector, [](Item item) { return item; });
+	return ParallelMin<Item, Item>(vector, [](const Item& item) { return item; });
 }
 
 template <typename Item>
-inline bool ParallelExists(const std::vector<Item>& vector, std::function<bool(Item)> valueGetter, int minElementsForParallel = 10000) {
+inline bool ParallelExists(const std::vector<Item>& vector, std::function<bool(const Item&)> valueGetter, int minElementsForParallel = 10000) {
 
 	if (vector.size() == 0) {
 		return false;
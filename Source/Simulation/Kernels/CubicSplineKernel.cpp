@@ -17,18 +17,24 @@ UCubicSplineKernel * UCubicSplineKernel::CreateCubicSplineKernel(float supportRa
 
 double UCubicSplineKernel::ComputeValue(const Particle & particle1, const Particle & particle2) const
 {
-	return UCubicSplineKernel::ComputeValue(particle1.Position, particle2.Position);
+	return ComputeScaledValue(particle1.Position, particle2.Position, GetPairSmoothingScale(particle1, particle2));
 }
 
 double UCubicSplineKernel::ComputeValue(const Vector3D& position1, const Vector3D& position2) const
 {
-	double q = 2 * (position1 - position2).Size() / (SupportRange * ParticleSpacing);
+	return ComputeScaledValue(position1, position2, 1.0);
+}
+
+double UCubicSplineKernel::ComputeScaledValue(const Vector3D& position1, const Vector3D& position2, double smoothingScale) const
+{
+	double q = 2 * GetDistanceVector(position1, position2).Size() / (SupportRange * ParticleSpacing * smoothingScale);
+	double prefactor = Prefactor * GetScaledPrefactorFactor(smoothingScale);
 
 	if (0 <= q && q < 1) {
-		return (pow((2 - q), 3) - 4 * pow((1 - q), 3)) * Prefactor;
+		return (pow((2 - q), 3) - 4 * pow((1 - q), 3)) * prefactor;
 	}
 	if (1 <= q && q < 2) {
-		return pow((2 - q), 3) * Prefactor;
+		return pow((2 - q), 3) * prefactor;
 	}
 	if (2 <= q) {
 		return 0;
@@ -43,14 +49,20 @@ double UCubicSplineKernel::ComputeValue(const Vector3D& position1, const Vector3
 
 Vector3D UCubicSplineKernel::ComputeGradient(const Particle & particle1, const Particle & particle2) const
 {
-	return UCubicSplineKernel::ComputeGradient(particle1.Position, particle2.Position);
+	return ComputeScaledGradient(particle1.Position, particle2.Position, GetPairSmoothingScale(particle1, particle2));
 }
 
 Vector3D UCubicSplineKernel::ComputeGradient(const Vector3D& position1, const Vector3D& position2) const
 {
-	Vector3D PositionDifference = position1 - position2;
-	double q = 2 * (position1 - position2).Size() / (SupportRange * ParticleSpacing);
-	Vector3D gradientq = 2 * PositionDifference / (PositionDifference.Size() * ParticleSpacing * SupportRange);
+	return ComputeScaledGradient(position1, position2, 1.0);
+}
+
+Vector3D UCubicSplineKernel::ComputeScaledGradient(const Vector3D& position1, const Vector3D& position2, double smoothingScale) const
+{
+	Vector3D PositionDifference = GetDistanceVector(position1, position2);
+	double q = 2 * PositionDifference.Size() / (SupportRange * ParticleSpacing * smoothingScale);
+	Vector3D gradientq = 2 * PositionDifference / (PositionDifference.Size() * ParticleSpacing * smoothingScale * SupportRange);
+	double prefactor = Prefactor * GetScaledPrefactorFactor(smoothingScale);
 
 	// No pressure direction if they're at the same location 
 	if (q == 0) {
@@ -58,10 +70,10 @@ Vector3D UCubicSplineKernel::ComputeGradient(const Vector3D& position1, const Ve
 	}
 
 	if (0 <= q && q < 1) {
-		return Prefactor * gradientq * (-3 * pow(2 - q, 2) + 12 * pow(1 - q, 2));
+		return prefactor * gradientq * (-3 * pow(2 - q, 2) + 12 * pow(1 - q, 2));
 	}
 	if (1 <= q && q < 2) {
-		return Prefactor * gradientq * -3 * pow(2 - q, 2);
+		return prefactor * gradientq * -3 * pow(2 - q, 2);
 	}
 	if (2 <= q) {
 		return { 0, 0, 0 };
@@ -22,5 +22,9 @@ public:
 protected:
 	void ComputePrefactor() override;
 
+	// Kernel with the support stretched by the smoothing scale, used for particles of adaptive resolution
+	double ComputeScaledValue(const Vector3D& position1, const Vector3D& position2, double smoothingScale) const;
+	Vector3D ComputeScaledGradient(const Vector3D& position1, const Vector3D& position2, double smoothingScale) const;
+
 	double Prefactor;
 };
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "Kernel.h"
+#include "Simulator.h"
 
 UKernel::~UKernel()
 {
@@ -14,6 +15,36 @@ double UKernel::GetSupportRange() const
 	return SupportRange;
 }
 
+void UKernel::SetPeriodicCondition(const UPeriodicCondition * periodicCondition)
+{
+	PeriodicCondition = periodicCondition;
+}
+
+Vector3D UKernel::GetDistanceVector(const Vector3D& position1, const Vector3D& position2) const
+{
+	if (PeriodicCondition != nullptr) {
+		return PeriodicCondition->GetMinimumImage(position1 - position2);
+	}
+	return position1 - position2;
+}
+
+double UKernel::GetPairSmoothingScale(const Particle & particle1, const Particle & particle2)
+{
+	return 0.5 * (particle1.SmoothingScale + particle2.SmoothingScale);
+}
+
+double UKernel::GetScaledPrefactorFactor(double smoothingScale) const
+{
+	switch (Dimensionality) {
+	case EDimensionality::One:
+		return 1.0 / smoothingScale;
+	case EDimensionality::Two:
+		return 1.0 / (smoothingScale * smoothingScale);
+	default:
+		return 1.0 / (smoothingScale * smoothingScale * smoothingScale);
+	}
+}
+
 void UKernel::ComputePrefactor()
 {
 	throw("Thisis an abstrakt function and should never be called");
@@ -6,6 +6,7 @@
 #include "Kernel.generated.h"
 
 enum EDimensionality;
+class UPeriodicCondition;
 
 UCLASS()
 class UKernel : public UObject{
@@ -25,8 +26,20 @@ public:
 	double GetParticleSpacing() const;
 	double GetSupportRange() const;
 
+	// Distances are measured to the nearest periodic image of a particle if a periodic condition is set
+	void SetPeriodicCondition(const UPeriodicCondition * periodicCondition);
+
+	// Vector from position2 to position1, across the periodic limit if that is shorter
+	Vector3D GetDistanceVector(const Vector3D& position1, const Vector3D& position2) const;
+
 protected:
 
+	// Symmetric smoothing scale of a particle pair, so both particles see the same interaction
+	static double GetPairSmoothingScale(const Particle & particle1, const Particle & particle2);
+
+	// Factor the prefactor is multiplied with if the support is stretched by the smoothing scale
+	double GetScaledPrefactorFactor(double smoothingScale) const;
+
 	virtual void ComputePrefactor();
 
 	double ParticleSpacing;
@@ -35,4 +48,6 @@ protected:
 	double SupportRange;
 
 	EDimensionality Dimensionality;
+
+	const UPeriodicCondition * PeriodicCondition = nullptr;
 };
\ No newline at end of file
@@ -17,28 +17,44 @@ UWendland * UWendland::CreateWendlandKernel(float supportRange)
 
 double UWendland::ComputeValue(const Particle & particle1, const Particle & particle2) const
 {
-	return UWendland::ComputeValue(particle1.Position, particle2.Position);
+	return ComputeScaledValue(particle1.Position, particle2.Position, GetPairSmoothingScale(particle1, particle2));
 }
 
 double UWendland::ComputeValue(const Vector3D& position1, const Vector3D& position2) const
 {
-	double q = 2 * (position1 - position2).Size() / (SupportRange * ParticleSpacing);
-	return pow(1 - q / 2, 4) * (2 * q + 1) * Prefactor;
+	return ComputeScaledValue(position1, position2, 1.0);
+}
+
+double UWendland::ComputeScaledValue(const Vector3D& position1, const Vector3D& position2, double smoothingScale) const
+{
+	double q = 2 * GetDistanceVector(position1, position2).Size() / (SupportRange * ParticleSpacing * smoothingScale);
+	double prefactor = Prefactor * GetScaledPrefactorFactor(smoothingScale);
+
+	if (q >= 2) {
+		return 0;
+	}
+	return pow(1 - q / 2, 4) * (2 * q + 1) * prefactor;
 }
 
 Vector3D UWendland::ComputeGradient(const Particle & particle1, const Particle & particle2) const
 {
-	return UWendland::ComputeGradient(particle1.Position, particle2.Position);
+	return ComputeScaledGradient(particle1.Position, particle2.Position, GetPairSmoothingScale(particle1, particle2));
 }
 
 Vector3D UWendland::ComputeGradient(const Vector3D& position1, const Vector3D& position2) const
 {
-	Vector3D PositionDifference = position1 - position2;
-	double q = 2 * (position1 - position2).Size() / (SupportRange * ParticleSpacing);
-	Vector3D gradientq = 2 * PositionDifference / (PositionDifference.Size() * ParticleSpacing * SupportRange);
+	return ComputeScaledGradient(position1, position2, 1.0);
+}
+
+Vector3D UWendland::ComputeScaledGradient(const Vector3D& position1, const Vector3D& position2, double smoothingScale) const
+{
+	Vector3D PositionDifference = GetDistanceVector(position1, position2);
+	double q = 2 * PositionDifference.Size() / (SupportRange * ParticleSpacing * smoothingScale);
+	Vector3D gradientq = 2 * PositionDifference / (PositionDifference.Size() * ParticleSpacing * smoothingScale * SupportRange);
+	double prefactor = Prefactor * GetScaledPrefactorFactor(smoothingScale);
 
 	if (0 < q && q < 2) {
-		return Prefactor * -5 * gradientq * q * pow(1 - 0.5 * q, 3);
+		return prefactor * -5 * gradientq * q * pow(1 - 0.5 * q, 3);
 	}
 	// No pressure direction if they're at the same location 
 	return Vector3D::Zero;
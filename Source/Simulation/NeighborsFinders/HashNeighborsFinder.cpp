@@ -1,4 +1,5 @@
 #include "HashNeighborsFinder.h"
+#include "Kernels/Kernel.h"
 
 UHashNeighborsFinder::~UHashNeighborsFinder()
 {
@@ -29,26 +30,30 @@ void UHashNeighborsFinder::AddStaticParticles(std::vector<UStaticBorder*>& borde
 }
 
 void UHashNeighborsFinder::AddStaticParticles(UStaticBorder * border, double particleDistance) {
+	UpdateCellLayout(SupportRange * particleDistance);
+
 	for (int i = 0; i < border->Particles->size(); i++) {
 		Particle& b = border->Particles->at(i);
 
-		int x = GetHash(b, SupportRange * particleDistance);
+		int hash = GetCellHash(b.Position);
 
-		if (StaticHashtable.count(GetHash(b, SupportRange * particleDistance)) == 1) {
+		if (StaticHashtable.count(hash) == 1) {
 			// if there is already a list at this box, just add the neighbor entry
-			StaticHashtable.at(GetHash(b, SupportRange * particleDistance)).emplace_back(i, b);
+			StaticHashtable.at(hash).emplace_back(i, b);
 		}
 		else {
 
 			// Create new list at Hash and add the neighbor entry
-			StaticHashtable.insert(std::pair<int, std::vector<StaticBorderNeighbor>>(GetHash(b, SupportRange * particleDistance), std::vector<StaticBorderNeighbor>()));
-			StaticHashtable.at(GetHash(b, SupportRange * particleDistance)).emplace_back(i, b);
+			StaticHashtable.insert(std::pair<int, std::vector<StaticBorderNeighbor>>(hash, std::vector<StaticBorderNeighbor>()));
+			StaticHashtable.at(hash).emplace_back(i, b);
 		}
 	}
 }
 
 void UHashNeighborsFinder::FindNeighbors(const UParticleContext& particleContext, double particleDistance, FNeighborsSearchRelations searchRelations)
 {
+	UpdateCellLayout(SupportRange * particleDistance);
+
 	if (searchRelations.FluidNeedsNeighbors()) {
 		FillHashtableDynamic(particleContext, particleDistance);
 		RegisterNeighborsFluids(particleContext.GetFluids(), particleDistance, searchRelations);
@@ -56,42 +61,48 @@ void UHashNeighborsFinder::FindNeighbors(const UParticleContext& particleContext
 	if (searchRelations.StaticBorderNeedsNeighbors()) {
 		RegisterNeighborsStaticBorders(particleContext.GetStaticBorders(), particleDistance, searchRelations);
 	}
-
-	FindPeriodicNeighbors(particleContext, searchRelations);
 }
 
-FNeighborhood UHashNeighborsFinder::NeighborsOfPosition(const Vector3D & position, const UParticleContext & particleContext) const
+void UHashNeighborsFinder::GatherNeighborsOfPosition(const Vector3D & position, const UParticleContext & particleContext, FNeighborhood& neighborhood) const
 {
-	FNeighborhood neighborhood;
+	neighborhood.FluidNeighbors.clear();
+	neighborhood.StaticBorderNeighbors.clear();
+
+	const double supportLength = SupportRange * particleContext.GetParticleDistance();
+	const double supportLengthSquared = supportLength * supportLength;
 
-	int xGrid = floor(position.X / (SupportRange * particleContext.GetParticleDistance()));
-	int yGrid = floor(position.Y / (SupportRange * particleContext.GetParticleDistance()));
-	int zGrid = floor(position.Z / (SupportRange * particleContext.GetParticleDistance()));
+	int xGrid, yGrid, zGrid;
+	GetCell(position, xGrid, yGrid, zGrid);
 
-	for (int xOffset = -1; xOffset <= 1; xOffset++) {
-		for (int yOffset = -1; yOffset <= 1; yOffset++) {
-			for (int zOffset = -1; zOffset <= 1; zOffset++) {
+	int xFirst, xLast, yFirst, yLast, zFirst, zLast;
+	GetOffsetRange(0, 1, xFirst, xLast);
+	GetOffsetRange(1, 1, yFirst, yLast);
+	GetOffsetRange(2, 1, zFirst, zLast);
+
+	for (int xOffset = xFirst; xOffset <= xLast; xOffset++) {
+		for (int yOffset = yFirst; yOffset <= yLast; yOffset++) {
+			for (int zOffset = zFirst; zOffset <= zLast; zOffset++) {
 
 				// get hashindex of current cell
-				int hash = GetHash(xGrid + xOffset, yGrid + yOffset, zGrid + zOffset);
+				int hash = GetCellHash(xGrid + xOffset, yGrid + yOffset, zGrid + zOffset);
 
 				// search through dynamic particles like fluid and rigid bodies
-				if (DynamicHashtable.find(hash) != DynamicHashtable.end()) {
-					const std::vector<FluidNeighbor>& neighbors = DynamicHashtable.at(hash);
-					for (const FluidNeighbor& neighbor : neighbors) {
+				auto dynamicCell = DynamicHashtable.find(hash);
+				if (dynamicCell != DynamicHashtable.end()) {
+					for (const FluidNeighbor& neighbor : dynamicCell->second) {
 						// check if particle is near enough
-						if ((position - neighbor.GetParticle()->Position).Size() < (SupportRange *  particleContext.GetParticleDistance())) {
+						if (GetDistanceVector(position, neighbor.GetParticle()->Position).LengthSquared() < supportLengthSquared) {
 							neighborhood.FluidNeighbors.push_back(neighbor);
 						}
 					}
 				}
 
 				// Search through static particles like borders
-				if (StaticHashtable.find(hash) != StaticHashtable.end()) {
-					const std::vector<StaticBorderNeighbor>& neighbors = StaticHashtable.at(hash);
-					for (const StaticBorderNeighbor& neighbor : neighbors) {
+				auto staticCell = StaticHashtable.find(hash);
+				if (staticCell != StaticHashtable.end()) {
+					for (const StaticBorderNeighbor& neighbor : staticCell->second) {
 						// check if particle is near enough
-						if ((position - neighbor.GetParticle()->Position).Size() < (SupportRange * particleContext.GetParticleDistance())) {
+						if (GetDistanceVector(position, neighbor.GetParticle()->Position).LengthSquared() < supportLengthSquared) {
 							neighborhood.StaticBorderNeighbors.push_back(neighbor);
 						}
 					}
@@ -99,8 +110,6 @@ FNeighborhood UHashNeighborsFinder::NeighborsOfPosition(const Vector3D & positio
 			}
 		}
 	}
-
-	return neighborhood;
 }
 
 
@@ -115,23 +124,27 @@ void UHashNeighborsFinder::FindBorderNeighbors(UStaticBorder * border, double pa
 
 		b.StaticBorderNeighbors.clear();
 
-		int xGrid = floor(b.Position.X / (SupportRange * particleDistance));
-		int yGrid = floor(b.Position.Y / (SupportRange * particleDistance));
-		int zGrid = floor(b.Position.Z / (SupportRange * particleDistance));
+		int xGrid, yGrid, zGrid;
+		GetCell(b.Position, xGrid, yGrid, zGrid);
+
+		int xFirst, xLast, yFirst, yLast, zFirst, zLast;
+		GetOffsetRange(0, 1, xFirst, xLast);
+		GetOffsetRange(1, 1, yFirst, yLast);
+		GetOffsetRange(2, 1, zFirst, zLast);
 
-		for (double xOffset = -1; xOffset <= 1; xOffset++) {
-			for (double yOffset = -1; yOffset <= 1; yOffset++) {
-				for (double zOffset = -1; zOffset <= 1; zOffset++) {
+		for (int xOffset = xFirst; xOffset <= xLast; xOffset++) {
+			for (int yOffset = yFirst; yOffset <= yLast; yOffset++) {
+				for (int zOffset = zFirst; zOffset <= zLast; zOffset++) {
 
 					// get hashindex of current cell
-					int hash = GetHash(xGrid + xOffset, yGrid + yOffset, zGrid + zOffset);
+					int hash = GetCellHash(xGrid + xOffset, yGrid + yOffset, zGrid + zOffset);
 
 					// only search through static particles like borders
 					if (StaticHashtable.find(hash) != StaticHashtable.end()) {
 						std::vector<StaticBorderNeighbor>& neighbors = StaticHashtable.at(hash);
 						for (StaticBorderNeighbor& bb : neighbors) {
 							// check if particle is near enough
-							if ((b.Position - bb.GetParticle()->Position).Size() < (SupportRange * particleDistance)) {
+							if (GetDistanceVector(b.Position, bb.GetParticle()->Position).Size() < (SupportRange * particleDistance)) {
 								b.StaticBorderNeighbors.push_back(bb);
 							}
 						}
@@ -145,6 +158,7 @@ void UHashNeighborsFinder::FindBorderNeighbors(UStaticBorder * border, double pa
 void UHashNeighborsFinder::FillHashtableDynamic(const UParticleContext& particleContext, double particleDistance)
 {
 	DynamicHashtable.clear();
+	AwakeCells.clear();
 	int totalFluidParticles = 0;
 	for (UFluid* fluid : particleContext.GetFluids()) {
 		totalFluidParticles += fluid->Particles->size();
@@ -156,15 +170,26 @@ void UHashNeighborsFinder::FillHashtableDynamic(const UParticleContext& particle
 		for (int i = 0; i < fluid->Particles->size(); i++) {
 			Particle& f = fluid->Particles->at(i);
 
+			// removed particles are nobodys neighbor
+			if (f.IsRemoved) {
+				continue;
+			}
+
+			int hash = GetCellHash(f.Position);
+
+			// sleeping particles stay in the table, they still support their awake neighbors
+			if (!f.IsSleeping) {
+				AwakeCells.insert(hash);
+			}
 
-			if (DynamicHashtable.count(GetHash(f, (SupportRange * particleDistance))) == 1) {
+			if (DynamicHashtable.count(hash) == 1) {
 				// if there is already a list at this box, just add the particle
-				DynamicHashtable.at(GetHash(f, (SupportRange * particleDistance))).emplace_back(i, f);
+				DynamicHashtable.at(hash).emplace_back(i, f);
 			}
 			else {
 				// Create new list at Hash and add the particle
-				DynamicHashtable.insert(std::pair<int, std::vector<FluidNeighbor>>(GetHash(f, (SupportRange * particleDistance)), std::vector<FluidNeighbor>()));
-				DynamicHashtable.at(GetHash(f, (SupportRange * particleDistance))).emplace_back(i, f);
+				DynamicHashtable.insert(std::pair<int, std::vector<FluidNeighbor>>(hash, std::vector<FluidNeighbor>()));
+				DynamicHashtable.at(hash).emplace_back(i, f);
 			}
 		}
 	}
@@ -182,25 +207,41 @@ void UHashNeighborsFinder::RegisterNeighborsFluids(const std::vector<UFluid*>& f
 			if (searchRelations.StaticBorderNeighborsOfFluidRequired)
 				f.StaticBorderNeighbors.clear();
 
+			if (f.IsRemoved) {
+				return;
+			}
+
+			int xGrid, yGrid, zGrid;
+			GetCell(f.Position, xGrid, yGrid, zGrid);
+
+			// particles with stretched support reach into cells further away, coarser neighbors are found by the coarser particle
+			int cellRange = (int)ceil(f.SmoothingScale);
 
-			int xGrid = floor(f.Position.X / (SupportRange * particleDistance));
-			int yGrid = floor(f.Position.Y / (SupportRange * particleDistance));;
-			int zGrid = floor(f.Position.Z / (SupportRange * particleDistance));;
+			// sleeping particles surrounded by sleeping cells have nothing moving around them and get no neighborhoods
+			if (f.IsSleeping && !HasAwakeCellAround(xGrid, yGrid, zGrid, cellRange)) {
+				return;
+			}
+
+			int xFirst, xLast, yFirst, yLast, zFirst, zLast;
+			GetOffsetRange(0, cellRange, xFirst, xLast);
+			GetOffsetRange(1, cellRange, yFirst, yLast);
+			GetOffsetRange(2, cellRange, zFirst, zLast);
 
-			for (int xOffset = -1; xOffset <= 1; xOffset++) {
-				for (int yOffset = -1; yOffset <= 1; yOffset++) {
-					for (int zOffset = -1; zOffset <= 1; zOffset++) {
+			for (int xOffset = xFirst; xOffset <= xLast; xOffset++) {
+				for (int yOffset = yFirst; yOffset <= yLast; yOffset++) {
+					for (int zOffset = zFirst; zOffset <= zLast; zOffset++) {
 
 						// get hashindex of current cell
-						int hash = GetHash(xGrid + xOffset, yGrid + yOffset, zGrid + zOffset);
+						int hash = GetCellHash(xGrid + xOffset, yGrid + yOffset, zGrid + zOffset);
 
 						if (searchRelations.FluidNeighborsOfFluidRequired) {
 							// search through dynamic particles like fluid and rigid bodies
 							if (DynamicHashtable.find(hash) != DynamicHashtable.end()) {
 								std::vector<FluidNeighbor>& neighbors = DynamicHashtable.at(hash);
 								for (const FluidNeighbor& neighbor : neighbors) {
-									// check if particle is near enough
-									if ((f.Position - neighbor.GetParticle()->Position).Size() < (SupportRange * particleDistance)) {
+									const Particle& ff = *neighbor.GetParticle();
+									// check if particle is near enough for the support of the pair
+									if (!IsCoarser(ff, f) && GetDistanceVector(f.Position, ff.Position).Size() < (SupportRange * particleDistance * UKernel::GetPairSmoothingScale(f, ff))) {
 										f.FluidNeighbors.push_back(neighbor);
 									}
 								}
@@ -213,8 +254,8 @@ void UHashNeighborsFinder::RegisterNeighborsFluids(const std::vector<UFluid*>& f
 							if (StaticHashtable.find(hash) != StaticHashtable.end()) {
 								std::vector<StaticBorderNeighbor>& neighbors = StaticHashtable.at(hash);
 								for (const StaticBorderNeighbor& neighbor : neighbors) {
-									// check if particle is near enough
-									if ((f.Position - neighbor.GetParticle()->Position).Size() < (SupportRange * particleDistance)) {
+									// check if particle is near enough for the support of the pair
+									if (GetDistanceVector(f.Position, neighbor.GetParticle()->Position).Size() < (SupportRange * particleDistance * UKernel::GetPairSmoothingScale(f, *neighbor.GetParticle()))) {
 										f.StaticBorderNeighbors.push_back(neighbor);
 									}
 								}
@@ -225,6 +266,34 @@ void UHashNeighborsFinder::RegisterNeighborsFluids(const std::vector<UFluid*>& f
 			}
 		});
 	});
+
+	if (!searchRelations.FluidNeighborsOfFluidRequired || SearchRangeScale <= 1.0) {
+		return;
+	}
+
+	// finer particles do not search as far as their coarser neighbors, so the coarser particle hands the pair over
+	for (UFluid * fluid : fluids) {
+		for (int i = 0; i < fluid->Particles->size(); i++) {
+			Particle& f = fluid->Particles->at(i);
+			if (f.SmoothingScale <= 1.0) {
+				continue;
+			}
+
+			for (const FluidNeighbor& neighbor : f.FluidNeighbors) {
+				Particle& ff = *neighbor.GetParticle();
+
+				// sleeping particles without a neighborhood of their own stay without one
+				if (IsCoarser(f, ff) && !(ff.IsSleeping && ff.FluidNeighbors.empty())) {
+					ff.FluidNeighbors.emplace_back(i, f);
+				}
+			}
+		}
+	}
+}
+
+bool UHashNeighborsFinder::IsCoarser(const Particle& particle, const Particle& other)
+{
+	return particle.SmoothingScale > other.SmoothingScale * (1.0 + 1e-6);
 }
 
 void UHashNeighborsFinder::RegisterNeighborsStaticBorders(const std::vector<UStaticBorder*>& borders, double particleDistance, FNeighborsSearchRelations searchRelations)
@@ -239,24 +308,31 @@ void UHashNeighborsFinder::RegisterNeighborsStaticBorders(const std::vector<USta
 				b.StaticBorderNeighbors.clear();
 
 
-			int xGrid = floor(b.Position.X / (SupportRange * particleDistance));
-			int yGrid = floor(b.Position.Y / (SupportRange * particleDistance));;
-			int zGrid = floor(b.Position.Z / (SupportRange * particleDistance));;
+			int xGrid, yGrid, zGrid;
+			GetCell(b.Position, xGrid, yGrid, zGrid);
+
+			// the support of a pair is the mean of both smoothing scales, so the coarsest fluid particles are found a bit further away
+			int cellRange = (int)ceil(0.5 * (b.SmoothingScale + SearchRangeScale));
+
+			int xFirst, xLast, yFirst, yLast, zFirst, zLast;
+			GetOffsetRange(0, cellRange, xFirst, xLast);
+			GetOffsetRange(1, cellRange, yFirst, yLast);
+			GetOffsetRange(2, cellRange, zFirst, zLast);
 
-			for (int xOffset = -1; xOffset <= 1; xOffset++) {
-				for (int yOffset = -1; yOffset <= 1; yOffset++) {
-					for (int zOffset = -1; zOffset <= 1; zOffset++) {
+			for (int xOffset = xFirst; xOffset <= xLast; xOffset++) {
+				for (int yOffset = yFirst; yOffset <= yLast; yOffset++) {
+					for (int zOffset = zFirst; zOffset <= zLast; zOffset++) {
 
 						// get hashindex of current cell
-						int hash = GetHash(xGrid + xOffset, yGrid + yOffset, zGrid + zOffset);
+						int hash = GetCellHash(xGrid + xOffset, yGrid + yOffset, zGrid + zOffset);
 
 						if (searchRelations.FluidNeighborsOfStaticBorderRequired) {
 							// search through dynamic particles like fluid and rigid bodies
 							if (DynamicHashtable.find(hash) != DynamicHashtable.end()) {
 								std::vector<FluidNeighbor>& neighbors = DynamicHashtable.at(hash);
 								for (const FluidNeighbor& bf : neighbors) {
-									// check if particle is near enough
-									if ((b.Position - bf.GetParticle()->Position).Size() < (SupportRange * particleDistance)) {
+									// check if particle is near enough for the support of the pair
+									if (GetDistanceVector(b.Position, bf.GetParticle()->Position).Size() < (SupportRange * particleDistance * UKernel::GetPairSmoothingScale(b, *bf.GetParticle()))) {
 										b.FluidNeighbors.push_back(bf);
 									}
 								}
@@ -269,7 +345,7 @@ void UHashNeighborsFinder::RegisterNeighborsStaticBorders(const std::vector<USta
 								std::vector<StaticBorderNeighbor>& neighbors = StaticHashtable.at(hash);
 								for (const StaticBorderNeighbor& bb : neighbors) {
 									// check if particle is near enough
-									if ((b.Position - bb.GetParticle()->Position).Size() < (SupportRange * particleDistance)) {
+									if (GetDistanceVector(b.Position, bb.GetParticle()->Position).Size() < (SupportRange * particleDistance)) {
 										b.StaticBorderNeighbors.push_back(bb);
 									}
 								}
@@ -282,67 +358,153 @@ void UHashNeighborsFinder::RegisterNeighborsStaticBorders(const std::vector<USta
 	}
 }
 
-void UHashNeighborsFinder::FindPeriodicNeighbors(const UParticleContext& particleContext, FNeighborsSearchRelations searchRelations)
+int UHashNeighborsFinder::GetHash(const Vector3D& vector, double supportDistance) {
+	return 611657 * (int)floor(vector.X / supportDistance) + 1109 * (int)floor(vector.Y / supportDistance) + (int)floor(vector.Z / supportDistance);
+}
+
+int UHashNeighborsFinder::GetHash(const Particle& particle, double supportDistance)
 {
-	if (particleContext.GetPeriodicCondition() != nullptr && searchRelations.FluidNeighborsRequired()) {
-		UPeriodicCondition * periodic = particleContext.GetPeriodicCondition();
-		for (int j = 0; j < periodic->GetGhostParticles().size(); j++) {
-			Particle& ghost = const_cast<Particle&>(periodic->GetGhostParticles()[j]);
+	return GetHash(particle.Position, supportDistance);
+}
 
-			int xGrid = floor(ghost.Position.X / (SupportRange * particleContext.GetParticleDistance()));
-			int yGrid = floor(ghost.Position.Y / (SupportRange * particleContext.GetParticleDistance()));;
-			int zGrid = floor(ghost.Position.Z / (SupportRange * particleContext.GetParticleDistance()));;
+int UHashNeighborsFinder::GetHash(int x, int y, int z)
+{
+	return 611657 * x + 1109 * y + z;
+}
+void UHashNeighborsFinder::SetPeriodicCondition(const UPeriodicCondition * periodicCondition)
+{
+	UNeighborsFinder::SetPeriodicCondition(periodicCondition);
 
-			for (int xOffset = -1; xOffset <= 1; xOffset++) {
-				for (int yOffset = -1; yOffset <= 1; yOffset++) {
-					for (int zOffset = -1; zOffset <= 1; zOffset++) {
+	// the cell layout changes, so static particles added before have to be added again
+	StaticHashtable.clear();
+	CellSize = 0.0;
+}
 
-						// get hashindex of current cell
-						int hash = GetHash(xGrid + xOffset, yGrid + yOffset, zGrid + zOffset);
+void UHashNeighborsFinder::UpdateCellLayout(double cellSize)
+{
+	if (cellSize == CellSize) {
+		return;
+	}
+	CellSize = cellSize;
+	ComputeCellLayout(cellSize, PeriodicCellCounts, CellWidths, CellOrigin);
+}
 
-						if (searchRelations.FluidNeighborsOfFluidRequired) {
-							// search through dynamic particles like fluid and rigid bodies
-							if (DynamicHashtable.find(hash) != DynamicHashtable.end()) {
-								std::vector<FluidNeighbor>& neighbors = DynamicHashtable.at(hash);
-								for (const FluidNeighbor& ff : neighbors) {
-									// check if particle is near enough and push ghost particle inside if close enough
-									if ((ghost.Position - ff.GetParticle()->Position).Size() < (SupportRange * particleContext.GetParticleDistance())) {
-										ff.GetParticle()->FluidNeighbors.push_back(FluidNeighbor(periodic->GetReferencedParticlesIndices()[j], ghost));
-									}
-								}
-							}
+void UHashNeighborsFinder::ComputeCellLayout(double cellSize, int periodicCellCounts[3], double cellWidths[3], double cellOrigin[3]) const
+{
+	const Vector3D periods = PeriodicCondition != nullptr ? PeriodicCondition->GetPeriods() : Vector3D(0.0);
+	const Vector3D boxMin = PeriodicCondition != nullptr ? PeriodicCondition->GetBoxMin() : Vector3D(0.0);
+	const double axisPeriods[3] = { periods.X, periods.Y, periods.Z };
+	const double axisMins[3] = { boxMin.X, boxMin.Y, boxMin.Z };
+
+	for (int axis = 0; axis < 3; axis++) {
+		if (axisPeriods[axis] > 0.0) {
+			// periodic axes are covered by a whole number of cells, which are stretched to be at least as large as the support
+			periodicCellCounts[axis] = std::max(1, (int)floor(axisPeriods[axis] / cellSize));
+			cellWidths[axis] = axisPeriods[axis] / periodicCellCounts[axis];
+			cellOrigin[axis] = axisMins[axis];
+		}
+		else {
+			periodicCellCounts[axis] = 0;
+			cellWidths[axis] = cellSize;
+			cellOrigin[axis] = 0.0;
+		}
+	}
+}
 
-						}
-						if (searchRelations.FluidNeighborsOfStaticBorderRequired) {
-							// search through dynamic particles like fluid and rigid bodies
-							if (StaticHashtable.find(hash) != StaticHashtable.end()) {
-								std::vector<StaticBorderNeighbor>& neighbors = StaticHashtable.at(hash);
-								for (const StaticBorderNeighbor& fb : neighbors) {
-									// check if particle is near enough
-									if ((ghost.Position - fb.GetParticle()->Position).Size() < (SupportRange *  particleContext.GetParticleDistance())) {
-										fb.GetParticle()->FluidNeighbors.push_back(FluidNeighbor(periodic->GetReferencedParticlesIndices()[j], ghost));
-									}
-								}
-							}
-						}
-					}
-				}
-			}
-	
+void UHashNeighborsFinder::GetCell(const Vector3D& position, int& x, int& y, int& z) const
+{
+	x = WrapCell((int)floor((position.X - CellOrigin[0]) / CellWidths[0]), 0);
+	y = WrapCell((int)floor((position.Y - CellOrigin[1]) / CellWidths[1]), 1);
+	z = WrapCell((int)floor((position.Z - CellOrigin[2]) / CellWidths[2]), 2);
+}
+
+void UHashNeighborsFinder::GetCellCoordinates(const Vector3D& position, double particleDistance, int& x, int& y, int& z) const
+{
+	if (GetCellSize(particleDistance) == CellSize) {
+		GetCell(position, x, y, z);
+		return;
+	}
+
+	// before the first search the layout is computed for the call, it is the one the search will use
+	int periodicCellCounts[3];
+	double cellWidths[3];
+	double cellOrigin[3];
+	ComputeCellLayout(GetCellSize(particleDistance), periodicCellCounts, cellWidths, cellOrigin);
+
+	const double coordinates[3] = { position.X, position.Y, position.Z };
+	int cells[3];
+	for (int axis = 0; axis < 3; axis++) {
+		const int count = periodicCellCounts[axis];
+		cells[axis] = (int)floor((coordinates[axis] - cellOrigin[axis]) / cellWidths[axis]);
+		if (count > 0) {
+			cells[axis] = ((cells[axis] % count) + count) % count;
 		}
 	}
+	x = cells[0];
+	y = cells[1];
+	z = cells[2];
 }
 
-int UHashNeighborsFinder::GetHash(const Vector3D& vector, double supportDistance) {
-	return 611657 * (int)floor(vector.X / supportDistance) + 1109 * (int)floor(vector.Y / supportDistance) + (int)floor(vector.Z / supportDistance);
+Vector3D UHashNeighborsFinder::GetCellCenter(int x, int y, int z, double particleDistance) const
+{
+	if (GetCellSize(particleDistance) == CellSize) {
+		return Vector3D(CellOrigin[0] + (x + 0.5) * CellWidths[0], CellOrigin[1] + (y + 0.5) * CellWidths[1], CellOrigin[2] + (z + 0.5) * CellWidths[2]);
+	}
+
+	int periodicCellCounts[3];
+	double cellWidths[3];
+	double cellOrigin[3];
+	ComputeCellLayout(GetCellSize(particleDistance), periodicCellCounts, cellWidths, cellOrigin);
+	return Vector3D(cellOrigin[0] + (x + 0.5) * cellWidths[0], cellOrigin[1] + (y + 0.5) * cellWidths[1], cellOrigin[2] + (z + 0.5) * cellWidths[2]);
 }
 
-int UHashNeighborsFinder::GetHash(const Particle& particle, double supportDistance)
+int UHashNeighborsFinder::WrapCell(int cell, int axis) const
 {
-	return GetHash(particle.Position, supportDistance);
+	const int count = PeriodicCellCounts[axis];
+	if (count > 0) {
+		return ((cell % count) + count) % count;
+	}
+	return cell;
 }
 
-int UHashNeighborsFinder::GetHash(int x, int y, int z)
+int UHashNeighborsFinder::GetCellHash(const Vector3D& position) const
 {
-	return 611657 * x + 1109 * y + z;
-}
\ No newline at end of file
+	int x, y, z;
+	GetCell(position, x, y, z);
+	return GetHash(x, y, z);
+}
+
+int UHashNeighborsFinder::GetCellHash(int x, int y, int z) const
+{
+	return GetHash(WrapCell(x, 0), WrapCell(y, 1), WrapCell(z, 2));
+}
+
+bool UHashNeighborsFinder::HasAwakeCellAround(int x, int y, int z, int cellRange) const
+{
+	int xFirst, xLast, yFirst, yLast, zFirst, zLast;
+	GetOffsetRange(0, cellRange, xFirst, xLast);
+	GetOffsetRange(1, cellRange, yFirst, yLast);
+	GetOffsetRange(2, cellRange, zFirst, zLast);
+
+	for (int xOffset = xFirst; xOffset <= xLast; xOffset++) {
+		for (int yOffset = yFirst; yOffset <= yLast; yOffset++) {
+			for (int zOffset = zFirst; zOffset <= zLast; zOffset++) {
+				if (AwakeCells.count(GetCellHash(x + xOffset, y + yOffset, z + zOffset)) == 1) {
+					return true;
+				}
+			}
+		}
+	}
+	return false;
+}
+
+void UHashNeighborsFinder::GetOffsetRange(int axis, int cellRange, int& first, int& last) const
+{
+	first = -cellRange;
+	last = cellRange;
+
+	// if a periodic axis has fewer cells than are searched, every cell is only visited once
+	if (PeriodicCellCounts[axis] > 0 && 2 * cellRange + 1 > PeriodicCellCounts[axis]) {
+		last = first + PeriodicCellCounts[axis] - 1;
+	}
+}
@@ -33,13 +33,17 @@ public:
 	void FindNeighbors(const UParticleContext& particleContext, double particleDistance, FNeighborsSearchRelations searchRelations = FNeighborsSearchRelations()) override;
 
 	// FInds neighbors at a specified position
-	FNeighborhood NeighborsOfPosition(const Vector3D& position, const UParticleContext& particleContext) const override;
+	void GatherNeighborsOfPosition(const Vector3D& position, const UParticleContext& particleContext, FNeighborhood& neighborhood) const override;
 
 	// Finds neighbors for border particles
 	void FindBorderNeighbors(UStaticBorder * border, double particleDistance);
 
-	// Inefficiently adds the ghost particles from the periodic condition to the particles neighborhoods
-	void FindPeriodicNeighbors(const UParticleContext& particleContext, FNeighborsSearchRelations searchRelations);
+	// Wraps the cells around the periodic axes of the domain, so neighbors across the periodic limit lie in adjacent cells
+	void SetPeriodicCondition(const UPeriodicCondition * periodicCondition) override;
+
+	// Cells of the hashtables, stretched and wrapped on periodic axes
+	void GetCellCoordinates(const Vector3D& position, double particleDistance, int& x, int& y, int& z) const override;
+	Vector3D GetCellCenter(int x, int y, int z, double particleDistance) const override;
 
 	static int GetHash(const Vector3D& vector, double supportLength);
 	static int GetHash(const Particle& particle, double supportLength);
@@ -50,9 +54,42 @@ public:
 
 private:
 
+	// Cell size the layout was computed for
+	double CellSize = 0.0;
+
+	// Number of cells on periodic axes, zero on axes that are not periodic
+	int PeriodicCellCounts[3] = { 0, 0, 0 };
+
+	// Cells on periodic axes start at the lower corner of the domain and are stretched to cover it with a whole number of cells
+	double CellWidths[3] = { 1.0, 1.0, 1.0 };
+	double CellOrigin[3] = { 0.0, 0.0, 0.0 };
+
+	void UpdateCellLayout(double cellSize);
+
+	// Layout of the cells for a cell size, written into the arrays given
+	void ComputeCellLayout(double cellSize, int periodicCellCounts[3], double cellWidths[3], double cellOrigin[3]) const;
+
+	// Cell coordinates of a position, wrapped on periodic axes
+	void GetCell(const Vector3D& position, int& x, int& y, int& z) const;
+	int WrapCell(int cell, int axis) const;
+
+	int GetCellHash(const Vector3D& position) const;
+	int GetCellHash(int x, int y, int z) const;
+
+	// Cells containing at least one awake fluid particle, all other filled cells are asleep
+	std::unordered_set<int> AwakeCells;
+
+	bool HasAwakeCellAround(int x, int y, int z, int cellRange) const;
+
+	// Range of cell offsets searched on an axis. On periodic axes with only a few cells every cell is visited once
+	void GetOffsetRange(int axis, int cellRange, int& first, int& last) const;
+
 	void FillHashtableDynamic(const UParticleContext& particleContext, double supportLength);
 
 	void RegisterNeighborsFluids(const std::vector<UFluid*>& fluids, double supportLength, FNeighborsSearchRelations searchRelations);
+
+	// Pairs of particles with different smoothing scales are only searched by the coarser one
+	static bool IsCoarser(const Particle& particle, const Particle& other);
 	void RegisterNeighborsStaticBorders(const std::vector<UStaticBorder*>& borders, double supportLength, FNeighborsSearchRelations searchRelations);
 };
 
@@ -1,4 +1,5 @@
 #include "NaiveNeighborsFinder.h"
+#include "Kernels/Kernel.h"
 
 UNaiveNeighborsFinder::UNaiveNeighborsFinder()
 {
@@ -28,28 +29,24 @@ void UNaiveNeighborsFinder::FindNeighbors(const UParticleContext& particleContex
 			ParallelFor(fluid->Particles->size(), [&](int32 i) {
 				Particle& f = fluid->Particles->at(i);
 
+				// removed particles have no neighbors and are nobodys neighbor
+				if (f.IsRemoved) {
+					f.FluidNeighbors.clear();
+					f.StaticBorderNeighbors.clear();
+					return;
+				}
+
 				if (searchRelations.FluidNeighborsOfFluidRequired) {
 					f.FluidNeighbors.clear();
 					for (UFluid * neighborFluid : particleContext.GetFluids()) {
 						for (int j = 0; j < neighborFluid->Particles->size(); j++) {
 							Particle& ff = neighborFluid->Particles->at(j);
 							// if distance between particles is smaller as supportrange * h, then add the particle to neighboring particles 
-							if ((f.Position - ff.Position).Size() < (SupportRange * particleDistance)) {
+							if (!ff.IsRemoved && GetDistanceVector(f.Position, ff.Position).Size() < (SupportRange * particleDistance * UKernel::GetPairSmoothingScale(f, ff))) {
 								f.FluidNeighbors.emplace_back(j, ff);
 							}
 						}
 					}
-
-					if (particleContext.GetPeriodicCondition() != nullptr) {
-						UPeriodicCondition * periodic = particleContext.GetPeriodicCondition();
-						for (int j = 0; j < periodic->GetGhostParticles().size(); j++) {
-							Particle& ghost = const_cast<Particle&>(periodic->GetGhostParticles()[j]);
-
-							if ((ghost.Position - f.Position).Size() < SupportRange * particleDistance) {
-								f.FluidNeighbors.emplace_back(periodic->GetReferencedParticlesIndices()[j], ghost);
-							}
-						}
-					}
 				}
 
 				if (searchRelations.StaticBorderNeighborsOfFluidRequired) {
@@ -58,7 +55,7 @@ void UNaiveNeighborsFinder::FindNeighbors(const UParticleContext& particleContex
 						for (int j = 0; j < border->Particles->size(); j++) {
 							Particle& fb = border->Particles->at(j);
 							// if distance between particles is smaller as 2 * h, then add the particle to neighboring particles 
-							if ((f.Position - fb.Position).Size() < (SupportRange * particleDistance)) {
+							if (GetDistanceVector(f.Position, fb.Position).Size() < (SupportRange * particleDistance * UKernel::GetPairSmoothingScale(f, fb))) {
 								f.StaticBorderNeighbors.emplace_back(j, fb);
 							}
 						}
@@ -79,22 +76,11 @@ void UNaiveNeighborsFinder::FindNeighbors(const UParticleContext& particleContex
 						for (int j = 0; j < neighborFluid->Particles->size(); j++) {
 							Particle& bf = neighborFluid->Particles->at(j);
 							// if distance between particles is smaller as 2 * h, then add the particle to neighboring particles 
-							if ((b.Position - bf.Position).Size() < (SupportRange * particleDistance)) {
+							if (!bf.IsRemoved && GetDistanceVector(b.Position, bf.Position).Size() < (SupportRange * particleDistance * UKernel::GetPairSmoothingScale(b, bf))) {
 								b.FluidNeighbors.emplace_back(j, bf);
 							}
 						}
 					}
-
-					if (particleContext.GetPeriodicCondition() != nullptr) {
-						UPeriodicCondition * periodic = particleContext.GetPeriodicCondition();
-						for (int j = 0; j < periodic->GetGhostParticles().size(); j++) {
-							Particle& ghost = const_cast<Particle&>(periodic->GetGhostParticles()[j]);
-
-							if ((ghost.Position - b.Position).Size() < SupportRange * particleDistance) {
-								b.FluidNeighbors.emplace_back(periodic->GetReferencedParticlesIndices()[j], ghost);
-							}
-						}
-					}
 				}
 
 				if (searchRelations.StaticBorderNeighborsOfStaticBorderRequired) {
@@ -103,7 +89,7 @@ void UNaiveNeighborsFinder::FindNeighbors(const UParticleContext& particleContex
 						for (int j = 0; j < neighborBorder->Particles->size(); j++) {
 							Particle& bb = neighborBorder->Particles->at(j);
 							// if distance between particles is smaller as 2 * h, then add the particle to neighboring particles 
-							if ((b.Position - bb.Position).Size() < (SupportRange * particleDistance)) {
+							if (GetDistanceVector(b.Position, bb.Position).Size() < (SupportRange * particleDistance)) {
 								b.StaticBorderNeighbors.emplace_back(j, bb);
 							}
 						}
@@ -114,42 +100,30 @@ void UNaiveNeighborsFinder::FindNeighbors(const UParticleContext& particleContex
 	}
 }
 
-FNeighborhood UNaiveNeighborsFinder::NeighborsOfPosition(const Vector3D& position, const UParticleContext& particleContext) const
+void UNaiveNeighborsFinder::GatherNeighborsOfPosition(const Vector3D& position, const UParticleContext& particleContext, FNeighborhood& neighborhood) const
 {
-	FNeighborhood neighborhood;
+	neighborhood.FluidNeighbors.clear();
+	neighborhood.StaticBorderNeighbors.clear();
 
 	for (UFluid * neighborFluid : particleContext.GetFluids()) {
 		for (int j = 0; j < neighborFluid->Particles->size(); j++) {
 			Particle& bf = neighborFluid->Particles->at(j);
 			// if distance between particles is smaller as 2 * h, then add the particle to neighboring particles 
-			if ((position - bf.Position).Size() < (SupportRange * particleContext.GetParticleDistance())) {
+			if (!bf.IsRemoved && GetDistanceVector(position, bf.Position).Size() < (SupportRange * particleContext.GetParticleDistance())) {
 				neighborhood.FluidNeighbors.emplace_back(j, bf);
 			}
 		}
 	}
 
-	if (particleContext.GetPeriodicCondition() != nullptr) {
-		UPeriodicCondition * periodic = particleContext.GetPeriodicCondition();
-		for (int j = 0; j < periodic->GetGhostParticles().size(); j++) {
-			Particle& ghost = const_cast<Particle&>(periodic->GetGhostParticles()[j]);
-
-			if ((ghost.Position - position).Size() < SupportRange * particleContext.GetParticleDistance()) {
-				neighborhood.FluidNeighbors.emplace_back(periodic->GetReferencedParticlesIndices()[j], ghost);
-			}
-		}
-	}
-
 	for (UStaticBorder * neighborBorder : particleContext.GetStaticBorders()) {
 		for (int j = 0; j < neighborBorder->Particles->size(); j++) {
 			Particle& bb = neighborBorder->Particles->at(j);
 			// if distance between particles is smaller as 2 * h, then add the particle to neighboring particles 
-			if ((position - bb.Position).Size() < (SupportRange * particleContext.GetParticleDistance())) {
+			if (GetDistanceVector(position, bb.Position).Size() < (SupportRange * particleContext.GetParticleDistance())) {
 				neighborhood.StaticBorderNeighbors.emplace_back(j, bb);
 			}
 		}
 	}
-
-	return neighborhood;
 }
 
 
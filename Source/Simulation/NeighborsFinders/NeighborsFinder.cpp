@@ -17,9 +17,15 @@ void UNeighborsFinder::FindNeighbors(const UParticleContext& particleContext, do
 }
 
 FNeighborhood UNeighborsFinder::NeighborsOfPosition(const Vector3D& position, const UParticleContext& particleContext) const
+{
+	FNeighborhood neighborhood;
+	GatherNeighborsOfPosition(position, particleContext, neighborhood);
+	return neighborhood;
+}
+
+void UNeighborsFinder::GatherNeighborsOfPosition(const Vector3D& position, const UParticleContext& particleContext, FNeighborhood& neighborhood) const
 {
 	throw("This is an abstract base class and should not be called!");
-	return (FNeighborhood());
 }
 
 void UNeighborsFinder::AddStaticParticles(UStaticBorder * borders, double particleDistance)
@@ -41,3 +47,45 @@ ENeighborhoodSearch UNeighborsFinder::GetNeighborsFinderType()
 {
 	return NeighborsFinderType;
 }
+
+
+void UNeighborsFinder::SetSearchRangeScale(double searchRangeScale)
+{
+	SearchRangeScale = std::max(searchRangeScale, 1.0);
+}
+
+double UNeighborsFinder::GetSearchRangeScale() const
+{
+	return SearchRangeScale;
+}
+
+double UNeighborsFinder::GetCellSize(double particleDistance) const
+{
+	return SupportRange * particleDistance;
+}
+
+void UNeighborsFinder::GetCellCoordinates(const Vector3D& position, double particleDistance, int& x, int& y, int& z) const
+{
+	const double cellSize = GetCellSize(particleDistance);
+	x = (int)floor(position.X / cellSize);
+	y = (int)floor(position.Y / cellSize);
+	z = (int)floor(position.Z / cellSize);
+}
+
+Vector3D UNeighborsFinder::GetCellCenter(int x, int y, int z, double particleDistance) const
+{
+	return Vector3D(x + 0.5, y + 0.5, z + 0.5) * GetCellSize(particleDistance);
+}
+
+void UNeighborsFinder::SetPeriodicCondition(const UPeriodicCondition * periodicCondition)
+{
+	PeriodicCondition = periodicCondition;
+}
+
+Vector3D UNeighborsFinder::GetDistanceVector(const Vector3D& position1, const Vector3D& position2) const
+{
+	if (PeriodicCondition != nullptr) {
+		return PeriodicCondition->GetMinimumImage(position1 - position2);
+	}
+	return position1 - position2;
+}
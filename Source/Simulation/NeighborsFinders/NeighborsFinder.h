@@ -72,7 +72,10 @@ public:
 	void Build(double supportRange);
 
 	virtual void FindNeighbors(const UParticleContext& particleContext, double supportLength, FNeighborsSearchRelations searchRelations = FNeighborsSearchRelations());
-	virtual FNeighborhood NeighborsOfPosition(const Vector3D& position, const UParticleContext& particleContext) const;
+	FNeighborhood NeighborsOfPosition(const Vector3D& position, const UParticleContext& particleContext) const;
+
+	// Replaces the neighbors in the given neighborhood with the ones of the position. Reusing the neighborhood keeps its allocations
+	virtual void GatherNeighborsOfPosition(const Vector3D& position, const UParticleContext& particleContext, FNeighborhood& neighborhood) const;
 	virtual void AddStaticParticles(UStaticBorder * borders, double supportRange);
 	virtual void AddStaticParticles(TArray<UStaticBorder*>& borders, double supportRange);
 	virtual void AddStaticParticles(std::vector<UStaticBorder*>& borders, double supportRange);
@@ -80,10 +83,34 @@ public:
 
 	ENeighborhoodSearch GetNeighborsFinderType();
 
+	// Largest smoothing scale of the particles. Fluid particles search up to their own scale, static particles up to the mean of theirs and this one
+	void SetSearchRangeScale(double searchRangeScale);
+	double GetSearchRangeScale() const;
+
+	// Edge length of the cells the neighbors are searched in, in simulation units
+	double GetCellSize(double particleDistance) const;
+
+	// Coordinates of the cell of a position in the grid of the neighbor search, wrapped around periodic axes. Cells of the same coordinates are the same cell
+	virtual void GetCellCoordinates(const Vector3D& position, double particleDistance, int& x, int& y, int& z) const;
+
+	// Center of the cell with the given coordinates
+	virtual Vector3D GetCellCenter(int x, int y, int z, double particleDistance) const;
+
+	// Searches neighbors across the limits of the periodic domain. Has to be set before static particles are added
+	virtual void SetPeriodicCondition(const UPeriodicCondition * periodicCondition);
+
 protected:
 
 	// Support range in particle Units. Scales how far the neighborhood is computed
 	double SupportRange;
 
+	// Largest smoothing scale of all particles. Neighbors are registered within the support range times the mean smoothing scale of the pair
+	double SearchRangeScale = 1.0;
+
 	ENeighborhoodSearch NeighborsFinderType;
+
+	const UPeriodicCondition * PeriodicCondition = nullptr;
+
+	// Vector from position2 to position1, across the periodic limit if that is shorter
+	Vector3D GetDistanceVector(const Vector3D& position1, const Vector3D& position2) const;
 };
\ No newline at end of file
@@ -48,6 +48,13 @@ void UParticleContext::Build(UWorld * world, ASimulator * simulator, EDimensiona
 {
 	Simulator = simulator;
 
+	// the periodic domain has to be known before static particles are sorted into the cells of the neighbors finder
+	if (PeriodicCondition != nullptr) {
+		PeriodicCondition->Build(this, dimensionality);
+		simulator->GetNeighborsFinder()->SetPeriodicCondition(PeriodicCondition);
+		simulator->GetKernel()->SetPeriodicCondition(PeriodicCondition);
+	}
+
 	for (int i = 0; i < Fluids.size(); i++) {
 		Fluids[i]->Build(this, dimensionality);
 		Fluids[i]->Index = i;
@@ -60,10 +67,6 @@ void UParticleContext::Build(UWorld * world, ASimulator * simulator, EDimensiona
 
 	ParticleVisualiser = world->SpawnActor<AParticleCloudActor>(FVector(0), FRotator(0));
 	ParticleVisualiser->Build(this, VisualisationInformation);
-	
-	if (PeriodicCondition != nullptr) {
-		PeriodicCondition->Build(this, dimensionality);
-	}
 }
 
 void UParticleContext::UpdateVisual()
@@ -189,6 +192,11 @@ UPeriodicCondition * UParticleContext::GetPeriodicCondition() const
 void UParticleContext::SetVisualisationInformation(FVisualisationInformation visualisationInformation)
 {
 	VisualisationInformation = visualisationInformation;
+
+	// switching between scalar colorings doesn't need the points to be converted again
+	if (ParticleVisualiser != nullptr) {
+		ParticleVisualiser->ApplyColorRamp(VisualisationInformation);
+	}
 }
 
 FVisualisationInformation UParticleContext::GetVisualisationInformation() const
@@ -21,208 +21,118 @@ void UPeriodicCondition::Build(UParticleContext * particleContext, EDimensionali
 	SupportRange = particleContext->GetParticleDistance() * 2;
 	ParticleContext = particleContext;
 	Dimensionality = dimensionality;
+
+	// X is periodic in every dimensionality, Z from two dimensions and Y only in three dimensions
+	Periods = Vector3D(BoxMax.X - BoxMin.X, 0.0, 0.0);
+	if (Dimensionality == EDimensionality::Three) {
+		Periods.Y = BoxMax.Y - BoxMin.Y;
+	}
+	if (Dimensionality == EDimensionality::Three || Dimensionality == EDimensionality::Two) {
+		Periods.Z = BoxMax.Z - BoxMin.Z;
+	}
 }
 
 void UPeriodicCondition::UpdateGhostParticles()
 {
-	GhostParticles.clear();
-	ReferencedParticles.clear();
-	ReferencedParticlesIndices.clear();
-	MirroringCauses.clear();
-
 	const std::vector<UFluid*>& fluids = ParticleContext->GetFluids();
-	for (const UFluid * fluid : fluids) {
-		for (int i = 0; i < fluid->Particles->size(); i++) {
-			Particle& f = fluid->Particles->at(i);
-			// check left side
-			if (f.Position.X < BoxMin.X + SupportRange && f.Position.X > BoxMin.X) {
-				// Particle needs to be mirrored in X direction
-				Vector3D ghostPosition = Vector3D(f.Position.X + (BoxMax.X - BoxMin.X) , f.Position.Y, f.Position.Z );
-				GhostParticles.push_back(MakeGhostParticle(ghostPosition, f));
-				ReferencedParticles.push_back(&f);
-				ReferencedParticlesIndices.push_back(i);
-				MirroringCauses.push_back(EMirroringCause::Left);
-			}
-
-			// check right side
-			if (f.Position.X > BoxMax.X - SupportRange && f.Position.X < BoxMax.X) {
-				// Particle needs to be mirrored in X direction
-				Vector3D ghostPosition = Vector3D(f.Position.X - (BoxMax.X - BoxMin.X) , f.Position.Y, f.Position.Z );
-				GhostParticles.push_back(MakeGhostParticle(ghostPosition, f));
-				ReferencedParticles.push_back(&f);
-				ReferencedParticlesIndices.push_back(i);
-				MirroringCauses.push_back(EMirroringCause::Right);
-			}
 
-			if (Dimensionality == EDimensionality::Three) {
-				// check front side
-				if (f.Position.Y < BoxMin.Y + SupportRange && f.Position.Y > BoxMin.Y) {
-					// Particle needs to be mirrored in Y direction
-					Vector3D ghostPosition = Vector3D(f.Position.X, f.Position.Y + (BoxMax.Y - BoxMin.Y), f.Position.Z);
-					GhostParticles.push_back(MakeGhostParticle(ghostPosition, f));
-					ReferencedParticles.push_back(&f);
-					ReferencedParticlesIndices.push_back(i);
-					MirroringCauses.push_back(EMirroringCause::Front);
-				}
+	std::vector<int> fluidOffsets(fluids.size() + 1, 0);
+	for (int fluidIndex = 0; fluidIndex < fluids.size(); fluidIndex++) {
+		fluidOffsets[fluidIndex + 1] = fluidOffsets[fluidIndex] + fluids[fluidIndex]->Particles->size();
+	}
 
-				// check back side
-				if (f.Position.Y > BoxMax.Y - SupportRange && f.Position.Y < BoxMax.Y) {
-					// Particle needs to be mirrored in Y direction
-					Vector3D ghostPosition = Vector3D(f.Position.X, f.Position.Y - (BoxMax.Y - BoxMin.Y), f.Position.Z);
-					GhostParticles.push_back(MakeGhostParticle(ghostPosition, f));
-					ReferencedParticles.push_back(&f);
-					ReferencedParticlesIndices.push_back(i);
-					MirroringCauses.push_back(EMirroringCause::Back);
-				}
-			}
-			
-			if (Dimensionality == EDimensionality::Three || Dimensionality == EDimensionality::Two) {
-				// check bottom side
-				if (f.Position.Z < BoxMin.Z + SupportRange && f.Position.Z > BoxMin.Z) {
-					// Particle needs to be mirrored in Z direction
-					Vector3D ghostPosition = Vector3D(f.Position.X, f.Position.Y, f.Position.Z + (BoxMax.Z - BoxMin.Z));
-					GhostParticles.push_back(MakeGhostParticle(ghostPosition, f));
-					ReferencedParticles.push_back(&f);
-					ReferencedParticlesIndices.push_back(i);
-					MirroringCauses.push_back(EMirroringCause::Bottom);
-				}
+	// first pass counts the images of every particle
+	std::vector<int> ghostOffsets(fluidOffsets.back() + 1, 0);
+	for (int fluidIndex = 0; fluidIndex < fluids.size(); fluidIndex++) {
+		const std::vector<Particle>& particles = *fluids[fluidIndex]->Particles;
+		ParallelFor(particles.size(), [&](int32 i) {
+			double axisShifts[3][3];
+			int numAxisShifts[3];
+			// removed particles have no images
+			ghostOffsets[fluidOffsets[fluidIndex] + i + 1] = particles[i].IsRemoved ? 0 : GetImageShifts(particles[i].Position, axisShifts, numAxisShifts);
+		});
+	}
 
-				// check top side
-				if (f.Position.Z > BoxMax.Z - SupportRange && f.Position.Z < BoxMax.Z) {
-					// Particle needs to be mirrored in Z direction
-					Vector3D ghostPosition = Vector3D(f.Position.X, f.Position.Y, f.Position.Z - (BoxMax.Z - BoxMin.Z));
-					GhostParticles.push_back(MakeGhostParticle(ghostPosition, f));
-					ReferencedParticles.push_back(&f);
-					ReferencedParticlesIndices.push_back(i);
-					MirroringCauses.push_back(EMirroringCause::Top);
-				}
-			}
+	// the prefix sum gives every particle its own range of ghosts, so the second pass needs no synchronisation
+	for (int i = 1; i < ghostOffsets.size(); i++) {
+		ghostOffsets[i] += ghostOffsets[i - 1];
+	}
 
-			if (Dimensionality == EDimensionality::Three) {
-				// TODO
-				// check all 8 corners
+	const int numGhosts = ghostOffsets.back();
+	GhostFluids.resize(numGhosts);
+	GhostIndices.resize(numGhosts);
+	GhostShifts.resize(numGhosts);
+
+	// second pass writes the images, all combinations of the shifts on each axis except the particle itself
+	for (int fluidIndex = 0; fluidIndex < fluids.size(); fluidIndex++) {
+		const std::vector<Particle>& particles = *fluids[fluidIndex]->Particles;
+		ParallelFor(particles.size(), [&](int32 i) {
+			if (particles[i].IsRemoved) {
+				return;
 			}
 
-			if (Dimensionality == EDimensionality::Two) {
-				// check top right corner
-				if (f.Position.Z > BoxMax.Z - SupportRange && f.Position.Z < BoxMax.Z &&
-					f.Position.X > BoxMax.X - SupportRange && f.Position.X < BoxMax.X) {
-					// Particle needs to be mirrored in Z direction
-					Vector3D ghostPosition = Vector3D(f.Position.X - (BoxMax.X - BoxMin.X), f.Position.Y, f.Position.Z - (BoxMax.Z - BoxMin.Z));
-					GhostParticles.push_back(MakeGhostParticle(ghostPosition, f));
-					ReferencedParticles.push_back(&f);
-					ReferencedParticlesIndices.push_back(i);
-					MirroringCauses.push_back(EMirroringCause::TopRight);
-				}
-
-				// check top left corner
-				if (f.Position.Z > BoxMax.Z - SupportRange && f.Position.Z < BoxMax.Z &&
-					f.Position.X < BoxMin.X + SupportRange && f.Position.X > BoxMin.X) {
-					// Particle needs to be mirrored in Z direction
-					Vector3D ghostPosition = Vector3D(f.Position.X + (BoxMax.X - BoxMin.X), f.Position.Y, f.Position.Z - (BoxMax.Z - BoxMin.Z));
-					GhostParticles.push_back(MakeGhostParticle(ghostPosition, f));
-					ReferencedParticles.push_back(&f);
-					ReferencedParticlesIndices.push_back(i);
-					MirroringCauses.push_back(EMirroringCause::TopLeft);
-				}
-
-				// check bottom left corner
-				if (f.Position.Z < BoxMin.Z + SupportRange && f.Position.Z > BoxMin.Z &&
-					f.Position.X < BoxMin.X + SupportRange && f.Position.X > BoxMin.X) {
-					// Particle needs to be mirrored in Z direction
-					Vector3D ghostPosition = Vector3D(f.Position.X + (BoxMax.X - BoxMin.X), f.Position.Y, f.Position.Z + (BoxMax.Z - BoxMin.Z));
-					GhostParticles.push_back(MakeGhostParticle(ghostPosition, f));
-					ReferencedParticles.push_back(&f);
-					ReferencedParticlesIndices.push_back(i);
-					MirroringCauses.push_back(EMirroringCause::BottomLeft);
-				}
-
-				// check bottom right corner
-				if (f.Position.Z < BoxMin.Z + SupportRange && f.Position.Z > BoxMin.Z &&
-					f.Position.X > BoxMax.X - SupportRange && f.Position.X < BoxMax.X) {
-					// Particle needs to be mirrored in Z direction
-					Vector3D ghostPosition = Vector3D(f.Position.X - (BoxMax.X - BoxMin.X), f.Position.Y, f.Position.Z + (BoxMax.Z - BoxMin.Z));
-					GhostParticles.push_back(MakeGhostParticle(ghostPosition, f));
-					ReferencedParticles.push_back(&f);
-					ReferencedParticlesIndices.push_back(i);
-					MirroringCauses.push_back(EMirroringCause::BottomRight);
+			double axisShifts[3][3];
+			int numAxisShifts[3];
+			GetImageShifts(particles[i].Position, axisShifts, numAxisShifts);
+
+			int ghost = ghostOffsets[fluidOffsets[fluidIndex] + i];
+			for (int x = 0; x < numAxisShifts[0]; x++) {
+				for (int y = 0; y < numAxisShifts[1]; y++) {
+					for (int z = 0; z < numAxisShifts[2]; z++) {
+						if (x == 0 && y == 0 && z == 0) {
+							continue;
+						}
+						GhostFluids[ghost] = fluidIndex;
+						GhostIndices[ghost] = i;
+						GhostShifts[ghost] = Vector3D(axisShifts[0][x], axisShifts[1][y], axisShifts[2][z]);
+						ghost++;
+					}
 				}
 			}
-
-			if (Dimensionality == EDimensionality::One) {
-				// check no corners
-			}
-		}
-	}
-}
-
-void UPeriodicCondition::UpdateGhostParticleAttributes(bool updatePosition)
-{
-	for (int i = 0; i < GhostParticles.size(); i++) {
-		GhostParticles[i] = MakeGhostParticle(GhostParticles[i].Position, *ReferencedParticles[i]);
-	}
-
-	if (updatePosition) {
-		for (int i = 0; i < GhostParticles.size(); i++) {
-			const Particle& f = *ReferencedParticles[i];
-
-			switch (MirroringCauses[i]) {
-			case EMirroringCause::Left:
-				GhostParticles[i].Position = Vector3D(f.Position.X + (BoxMax.X - BoxMin.X), f.Position.Y, f.Position.Z);
-				break;
-			case EMirroringCause::Right:
-				GhostParticles[i].Position = Vector3D(f.Position.X - (BoxMax.X - BoxMin.X), f.Position.Y, f.Position.Z);
-				break;
-			case EMirroringCause::Front:
-				GhostParticles[i].Position = Vector3D(f.Position.X, f.Position.Y + (BoxMax.Y - BoxMin.Y), f.Position.Z);
-				break;
-			case EMirroringCause::Back:
-				GhostParticles[i].Position = Vector3D(f.Position.X, f.Position.Y - (BoxMax.Y - BoxMin.Y), f.Position.Z);
-				break;
-			case EMirroringCause::Bottom:
-				GhostParticles[i].Position = Vector3D(f.Position.X, f.Position.Y, f.Position.Z + (BoxMax.Z - BoxMin.Z));
-				break;	
-			case EMirroringCause::Top:
-				GhostParticles[i].Position = Vector3D(f.Position.X, f.Position.Y, f.Position.Z - (BoxMax.Z - BoxMin.Z));
-				break;
-			case EMirroringCause::BottomLeft:
-				GhostParticles[i].Position = Vector3D(f.Position.X + (BoxMax.X - BoxMin.X), f.Position.Y, f.Position.Z + (BoxMax.Z - BoxMin.Z));
-				break;
-			case EMirroringCause::BottomRight:
-				GhostParticles[i].Position = Vector3D(f.Position.X - (BoxMax.X - BoxMin.X), f.Position.Y, f.Position.Z + (BoxMax.Z - BoxMin.Z));
-				break;
-			case EMirroringCause::TopLeft:
-				GhostParticles[i].Position = Vector3D(f.Position.X + (BoxMax.X - BoxMin.X), f.Position.Y, f.Position.Z - (BoxMax.Z - BoxMin.Z));
-				break;
-			case EMirroringCause::TopRight:
-				GhostParticles[i].Position = Vector3D(f.Position.X - (BoxMax.X - BoxMin.X), f.Position.Y, f.Position.Z - (BoxMax.Z - BoxMin.Z));
-				break;
-			}
-			 
-		}
+		});
 	}
 
+	UpdateGhostParticleAttributes();
 }
 
-void UPeriodicCondition::UpdateGhostParticleDensity()
+void UPeriodicCondition::UpdateGhostParticleAttributes()
 {
-	for (int i = 0; i < GhostParticles.size(); i++) {
-		GhostParticles[i].Density = ReferencedParticles[i]->Density;
-	}
-}
+	const std::vector<UFluid*>& fluids = ParticleContext->GetFluids();
+	GhostPositions.resize(GhostIndices.size());
 
-void UPeriodicCondition::UpdateGhostParticlePressure()
-{
-	for (int i = 0; i < GhostParticles.size(); i++) {
-		GhostParticles[i].Pressure = ReferencedParticles[i]->Pressure;
-	}
+	// gather the positions of the referenced particles, the ghosts own no particles
+	ParallelFor(GhostIndices.size(), [&](int32 j) {
+		GhostPositions[j] = fluids[GhostFluids[j]]->Particles->at(GhostIndices[j]).Position + GhostShifts[j];
+	});
 }
 
-void UPeriodicCondition::UpdateGhostParticleAcceleration()
+int UPeriodicCondition::GetImageShifts(const Vector3D& position, double axisShifts[3][3], int numAxisShifts[3]) const
 {
-	for (int i = 0; i < GhostParticles.size(); i++) {
-		GhostParticles[i].Acceleration = ReferencedParticles[i]->Acceleration;
+	const double coordinates[3] = { position.X, position.Y, position.Z };
+	const double periods[3] = { Periods.X, Periods.Y, Periods.Z };
+	const double mins[3] = { BoxMin.X, BoxMin.Y, BoxMin.Z };
+	const double maxs[3] = { BoxMax.X, BoxMax.Y, BoxMax.Z };
+
+	int numImages = 1;
+	for (int axis = 0; axis < 3; axis++) {
+		// the first shift of every axis keeps the particle in place
+		axisShifts[axis][0] = 0.0;
+		numAxisShifts[axis] = 1;
+
+		if (periods[axis] > 0.0) {
+			// particles near the lower limit continue behind the upper limit and the other way around
+			if (coordinates[axis] < mins[axis] + SupportRange) {
+				axisShifts[axis][numAxisShifts[axis]++] = periods[axis];
+			}
+			if (coordinates[axis] > maxs[axis] - SupportRange) {
+				axisShifts[axis][numAxisShifts[axis]++] = -periods[axis];
+			}
+		}
+		numImages *= numAxisShifts[axis];
 	}
+
+	// faces, edges and corners, up to 26 images in three dimensions
+	return numImages - 1;
 }
 
 void UPeriodicCondition::MoveOutOfBoundsParticles()
@@ -275,29 +185,54 @@ void UPeriodicCondition::MoveOutOfBoundsParticles()
 	}
 }
 
-const std::vector<Particle>& UPeriodicCondition::GetGhostParticles() const
+Vector3D UPeriodicCondition::GetMinimumImage(const Vector3D& distanceVector) const
+{
+	Vector3D image = distanceVector;
+
+	// shift by whole periods until the component lies within half a period
+	if (Periods.X > 0.0) {
+		image.X -= Periods.X * floor(image.X / Periods.X + 0.5);
+	}
+	if (Periods.Y > 0.0) {
+		image.Y -= Periods.Y * floor(image.Y / Periods.Y + 0.5);
+	}
+	if (Periods.Z > 0.0) {
+		image.Z -= Periods.Z * floor(image.Z / Periods.Z + 0.5);
+	}
+	return image;
+}
+
+const Vector3D& UPeriodicCondition::GetPeriods() const
+{
+	return Periods;
+}
+
+const Vector3D& UPeriodicCondition::GetBoxMin() const
+{
+	return BoxMin;
+}
+
+const Vector3D& UPeriodicCondition::GetBoxMax() const
+{
+	return BoxMax;
+}
+
+int UPeriodicCondition::GetNumGhostParticles() const
 {
-	return GhostParticles;
+	return GhostIndices.size();
 }
 
-const std::vector<Particle*>& UPeriodicCondition::GetReferencedParticles() const
+const std::vector<Vector3D>& UPeriodicCondition::GetGhostPositions() const
 {
-	return ReferencedParticles;
+	return GhostPositions;
 }
 
-const std::vector<int>& UPeriodicCondition::GetReferencedParticlesIndices() const
+const std::vector<int>& UPeriodicCondition::GetGhostFluids() const
 {
-	return ReferencedParticlesIndices;
+	return GhostFluids;
 }
 
-Particle UPeriodicCondition::MakeGhostParticle(const Vector3D & ghostPosition, const Particle & referenceParticle)
+const std::vector<int>& UPeriodicCondition::GetGhostIndices() const
 {
-	return Particle(ghostPosition,
-		referenceParticle.Velocity,
-		referenceParticle.Acceleration,
-		referenceParticle.Mass,
-		referenceParticle.Fluid,
-		referenceParticle.Pressure,
-		referenceParticle.Density,
-		referenceParticle.IsScripted);
+	return GhostIndices;
 }
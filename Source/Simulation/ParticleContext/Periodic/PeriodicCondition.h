@@ -12,23 +12,10 @@ class UParticleContext;
 class Particle;
 enum EDimensionality;
 
-enum class EMirroringCause {
-	Left,
-	Right,
-	Bottom,
-	Top,
-	Front,
-	Back,
-	BottomLeft,
-	BottomRight,
-	TopLeft,
-	TopRight
-};
-
 UCLASS(BlueprintType)
 // Periodic Condition implements a periodic simulation domain.
-// This is done by copying all particles near the periodic limit to the other side. Copied particles are calles ghost particles.
-// These particles are copies of the original particles. Throughout a simulation step the ghost particle attributes need to be refreshed multiple times.
+// Particles leaving the domain are moved to the other side. Interactions across the periodic limit are found by the neighbors finder,
+// which wraps its cells around the domain, and evaluated with the minimum image of the distance vector. No particles are copied for that.
 class UPeriodicCondition : public UObject{
 	GENERATED_BODY()
 public:
@@ -38,27 +25,30 @@ public:
 
 	void Build(UParticleContext * particleContext, EDimensionality dimensionality);
 
-	// Generated ghost particles required for the periodic condition, assings positions and copies all other attributes from the original particle
-	// Do not call if current neighborhoods are still required, since GhostParticle vector is modified
-	void UpdateGhostParticles();
+	void MoveOutOfBoundsParticles();
 
-	// Copies all attributes from the refrenced particles to the ghost particle except the position
-	void UpdateGhostParticleAttributes(bool updatePosition = false);
+	// Shortest vector between two positions over all periodic images of the domain.
+	// Periodic axes have to be longer than twice the support, otherwise a particle could interact with more than one image
+	Vector3D GetMinimumImage(const Vector3D& distanceVector) const;
 
-	// Updates the density stored in ghost particles by their referenced particles density
-	void UpdateGhostParticleDensity();
+	// Length of the domain on each axis, zero on axes that are not periodic
+	const Vector3D& GetPeriods() const;
+	const Vector3D& GetBoxMin() const;
+	const Vector3D& GetBoxMax() const;
 
-	// Updates the pressure stored in ghost particles by their referenced particles pressure
-	void UpdateGhostParticlePressure();
+	// Generates images of the particles near the periodic limit, only used to visualise the periodic continuation of the fluid.
+	// Particles at edges and corners get an image across every combination of limits they are near
+	void UpdateGhostParticles();
 
-	// Updates the acceleration stored in ghost particles by their referenced particles acceleration
-	void UpdateGhostParticleAcceleration();
+	// Gathers the positions of the ghost particles from the particles they are images of
+	void UpdateGhostParticleAttributes();
 
-	void MoveOutOfBoundsParticles();
+	int GetNumGhostParticles() const;
+	const std::vector<Vector3D>& GetGhostPositions() const;
 
-	const std::vector<Particle>& GetGhostParticles() const;
-	const std::vector<Particle*>& GetReferencedParticles() const;
-	const std::vector<int>& GetReferencedParticlesIndices() const;
+	// Fluid and particle index of the particle a ghost particle is an image of
+	const std::vector<int>& GetGhostFluids() const;
+	const std::vector<int>& GetGhostIndices() const;
 
 protected:
 	// Defines the bounds of the periodic space
@@ -71,16 +61,19 @@ protected:
 	// DImensionality is important to know in which directions the fluid needs to be copied
 	EDimensionality Dimensionality;
 
+	// Length of the domain on periodic axes, zero otherwise
+	Vector3D Periods;
+
 	// the particle context the periodic condition acts on
 	UParticleContext * ParticleContext;
 
-	// Particles that are generated for the periodicCondition
-	std::vector<Particle> GhostParticles;
+	// Ghost particles are stored as references to the imaged particle and the shift of the image
+	std::vector<int> GhostFluids;
+	std::vector<int> GhostIndices;
+	std::vector<Vector3D> GhostShifts;
 
-	// References to the particles that are the real counterpart to ghost particles
-	std::vector<Particle*> ReferencedParticles;
-	std::vector<int> ReferencedParticlesIndices;
-	std::vector<EMirroringCause> MirroringCauses;
+	std::vector<Vector3D> GhostPositions;
 
-	static Particle MakeGhostParticle(const Vector3D& ghostPosition, const Particle& referenceParticle);
+	// Shifts the position is imaged with on each axis, the first shift of an axis is zero. Returns the number of images
+	int GetImageShifts(const Vector3D& position, double axisShifts[3][3], int numAxisShifts[3]) const;
 };
\ No newline at end of file
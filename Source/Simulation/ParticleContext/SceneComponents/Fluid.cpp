@@ -67,6 +67,7 @@ void UFluid::InitializeBoxFluid(float particleDistance, FTransform transform, FV
 		}
 		displace = !displace;
 	}
+	AssignParticleIds();
 	ComputeMasses(dimensionality, particleDistance, fluidDensity);
 }
 
@@ -85,13 +86,14 @@ void UFluid::InitializeFluidFromPositionsAndVelocities(TArray<Vector3D>& positio
 	for (int i = 0; i < positions.Num(); i++) {
 		Particles->emplace_back(positions[i], velocities[i], 0, this);
 	}
+	AssignParticleIds();
 
 	// fill in masses
 	ComputeMasses(dimensionality, GetParticleContext()->GetParticleDistance(), fluidDensity);
 
 }
 
-void UFluid::InitializeFluidFromPositionsVelocitiesAndMasses(TArray<Vector3D>& positions, TArray<Vector3D>& velocities, TArray<double> masses, float fluidDensity, float viscosity)
+void UFluid::InitializeFluidFromPositionsVelocitiesAndMasses(TArray<Vector3D>& positions, TArray<Vector3D>& velocities, TArray<double> masses, float fluidDensity, float viscosity, const std::vector<uint32_t>& ids, uint32_t nextParticleId)
 {
 	if (positions.Num() != velocities.Num()) {
 		throw("There have to be the same amount of velocities and positions!");
@@ -107,6 +109,17 @@ void UFluid::InitializeFluidFromPositionsVelocitiesAndMasses(TArray<Vector3D>& p
 	for (int i = 0; i < positions.Num(); i++) {
 		Particles->emplace_back(positions[i], velocities[i], masses[i], this);
 	}
+	AssignParticleIds();
+
+	if (ids.size() == Particles->size()) {
+		// new particles must not get the id of an earlier one
+		NextParticleId = nextParticleId;
+		for (int i = 0; i < ids.size(); i++) {
+			Particles->at(i).Id = ids[i];
+			NextParticleId = std::max(NextParticleId, ids[i] + 1);
+		}
+		RebuildParticleIndex();
+	}
 }
 
 UFluid * UFluid::CreateFluidFromSpawner(AFluidSpawner * fluidSpawner)
@@ -266,15 +279,17 @@ TArray<FVector> UFluid::GetAllParticlePositions()
 {
 	TArray<FVector> positions;
 
-	for (Particle particle : *Particles) {
-		positions.Add(particle.Position);
+	for (const Particle& particle : *Particles) {
+		if (!particle.IsRemoved) {
+			positions.Add(particle.Position);
+		}
 	}
 	return positions;
 }
 
 void UFluid::AddParticle(const Particle& particle)
 {
-	Particles->push_back(particle);
+	PlaceParticle(particle);
 }
 
 void UFluid::AddParticle(FVector position, FVector velocity, bool updateVisual)
@@ -294,7 +309,7 @@ void UFluid::AddParticle(FVector position, FVector velocity, bool updateVisual)
 		break;
 	}
 
-	Particles->emplace_back((Vector3D)position, (Vector3D)velocity, mass, this);
+	PlaceParticle(Particle((Vector3D)position, (Vector3D)velocity, mass, this));
 
 	if (updateVisual) {
 		GetParticleContext()->UpdateVisual();
@@ -320,45 +335,142 @@ void UFluid::AddParticles(const std::vector<FVector>& positions, const std::vect
 		break;
 	}
 	
-	Particles->reserve(Particles->size() + positions.size());
+	Particles->reserve(Particles->size() + std::max(0, static_cast<int>(positions.size()) - static_cast<int>(FreeSlots.size())));
 
 	for (int i = 0; i < positions.size(); i++) {
-		Particles->emplace_back((Vector3D)positions[i], (Vector3D)velocities[i], mass, this);
+		PlaceParticle(Particle((Vector3D)positions[i], (Vector3D)velocities[i], mass, this));
 	}
 
 }
 
 bool UFluid::RemoveParticle(int index) {
 
-	if (index >= Particles->size()) {
+	if (index < 0 || index >= Particles->size() || Particles->at(index).IsRemoved) {
 		return false;
 	}
 
-	Particles->erase(Particles->begin() + index);
+	Particle& particle = Particles->at(index);
+
+	// the particle stays in place as a sleeping particle without mass, which no solver step and no neighbor search touches
+	particle.IsRemoved = true;
+	particle.IsSleeping = true;
+	particle.IsActiveInStep = false;
+	particle.RequiresDensity = false;
+	particle.IsScripted = false;
+	particle.Mass = 0.0;
+	particle.Velocity = Vector3D::Zero;
+	particle.Acceleration = Vector3D::Zero;
+	particle.LastTimestep = 0.0;
+	particle.Pressure = 0.0;
+	particle.Density = RestDensity;
+	particle.FluidNeighbors.clear();
+	particle.StaticBorderNeighbors.clear();
+
+	FreeSlots.push_back(index);
+	IdToIndex.erase(particle.Id);
 
 	return true;
 }
 
 bool UFluid::RemoveParticle(Particle & particle) {
 
-	size_t oldSize = Particles->size();
-	std::remove_if(Particles->begin(), Particles->end(),
-		[&](const Particle & particleCandidate) {
-		return &particleCandidate == &particle;
+	// the particle has to be part of this fluid
+	if (Particles->empty() || &particle < Particles->data() || &particle >= Particles->data() + Particles->size()) {
+		return false;
+	}
+
+	return RemoveParticle(static_cast<int>(&particle - Particles->data()));
+}
+
+int UFluid::RemoveParticles(std::function<bool(const Particle&)> criteria) {
+	std::vector<char> remove(Particles->size());
+	ParallelFor(Particles->size(), [&](int32 i) {
+		const Particle& particle = Particles->at(i);
+		remove[i] = !particle.IsRemoved && criteria(particle);
 	});
 
-	bool deletedParticle = Particles->size() != oldSize;
+	int deletedParticles = 0;
+	for (int i = 0; i < remove.size(); i++) {
+		if (remove[i] && RemoveParticle(i)) {
+			deletedParticles++;
+		}
+	}
 
-	return deletedParticle;
+	return deletedParticles;
 }
 
-int UFluid::RemoveParticles(std::function<bool(const Particle&)> criteria) {
+int UFluid::CompactParticles(double maxRemovedFraction)
+{
+	if (FreeSlots.empty() || FreeSlots.size() <= maxRemovedFraction * Particles->size()) {
+		return 0;
+	}
+
 	size_t oldSize = Particles->size();
-	Particles->erase(std::remove_if(Particles->begin(), Particles->end(), criteria), Particles->end());
+	Particles->erase(std::remove_if(Particles->begin(), Particles->end(), [](const Particle& particle) { return particle.IsRemoved; }), Particles->end());
 
-	int deletedParticles = oldSize - Particles->size();
+	// the particles moved, compaction is rare enough to index them again
+	RebuildParticleIndex();
 
-	return deletedParticles;
+	return oldSize - Particles->size();
+}
+
+void UFluid::RebuildParticleIndex()
+{
+	FreeSlots.clear();
+	IdToIndex.clear();
+	IdToIndex.reserve(Particles->size());
+	for (int i = 0; i < Particles->size(); i++) {
+		if (Particles->at(i).IsRemoved) {
+			FreeSlots.push_back(i);
+		}
+		else {
+			IdToIndex[Particles->at(i).Id] = i;
+		}
+	}
+}
+
+uint32_t UFluid::CreateParticleId()
+{
+	return NextParticleId++;
+}
+
+int UFluid::FindParticle(uint32_t id) const
+{
+	auto entry = IdToIndex.find(id);
+	return entry != IdToIndex.end() ? entry->second : -1;
+}
+
+int UFluid::GetParticleIndex(int particleId) const
+{
+	return particleId < 0 ? -1 : FindParticle(static_cast<uint32_t>(particleId));
+}
+
+void UFluid::AssignParticleIds()
+{
+	NextParticleId = 0;
+	for (Particle& particle : *Particles) {
+		particle.Id = CreateParticleId();
+	}
+	RebuildParticleIndex();
+}
+
+int UFluid::PlaceParticle(const Particle& particle)
+{
+	int index;
+	if (FreeSlots.empty()) {
+		index = Particles->size();
+		Particles->push_back(particle);
+	}
+	else {
+		// the most recently freed slot is reused first, it is the most likely one to be in the cache
+		index = FreeSlots.back();
+		FreeSlots.pop_back();
+		Particles->at(index) = particle;
+	}
+
+	Particles->at(index).Id = CreateParticleId();
+	IdToIndex[Particles->at(index).Id] = index;
+	return index;
 }
 
 int UFluid::GetNumParticles() const
@@ -366,6 +478,16 @@ int UFluid::GetNumParticles() const
 	return Particles->size();
 }
 
+int UFluid::GetNumLiveParticles() const
+{
+	return Particles->size() - FreeSlots.size();
+}
+
+int UFluid::GetNumRemovedParticles() const
+{
+	return FreeSlots.size();
+}
+
 void UFluid::ComputeMasses(EDimensionality dimensionality, double particleDistance, double fluidDensity)
 {
 	switch (dimensionality) {
@@ -495,8 +617,21 @@ UFluid * UFluid::ReadFluidFromFile(std::string file, UFluid * fluid) {
 	}
 
 
+	// the next particle id is optional, files written before particles had ids have none
+	uint32_t nextParticleId = 0;
+	if (std::getline(fluidFile, line) && line.find("Next Particle Id:\t") != std::string::npos) {
+		try {
+			nextParticleId = std::stoul(line.substr(18, line.length() - 18));
+		}
+		catch (std::invalid_argument) {
+			// No next particle id could be read
+			return nullptr;
+		}
+		std::getline(fluidFile, line);
+	}
+
 	// check Particle keyword
-	if (std::getline(fluidFile, line))
+	if (fluidFile)
 	{
 		if (line != "Particles") {
 			// couldn't find "Particles" Keyword
@@ -511,6 +646,8 @@ UFluid * UFluid::ReadFluidFromFile(std::string file, UFluid * fluid) {
 	TArray<Vector3D> positions =  TArray<Vector3D>();
 	TArray<Vector3D> velocities = TArray<Vector3D>();
 	TArray<double> masses = TArray<double>();
+	std::vector<uint32_t> ids;
+	bool hasIds = true;
 
 	// read all particles
 	while (std::getline(fluidFile, line)) {
@@ -546,7 +683,7 @@ UFluid * UFluid::ReadFluidFromFile(std::string file, UFluid * fluid) {
 		}
 
 		startindex = line.find("Velocity: ");
-		endindex = line.find("\n", startindex);
+		endindex = line.find("\t", startindex);
 
 		try {
 			velocity = Vector3D::FromString(line.substr(startindex + 10, endindex - startindex - 10));
@@ -556,12 +693,30 @@ UFluid * UFluid::ReadFluidFromFile(std::string file, UFluid * fluid) {
 			return nullptr;
 		}
 
+		// ids are only restored if every particle has one
+		size_t idIndex = line.find("Id: ");
+		if (idIndex != std::string::npos && hasIds) {
+			try {
+				ids.push_back(std::stoul(line.substr(idIndex + 4)));
+			}
+			catch (std::invalid_argument) {
+				// No id could be read
+				return nullptr;
+			}
+		}
+		else {
+			hasIds = false;
+		}
+
 		positions.Add(position);
 		velocities.Add(velocity);
 		masses.Add(mass);
 
 	}
-	fluid->InitializeFluidFromPositionsVelocitiesAndMasses(positions, velocities, masses, restDensity, viscosity);
+	if (!hasIds) {
+		ids.clear();
+	}
+	fluid->InitializeFluidFromPositionsVelocitiesAndMasses(positions, velocities, masses, restDensity, viscosity, ids, nextParticleId);
 
 	return fluid;
 }
@@ -581,9 +736,13 @@ void UFluid::WriteFluidToFile(const std::string file, int iterationCount)
 	fluidFile << "Rest Density:\t" << RestDensity << std::endl;
 	fluidFile << "Viscosity:\t" << Viscosity << std::endl;
 	fluidFile << "Particle Distance:\t" << GetParticleContext()->GetParticleDistance() << std::endl;
+	fluidFile << "Next Particle Id:\t" << NextParticleId << std::endl;
 	fluidFile << "Particles" << std::endl;
 	for (Particle & particle : *Particles) {
-		fluidFile << "Mass: " << particle.Mass << "\t" << "Position: " << particle.Position.ToString() << "\t" << "Velocity: " << particle.Velocity.ToString() << std::endl;
+		if (particle.IsRemoved) {
+			continue;
+		}
+		fluidFile << "Mass: " << particle.Mass << "\t" << "Position: " << particle.Position.ToString() << "\t" << "Velocity: " << particle.Velocity.ToString() << "\t" << "Id: " << particle.Id << std::endl;
 	}
 	fluidFile << std::endl;
 	fluidFile.close();
@@ -5,6 +5,7 @@
 #include <vector>
 #include <algorithm>
 #include <functional>
+#include <unordered_map>
 
 #include "Kismet/KismetMathLibrary.h"
 #include "CoreMinimal.h"
@@ -31,7 +32,8 @@ public:
 
 	void InitializeBoxFluid(float particleDistance, FTransform transform, FVector initialVelocity, float fluidDensity, float viscosity, float massFactor, EDimensionality dimensionality, bool displaceParticles = true);
 	void InitializeFluidFromPositionsAndVelocities(TArray<Vector3D>& positions, TArray<Vector3D>& velocities, float fluidDensity, float viscosity, EDimensionality dimensionality);
-	void InitializeFluidFromPositionsVelocitiesAndMasses(TArray<Vector3D>& positions, TArray<Vector3D>& velocities, TArray<double> masses, float fluidDensity, float viscosity);
+	// ids of the particles and the next free id are restored if given, e.g. from a saved simulation state
+	void InitializeFluidFromPositionsVelocitiesAndMasses(TArray<Vector3D>& positions, TArray<Vector3D>& velocities, TArray<double> masses, float fluidDensity, float viscosity, const std::vector<uint32_t>& ids = std::vector<uint32_t>(), uint32_t nextParticleId = 0);
 	
 	UFUNCTION(BlueprintPure)
 	static UFluid * CreateFluidFromSpawner(AFluidSpawner * fluidSpawner);
@@ -61,12 +63,32 @@ public:
 
 	void AddParticles(const std::vector<FVector>& positions, const std::vector<FVector>& velocities);
 
+	// Removed particles only get flagged, so indices of the other particles stay valid. New particles reuse their slots
 	bool RemoveParticle(int index); 
 	bool RemoveParticle(Particle & particle);
 	int RemoveParticles(std::function<bool(const Particle&)> criteria);
 
+	// Erases removed particles if they make up more than maxRemovedFraction of the slots, so the cost is spread over many removals. Returns the number of erased slots
+	int CompactParticles(double maxRemovedFraction = 0.25);
+
+	// Collects the slots of removed particles and the indices of all ids again after the particles were rearranged
+	void RebuildParticleIndex();
+
+	// Returns a new id for a particle which is not created by the fluid, e.g. by splitting particles. Its index is registered by RebuildParticleIndex
+	uint32_t CreateParticleId();
+
+	// Index of the particle with the given id, -1 if there is no such particle
+	int FindParticle(uint32_t id) const;
+
+	UFUNCTION(BlueprintPure)
+	int GetParticleIndex(int particleId) const;
+
+	// Number of slots including removed particles. Particle indices range up to this number
 	int GetNumParticles() const;
 
+	int GetNumLiveParticles() const;
+	int GetNumRemovedParticles() const;
+
 	// Computes masses of fluid particles based on the particle distance, fluid density and the mass factor.
 	void ComputeMasses(EDimensionality dimensionality, double particleDistance, double fluidDensity);
 
@@ -100,6 +122,20 @@ protected:
 	// Used to scale the mass of the particles. This results in more particles in a neighborhood
 	double MassFactor;
 
+	// Slots of removed particles, reused by new particles
+	std::vector<int> FreeSlots;
+
+	uint32_t NextParticleId = 0;
+
+	// Index of every live particle by its id, updated with every added and removed particle
+	std::unordered_map<uint32_t, int> IdToIndex;
+
+	// Gives the particles built at once consecutive ids
+	void AssignParticleIds();
+
+	// Places a new particle in a free slot or at the end and returns its index
+	int PlaceParticle(const Particle& particle);
+
 public:
 
 	UFUNCTION(BlueprintPure)
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vector>
+#include <cstdint>
 #include "DataStructures/Vector3D.h"
 
 enum ParticleType {
@@ -74,6 +75,37 @@ public:
 	// Flags if particles is scripted by volumes
 	bool IsScripted = false;
 
+	// Acceleration and timestep of the last integration step. Used by integrators that need a history, zero timestep means no history
+	Vector3D LastAcceleration = Vector3D(0.0);
+	double LastTimestep = 0.0;
+
+	// Power-of-two timestep level for local time stepping. The particle receives its velocity change for 2^TimestepLevel steps at the start of each block and drifts in between
+	int TimestepLevel = 0;
+
+	// Flags if a block of the particle starts in the current step, so its accelerations are computed
+	bool IsActiveInStep = true;
+
+	// Flags if the density and pressure of the particle are needed in the current step, because it or one of its neighbors is active
+	bool RequiresDensity = true;
+
+	// Flags if the particle is at rest and excluded from the solver until it gets disturbed
+	bool IsSleeping = false;
+
+	// Number of consecutive steps the particle stayed below the resting thresholds
+	int RestingSteps = 0;
+
+	// Kernel support of the particle relative to the particle distance of the context. Changed by splitting and merging with adaptive resolution
+	double SmoothingScale = 1.0;
+
+	// Scales the error tolerances of pressure solvers for this particle. Raised outside of regions of interest
+	double ErrorToleranceFactor = 1.0;
+
+	// Identifies the particle in its fluid for its whole life, also when its index changes by compaction or adaptive resolution
+	uint32_t Id = 0;
+
+	// Flags if the particle was removed. A removed particle sleeps without mass and neighbors until its slot is reused or the fluid is compacted
+	bool IsRemoved = false;
+
 
 	std::vector<FluidNeighbor> FluidNeighbors;
 	std::vector<StaticBorderNeighbor> StaticBorderNeighbors;
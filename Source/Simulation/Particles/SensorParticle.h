@@ -8,11 +8,6 @@ public:
 
 	// Constructs a sensor particle
 	SensorParticle(Vector3D position);
-
-	double SensorDensity;
-
-	std::vector<FluidNeighbor> FluidNeighbors;
-	std::vector<StaticBorderNeighbor> StaticBorderNeighbors;
 };
 
 
@@ -0,0 +1,273 @@
+#include "ColumnarFile.h"
+
+#include <cstring>
+
+#include "Misc/Compression.h"
+
+namespace {
+	const char ColumnarMagic[8] = { 'S', 'P', 'H', 'C', 'O', 'L', 'M', 'N' };
+	const uint32 ColumnarVersion = 1;
+	const uint32 CompressedFlag = 1;
+
+	int GetTypeSize(EColumnType type) {
+		switch (type) {
+		case EColumnType::Float32Column:
+			return sizeof(float);
+		case EColumnType::Int32Column:
+			return sizeof(int32);
+		default:
+			return sizeof(double);
+		}
+	}
+
+	template <typename ValueType>
+	void WriteValue(std::ofstream& file, const ValueType& value) {
+		file.write(reinterpret_cast<const char*>(&value), sizeof(ValueType));
+	}
+
+	template <typename ValueType>
+	bool ReadValue(std::ifstream& file, ValueType& value) {
+		return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(ValueType)));
+	}
+
+	template <typename ValueType>
+	void AppendValue(std::vector<uint8>& buffer, ValueType value) {
+		const size_t offset = buffer.size();
+		buffer.resize(offset + sizeof(ValueType));
+		std::memcpy(buffer.data() + offset, &value, sizeof(ValueType));
+	}
+
+	template <typename ValueType>
+	void AppendColumn(const uint8* values, int numRows, std::vector<double>& column) {
+		for (int row = 0; row < numRows; row++) {
+			ValueType value;
+			std::memcpy(&value, values + row * sizeof(ValueType), sizeof(ValueType));
+			column.push_back(static_cast<double>(value));
+		}
+	}
+}
+
+FColumnarFileWriter::~FColumnarFileWriter()
+{
+	Close();
+}
+
+bool FColumnarFileWriter::Open(const std::string& file, const std::vector<FColumnDescription>& columns, const std::string& metadata, bool compress, int rowsPerChunk)
+{
+	Close();
+
+	File.open(file, std::ios::binary);
+	if (!File.is_open()) {
+		return false;
+	}
+
+	Columns = columns;
+	Compress = compress;
+	RowsPerChunk = std::max(1, rowsPerChunk);
+	ColumnBuffers.assign(Columns.size(), std::vector<uint8>());
+	for (int column = 0; column < Columns.size(); column++) {
+		ColumnBuffers[column].reserve(RowsPerChunk * GetTypeSize(Columns[column].Type));
+	}
+	BufferedRows = 0;
+	CurrentColumn = 0;
+
+	File.write(ColumnarMagic, sizeof(ColumnarMagic));
+	WriteValue(File, ColumnarVersion);
+	WriteValue(File, static_cast<uint32>(Columns.size()));
+	WriteValue(File, Compress ? CompressedFlag : 0u);
+
+	// the wall time lets rows be matched to logs and other recordings of the same run
+	const std::string fullMetadata = std::string("Created\t") + TCHAR_TO_UTF8(*FDateTime::UtcNow().ToIso8601()) + '\n' + metadata;
+	WriteValue(File, static_cast<uint32>(fullMetadata.size()));
+	File.write(fullMetadata.data(), fullMetadata.size());
+
+	for (const FColumnDescription& column : Columns) {
+		WriteValue(File, static_cast<uint8>(column.Type));
+		WriteValue(File, static_cast<uint16>(column.Name.size()));
+		File.write(column.Name.data(), column.Name.size());
+	}
+	return true;
+}
+
+bool FColumnarFileWriter::IsOpen() const
+{
+	return File.is_open();
+}
+
+void FColumnarFileWriter::Add(double value)
+{
+	if (CurrentColumn >= Columns.size()) {
+		throw("More values than columns in a row of a columnar file");
+	}
+
+	std::vector<uint8>& buffer = ColumnBuffers[CurrentColumn];
+	switch (Columns[CurrentColumn].Type) {
+	case EColumnType::Float64Column:
+		AppendValue(buffer, value);
+		break;
+	case EColumnType::Float32Column:
+		AppendValue(buffer, static_cast<float>(value));
+		break;
+	case EColumnType::Int32Column:
+		AppendValue(buffer, static_cast<int32>(value));
+		break;
+	}
+	CurrentColumn++;
+}
+
+void FColumnarFileWriter::EndRow()
+{
+	if (CurrentColumn != Columns.size()) {
+		throw("Row of a columnar file ended before all columns were added");
+	}
+
+	CurrentColumn = 0;
+	BufferedRows++;
+
+	if (BufferedRows >= RowsPerChunk) {
+		WriteChunk();
+	}
+}
+
+void FColumnarFileWriter::Flush()
+{
+	if (!File.is_open()) {
+		return;
+	}
+	WriteChunk();
+	File.flush();
+}
+
+void FColumnarFileWriter::Close()
+{
+	if (!File.is_open()) {
+		return;
+	}
+	WriteChunk();
+	File.close();
+}
+
+int FColumnarFileWriter::GetNumColumns() const
+{
+	return Columns.size();
+}
+
+void FColumnarFileWriter::WriteChunk()
+{
+	if (BufferedRows == 0) {
+		return;
+	}
+
+	WriteValue(File, static_cast<uint32>(BufferedRows));
+
+	std::vector<uint8> compressed;
+	for (std::vector<uint8>& buffer : ColumnBuffers) {
+		const uint8* values = buffer.data();
+		int32 size = buffer.size();
+
+		if (Compress) {
+			int32 compressedSize = FCompression::CompressMemoryBound(COMPRESS_ZLIB, size);
+			compressed.resize(compressedSize);
+			if (FCompression::CompressMemory(COMPRESS_ZLIB, compressed.data(), compressedSize, values, size)) {
+				values = compressed.data();
+				size = compressedSize;
+			}
+			else {
+				throw("Chunk of a columnar file could not be compressed");
+			}
+		}
+
+		WriteValue(File, static_cast<uint32>(size));
+		File.write(reinterpret_cast<const char*>(values), size);
+		buffer.clear();
+	}
+
+	BufferedRows = 0;
+}
+
+int FColumnarTable::FindColumn(const std::string& name) const
+{
+	for (int column = 0; column < ColumnNames.size(); column++) {
+		if (ColumnNames[column] == name) {
+			return column;
+		}
+	}
+	return INDEX_NONE;
+}
+
+bool FColumnarFileReader::Read(const std::string& file, FColumnarTable& table)
+{
+	std::ifstream input(file, std::ios::binary);
+
+	char magic[sizeof(ColumnarMagic)];
+	uint32 version, numColumns, flags, metadataSize;
+	if (!input.read(magic, sizeof(magic)) || std::memcmp(magic, ColumnarMagic, sizeof(magic)) != 0 ||
+		!ReadValue(input, version) || version != ColumnarVersion ||
+		!ReadValue(input, numColumns) || !ReadValue(input, flags) || !ReadValue(input, metadataSize)) {
+		return false;
+	}
+
+	table.Metadata.resize(metadataSize);
+	if (metadataSize > 0 && !input.read(&table.Metadata[0], metadataSize)) {
+		return false;
+	}
+
+	std::vector<EColumnType> types(numColumns);
+	table.ColumnNames.assign(numColumns, std::string());
+	table.Columns.assign(numColumns, std::vector<double>());
+
+	for (uint32 column = 0; column < numColumns; column++) {
+		uint8 type;
+		uint16 nameLength;
+		if (!ReadValue(input, type) || !ReadValue(input, nameLength)) {
+			return false;
+		}
+		types[column] = static_cast<EColumnType>(type);
+		table.ColumnNames[column].resize(nameLength);
+		if (nameLength > 0 && !input.read(&table.ColumnNames[column][0], nameLength)) {
+			return false;
+		}
+	}
+
+	std::vector<uint8> stored;
+	std::vector<uint8> values;
+	uint32 numRows;
+	while (ReadValue(input, numRows)) {
+		for (uint32 column = 0; column < numColumns; column++) {
+			uint32 storedSize;
+			if (!ReadValue(input, storedSize)) {
+				return false;
+			}
+			stored.resize(storedSize);
+			if (storedSize > 0 && !input.read(reinterpret_cast<char*>(stored.data()), storedSize)) {
+				return false;
+			}
+
+			const int32 size = numRows * GetTypeSize(types[column]);
+			const uint8* columnValues = stored.data();
+			if (flags & CompressedFlag) {
+				values.resize(size);
+				if (!FCompression::UncompressMemory(COMPRESS_ZLIB, values.data(), size, stored.data(), storedSize)) {
+					return false;
+				}
+				columnValues = values.data();
+			}
+			else if (storedSize != size) {
+				return false;
+			}
+
+			switch (types[column]) {
+			case EColumnType::Float64Column:
+				AppendColumn<double>(columnValues, numRows, table.Columns[column]);
+				break;
+			case EColumnType::Float32Column:
+				AppendColumn<float>(columnValues, numRows, table.Columns[column]);
+				break;
+			case EColumnType::Int32Column:
+				AppendColumn<int32>(columnValues, numRows, table.Columns[column]);
+				break;
+			}
+		}
+	}
+	return true;
+}
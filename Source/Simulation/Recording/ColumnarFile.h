@@ -0,0 +1,87 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <fstream>
+
+#include "CoreMinimal.h"
+
+// Columnar binary files for recorded time series like sensor data and solver statistics.
+//
+// Layout, little endian:
+//   header    "SPHCOLMN", uint32 version, uint32 number of columns, uint32 flags (1 = chunks are zlib compressed)
+//   metadata  uint32 length and that many bytes of text, lines of tab separated keys and values. The first line is the UTC wall time the file was created
+//   columns   per column a uint8 type (see EColumnType), a uint16 name length and the name
+//   chunks    until the end of the file: uint32 number of rows, then per column a uint32 stored size and the stored values of the column
+//
+// Rows are buffered and written as one chunk per column, so a column can be read without touching the others
+enum EColumnType {
+	Float64Column,
+	Float32Column,
+	Int32Column
+};
+
+struct FColumnDescription {
+	std::string Name;
+	EColumnType Type;
+
+	FColumnDescription(const std::string& name, EColumnType type = EColumnType::Float64Column) :
+		Name(name),
+		Type(type)
+	{
+	}
+};
+
+// Streams rows into a columnar file. Values are added column by column, each row has to be ended with EndRow
+class FColumnarFileWriter {
+public:
+
+	~FColumnarFileWriter();
+
+	bool Open(const std::string& file, const std::vector<FColumnDescription>& columns, const std::string& metadata, bool compress, int rowsPerChunk = 4096);
+
+	bool IsOpen() const;
+
+	// Adds the value of the next column of the current row, converted to the type of the column
+	void Add(double value);
+
+	void EndRow();
+
+	// Writes the buffered rows as a chunk and flushes the file
+	void Flush();
+
+	void Close();
+
+	int GetNumColumns() const;
+
+protected:
+
+	std::ofstream File;
+	std::vector<FColumnDescription> Columns;
+	bool Compress = false;
+	int RowsPerChunk = 4096;
+
+	// values of the buffered rows per column, already in the type of the column
+	std::vector<std::vector<uint8>> ColumnBuffers;
+	int BufferedRows = 0;
+	int CurrentColumn = 0;
+
+	void WriteChunk();
+};
+
+// Contents of a columnar file, all values converted to double
+struct FColumnarTable {
+	std::string Metadata;
+	std::vector<std::string> ColumnNames;
+	std::vector<std::vector<double>> Columns;
+
+	// Index of the column with the name, INDEX_NONE if there is none
+	int FindColumn(const std::string& name) const;
+};
+
+class FColumnarFileReader {
+public:
+
+	// Reads a whole columnar file. Returns false if the file could not be read or is not a columnar file
+	static bool Read(const std::string& file, FColumnarTable& table);
+};
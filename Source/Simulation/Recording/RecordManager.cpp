@@ -3,6 +3,12 @@
 
 #include "RecordManager.h"
 #include "Simulator.h"
+#include <algorithm>
+
+namespace {
+	// color of the fluid particles in replays
+	const FColor ReplayColor(0, 255, 255);
+}
 
 
 URecordManager::~URecordManager()
@@ -42,6 +48,10 @@ void URecordManager::Build(UWorld * world, ASimulator * simulator)
 	}
 
 	ParticleVisualizer = world->SpawnActor<AParticleCloudActor>(FVector(0), FRotator(0));	
+
+	if (SurfaceReconstructor) {
+		SurfaceReconstructor->Build(world, simulator->GetKernel());
+	}
 }
 
 void URecordManager::CamerasCapture(int frame, FString simulationName)
@@ -65,48 +75,87 @@ void URecordManager::CamerasCapture(int frame, FString simulationName)
 
 void URecordManager::WriteSolverStatisticsToFile()
 {
-		std::ofstream file;
-		file.open(TCHAR_TO_UTF8(*(FPaths::ProjectDir() + "Solver Informations/" + GetSimulator()->GetSimulationName() + ".solverinfo")));
+	// the statistics are streamed while simulating, only the steps since the last update are left
+	StreamSolverStatistics();
+	StatisticsFile.Flush();
+}
+
+void URecordManager::StreamSolverStatistics()
+{
+	USolver * solver = GetSimulator()->GetSolver();
+	const int numSteps = solver->OldAverageDensityErrors.size();
+
+	if (WrittenStatistics >= numSteps) {
+		return;
+	}
+
+	// timestep level populations are only recorded when local time stepping was enabled for the whole simulation
+	const std::vector<std::vector<int>>& levelPopulations = solver->OldTimestepLevelPopulations;
 
-		file << "Elapsed Time Simulating\t" << GetSimulator()->GetElapsedTimeWhileSimulating() << std::endl;
-		file << "Total Simulated Time\t" << GetSimulator()->GetSimulatedTime() << std::endl;
-		file << "Computation Time per Simulated Second\t" << GetSimulator()->GetElapsedTimeWhileSimulating() / GetSimulator()->GetSimulatedTime() << std::endl;
-		file << "Timestep Factor\t" << GetSimulator()->GetCFLNumber() << std::endl;
-		file << "Max Timestep\t" << GetSimulator()->GetMaxTimestep() << std::endl;
+	if (!StatisticsFile.IsOpen()) {
+		std::ostringstream metadata;
+		metadata << "Timestep Factor\t" << GetSimulator()->GetCFLNumber() << '\n';
+		metadata << "Max Timestep\t" << GetSimulator()->GetMaxTimestep() << '\n';
 
-		switch (GetSimulator()->GetSolver()->GetSolverType()) {
+		switch (solver->GetSolverType()) {
 		case SESPH:
-			file << "Solver\t" << "SESPH" << std::endl;
+			metadata << "Solver\t" << "SESPH" << '\n';
 			break;
 		case IISPH:
-			file << "Solver\t" << "IISPH" << std::endl;
+			metadata << "Solver\t" << "IISPH" << '\n';
 			break;
 		case DFSPH:
-			file << "Solver\t" << "DFSPH" << std::endl;
+			metadata << "Solver\t" << "DFSPH" << '\n';
 			break;
 		}
-		file << std::endl;
-		file << "Realtime\tSimulated Time\tComputation Time per Step\tTimestep\tIteration Count\tAverage Density Error\tKineticEnergy" << std::endl;
-
-		double elapsedTime = 0;
-		double simulatedTime = 0;
-		for (int i = 0; i < GetSimulator()->GetSolver()->OldAverageDensityErrors.size(); i++) {
-			elapsedTime += GetSimulator()->GetSolver()->OldComputationTimesPerStep[i];
-			simulatedTime += GetSimulator()->GetSolver()->OldTimesteps[i];
-
-			file << elapsedTime << "\t";
-			file << simulatedTime << "\t";
-			file << GetSimulator()->GetSolver()->OldComputationTimesPerStep[i] << "\t";
-			file << GetSimulator()->GetSolver()->OldTimesteps[i] << "\t";
-			file << GetSimulator()->GetSolver()->OldIterationCounts[i] << "\t";
-			file << GetSimulator()->GetSolver()->OldAverageDensityErrors[i] << "\t";
-			file << GetSimulator()->GetSolver()->OldKineticEnergies[i] << "\t";
-			file << std::endl;
+
+		std::vector<FColumnDescription> columns = {
+			FColumnDescription("Realtime"),
+			FColumnDescription("Simulated Time"),
+			FColumnDescription("Computation Time per Step"),
+			FColumnDescription("Timestep"),
+			FColumnDescription("Iteration Count", EColumnType::Int32Column),
+			FColumnDescription("Average Density Error"),
+			FColumnDescription("Kinetic Energy")
+		};
+
+		NumStatisticsLevels = WrittenStatistics == 0 && levelPopulations.size() == numSteps ? levelPopulations[0].size() : 0;
+		for (int level = 0; level < NumStatisticsLevels; level++) {
+			columns.emplace_back("Timestep Level " + std::to_string(level), EColumnType::Int32Column);
+		}
+
+		std::experimental::filesystem::create_directory(TCHAR_TO_UTF8(*(FPaths::ProjectDir() + "Solver Informations")));
+		StatisticsFile.Open(TCHAR_TO_UTF8(*(FPaths::ProjectDir() + "Solver Informations/" + GetSimulator()->GetSimulationName() + ".solvercols")), columns, metadata.str(), CompressOutputFiles);
+	}
+
+	for (int i = WrittenStatistics; i < numSteps; i++) {
+		StatisticsElapsedTime += solver->OldComputationTimesPerStep[i];
+		StatisticsSimulatedTime += solver->OldTimesteps[i];
+
+		StatisticsFile.Add(StatisticsElapsedTime);
+		StatisticsFile.Add(StatisticsSimulatedTime);
+		StatisticsFile.Add(solver->OldComputationTimesPerStep[i]);
+		StatisticsFile.Add(solver->OldTimesteps[i]);
+		StatisticsFile.Add(solver->OldIterationCounts[i]);
+		StatisticsFile.Add(solver->OldAverageDensityErrors[i]);
+		StatisticsFile.Add(solver->OldKineticEnergies[i]);
+		for (int level = 0; level < NumStatisticsLevels; level++) {
+			StatisticsFile.Add(i < levelPopulations.size() && level < levelPopulations[i].size() ? levelPopulations[i][level] : 0);
 		}
-		file.close();
+		StatisticsFile.EndRow();
+	}
+	WrittenStatistics = numSteps;
 }
 
 void URecordManager::WriteSensorDataToFile()
+{
+	// the samples are already streamed to the files, only the unfinished aggregation windows are left
+	for (ASensor * sensor : Sensors) {
+		sensor->FlushSensorData();
+	}
+}
+
+std::experimental::filesystem::path URecordManager::CreateSensorDirectory() const
 {
 	std::experimental::filesystem::path simulationRecordingDirectory = TCHAR_TO_UTF8(*(FPaths::ProjectDir() + "Solver Informations/" + GetSimulator()->GetSimulationName()));
 	std::experimental::filesystem::create_directory(simulationRecordingDirectory);
@@ -114,10 +163,7 @@ void URecordManager::WriteSensorDataToFile()
 	std::experimental::filesystem::path sensorDirectory = TCHAR_TO_UTF8(*(FPaths::ProjectDir() + "Solver Informations/" + GetSimulator()->GetSimulationName() + "/Sensors"));
 	std::experimental::filesystem::create_directory(sensorDirectory);
 
-	for (int i = 0; i < Sensors.Num(); i++) {
-		ASensor * sensor = Sensors[i];
-		sensor->WriteSensorDataToFile(i, sensorDirectory);
-	}
+	return sensorDirectory;
 }
 
 ASimulator * URecordManager::GetSimulator() const
@@ -195,6 +241,11 @@ double URecordManager::GetLastRecordedTime() const
 	return LastRecordedTime;
 }
 
+float URecordManager::GetLastSensorEvaluationTime() const
+{
+	return SensorEvaluator.GetLastEvaluationTime();
+}
+
 double URecordManager::GetNextRecordTime() const
 {
 	return NextRecordTime;
@@ -205,6 +256,28 @@ AParticleCloudActor * URecordManager::GetParticleCloudActor()
 	return ParticleVisualizer;
 }
 
+void URecordManager::SetSurfaceReconstructor(USurfaceReconstructor * surfaceReconstructor)
+{
+	SurfaceReconstructor = surfaceReconstructor;
+
+	// the record manager might already be built
+	if (SurfaceReconstructor && Simulator) {
+		SurfaceReconstructor->Build(Simulator->GetWorld(), Simulator->GetKernel());
+	}
+}
+
+USurfaceReconstructor * URecordManager::GetSurfaceReconstructor() const
+{
+	return SurfaceReconstructor;
+}
+
+void URecordManager::FinishSurfaceReconstruction()
+{
+	if (SurfaceReconstructor) {
+		SurfaceReconstructor->WaitForCompletion();
+	}
+}
+
 bool URecordManager::GetSaveSimulationState() const
 {
 	return SaveSimulationState;
@@ -239,12 +312,23 @@ bool URecordManager::UpdateTimeAndRecordings(double deltaTime, int iteration, do
 		WriteSimulationStateToFile(iteration);
 	}
 
+	StreamSolverStatistics();
+
+	// show meshes of frames that finished in the meantime
+	if (SurfaceReconstructor) {
+		SurfaceReconstructor->UpdateMesh();
+	}
+
 	// sensors capture the current fluid attributes
-	if (SensorsActive) {
-		for (ASensor * sensor : Sensors) {
-			sensor->FindNeighbors(*GetSimulator()->GetNeighborsFinder());
-			sensor->MeasureProperty(*GetSimulator()->GetKernel());
+	if (SensorsActive && Sensors.Num() > 0) {
+		if (!SensorsStreaming) {
+			std::experimental::filesystem::path sensorDirectory = CreateSensorDirectory();
+			for (int i = 0; i < Sensors.Num(); i++) {
+				Sensors[i]->BeginStreaming(i, sensorDirectory, CompressOutputFiles);
+			}
+			SensorsStreaming = true;
 		}
+		SensorEvaluator.Evaluate(Sensors, *GetSimulator()->GetNeighborsFinder(), *GetSimulator()->GetKernel(), *GetSimulator()->GetParticleContext(), simulatedTime);
 	}
 
 	// Should Recorder record frame?
@@ -256,42 +340,63 @@ bool URecordManager::UpdateTimeAndRecordings(double deltaTime, int iteration, do
 
 		if (RecordParticles) {
 
-			std::vector<std::vector<Vector3D>> positions;
-			std::vector<std::vector<Vector3D>> velocities;
-			std::vector<std::vector<double>> densities;
-
-			positions.reserve(GetSimulator()->GetParticleContext()->GetFluids().size());
-			velocities.reserve(GetSimulator()->GetParticleContext()->GetFluids().size());
-			densities.reserve(GetSimulator()->GetParticleContext()->GetFluids().size());
-
-
-			for (int fluidIndex = 0; fluidIndex < GetSimulator()->GetParticleContext()->GetFluids().size(); fluidIndex++) {
-				UFluid* fluid = GetSimulator()->GetParticleContext()->GetFluids()[fluidIndex];
-				positions.push_back(std::vector<Vector3D>());
-				velocities.push_back(std::vector<Vector3D>());
-				densities.push_back(std::vector<double>());
-
-				positions[fluidIndex].reserve(fluid->Particles->size());
-				velocities[fluidIndex].reserve(fluid->Particles->size());
-				densities[fluidIndex].reserve(fluid->Particles->size());
-
-
+			const std::vector<UFluid*>& fluids = GetSimulator()->GetParticleContext()->GetFluids();
 
+			int numParticles = 0;
+			for (UFluid* fluid : fluids) {
+				numParticles += fluid->GetNumParticles();
+			}
 
-				for (Particle & particle : *fluid->Particles) {
-					positions[fluidIndex].push_back(particle.Position);
-					velocities[fluidIndex].push_back(particle.Velocity);
-					densities[fluidIndex].push_back(particle.Density);
+			// positions are stored in the layout of the vertex buffer, so the replay uploads them without converting
+			FReplayFrame& replayFrame = ReplayFrames[ReplayFrames.AddDefaulted()];
+			replayFrame.Vertices.SetNumUninitialized(numParticles);
+			replayFrame.Scalars.SetNumUninitialized(numParticles);
+			replayFrame.ParticleKeys.SetNumUninitialized(numParticles);
+
+			int offset = 0;
+			for (UFluid* fluid : fluids) {
+				const std::vector<Particle>& particles = *fluid->Particles;
+
+				FPointCloudVertex* vertices = replayFrame.Vertices.GetData() + offset;
+				FVector4* scalars = replayFrame.Scalars.GetData() + offset;
+				uint64* particleKeys = replayFrame.ParticleKeys.GetData() + offset;
+				ParallelFor(particles.size(), [&](int32 i) {
+					// unreal uses a left handed coordinate system in centimeters
+					vertices[i].Location = FVector(static_cast<float>(-particles[i].Position.X) * 10, static_cast<float>(particles[i].Position.Y) * 10, static_cast<float>(particles[i].Position.Z) * 10);
+					vertices[i].Color = ReplayColor;
+					// curl is not recorded
+					scalars[i] = FVector4(particles[i].Density, particles[i].Velocity.Length(), particles[i].Pressure, PC_NO_SCALAR);
+					particleKeys[i] = GetParticleKey(fluid->Index, particles[i].Id);
+				});
+
+				// removed particles are not recorded, there are few of them
+				if (fluid->GetNumRemovedParticles() > 0) {
+					int numLive = 0;
+					for (int i = 0; i < particles.size(); i++) {
+						if (!particles[i].IsRemoved) {
+							vertices[numLive] = vertices[i];
+							scalars[numLive] = scalars[i];
+							particleKeys[numLive] = particleKeys[i];
+							numLive++;
+						}
+					}
 				}
+				offset += fluid->GetNumLiveParticles();
 			}
+			replayFrame.Vertices.SetNum(offset, false);
+			replayFrame.Scalars.SetNum(offset, false);
+			replayFrame.ParticleKeys.SetNum(offset, false);
+			replayFrame.SortParticleKeys();
 
-			OldPositions.push_back(positions);
-			OldVelocities.push_back(velocities);
-			OldDensities.push_back(densities);
+			AParticleCloudActor::GetScalarLimits(replayFrame.Scalars, replayFrame.ScalarMin, replayFrame.ScalarMax);
 		}
 		if (TakeScreenshots) {
 			CamerasCapture(RecordedFrames, GetSimulator()->GetSimulationName());
 		}
+		if (SurfaceReconstructor) {
+			std::experimental::filesystem::path meshDirectory = TCHAR_TO_UTF8(*(FPaths::ProjectDir() + "Simulation Recordings/" + GetSimulator()->GetSimulationName() + "/Meshes"));
+			SurfaceReconstructor->ReconstructAsync(*GetSimulator()->GetParticleContext(), RecordedFrames, meshDirectory);
+		}
 
 		ReplayEnd = false;
 		return true;
@@ -310,13 +415,81 @@ void URecordManager::SetRecordedParticlePosition(double deltaTime)
 		CurrentFrame = frame;
 
 		// End of replay
-		if (OldPositions.size() <= frame) {
+		if (ReplayFrames.Num() <= frame) {
 			GetSimulator()->PauseSimulation();
 			ReplayEnd = true;
 			return;
 		}
-		ParticleVisualizer->VisualisePositions(OldPositions[frame], OldVelocities[frame], GetSimulator()->GetParticleContext()->GetParticleDistance(), FluidColorMode);
+		const FReplayFrame& replayFrame = ReplayFrames[frame];
+		if (ReplayHighlights.Num() == 0) {
+			ParticleVisualizer->VisualiseVertices(replayFrame.Vertices, replayFrame.Scalars, replayFrame.ScalarMin, replayFrame.ScalarMax, GetSimulator()->GetParticleContext()->GetParticleDistance());
+			return;
+		}
+
+		// only the highlighted vertices are looked up and recolored in a copy of the frame
+		HighlightedVertices = replayFrame.Vertices;
+		for (const TPair<uint64, FColor>& highlight : ReplayHighlights) {
+			int vertex = replayFrame.FindVertex(highlight.Key);
+			if (vertex >= 0) {
+				HighlightedVertices[vertex].Color = highlight.Value;
+			}
+		}
+		ParticleVisualizer->VisualiseVertices(HighlightedVertices, replayFrame.Scalars, replayFrame.ScalarMin, replayFrame.ScalarMax, GetSimulator()->GetParticleContext()->GetParticleDistance());
+	}
+}
+
+void FReplayFrame::SortParticleKeys()
+{
+	KeyVertices.SetNumUninitialized(ParticleKeys.Num());
+	for (int i = 0; i < KeyVertices.Num(); i++) {
+		KeyVertices[i] = i;
+	}
+	std::sort(KeyVertices.GetData(), KeyVertices.GetData() + KeyVertices.Num(), [&](int32 a, int32 b) {
+		return ParticleKeys[a] < ParticleKeys[b];
+	});
+
+	TArray<uint64> sortedKeys;
+	sortedKeys.SetNumUninitialized(ParticleKeys.Num());
+	for (int i = 0; i < KeyVertices.Num(); i++) {
+		sortedKeys[i] = ParticleKeys[KeyVertices[i]];
+	}
+	ParticleKeys = MoveTemp(sortedKeys);
+}
+
+int FReplayFrame::FindVertex(uint64 particleKey) const
+{
+	const uint64* keysEnd = ParticleKeys.GetData() + ParticleKeys.Num();
+	const uint64* key = std::lower_bound(ParticleKeys.GetData(), keysEnd, particleKey);
+	return key != keysEnd && *key == particleKey ? KeyVertices[key - ParticleKeys.GetData()] : -1;
+}
+
+uint64 URecordManager::GetParticleKey(int fluidIndex, uint32 particleId)
+{
+	return (static_cast<uint64>(fluidIndex) << 32) | particleId;
+}
+
+TArray<FVector> URecordManager::GetRecordedPathline(int fluidIndex, int particleId) const
+{
+	TArray<FVector> pathline;
+	const uint64 particleKey = GetParticleKey(fluidIndex, static_cast<uint32>(particleId));
+
+	for (const FReplayFrame& replayFrame : ReplayFrames) {
+		int vertex = replayFrame.FindVertex(particleKey);
+		if (vertex >= 0) {
+			pathline.Add(replayFrame.Vertices[vertex].Location);
+		}
 	}
+	return pathline;
+}
+
+void URecordManager::HighlightParticleInReplay(int fluidIndex, int particleId, FLinearColor color)
+{
+	ReplayHighlights.Add(GetParticleKey(fluidIndex, static_cast<uint32>(particleId)), color.ToFColor(false));
+}
+
+void URecordManager::ClearReplayHighlights()
+{
+	ReplayHighlights.Empty();
 }
 
 void URecordManager::WriteSimulationStateToFile(int iteration)
@@ -7,8 +7,11 @@
 
 
 #include "CoreMinimal.h"
+#include "ColumnarFile.h"
 #include "RecordingCamera.h"
 #include "Sensors/Sensor.h"
+#include "Sensors/SensorEvaluator.h"
+#include "SurfaceReconstructor.h"
 #include "UnrealComponents/ParticleCloudActor.h"
 
 #include "RecordManager.generated.h"
@@ -49,6 +52,28 @@ struct FReplayInformation {
 	}
 };
 
+// Recorded fluid particles of one frame, ready to be uploaded to the point cloud
+struct FReplayFrame {
+	TArray<FPointCloudVertex> Vertices;
+
+	// density, speed and pressure of each vertex, see EParticleScalar
+	TArray<FVector4> Scalars;
+	FVector4 ScalarMin;
+	FVector4 ScalarMax;
+
+	// fluid index and particle id of the vertices in ascending order once sorted, see URecordManager::GetParticleKey
+	TArray<uint64> ParticleKeys;
+
+	// Vertex of each particle key
+	TArray<int32> KeyVertices;
+
+	// Sorts the particle keys of the vertices, so FindVertex can search them
+	void SortParticleKeys();
+
+	// Index of the vertex of a particle, -1 if the particle is not in the frame
+	int FindVertex(uint64 particleKey) const;
+};
+
 
 UCLASS(BlueprintType)
 class SIMULATION_API URecordManager : public UObject {
@@ -82,9 +107,11 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Recording")
 	void TakeScreenshot(int currentFrame, FString simulationName);
 
+	// Statistics are streamed to a columnar file while simulating, this writes the remaining steps and flushes the file
 	UFUNCTION(BlueprintCallable, Category = "Recording")
 	void WriteSolverStatisticsToFile();
 
+	// Samples are streamed to the sensor files while simulating, this writes unfinished aggregation windows and flushes the files
 	UFUNCTION(BlueprintCallable, Category = "Recording")
 	void WriteSensorDataToFile();
 
@@ -135,17 +162,49 @@ public:
 	UFUNCTION(BlueprintPure)
 		FReplayInformation ReplayInformation() const;
 
+	// Identifies a particle over all fluids and frames by the index of its fluid and its id
+	static uint64 GetParticleKey(int fluidIndex, uint32 particleId);
+
+	// Recorded positions of a particle in all frames it exists in, in unreal coordinates
+	UFUNCTION(BlueprintCallable, Category = "Recording")
+		TArray<FVector> GetRecordedPathline(int fluidIndex, int particleId) const;
+
+	// Shows a particle in the given color when replaying
+	UFUNCTION(BlueprintCallable, Category = "Recording")
+		void HighlightParticleInReplay(int fluidIndex, int particleId, FLinearColor color);
+
+	UFUNCTION(BlueprintCallable, Category = "Recording")
+		void ClearReplayHighlights();
+
 
 	double GetLastRecordedTime() const;
 	double GetNextRecordTime() const;
 
 	AParticleCloudActor * GetParticleCloudActor();
 
+	// Recorded frames are meshed by the surface reconstructor, if one is set
+	UFUNCTION(BlueprintCallable, Category = "Recording")
+		void SetSurfaceReconstructor(USurfaceReconstructor * surfaceReconstructor);
+
+	UFUNCTION(BlueprintPure, Category = "Recording")
+		USurfaceReconstructor * GetSurfaceReconstructor() const;
+
+	// Waits until the meshes of all recorded frames are written, called when the simulation is paused
+	void FinishSurfaceReconstruction();
+
 	// Flag that determines whether sensors calculate and record the properties. 
 	// Can be turned off for small performance gain.
 	UPROPERTY(BlueprintReadWrite, EditAnywhere)
 	bool SensorsActive = true;
 
+	// Compresses the chunks of the columnar sensor and statistics files. Has to be set before the simulation starts
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+	bool CompressOutputFiles = false;
+
+	// Time in seconds the sensors took to measure in the last step
+	UFUNCTION(BlueprintPure, Category = "Recording")
+		float GetLastSensorEvaluationTime() const;
+
 
 protected:
 
@@ -170,11 +229,32 @@ protected:
 
 	TArray<ASensor*> Sensors;
 
+	FSensorEvaluator SensorEvaluator;
+
+	// the files of the sensors are opened with the first measurement
+	bool SensorsStreaming = false;
+
+	std::experimental::filesystem::path CreateSensorDirectory() const;
+
+	FColumnarFileWriter StatisticsFile;
+	int WrittenStatistics = 0;
+	int NumStatisticsLevels = 0;
+	double StatisticsElapsedTime = 0.0;
+	double StatisticsSimulatedTime = 0.0;
+
+	// Appends the statistics of the steps since the last call to the statistics file
+	void StreamSolverStatistics();
+
 	AParticleCloudActor * ParticleVisualizer;
 
-	std::vector<std::vector<std::vector<Vector3D>>> OldPositions;
-	std::vector<std::vector<std::vector<Vector3D>>> OldVelocities;
-	std::vector<std::vector<std::vector<double>>> OldDensities;
+	USurfaceReconstructor * SurfaceReconstructor = nullptr;
+
+	// recorded fluid particles per frame
+	TArray<FReplayFrame> ReplayFrames;
+
+	// colors of highlighted particles by particle key and the recolored vertices of the current frame
+	TMap<uint64, FColor> ReplayHighlights;
+	TArray<FPointCloudVertex> HighlightedVertices;
 
 	TArray<double> OldAverageDensityErrors;
 
@@ -0,0 +1,178 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "GridSensor.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <tuple>
+
+#include "Simulator.h"
+
+namespace {
+	// Fixed size header of a field. It is followed by the names of the channels, 32 characters each,
+	// and one float per lattice point for each channel. The first axis runs fastest.
+	// The fields of a sensor are appended to one file and all have the same size, so field n starts at n times the size of a field
+	struct FFieldHeader {
+		char Magic[8];
+		uint32 Version;
+		uint32 Dimensions[3];
+		uint32 NumChannels;
+		uint32 NumSamples;
+		double Time;
+		double Origin[3];
+		double Axes[3][3];
+	};
+	static_assert(sizeof(FFieldHeader) == 136, "Field header must not contain padding");
+
+	const int ChannelNameLength = 32;
+
+	struct FFieldChannel {
+		std::string Name;
+		std::function<double(const FSensorMeasurement&)> Value;
+	};
+
+	// One channel per measured value, in the same order as the columns of the text sensors
+	std::vector<FFieldChannel> GetChannels(const FMeasuredAttributes& attributes) {
+		std::vector<FFieldChannel> channels;
+
+		if (attributes.MeasureCurl) {
+			channels.push_back({ "Curl", [](const FSensorMeasurement& measurement) { return measurement.Curl; } });
+		}
+		if (attributes.MeasureDensity) {
+			channels.push_back({ "Density", [](const FSensorMeasurement& measurement) { return measurement.Density; } });
+		}
+		if (attributes.MeasurePressure) {
+			channels.push_back({ "Pressure", [](const FSensorMeasurement& measurement) { return measurement.Pressure; } });
+		}
+		if (attributes.MeasureVelocity) {
+			channels.push_back({ "Velocity", [](const FSensorMeasurement& measurement) { return measurement.Velocity; } });
+		}
+		if (attributes.MeasureVelocityDirection) {
+			channels.push_back({ "Velocity Direction X", [](const FSensorMeasurement& measurement) { return measurement.VelocityDirection.X; } });
+			channels.push_back({ "Velocity Direction Y", [](const FSensorMeasurement& measurement) { return measurement.VelocityDirection.Y; } });
+			channels.push_back({ "Velocity Direction Z", [](const FSensorMeasurement& measurement) { return measurement.VelocityDirection.Z; } });
+		}
+		if (attributes.MeasureVelocityDivergence) {
+			channels.push_back({ "Velocity Divergence", [](const FSensorMeasurement& measurement) { return measurement.VelocityDivergence; } });
+		}
+		if (attributes.MeasureVelocityX) {
+			channels.push_back({ "Velocity X Component", [](const FSensorMeasurement& measurement) { return measurement.VelocityX; } });
+		}
+		return channels;
+	}
+}
+
+void AGridSensor::GetSamplePoints(std::vector<const Particle*>& samplePoints) const
+{
+	for (int index : WalkOrder) {
+		samplePoints.push_back(&LatticePoints[index]);
+	}
+}
+
+void AGridSensor::Build(UParticleContext * particleContext)
+{
+	ASensor::Build(particleContext);
+	SortWalkOrder();
+}
+
+void AGridSensor::BuildLattice()
+{
+	LatticePoints.clear();
+	LatticePoints.reserve(Dimensions[0] * Dimensions[1] * Dimensions[2]);
+
+	for (int z = 0; z < Dimensions[2]; z++) {
+		for (int y = 0; y < Dimensions[1]; y++) {
+			for (int x = 0; x < Dimensions[0]; x++) {
+				LatticePoints.emplace_back(Origin + x * Axes[0] + y * Axes[1] + z * Axes[2]);
+			}
+		}
+	}
+
+	WalkOrder.resize(LatticePoints.size());
+	for (int i = 0; i < WalkOrder.size(); i++) {
+		WalkOrder[i] = i;
+	}
+
+	SortWalkOrder();
+}
+
+void AGridSensor::SortWalkOrder()
+{
+	if (ParticleContext == nullptr || ParticleContext->GetSimulator() == nullptr || ParticleContext->GetSimulator()->GetNeighborsFinder() == nullptr) {
+		return;
+	}
+
+	// the cells of the neighbor search, wrapped around periodic axes
+	const UNeighborsFinder * neighborsFinder = ParticleContext->GetSimulator()->GetNeighborsFinder();
+	const double particleDistance = ParticleContext->GetParticleDistance();
+
+	std::vector<std::tuple<int, int, int>> cells(LatticePoints.size());
+	for (int i = 0; i < LatticePoints.size(); i++) {
+		int x, y, z;
+		neighborsFinder->GetCellCoordinates(LatticePoints[i].Position, particleDistance, x, y, z);
+		cells[i] = std::make_tuple(z, y, x);
+	}
+
+	// points within a cell keep the lattice order
+	std::stable_sort(WalkOrder.begin(), WalkOrder.end(), [&cells](int a, int b) { return cells[a] < cells[b]; });
+}
+
+void AGridSensor::OpenOutput(int sensorIndex, std::experimental::filesystem::path directory, bool compress)
+{
+	if (FieldFile.is_open()) {
+		FieldFile.close();
+	}
+	FieldFile.open(directory.generic_string() + "/" + std::to_string(sensorIndex) + ".fields", std::ios::binary | std::ios::trunc);
+}
+
+void AGridSensor::WriteSample(double time, int numSamples, const FSensorMeasurement* values, const FSensorMeasurement* maxValues, int numSamplePoints)
+{
+	if (!FieldFile.is_open()) {
+		return;
+	}
+
+	std::vector<FFieldChannel> channels = GetChannels(MeasuredAttributes);
+	const int numValueChannels = channels.size();
+
+	FFieldHeader header;
+	std::memcpy(header.Magic, "SPHFIELD", sizeof(header.Magic));
+	header.Version = 1;
+	header.Origin[0] = Origin.X;
+	header.Origin[1] = Origin.Y;
+	header.Origin[2] = Origin.Z;
+	for (int axis = 0; axis < 3; axis++) {
+		header.Dimensions[axis] = Dimensions[axis];
+		header.Axes[axis][0] = Axes[axis].X;
+		header.Axes[axis][1] = Axes[axis].Y;
+		header.Axes[axis][2] = Axes[axis].Z;
+	}
+	header.NumChannels = maxValues != nullptr ? 2 * numValueChannels : numValueChannels;
+	header.NumSamples = numSamples;
+	header.Time = time;
+
+	FieldFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	for (int channel = 0; channel < header.NumChannels; channel++) {
+		char name[ChannelNameLength] = {};
+		std::string channelName = (maxValues != nullptr ? (channel < numValueChannels ? "Min " : "Max ") : "") + channels[channel % numValueChannels].Name;
+		channelName.copy(name, ChannelNameLength - 1);
+		FieldFile.write(name, ChannelNameLength);
+	}
+
+	// the values arrive in walk order and are scattered back into the lattice
+	std::vector<float> field(LatticePoints.size(), 0.f);
+	for (int channel = 0; channel < header.NumChannels; channel++) {
+		const FSensorMeasurement* measurements = channel < numValueChannels ? values : maxValues;
+		const FFieldChannel& fieldChannel = channels[channel % numValueChannels];
+
+		for (int i = 0; i < numSamplePoints; i++) {
+			field[WalkOrder[i]] = static_cast<float>(fieldChannel.Value(measurements[i]));
+		}
+		FieldFile.write(reinterpret_cast<const char*>(field.data()), field.size() * sizeof(float));
+	}
+
+	// complete fields can be read while the simulation runs
+	FieldFile.flush();
+}
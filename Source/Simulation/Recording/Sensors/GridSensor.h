@@ -0,0 +1,51 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Sensor.h"
+#include "Particles/SensorParticle.h"
+#include "GridSensor.generated.h"
+
+// Sensor on a regular lattice of points. The points are measured cell by cell of the neighbor search, so consecutive points read the same neighbors.
+// Each sample or aggregation window is appended to the file of the sensor as a binary field with one float array per attribute, which downstream tools can memory map
+UCLASS(BlueprintType)
+class SIMULATION_API AGridSensor : public ASensor
+{
+	GENERATED_BODY()
+
+public:
+
+	void GetSamplePoints(std::vector<const Particle*>& samplePoints) const override;
+
+	void Build(UParticleContext * particleContext) override;
+
+protected:
+
+	// First lattice point and the steps between neighboring lattice points along the three lattice axes
+	Vector3D Origin = Vector3D(0.0);
+	Vector3D Axes[3] = { Vector3D(0.0), Vector3D(0.0), Vector3D(0.0) };
+
+	// Number of lattice points along each axis
+	int Dimensions[3] = { 1, 1, 1 };
+
+	// lattice points with the first axis running fastest, like the fields are written
+	std::vector<SensorParticle> LatticePoints;
+
+	// lattice points in the order they are measured, sorted by the cells of the neighbor search
+	std::vector<int> WalkOrder;
+
+	std::ofstream FieldFile;
+
+	// Creates the lattice points from origin, axes and dimensions
+	void BuildLattice();
+
+	// Sorts the walk order by the cells of the neighbor search, once its cell size is known
+	void SortWalkOrder();
+
+	// Fields are written uncompressed, so they can be memory mapped
+	void OpenOutput(int sensorIndex, std::experimental::filesystem::path directory, bool compress) override;
+
+	// Appends the field of one sample to <sensor index>.fields
+	void WriteSample(double time, int numSamples, const FSensorMeasurement* values, const FSensorMeasurement* maxValues, int numSamplePoints) override;
+};
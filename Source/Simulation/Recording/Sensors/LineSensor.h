@@ -23,11 +23,7 @@ public:
 		FVector end,
 		float sensorParticleDistance = 1.f);
 
-	void MeasureProperty(const UKernel& kernel) override;
-
-	void FindNeighbors(const UNeighborsFinder& neighborsFinder) override;
-
-	void WriteSensorDataToFile(int sensorIndex, std::experimental::filesystem::path directory) override;
+	void GetSamplePoints(std::vector<const Particle*>& samplePoints) const override;
 
 protected:
 
@@ -37,14 +33,7 @@ protected:
 
 	std::vector<SensorParticle> LineSensorParticles;
 
-	std::vector<std::vector<double>> VelocityMeasurePoints;
-	std::vector<std::vector<Vector3D>> VelocityDirectionMeasurePoints;
-	std::vector<std::vector<double>> VelocityDivergenceMeasurePoints;
-	std::vector<std::vector<double>> VelocityXMeasurePoints;
-	std::vector<std::vector<double>> DensityMeasurePoints;
-	std::vector<std::vector<double>> PressureMeasurePoints;
-	std::vector<std::vector<double>> CurlMeasurePoints;
-
+	void WriteMetadata(std::ostream& metadata) const override;
 
 	void OnConstruction(const FTransform& Transform) override;
 };
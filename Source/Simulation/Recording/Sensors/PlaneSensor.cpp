@@ -0,0 +1,48 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PlaneSensor.h"
+
+APlaneSensor::APlaneSensor() {
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Plane"));
+}
+
+APlaneSensor * APlaneSensor::SpawnSensorPlane(UWorld * world,
+	FMeasuredAttributes attributesToMeasure,
+	FVector corner,
+	FVector edgeU,
+	FVector edgeV,
+	float sensorParticleDistance)
+{
+	APlaneSensor * planeSensor = world->SpawnActor<APlaneSensor>({ 0.f, 0.f, 0.f }, FRotator(0));
+	planeSensor->MeasuredAttributes = attributesToMeasure;
+	planeSensor->Corner = Vector3D(corner);
+	planeSensor->EdgeU = Vector3D(edgeU);
+	planeSensor->EdgeV = Vector3D(edgeV);
+	planeSensor->SensorParticleDistance = sensorParticleDistance;
+
+	planeSensor->UpdateLattice();
+	return planeSensor;
+}
+
+void APlaneSensor::UpdateLattice()
+{
+	Origin = Corner;
+	Axes[0] = EdgeU.Normalized() * SensorParticleDistance;
+	Axes[1] = EdgeV.Normalized() * SensorParticleDistance;
+	Axes[2] = Vector3D(0.0);
+
+	// the points include both ends of each edge, the tolerance keeps the far end on exact multiples of the distance
+	Dimensions[0] = std::max(1, static_cast<int>(std::floor(EdgeU.Length() / SensorParticleDistance + 1e-6)) + 1);
+	Dimensions[1] = std::max(1, static_cast<int>(std::floor(EdgeV.Length() / SensorParticleDistance + 1e-6)) + 1);
+	Dimensions[2] = 1;
+
+	BuildLattice();
+}
+
+void APlaneSensor::OnConstruction(const FTransform & Transform)
+{
+	// spawned sensors are constructed before their edges are set
+	if (SensorParticleDistance > 0.0) {
+		UpdateLattice();
+	}
+}
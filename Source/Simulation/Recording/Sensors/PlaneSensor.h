@@ -0,0 +1,38 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GridSensor.h"
+#include "PlaneSensor.generated.h"
+
+// Measures a slice through the domain on a 2D lattice spanned by two edges starting at a corner
+UCLASS(BlueprintType)
+class SIMULATION_API APlaneSensor : public AGridSensor
+{
+	GENERATED_BODY()
+
+public:
+
+	APlaneSensor();
+
+	UFUNCTION(BlueprintCallable)
+	static APlaneSensor * SpawnSensorPlane(UWorld * world,
+		FMeasuredAttributes attributesToMeasure,
+		FVector corner,
+		FVector edgeU,
+		FVector edgeV,
+		float sensorParticleDistance = 1.f);
+
+protected:
+
+	Vector3D Corner;
+	Vector3D EdgeU;
+	Vector3D EdgeV;
+	double SensorParticleDistance = 0.0;
+
+	// Derives the lattice from corner, edges and distance
+	void UpdateLattice();
+
+	void OnConstruction(const FTransform& Transform) override;
+};
@@ -19,23 +19,13 @@ public:
 	UFUNCTION(BlueprintCallable)
 	static APointSensor * SpawnSensorPoint(UWorld * world, FVector location, FMeasuredAttributes attributesToMeasure);
 
-	void MeasureProperty(const UKernel& kernel) override;
-
-	void FindNeighbors(const UNeighborsFinder& neighborsFinder) override;
-
-	void WriteSensorDataToFile(int sensorIndex, std::experimental::filesystem::path directory) override;
+	void GetSamplePoints(std::vector<const Particle*>& samplePoints) const override;
 
 protected:
 
 	SensorParticle PointSensorParticle;
 
-	std::vector<double> VelocityMeasurePoints;
-	std::vector<Vector3D> VelocityDirectionMeasurePoints;
-	std::vector<double> VelocityDivergenceMeasurePoints;
-	std::vector<double> VelocityXMeasurePoints;
-	std::vector<double> DensityMeasurePoints;
-	std::vector<double> PressureMeasurePoints;
-	std::vector<double> CurlMeasurePoints;
+	void WriteMetadata(std::ostream& metadata) const override;
 
 	void OnConstruction(const FTransform& Transform) override;
 };
@@ -2,22 +2,243 @@
 
 #include "Sensor.h"
 
-void ASensor::MeasureProperty(const UKernel& kernel)
+#include <sstream>
+
+namespace {
+	// Combines each value of the target with the same value of the measurement
+	template <typename CombineFunction>
+	void CombineMeasurement(FSensorMeasurement& target, const FSensorMeasurement& measurement, const CombineFunction& combine) {
+		target.Density = combine(target.Density, measurement.Density);
+		target.Pressure = combine(target.Pressure, measurement.Pressure);
+		target.Velocity = combine(target.Velocity, measurement.Velocity);
+		target.VelocityDirection.X = combine(target.VelocityDirection.X, measurement.VelocityDirection.X);
+		target.VelocityDirection.Y = combine(target.VelocityDirection.Y, measurement.VelocityDirection.Y);
+		target.VelocityDirection.Z = combine(target.VelocityDirection.Z, measurement.VelocityDirection.Z);
+		target.VelocityDivergence = combine(target.VelocityDivergence, measurement.VelocityDivergence);
+		target.VelocityX = combine(target.VelocityX, measurement.VelocityX);
+		target.Curl = combine(target.Curl, measurement.Curl);
+	}
+}
+
+void ASensor::GetSamplePoints(std::vector<const Particle*>& samplePoints) const
 {
 	throw("This is an abstract base class and should never be called");
 }
 
-void ASensor::WriteSensorDataToFile(int sensorIndex, std::experimental::filesystem::path directory)
+void ASensor::WriteMetadata(std::ostream& metadata) const
 {
 	throw("This is an abstract base class and should never be called");
 }
 
-void ASensor::FindNeighbors(const UNeighborsFinder& neighborsFinder)
+void ASensor::BeginStreaming(int sensorIndex, std::experimental::filesystem::path directory, bool compress)
 {
-	throw("This is an abstract base class and should never be called");
+	NextSampleTime = 0.0;
+	WindowSamples = 0;
+
+	OpenOutput(sensorIndex, directory, compress);
+}
+
+void ASensor::OpenOutput(int sensorIndex, std::experimental::filesystem::path directory, bool compress)
+{
+	std::ostringstream metadata;
+	WriteMetadata(metadata);
+
+	switch (Aggregation) {
+	case ESensorAggregation::NoAggregation:
+		metadata << "Aggregation\tNone" << '\n';
+		break;
+	case ESensorAggregation::Mean:
+		metadata << "Aggregation\tMean\t" << AggregationWindow << '\n';
+		break;
+	case ESensorAggregation::MinMax:
+		metadata << "Aggregation\tMin Max\t" << AggregationWindow << '\n';
+		break;
+	case ESensorAggregation::RootMeanSquare:
+		metadata << "Aggregation\tRoot Mean Square\t" << AggregationWindow << '\n';
+		break;
+	}
+
+	std::vector<const Particle*> samplePoints;
+	GetSamplePoints(samplePoints);
+
+	std::vector<FColumnDescription> columns;
+	columns.emplace_back("Time");
+	columns.emplace_back("Wall Time");
+	if (Aggregation != ESensorAggregation::NoAggregation) {
+		columns.emplace_back("Samples", EColumnType::Int32Column);
+	}
+	AddColumns(Aggregation == ESensorAggregation::MinMax ? "Min " : "", samplePoints.size(), columns);
+	if (Aggregation == ESensorAggregation::MinMax) {
+		AddColumns("Max ", samplePoints.size(), columns);
+	}
+
+	SensorFile.Open(directory.generic_string() + "/" + std::to_string(sensorIndex) + ".sensorcols", columns, metadata.str(), compress);
+	OutputStartTime = FPlatformTime::Seconds();
+}
+
+bool ASensor::IsSampleDue(double simulatedTime) const
+{
+	return SampleRate <= 0.f || NextSampleTime - simulatedTime < 0.00001;
+}
+
+void ASensor::AddMeasurements(const FSensorMeasurement* measurements, int numSamplePoints, double simulatedTime)
+{
+	// sample times lie on a grid, so a timestep longer than the sample interval skips samples instead of catching up
+	if (SampleRate > 0.f) {
+		NextSampleTime = (std::floor(simulatedTime * SampleRate + 0.00001) + 1) / SampleRate;
+	}
+
+	if (Aggregation == ESensorAggregation::NoAggregation) {
+		WriteSample(simulatedTime, 1, measurements, nullptr, numSamplePoints);
+		return;
+	}
+
+	// the first sample after a window starts the next one
+	if (WindowSamples > 0 && simulatedTime - WindowStart >= AggregationWindow) {
+		WriteWindow();
+	}
+
+	if (WindowSamples == 0) {
+		WindowStart = simulatedTime;
+		if (Aggregation == ESensorAggregation::MinMax) {
+			WindowValues.assign(measurements, measurements + numSamplePoints);
+			WindowMaxValues.assign(measurements, measurements + numSamplePoints);
+		}
+		else {
+			WindowValues.assign(numSamplePoints, FSensorMeasurement());
+		}
+	}
+
+	for (int i = 0; i < numSamplePoints; i++) {
+		switch (Aggregation) {
+		case ESensorAggregation::Mean:
+			CombineMeasurement(WindowValues[i], measurements[i], [](double sum, double value) { return sum + value; });
+			break;
+		case ESensorAggregation::RootMeanSquare:
+			CombineMeasurement(WindowValues[i], measurements[i], [](double sum, double value) { return sum + value * value; });
+			break;
+		case ESensorAggregation::MinMax:
+			CombineMeasurement(WindowValues[i], measurements[i], [](double min, double value) { return std::min(min, value); });
+			CombineMeasurement(WindowMaxValues[i], measurements[i], [](double max, double value) { return std::max(max, value); });
+			break;
+		}
+	}
+	WindowSamples++;
+}
+
+void ASensor::FlushSensorData()
+{
+	if (WindowSamples > 0) {
+		WriteWindow();
+	}
+	SensorFile.Flush();
+}
+
+void ASensor::WriteWindow()
+{
+	const double samples = WindowSamples;
+
+	for (FSensorMeasurement& value : WindowValues) {
+		switch (Aggregation) {
+		case ESensorAggregation::Mean:
+			CombineMeasurement(value, value, [samples](double sum, double) { return sum / samples; });
+			break;
+		case ESensorAggregation::RootMeanSquare:
+			CombineMeasurement(value, value, [samples](double sum, double) { return std::sqrt(sum / samples); });
+			break;
+		}
+	}
+
+	WriteSample(WindowStart, WindowSamples, WindowValues.data(), Aggregation == ESensorAggregation::MinMax ? WindowMaxValues.data() : nullptr, WindowValues.size());
+
+	WindowSamples = 0;
+}
+
+void ASensor::WriteSample(double time, int numSamples, const FSensorMeasurement* values, const FSensorMeasurement* maxValues, int numSamplePoints)
+{
+	if (!SensorFile.IsOpen()) {
+		return;
+	}
+
+	SensorFile.Add(time);
+	SensorFile.Add(FPlatformTime::Seconds() - OutputStartTime);
+	if (Aggregation != ESensorAggregation::NoAggregation) {
+		SensorFile.Add(numSamples);
+	}
+	AddValues(values, numSamplePoints);
+	if (maxValues != nullptr) {
+		AddValues(maxValues, numSamplePoints);
+	}
+	SensorFile.EndRow();
+}
+
+void ASensor::AddValues(const FSensorMeasurement* measurements, int numSamplePoints)
+{
+	auto addColumns = [&](auto valueGetter) {
+		for (int i = 0; i < numSamplePoints; i++) {
+			SensorFile.Add(valueGetter(measurements[i]));
+		}
+	};
+
+	if (MeasuredAttributes.MeasureCurl) {
+		addColumns([](const FSensorMeasurement& measurement) { return measurement.Curl; });
+	}
+	if (MeasuredAttributes.MeasureDensity) {
+		addColumns([](const FSensorMeasurement& measurement) { return measurement.Density; });
+	}
+	if (MeasuredAttributes.MeasurePressure) {
+		addColumns([](const FSensorMeasurement& measurement) { return measurement.Pressure; });
+	}
+	if (MeasuredAttributes.MeasureVelocity) {
+		addColumns([](const FSensorMeasurement& measurement) { return measurement.Velocity; });
+	}
+	if (MeasuredAttributes.MeasureVelocityDirection) {
+		addColumns([](const FSensorMeasurement& measurement) { return measurement.VelocityDirection.X; });
+		addColumns([](const FSensorMeasurement& measurement) { return measurement.VelocityDirection.Y; });
+		addColumns([](const FSensorMeasurement& measurement) { return measurement.VelocityDirection.Z; });
+	}
+	if (MeasuredAttributes.MeasureVelocityDivergence) {
+		addColumns([](const FSensorMeasurement& measurement) { return measurement.VelocityDivergence; });
+	}
+	if (MeasuredAttributes.MeasureVelocityX) {
+		addColumns([](const FSensorMeasurement& measurement) { return measurement.VelocityX; });
+	}
+}
+
+void ASensor::AddColumns(const std::string& prefix, int numSamplePoints, std::vector<FColumnDescription>& columns) const
+{
+	auto addColumns = [&](const std::string& name) {
+		for (int i = 0; i < numSamplePoints; i++) {
+			columns.emplace_back(prefix + name + " " + std::to_string(i));
+		}
+	};
+
+	if (MeasuredAttributes.MeasureCurl) {
+		addColumns("Curl");
+	}
+	if (MeasuredAttributes.MeasureDensity) {
+		addColumns("Density");
+	}
+	if (MeasuredAttributes.MeasurePressure) {
+		addColumns("Pressure");
+	}
+	if (MeasuredAttributes.MeasureVelocity) {
+		addColumns("Velocity");
+	}
+	if (MeasuredAttributes.MeasureVelocityDirection) {
+		addColumns("Velocity Direction X");
+		addColumns("Velocity Direction Y");
+		addColumns("Velocity Direction Z");
+	}
+	if (MeasuredAttributes.MeasureVelocityDivergence) {
+		addColumns("Velocity Divergence");
+	}
+	if (MeasuredAttributes.MeasureVelocityX) {
+		addColumns("Velocity X Component");
+	}
 }
 
 void ASensor::Build(UParticleContext * particleContext)
 {
 	ParticleContext = particleContext;
-}
\ No newline at end of file
+}
@@ -13,6 +13,7 @@
 #include "ParticleContext/ParticleContext.h"
 #include "NeighborsFinders/NeighborsFinder.h"
 #include "Kernels/Kernel.h"
+#include "Recording/ColumnarFile.h"
 
 #include "Sensor.generated.h"
 
@@ -40,6 +41,35 @@ struct FMeasuredAttributes {
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 		bool MeasureCurl = false;
+
+	bool MeasuresAnything() const {
+		return MeasureVelocity || MeasureVelocityDirection || MeasureVelocityDivergence || MeasureVelocityX || MeasureDensity || MeasurePressure || MeasureCurl;
+	}
+
+	// Gradients of the kernel are only needed for curl and divergence
+	bool NeedsGradients() const {
+		return MeasureVelocityDivergence || MeasureCurl;
+	}
+};
+
+// All attributes measured at one sample point. Only the ones requested by the sensor are computed
+struct FSensorMeasurement {
+	double Density = 0.0;
+	double Pressure = 0.0;
+	double Velocity = 0.0;
+	Vector3D VelocityDirection = Vector3D(0.0);
+	double VelocityDivergence = 0.0;
+	double VelocityX = 0.0;
+	double Curl = 0.0;
+};
+
+
+UENUM(BlueprintType)
+enum ESensorAggregation {
+	NoAggregation,
+	Mean,
+	MinMax,
+	RootMeanSquare
 };
 
 
@@ -50,21 +80,67 @@ class SIMULATION_API ASensor : public AActor
 	
 public:	
 
-	// Sensors calculate the property at the given points
-	virtual void MeasureProperty(const UKernel& kernel);
+	// Appends the points the sensor measures at. Sensors don't search neighbors themselves, the points of all sensors are evaluated together
+	virtual void GetSamplePoints(std::vector<const Particle*>& samplePoints) const;
+
+	// Opens the file of the sensor, samples are streamed into it as they are measured
+	void BeginStreaming(int sensorIndex, std::experimental::filesystem::path directory, bool compress);
+
+	// True if the sensor has to be sampled at the simulated time
+	bool IsSampleDue(double simulatedTime) const;
 
-	// Flushes all the recorded sensor data to a file
-	virtual void WriteSensorDataToFile(int sensorIndex, std::experimental::filesystem::path directory);
+	// Streams or aggregates the measurements of one sample, one for each sample point in the order they were given
+	void AddMeasurements(const FSensorMeasurement* measurements, int numSamplePoints, double simulatedTime);
 
-	// Called when the sensors need to find all surrounding neighbors
-	virtual void FindNeighbors(const UNeighborsFinder& neighborsFinder);
+	// Writes the unfinished aggregation window and flushes the file
+	void FlushSensorData();
 
 	UPROPERTY(BlueprintReadWrite, EditAnywhere)
 	FMeasuredAttributes MeasuredAttributes;
 
-	void Build(UParticleContext * particleContext);
+	// Samples per simulated second. 0 samples every solver step
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, meta = (ClampMin = "0"))
+	float SampleRate = 0.f;
+
+	// Samples are aggregated over windows of simulated time before they are written
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+	TEnumAsByte<ESensorAggregation> Aggregation = ESensorAggregation::NoAggregation;
+
+	// Length of an aggregation window in simulated seconds
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, meta = (ClampMin = "0"))
+	float AggregationWindow = 0.1f;
+
+	virtual void Build(UParticleContext * particleContext);
 
 protected:
 	UParticleContext * ParticleContext;
 
+	// Opens the columnar file of the sensor, one row per sample or aggregation window
+	virtual void OpenOutput(int sensorIndex, std::experimental::filesystem::path directory, bool compress);
+
+	// Writes the type of the sensor and the positions of its sample points into the metadata of the file
+	virtual void WriteMetadata(std::ostream& metadata) const;
+
+	FColumnarFileWriter SensorFile;
+
+	// wall time the file was opened, the rows store the wall time since then
+	double OutputStartTime = 0.0;
+
+	double NextSampleTime = 0.0;
+
+	// sums, sums of squares or minimum of the current window per sample point, depending on the aggregation
+	std::vector<FSensorMeasurement> WindowValues;
+	// maximum of the current window per sample point, only used for MinMax
+	std::vector<FSensorMeasurement> WindowMaxValues;
+	double WindowStart = 0.0;
+	int WindowSamples = 0;
+
+	void WriteWindow();
+
+	// Writes one sample or aggregation window. The maximum values are only given for MinMax
+	virtual void WriteSample(double time, int numSamples, const FSensorMeasurement* values, const FSensorMeasurement* maxValues, int numSamplePoints);
+
+	// Adds one column per sample point for each measured value
+	void AddValues(const FSensorMeasurement* measurements, int numSamplePoints);
+	void AddColumns(const std::string& prefix, int numSamplePoints, std::vector<FColumnDescription>& columns) const;
 };
@@ -0,0 +1,104 @@
+#include "SensorEvaluator.h"
+
+#include "Runtime/Core/Public/Async/ParallelFor.h"
+
+namespace {
+	// sample points evaluated by one task, they share the allocations of one neighborhood
+	const int SamplePointsPerBatch = 64;
+}
+
+void FSensorEvaluator::Evaluate(const TArray<ASensor*>& sensors, const UNeighborsFinder& neighborsFinder, const UKernel& kernel, const UParticleContext& particleContext, double simulatedTime)
+{
+	FDateTime evaluationStartTime = FDateTime::UtcNow();
+
+	SamplePoints.clear();
+	SampleAttributes.clear();
+	SensorOffsets.assign(sensors.Num(), INDEX_NONE);
+	SensorSampleCounts.assign(sensors.Num(), 0);
+
+	for (int i = 0; i < sensors.Num(); i++) {
+		if (sensors[i]->MeasuredAttributes.MeasuresAnything() && sensors[i]->IsSampleDue(simulatedTime)) {
+			SensorOffsets[i] = SamplePoints.size();
+			sensors[i]->GetSamplePoints(SamplePoints);
+			SampleAttributes.resize(SamplePoints.size(), &sensors[i]->MeasuredAttributes);
+			SensorSampleCounts[i] = SamplePoints.size() - SensorOffsets[i];
+		}
+	}
+
+	const int numSamplePoints = SamplePoints.size();
+	Measurements.assign(numSamplePoints, FSensorMeasurement());
+
+	const int numBatches = (numSamplePoints + SamplePointsPerBatch - 1) / SamplePointsPerBatch;
+	ParallelFor(numBatches, [&](int32 batch) {
+		FNeighborhood neighborhood;
+		const int end = std::min(numSamplePoints, (batch + 1) * SamplePointsPerBatch);
+
+		for (int i = batch * SamplePointsPerBatch; i < end; i++) {
+			neighborsFinder.GatherNeighborsOfPosition(SamplePoints[i]->Position, particleContext, neighborhood);
+			Measure(*SamplePoints[i], *SampleAttributes[i], neighborhood, kernel, Measurements[i]);
+		}
+	});
+
+	// hand the measurements back to the sensors the sample points came from
+	for (int i = 0; i < sensors.Num(); i++) {
+		if (SensorOffsets[i] != INDEX_NONE) {
+			sensors[i]->AddMeasurements(Measurements.data() + SensorOffsets[i], SensorSampleCounts[i], simulatedTime);
+		}
+	}
+
+	LastEvaluationTime = (FDateTime::UtcNow() - evaluationStartTime).GetTotalSeconds();
+}
+
+void FSensorEvaluator::Measure(const Particle& samplePoint, const FMeasuredAttributes& attributes, const FNeighborhood& neighborhood, const UKernel& kernel, FSensorMeasurement& measurement)
+{
+	const bool needsGradients = attributes.NeedsGradients();
+
+	for (const FluidNeighbor& ff : neighborhood.FluidNeighbors) {
+		const Particle& neighbor = *ff.GetParticle();
+		const double value = kernel.ComputeValue(samplePoint, neighbor);
+		const double volume = neighbor.GetVolume();
+
+		measurement.Density += neighbor.Mass * value;
+		measurement.Pressure += volume * neighbor.Pressure * value;
+		measurement.Velocity += volume * neighbor.Velocity.Length() * value;
+		measurement.VelocityDirection += volume * neighbor.Velocity * value;
+		measurement.VelocityX += volume * neighbor.Velocity.X * value;
+
+		if (needsGradients) {
+			const Vector3D gradient = kernel.ComputeGradient(samplePoint, neighbor);
+			measurement.VelocityDivergence += volume * neighbor.Velocity * gradient;
+			measurement.Curl += volume * Vector3D::CrossProduct(neighbor.Velocity, gradient).Y;
+		}
+	}
+
+	// the contributions of the boundary are weighted with the density at the sample point, which is only known after all neighbors are summed up
+	double borderVelocity = 0.0;
+	double borderVelocityDivergence = 0.0;
+
+	for (const StaticBorderNeighbor& fb : neighborhood.StaticBorderNeighbors) {
+		const Particle& neighbor = *fb.GetParticle();
+		const double value = kernel.ComputeValue(samplePoint, neighbor);
+
+		measurement.Density += neighbor.Mass * neighbor.Border->BorderDensityFactor * value;
+		borderVelocity += neighbor.Mass * neighbor.Velocity.Length() * value;
+
+		if (needsGradients) {
+			borderVelocityDivergence += neighbor.Mass * neighbor.Velocity * kernel.ComputeGradient(samplePoint, neighbor);
+		}
+	}
+
+	if (measurement.Density > 0.0) {
+		measurement.Velocity += borderVelocity / measurement.Density;
+		measurement.VelocityDivergence += borderVelocityDivergence / measurement.Density;
+	}
+}
+
+double FSensorEvaluator::GetLastEvaluationTime() const
+{
+	return LastEvaluationTime;
+}
+
+int FSensorEvaluator::GetNumSamplePoints() const
+{
+	return SamplePoints.size();
+}
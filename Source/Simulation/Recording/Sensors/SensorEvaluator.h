@@ -0,0 +1,35 @@
+#pragma once
+
+#include <vector>
+
+#include "CoreMinimal.h"
+#include "Sensor.h"
+
+// Measures the attributes of all sensors at once. The sample points of all sensors are gathered into one array, their neighbors are searched in parallel batches
+// and all requested attributes are summed up in a single pass over the neighbors of each point
+class FSensorEvaluator {
+public:
+
+	// Measures the sensors which are due at the simulated time
+	void Evaluate(const TArray<ASensor*>& sensors, const UNeighborsFinder& neighborsFinder, const UKernel& kernel, const UParticleContext& particleContext, double simulatedTime);
+
+	// Time in seconds the last evaluation took
+	double GetLastEvaluationTime() const;
+
+	int GetNumSamplePoints() const;
+
+protected:
+
+	// sample points of all sensors and the attributes measured at each of them, kept to reuse the allocations
+	std::vector<const Particle*> SamplePoints;
+	std::vector<const FMeasuredAttributes*> SampleAttributes;
+	std::vector<FSensorMeasurement> Measurements;
+
+	// index of the first sample point of each sensor, INDEX_NONE if the sensor is not measured
+	std::vector<int> SensorOffsets;
+	std::vector<int> SensorSampleCounts;
+
+	double LastEvaluationTime = 0.0;
+
+	static void Measure(const Particle& samplePoint, const FMeasuredAttributes& attributes, const FNeighborhood& neighborhood, const UKernel& kernel, FSensorMeasurement& measurement);
+};
@@ -0,0 +1,46 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "VolumeSensor.h"
+
+AVolumeSensor::AVolumeSensor() {
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Volume"));
+}
+
+AVolumeSensor * AVolumeSensor::SpawnSensorVolume(UWorld * world,
+	FMeasuredAttributes attributesToMeasure,
+	FVector minCorner,
+	FVector maxCorner,
+	float sensorParticleDistance)
+{
+	AVolumeSensor * volumeSensor = world->SpawnActor<AVolumeSensor>({ 0.f, 0.f, 0.f }, FRotator(0));
+	volumeSensor->MeasuredAttributes = attributesToMeasure;
+	volumeSensor->MinCorner = Vector3D(minCorner);
+	volumeSensor->MaxCorner = Vector3D(maxCorner);
+	volumeSensor->SensorParticleDistance = sensorParticleDistance;
+
+	volumeSensor->UpdateLattice();
+	return volumeSensor;
+}
+
+void AVolumeSensor::UpdateLattice()
+{
+	Origin = MinCorner;
+	Axes[0] = Vector3D(SensorParticleDistance, 0.0, 0.0);
+	Axes[1] = Vector3D(0.0, SensorParticleDistance, 0.0);
+	Axes[2] = Vector3D(0.0, 0.0, SensorParticleDistance);
+
+	// the points include both ends of each edge, the tolerance keeps the far end on exact multiples of the distance
+	Dimensions[0] = std::max(1, static_cast<int>(std::floor((MaxCorner.X - MinCorner.X) / SensorParticleDistance + 1e-6)) + 1);
+	Dimensions[1] = std::max(1, static_cast<int>(std::floor((MaxCorner.Y - MinCorner.Y) / SensorParticleDistance + 1e-6)) + 1);
+	Dimensions[2] = std::max(1, static_cast<int>(std::floor((MaxCorner.Z - MinCorner.Z) / SensorParticleDistance + 1e-6)) + 1);
+
+	BuildLattice();
+}
+
+void AVolumeSensor::OnConstruction(const FTransform & Transform)
+{
+	// spawned sensors are constructed before their corners are set
+	if (SensorParticleDistance > 0.0) {
+		UpdateLattice();
+	}
+}
@@ -0,0 +1,36 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GridSensor.h"
+#include "VolumeSensor.generated.h"
+
+// Measures an axis aligned box of the domain on a 3D lattice
+UCLASS(BlueprintType)
+class SIMULATION_API AVolumeSensor : public AGridSensor
+{
+	GENERATED_BODY()
+
+public:
+
+	AVolumeSensor();
+
+	UFUNCTION(BlueprintCallable)
+	static AVolumeSensor * SpawnSensorVolume(UWorld * world,
+		FMeasuredAttributes attributesToMeasure,
+		FVector minCorner,
+		FVector maxCorner,
+		float sensorParticleDistance = 1.f);
+
+protected:
+
+	Vector3D MinCorner;
+	Vector3D MaxCorner;
+	double SensorParticleDistance = 0.0;
+
+	// Derives the lattice from the corners and distance
+	void UpdateLattice();
+
+	void OnConstruction(const FTransform& Transform) override;
+};
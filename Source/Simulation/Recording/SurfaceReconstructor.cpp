@@ -0,0 +1,504 @@
+#include "SurfaceReconstructor.h"
+#include <fstream>
+#include <unordered_map>
+#include "NeighborsFinders/HashNeighborsFinder.h"
+#include "Runtime/Core/Public/Async/ParallelFor.h"
+
+namespace {
+	// Number of cells along each axis of a block
+	const int BlockCells = 8;
+
+	// Corners of a cell, corner c is at (c & 1, (c >> 1) & 1, (c >> 2) & 1)
+	Vector3D CornerPosition(int corner) {
+		return Vector3D(corner & 1, (corner >> 1) & 1, (corner >> 2) & 1);
+	}
+
+	// The two corners of each edge, ordered by axis
+	const int EdgeCorners[12][2] = {
+		{ 0, 1 }, { 2, 3 }, { 4, 5 }, { 6, 7 },
+		{ 0, 2 }, { 1, 3 }, { 4, 6 }, { 5, 7 },
+		{ 0, 4 }, { 1, 5 }, { 2, 6 }, { 3, 7 }
+	};
+
+	// Corners of each face in cyclic order and the outward normal of the face
+	const int FaceCorners[6][4] = {
+		{ 0, 2, 6, 4 }, { 1, 3, 7, 5 },
+		{ 0, 1, 5, 4 }, { 2, 3, 7, 6 },
+		{ 0, 1, 3, 2 }, { 4, 5, 7, 6 }
+	};
+	const Vector3D FaceNormals[6] = {
+		Vector3D(-1, 0, 0), Vector3D(1, 0, 0),
+		Vector3D(0, -1, 0), Vector3D(0, 1, 0),
+		Vector3D(0, 0, -1), Vector3D(0, 0, 1)
+	};
+
+	int EdgeBetween(int corner1, int corner2) {
+		for (int e = 0; e < 12; e++) {
+			if ((EdgeCorners[e][0] == corner1 && EdgeCorners[e][1] == corner2) || (EdgeCorners[e][0] == corner2 && EdgeCorners[e][1] == corner1)) {
+				return e;
+			}
+		}
+		return -1;
+	}
+
+	Vector3D EdgeMidpoint(int edge) {
+		return (CornerPosition(EdgeCorners[edge][0]) + CornerPosition(EdgeCorners[edge][1])) * 0.5;
+	}
+
+	// Builds the triangle table of marching cubes instead of spelling out all 256 cases. On every face the crossed edges are connected by segments,
+	// faces with two inside corners on a diagonal always separate them, so neighboring cells agree and the surface is closed. The segments are oriented
+	// with the inside on their left seen from outside of the cell, then chained into polygons and fanned into triangles facing out of the fluid
+	std::vector<std::vector<int>> BuildTriangleTable() {
+		std::vector<std::vector<int>> table(256);
+
+		for (int cubeCase = 0; cubeCase < 256; cubeCase++) {
+			auto isInside = [cubeCase](int corner) { return ((cubeCase >> corner) & 1) != 0; };
+
+			int nextEdge[12];
+			std::fill(nextEdge, nextEdge + 12, -1);
+
+			for (int face = 0; face < 6; face++) {
+				const int* corners = FaceCorners[face];
+
+				std::vector<int> crossed;
+				for (int i = 0; i < 4; i++) {
+					if (isInside(corners[i]) != isInside(corners[(i + 1) % 4])) {
+						crossed.push_back(i);
+					}
+				}
+
+				// pairs of edges, given by the index of their first corner on the face
+				std::vector<std::pair<int, int>> segments;
+				if (crossed.size() == 2) {
+					segments.push_back(std::make_pair(crossed[0], crossed[1]));
+				}
+				else if (crossed.size() == 4) {
+					for (int i = 0; i < 4; i++) {
+						if (isInside(corners[i])) {
+							segments.push_back(std::make_pair((i + 3) % 4, i));
+						}
+					}
+				}
+
+				for (const std::pair<int, int>& segment : segments) {
+					int from = EdgeBetween(corners[segment.first], corners[(segment.first + 1) % 4]);
+					int to = EdgeBetween(corners[segment.second], corners[(segment.second + 1) % 4]);
+
+					int insideCorner = isInside(EdgeCorners[from][0]) ? EdgeCorners[from][0] : EdgeCorners[from][1];
+					Vector3D side = Vector3D::CrossProduct(EdgeMidpoint(to) - EdgeMidpoint(from), FaceNormals[face]);
+					if (side * (CornerPosition(insideCorner) - EdgeMidpoint(from)) < 0) {
+						std::swap(from, to);
+					}
+					nextEdge[from] = to;
+				}
+			}
+
+			bool visited[12] = {};
+			for (int start = 0; start < 12; start++) {
+				if (nextEdge[start] < 0 || visited[start]) {
+					continue;
+				}
+
+				std::vector<int> polygon;
+				for (int edge = start; !visited[edge]; edge = nextEdge[edge]) {
+					visited[edge] = true;
+					polygon.push_back(edge);
+				}
+
+				for (int i = 1; i + 1 < polygon.size(); i++) {
+					table[cubeCase].push_back(polygon[0]);
+					table[cubeCase].push_back(polygon[i]);
+					table[cubeCase].push_back(polygon[i + 1]);
+				}
+			}
+		}
+		return table;
+	}
+
+	const std::vector<std::vector<int>>& GetTriangleTable() {
+		static const std::vector<std::vector<int>> table = BuildTriangleTable();
+		return table;
+	}
+
+	long long BlockKey(int x, int y, int z) {
+		return ((long long)(x + (1 << 20)) << 42) | ((long long)(y + (1 << 20)) << 21) | (long long)(z + (1 << 20));
+	}
+
+	int FloorToCell(double value, double cellSize) {
+		return static_cast<int>(floor(value / cellSize));
+	}
+}
+
+FSurfaceKernel::FSurfaceKernel(const UKernel & kernel, int numSamples)
+{
+	SupportLength = kernel.GetSupportRange() * kernel.GetParticleSpacing();
+	Values.resize(std::max(numSamples, 2));
+	for (int i = 0; i < Values.size(); i++) {
+		Values[i] = kernel.ComputeValue(Vector3D(SupportLength * i / (Values.size() - 1), 0.0, 0.0), Vector3D(0.0));
+	}
+}
+
+double FSurfaceKernel::ComputeValue(double distance) const
+{
+	if (distance >= SupportLength || Values.empty()) {
+		return 0.0;
+	}
+
+	const double sample = distance / SupportLength * (Values.size() - 1);
+	const int i = std::min(static_cast<int>(sample), static_cast<int>(Values.size()) - 2);
+	const double t = sample - i;
+	return Values[i] * (1 - t) + Values[i + 1] * t;
+}
+
+USurfaceReconstructor::~USurfaceReconstructor()
+{
+}
+
+void USurfaceReconstructor::BeginDestroy()
+{
+	for (TFuture<FSurfaceMesh>& frame : PendingFrames) {
+		frame.Wait();
+	}
+	PendingFrames.Empty();
+
+	Super::BeginDestroy();
+}
+
+USurfaceReconstructor * USurfaceReconstructor::CreateSurfaceReconstructor(float isoValue, float cellSizeFactor, EMeshFileFormat fileFormat, bool showMesh, int maxPendingFrames)
+{
+	USurfaceReconstructor * surfaceReconstructor = NewObject<USurfaceReconstructor>();
+	surfaceReconstructor->IsoValue = isoValue;
+	surfaceReconstructor->CellSizeFactor = std::max(cellSizeFactor, 0.05f);
+	surfaceReconstructor->FileFormat = fileFormat;
+	surfaceReconstructor->ShowMesh = showMesh;
+	surfaceReconstructor->MaxPendingFrames = std::max(maxPendingFrames, 1);
+
+	// prevent garbage collection
+	surfaceReconstructor->AddToRoot();
+	return surfaceReconstructor;
+}
+
+void USurfaceReconstructor::Build(UWorld * world, UKernel * kernel)
+{
+	if (kernel) {
+		Kernel = FSurfaceKernel(*kernel);
+	}
+
+	if (ShowMesh && MeshComponent == nullptr) {
+		MeshActor = world->SpawnActor<AActor>(FVector(0), FRotator(0));
+		MeshComponent = NewObject<UProceduralMeshComponent>(MeshActor);
+		MeshActor->SetRootComponent(MeshComponent);
+		MeshComponent->RegisterComponent();
+	}
+}
+
+void USurfaceReconstructor::ReconstructAsync(const UParticleContext & particleContext, int frame, std::experimental::filesystem::path directory)
+{
+	// finished frames do not count towards the limit
+	UpdateMesh();
+
+	// every recorded frame gets its mesh, so the recording waits for the oldest frames instead of skipping this one
+	if (PendingFrames.Num() >= MaxPendingFrames) {
+		StalledFrameCount++;
+		while (PendingFrames.Num() >= MaxPendingFrames) {
+			PendingFrames[0].Wait();
+			UpdateMesh();
+		}
+	}
+
+	FSurfaceParticles particles;
+	for (UFluid * fluid : particleContext.GetFluids()) {
+		for (const Particle& particle : *fluid->Particles) {
+			if (particle.IsRemoved) {
+				continue;
+			}
+			particles.Positions.push_back(particle.Position);
+			particles.Volumes.push_back(particle.Mass / (particle.Density > 0 ? particle.Density : fluid->GetRestDensity()));
+		}
+	}
+
+	std::string file;
+	if (FileFormat != EMeshFileFormat::NoMeshFile) {
+		std::experimental::filesystem::create_directories(directory);
+		file = (directory / (std::to_string(frame) + (FileFormat == EMeshFileFormat::OBJ ? ".obj" : ".ply"))).string();
+	}
+
+	// the task gets its own copy of the sampled kernel
+	const FSurfaceKernel kernel = Kernel;
+	const double isoValue = IsoValue;
+	const double cellSize = CellSizeFactor * particleContext.GetParticleDistance();
+	const EMeshFileFormat fileFormat = FileFormat;
+
+	PendingFrames.Add(Async<FSurfaceMesh>(EAsyncExecution::ThreadPool, [particles = std::move(particles), kernel, isoValue, cellSize, fileFormat, file, frame]() {
+		FDateTime startTime = FDateTime::UtcNow();
+
+		FSurfaceMesh mesh = Reconstruct(particles, kernel, isoValue, cellSize);
+		mesh.Frame = frame;
+
+		if (fileFormat == EMeshFileFormat::OBJ) {
+			WriteOBJ(mesh, file);
+		}
+		else if (fileFormat == EMeshFileFormat::PLY) {
+			WritePLY(mesh, file);
+		}
+
+		mesh.ReconstructionTime = (FDateTime::UtcNow() - startTime).GetTotalSeconds();
+		return mesh;
+	}));
+}
+
+void USurfaceReconstructor::UpdateMesh()
+{
+	// frames finish in order most of the time, only the newest finished one is shown
+	int numFinished = 0;
+	while (numFinished < PendingFrames.Num() && PendingFrames[numFinished].IsReady()) {
+		numFinished++;
+	}
+	if (numFinished == 0) {
+		return;
+	}
+
+	const FSurfaceMesh& mesh = PendingFrames[numFinished - 1].Get();
+	LastReconstructionTime = mesh.ReconstructionTime;
+	LastTriangleCount = mesh.Triangles.size() / 3;
+
+	if (MeshComponent) {
+		TArray<FVector> vertices;
+		TArray<FVector> normals;
+		TArray<int32> triangles;
+		vertices.SetNumUninitialized(mesh.Vertices.size());
+		normals.SetNumUninitialized(mesh.Normals.size());
+		triangles.SetNumUninitialized(mesh.Triangles.size());
+
+		// unreal uses a left handed coordinate system in centimeters
+		ParallelFor(mesh.Vertices.size(), [&](int32 i) {
+			vertices[i] = FVector(-mesh.Vertices[i].X, mesh.Vertices[i].Y, mesh.Vertices[i].Z) * 10;
+			normals[i] = FVector(-mesh.Normals[i].X, mesh.Normals[i].Y, mesh.Normals[i].Z);
+		});
+		FMemory::Memcpy(triangles.GetData(), mesh.Triangles.data(), mesh.Triangles.size() * sizeof(int));
+
+		MeshComponent->CreateMeshSection(0, vertices, triangles, normals, TArray<FVector2D>(), TArray<FColor>(), TArray<FProcMeshTangent>(), false);
+	}
+
+	PendingFrames.RemoveAt(0, numFinished);
+}
+
+void USurfaceReconstructor::WaitForCompletion()
+{
+	for (TFuture<FSurfaceMesh>& frame : PendingFrames) {
+		frame.Wait();
+	}
+	UpdateMesh();
+}
+
+FSurfaceMesh USurfaceReconstructor::Reconstruct(const FSurfaceParticles & particles, const FSurfaceKernel & kernel, double isoValue, double cellSize)
+{
+	FSurfaceMesh mesh;
+
+	const int numParticles = particles.Positions.size();
+	if (numParticles == 0) {
+		return mesh;
+	}
+
+	const double supportLength = kernel.SupportLength;
+	const double blockSize = BlockCells * cellSize;
+
+	// particles are sorted into cells of the support length with the hash of the neighbors finder
+	std::unordered_map<int, std::vector<int>> particleCells;
+	for (int i = 0; i < numParticles; i++) {
+		particleCells[UHashNeighborsFinder::GetHash(particles.Positions[i], supportLength)].push_back(i);
+	}
+
+	// only blocks within the support of a particle can contain the surface
+	std::unordered_map<long long, int> blockIndices;
+	std::vector<Vector3D> blocks;
+	for (const Vector3D& position : particles.Positions) {
+		for (int x = FloorToCell(position.X - supportLength, blockSize); x <= FloorToCell(position.X + supportLength, blockSize); x++) {
+			for (int y = FloorToCell(position.Y - supportLength, blockSize); y <= FloorToCell(position.Y + supportLength, blockSize); y++) {
+				for (int z = FloorToCell(position.Z - supportLength, blockSize); z <= FloorToCell(position.Z + supportLength, blockSize); z++) {
+					if (blockIndices.emplace(BlockKey(x, y, z), blocks.size()).second) {
+						blocks.push_back(Vector3D(x, y, z));
+					}
+				}
+			}
+		}
+	}
+
+	const std::vector<std::vector<int>>& triangleTable = GetTriangleTable();
+	std::vector<FSurfaceMesh> blockMeshes(blocks.size());
+
+	ParallelFor(blocks.size(), [&](int32 b) {
+		const Vector3D origin = blocks[b] * blockSize;
+
+		// the field is sampled with one additional layer around the block for the central differences of the normals
+		const int numSamples = BlockCells + 3;
+		auto sampleIndex = [numSamples](int x, int y, int z) { return (x + 1) + numSamples * ((y + 1) + numSamples * (z + 1)); };
+		std::vector<double> field(numSamples * numSamples * numSamples, 0.0);
+
+		// scatter the particles near the block onto the samples
+		const Vector3D sampleMin = origin - Vector3D(cellSize + supportLength);
+		const Vector3D sampleMax = origin + Vector3D(blockSize + cellSize + supportLength);
+
+		for (int cx = FloorToCell(sampleMin.X, supportLength); cx <= FloorToCell(sampleMax.X, supportLength); cx++) {
+			for (int cy = FloorToCell(sampleMin.Y, supportLength); cy <= FloorToCell(sampleMax.Y, supportLength); cy++) {
+				for (int cz = FloorToCell(sampleMin.Z, supportLength); cz <= FloorToCell(sampleMax.Z, supportLength); cz++) {
+					auto cell = particleCells.find(UHashNeighborsFinder::GetHash(cx, cy, cz));
+					if (cell == particleCells.end()) {
+						continue;
+					}
+
+					for (int i : cell->second) {
+						const Vector3D& position = particles.Positions[i];
+
+						// hash collisions put particles of other cells into the same list
+						if (FloorToCell(position.X, supportLength) != cx || FloorToCell(position.Y, supportLength) != cy || FloorToCell(position.Z, supportLength) != cz) {
+							continue;
+						}
+
+						for (int z = std::max(-1, FloorToCell(position.Z - supportLength - origin.Z, cellSize)); z <= std::min(BlockCells + 1, FloorToCell(position.Z + supportLength - origin.Z, cellSize) + 1); z++) {
+							for (int y = std::max(-1, FloorToCell(position.Y - supportLength - origin.Y, cellSize)); y <= std::min(BlockCells + 1, FloorToCell(position.Y + supportLength - origin.Y, cellSize) + 1); y++) {
+								for (int x = std::max(-1, FloorToCell(position.X - supportLength - origin.X, cellSize)); x <= std::min(BlockCells + 1, FloorToCell(position.X + supportLength - origin.X, cellSize) + 1); x++) {
+									Vector3D samplePosition = origin + Vector3D(x, y, z) * cellSize;
+									const double distance = (samplePosition - position).Size();
+									if (distance < supportLength) {
+										field[sampleIndex(x, y, z)] += particles.Volumes[i] * kernel.ComputeValue(distance);
+									}
+								}
+							}
+						}
+					}
+				}
+			}
+		}
+
+		// the color field decreases towards the outside, so the normal is its negative gradient
+		auto sampleNormal = [&](int x, int y, int z) {
+			return Vector3D(field[sampleIndex(x - 1, y, z)] - field[sampleIndex(x + 1, y, z)],
+				field[sampleIndex(x, y - 1, z)] - field[sampleIndex(x, y + 1, z)],
+				field[sampleIndex(x, y, z - 1)] - field[sampleIndex(x, y, z + 1)]);
+		};
+
+		FSurfaceMesh& blockMesh = blockMeshes[b];
+
+		// vertices are shared between the cells of a block, indexed by the sample of the lower corner of their edge and the axis of the edge
+		std::vector<int> edgeVertices(numSamples * numSamples * numSamples * 3, -1);
+
+		for (int z = 0; z < BlockCells; z++) {
+			for (int y = 0; y < BlockCells; y++) {
+				for (int x = 0; x < BlockCells; x++) {
+					int cubeCase = 0;
+					for (int corner = 0; corner < 8; corner++) {
+						if (field[sampleIndex(x + (corner & 1), y + ((corner >> 1) & 1), z + ((corner >> 2) & 1))] > isoValue) {
+							cubeCase |= 1 << corner;
+						}
+					}
+
+					for (int edge : triangleTable[cubeCase]) {
+						int corner1 = EdgeCorners[edge][0];
+						int corner2 = EdgeCorners[edge][1];
+						int x1 = x + (corner1 & 1), y1 = y + ((corner1 >> 1) & 1), z1 = z + ((corner1 >> 2) & 1);
+						int x2 = x + (corner2 & 1), y2 = y + ((corner2 >> 1) & 1), z2 = z + ((corner2 >> 2) & 1);
+
+						int& vertex = edgeVertices[sampleIndex(x1, y1, z1) * 3 + edge / 4];
+						if (vertex < 0) {
+							double value1 = field[sampleIndex(x1, y1, z1)];
+							double value2 = field[sampleIndex(x2, y2, z2)];
+							double t = (isoValue - value1) / (value2 - value1);
+
+							vertex = blockMesh.Vertices.size();
+							blockMesh.Vertices.push_back(origin + (Vector3D(x1, y1, z1) * (1 - t) + Vector3D(x2, y2, z2) * t) * cellSize);
+							blockMesh.Normals.push_back((sampleNormal(x1, y1, z1) * (1 - t) + sampleNormal(x2, y2, z2) * t).Normalized());
+						}
+						blockMesh.Triangles.push_back(vertex);
+					}
+				}
+			}
+		}
+	});
+
+	// concatenate the blocks, vertices on block borders are duplicated
+	int numVertices = 0;
+	int numIndices = 0;
+	for (const FSurfaceMesh& blockMesh : blockMeshes) {
+		numVertices += blockMesh.Vertices.size();
+		numIndices += blockMesh.Triangles.size();
+	}
+	mesh.Vertices.reserve(numVertices);
+	mesh.Normals.reserve(numVertices);
+	mesh.Triangles.reserve(numIndices);
+
+	for (const FSurfaceMesh& blockMesh : blockMeshes) {
+		int offset = mesh.Vertices.size();
+		mesh.Vertices.insert(mesh.Vertices.end(), blockMesh.Vertices.begin(), blockMesh.Vertices.end());
+		mesh.Normals.insert(mesh.Normals.end(), blockMesh.Normals.begin(), blockMesh.Normals.end());
+		for (int index : blockMesh.Triangles) {
+			mesh.Triangles.push_back(index + offset);
+		}
+	}
+
+	return mesh;
+}
+
+void USurfaceReconstructor::WriteOBJ(const FSurfaceMesh & mesh, const std::string & file)
+{
+	std::ofstream meshFile;
+	meshFile.open(file);
+
+	meshFile << "# frame " << mesh.Frame << std::endl;
+	for (const Vector3D& vertex : mesh.Vertices) {
+		meshFile << "v " << vertex.X << " " << vertex.Y << " " << vertex.Z << "\n";
+	}
+	for (const Vector3D& normal : mesh.Normals) {
+		meshFile << "vn " << normal.X << " " << normal.Y << " " << normal.Z << "\n";
+	}
+
+	// indices start at 1
+	for (int i = 0; i + 2 < mesh.Triangles.size(); i += 3) {
+		meshFile << "f";
+		for (int j = 0; j < 3; j++) {
+			meshFile << " " << mesh.Triangles[i + j] + 1 << "//" << mesh.Triangles[i + j] + 1;
+		}
+		meshFile << "\n";
+	}
+	meshFile.close();
+}
+
+void USurfaceReconstructor::WritePLY(const FSurfaceMesh & mesh, const std::string & file)
+{
+	std::ofstream meshFile;
+	meshFile.open(file);
+
+	meshFile << "ply" << std::endl;
+	meshFile << "format ascii 1.0" << std::endl;
+	meshFile << "comment frame " << mesh.Frame << std::endl;
+	meshFile << "element vertex " << mesh.Vertices.size() << std::endl;
+	meshFile << "property float x" << std::endl << "property float y" << std::endl << "property float z" << std::endl;
+	meshFile << "property float nx" << std::endl << "property float ny" << std::endl << "property float nz" << std::endl;
+	meshFile << "element face " << mesh.Triangles.size() / 3 << std::endl;
+	meshFile << "property list uchar int vertex_indices" << std::endl;
+	meshFile << "end_header" << std::endl;
+
+	for (int i = 0; i < mesh.Vertices.size(); i++) {
+		meshFile << mesh.Vertices[i].X << " " << mesh.Vertices[i].Y << " " << mesh.Vertices[i].Z << " ";
+		meshFile << mesh.Normals[i].X << " " << mesh.Normals[i].Y << " " << mesh.Normals[i].Z << "\n";
+	}
+	for (int i = 0; i + 2 < mesh.Triangles.size(); i += 3) {
+		meshFile << "3 " << mesh.Triangles[i] << " " << mesh.Triangles[i + 1] << " " << mesh.Triangles[i + 2] << "\n";
+	}
+	meshFile.close();
+}
+
+float USurfaceReconstructor::GetLastReconstructionTime() const
+{
+	return LastReconstructionTime;
+}
+
+int USurfaceReconstructor::GetLastTriangleCount() const
+{
+	return LastTriangleCount;
+}
+
+int USurfaceReconstructor::GetStalledFrameCount() const
+{
+	return StalledFrameCount;
+}
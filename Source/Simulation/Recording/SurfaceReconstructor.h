@@ -0,0 +1,121 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <experimental/filesystem>
+
+#include "CoreMinimal.h"
+#include "Runtime/Core/Public/Async/Future.h"
+#include "Runtime/Core/Public/Async/Async.h"
+#include "ProceduralMeshComponent.h"
+
+#include "DataStructures/Vector3D.h"
+#include "ParticleContext/ParticleContext.h"
+#include "Kernels/Kernel.h"
+
+#include "SurfaceReconstructor.generated.h"
+
+UENUM(BlueprintType)
+enum EMeshFileFormat {
+	NoMeshFile,
+	OBJ,
+	PLY
+};
+
+// Triangle mesh in simulation coordinates, triangles are counter clockwise seen from outside of the fluid
+struct FSurfaceMesh {
+	std::vector<Vector3D> Vertices;
+	std::vector<Vector3D> Normals;
+	std::vector<int> Triangles;
+
+	int Frame = -1;
+	double ReconstructionTime = 0.0;
+};
+
+// Copy of the particles a surface is reconstructed from, so the solver can continue while meshing
+struct FSurfaceParticles {
+	std::vector<Vector3D> Positions;
+	std::vector<double> Volumes;
+};
+
+// Radial profile of the kernel sampled on the game thread, so meshing does not depend on the lifetime of the kernel object
+struct FSurfaceKernel {
+	double SupportLength = 0.0;
+
+	// values at equally spaced distances from 0 to the support length
+	std::vector<double> Values;
+
+	FSurfaceKernel() {}
+	FSurfaceKernel(const UKernel& kernel, int numSamples = 1024);
+
+	// Linearly interpolated value at the distance, 0 outside of the support
+	double ComputeValue(double distance) const;
+};
+
+// Reconstructs the fluid surface of recorded frames with marching cubes. The color field sum(m/rho * W) of the fluid particles is sampled on a sparse grid
+// around the particles and meshed in parallel per block of cells. Each frame is meshed asynchronously on the thread pool, stepping only waits if too many frames are pending
+UCLASS(BlueprintType)
+class SIMULATION_API USurfaceReconstructor : public UObject {
+	GENERATED_BODY()
+public:
+
+	virtual ~USurfaceReconstructor();
+
+	// Waits for the pending frames, so their meshes are written completely
+	virtual void BeginDestroy() override;
+
+	// isoValue: value of the color field at the surface, 1 inside the fluid. cellSizeFactor: grid cell size in particle distances. maxPendingFrames: recording waits for the oldest frame if more are still meshed
+	UFUNCTION(BlueprintPure, Category = "Recording")
+	static USurfaceReconstructor * CreateSurfaceReconstructor(float isoValue = 0.5f, float cellSizeFactor = 0.5f, EMeshFileFormat fileFormat = EMeshFileFormat::OBJ, bool showMesh = false, int maxPendingFrames = 4);
+
+	void Build(UWorld * world, UKernel * kernel);
+
+	// Copies the fluid particles and starts meshing them. Every frame is meshed, if too many frames are pending this waits for the oldest ones
+	void ReconstructAsync(const UParticleContext& particleContext, int frame, std::experimental::filesystem::path directory);
+
+	// Shows the newest finished mesh. Has to be called from the game thread
+	void UpdateMesh();
+
+	// Blocks until all frames are meshed and written
+	UFUNCTION(BlueprintCallable, Category = "Recording")
+	void WaitForCompletion();
+
+	// Meshes the particles on the calling thread, blocks inside run in parallel
+	static FSurfaceMesh Reconstruct(const FSurfaceParticles& particles, const FSurfaceKernel& kernel, double isoValue, double cellSize);
+
+	static void WriteOBJ(const FSurfaceMesh& mesh, const std::string& file);
+	static void WritePLY(const FSurfaceMesh& mesh, const std::string& file);
+
+	UFUNCTION(BlueprintPure, Category = "Recording")
+	float GetLastReconstructionTime() const;
+
+	UFUNCTION(BlueprintPure, Category = "Recording")
+	int GetLastTriangleCount() const;
+
+	// Number of frames which had to wait for older frames to be meshed
+	UFUNCTION(BlueprintPure, Category = "Recording")
+	int GetStalledFrameCount() const;
+
+protected:
+
+	double IsoValue = 0.5;
+	double CellSizeFactor = 0.5;
+	EMeshFileFormat FileFormat = EMeshFileFormat::OBJ;
+	bool ShowMesh = false;
+	int MaxPendingFrames = 4;
+
+	FSurfaceKernel Kernel;
+
+	// Frames still being meshed, in the order they were started
+	TArray<TFuture<FSurfaceMesh>> PendingFrames;
+
+	double LastReconstructionTime = 0.0;
+	int LastTriangleCount = 0;
+	int StalledFrameCount = 0;
+
+	UPROPERTY()
+	AActor * MeshActor = nullptr;
+
+	UPROPERTY()
+	UProceduralMeshComponent * MeshComponent = nullptr;
+};
@@ -8,7 +8,7 @@ public class Simulation : ModuleRules
 	{
 		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
 	
-		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "PointCloudEditor", "PointCloudRuntime" });
+		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "ProceduralMeshComponent", "PointCloudEditor", "PointCloudRuntime" });
 
 		PublicIncludePaths.AddRange(new string[] {"PointCloudEditor/Public", "PointCloudEditor/Classes", "PointCloudRuntime/Public", "PointCloudRuntime/Classes" });
 
@@ -8,7 +8,8 @@ ASimulator::ASimulator()
 	PrimaryActorTick.bCanEverTick = true;
 	PrimaryActorTick.TickInterval = 0.001;
 
-	CFLNumber = 0.01;
+	// the time integrator recommends the CFL number
+	CFLNumber = 0.0;
 	SimulatedTime = 0;
 	SimulationStatus = Paused;
 }
@@ -72,6 +73,9 @@ void ASimulator::StartPauseSimulation()
 			ElapsedTimeWhileSimulating += FDateTime::UtcNow() - LastSimulationStart;
 		}
 		SimulationStatus = Paused;
+
+		// the meshes of the run are complete once it is paused
+		GetRecordManager()->FinishSurfaceReconstruction();
 	}
 }
 
@@ -80,6 +84,9 @@ void ASimulator::PauseSimulation() {
 		ElapsedTimeWhileSimulating += FDateTime::UtcNow() - LastSimulationStart;
 	}
 	SimulationStatus = Paused;
+
+	// the meshes of the run are complete once it is paused
+	GetRecordManager()->FinishSurfaceReconstruction();
 }
 
 void ASimulator::StartPauseReplay()
@@ -127,11 +134,12 @@ void ASimulator::WriteSimulationToFile(std::string file)
 	}
 
 	simulationFile << "Simulation Name:\t" << TCHAR_TO_UTF8(*SimulationName) << std::endl;
-	simulationFile << "TimestepFactor:\t" << CFLNumber << std::endl;
+	simulationFile << "TimestepFactor:\t" << GetSolver()->GetCFLNumber() << std::endl;
 	simulationFile << "MinTimestep:\t" << MinTimestep << std::endl;
 	simulationFile << "MaxTimestep:\t" << MaxTimestep << std::endl;
 	simulationFile << "Neighborhood Search Method:\t" << GetNeighborsFinder()->GetNeighborsFinderType() << std::endl;
 	simulationFile << "Solver Methode:\t" << GetSolver()->GetSolverType() << std::endl;
+	simulationFile << "Time Integrator:\t" << GetSolver()->GetTimeIntegrator()->GetIntegratorType() << std::endl;
 	simulationFile << "Smoothing Length:\t" << GetParticleContext()->GetParticleDistance() << std::endl;
 	simulationFile.close();
 }
@@ -184,20 +192,22 @@ const FSimulationInformation ASimulator::SimulationInformation() const
 
 	int numFluidParticles = 0;
 	for (UFluid * fluid : GetParticleContext()->GetFluids()) {
-		numFluidParticles += fluid->Particles->size();
+		numFluidParticles += fluid->GetNumLiveParticles();
 	}
 
 
 	return FSimulationInformation(SimulationStatus,
 		SimulatedTime,
 		static_cast<float>(Solver->GetCurrentTimestep()),
-		static_cast<float>(CFLNumber),
+		GetSolver()->GetCFLNumber(),
 		GetIterationCount(),
 		GetSolver()->GetLastAverageDensityError(),
 		GetElapsedTimeWhileSimulating(),
 		numFluidParticles,
 		numStaticParticles,
 		0,
+		numFluidParticles - Solver->GetSleepingParticleCount(),
+		Solver->GetSleepingParticleCount(),
 		Solver->GetComputationTimes());
 }
 
@@ -301,7 +311,7 @@ void ASimulator::TestSimulation()
 			Vector3D column3;
 
 			for (const Particle& ff : particle.FluidNeighbors) {
-				Vector3D positionDifference = (ff.Position - particle.Position);
+				Vector3D positionDifference = Kernel->GetDistanceVector(ff.Position, particle.Position);
 				Vector3D kernelGradient = GetKernel()->ComputeGradient(particle, ff);
 
 				column1 += positionDifference * kernelGradient.X;
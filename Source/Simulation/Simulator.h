@@ -70,6 +70,12 @@ struct FSimulationInformation {
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Struct")
 	int NumberOfRigidParticles;
 
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Struct")
+	int NumberOfActiveParticles;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Struct")
+	int NumberOfSleepingParticles;
+
 	FSimulationInformation() :
 		SimulationStatus(ESimulationState::Paused),
 		SimulatedTime(0.0f),
@@ -80,6 +86,8 @@ struct FSimulationInformation {
 		NumberOfFluidParticles(0),
 		NumberOfRigidParticles(0),
 		NumberOfStaticParticles(0),
+		NumberOfActiveParticles(0),
+		NumberOfSleepingParticles(0),
 		ElapsedTime(0.0f),
 		ComputationTimes(FComputationTimesPerStep())
 	{
@@ -95,6 +103,8 @@ struct FSimulationInformation {
 		int numberOfFluidParticles,
 		int numberOfStaticParticles,
 		int numberOfRigidParticles,
+		int numberOfActiveParticles,
+		int numberOfSleepingParticles,
 		FComputationTimesPerStep computationTimes)
 		:
 		SimulationStatus(simulationStatus),
@@ -106,6 +116,8 @@ struct FSimulationInformation {
 		NumberOfFluidParticles(numberOfFluidParticles),
 		NumberOfRigidParticles(numberOfRigidParticles),
 		NumberOfStaticParticles(numberOfStaticParticles),
+		NumberOfActiveParticles(numberOfActiveParticles),
+		NumberOfSleepingParticles(numberOfSleepingParticles),
 		ElapsedTime(elapsedTime),
 		ComputationTimes(computationTimes)
 	{
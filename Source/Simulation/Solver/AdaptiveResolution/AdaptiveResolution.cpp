@@ -0,0 +1,255 @@
+#include "AdaptiveResolution.h"
+#include "Simulator.h"
+
+UAdaptiveResolution::~UAdaptiveResolution()
+{
+}
+
+UAdaptiveResolution * UAdaptiveResolution::CreateAdaptiveResolution(TArray<AScriptedVolume*> regionsOfInterest, int mergeLevels, float surfaceDensityRatio, int adaptationInterval)
+{
+	UAdaptiveResolution * adaptiveResolution = NewObject<UAdaptiveResolution>();
+	adaptiveResolution->RegionsOfInterest = regionsOfInterest;
+	adaptiveResolution->MergeLevels = std::max(mergeLevels, 0);
+	adaptiveResolution->SurfaceDensityRatio = surfaceDensityRatio;
+	adaptiveResolution->AdaptationInterval = std::max(adaptationInterval, 1);
+
+	// prevent garbage collection
+	adaptiveResolution->AddToRoot();
+	return adaptiveResolution;
+}
+
+void UAdaptiveResolution::Build(EDimensionality dimensionality)
+{
+	Dimensionality = dimensionality;
+	StepsSinceAdaptation = 0;
+}
+
+void UAdaptiveResolution::AddRegionOfInterest(AScriptedVolume * region)
+{
+	RegionsOfInterest.AddUnique(region);
+}
+
+bool UAdaptiveResolution::ShouldAdaptInThisStep()
+{
+	StepsSinceAdaptation++;
+	if (StepsSinceAdaptation < AdaptationInterval) {
+		return false;
+	}
+	StepsSinceAdaptation = 0;
+	return true;
+}
+
+void UAdaptiveResolution::AdaptResolution(UParticleContext & particleContext)
+{
+	const double particleDistance = particleContext.GetParticleDistance();
+	const double levelFactor = GetLevelFactor();
+	const double maxSmoothingScale = GetMaxSmoothingScale();
+	const UKernel * kernel = particleContext.GetSimulator()->GetKernel();
+
+	LastSplitCount = 0;
+	LastMergeCount = 0;
+
+	for (UFluid * fluid : particleContext.GetFluids()) {
+		std::vector<Particle>& particles = *fluid->Particles;
+		const int numParticles = particles.size();
+
+		std::vector<char> requiresFineResolution(numParticles);
+		ParallelFor(numParticles, [&](int32 i) {
+			requiresFineResolution[i] = static_cast<char>(RequiresFineResolution(particles[i]));
+		});
+
+		// The fine band reaches one neighborhood into the fluid, so coarse particles never touch the surface
+		std::vector<char> isFine(numParticles);
+		ParallelFor(numParticles, [&](int32 i) {
+			bool fine = static_cast<bool>(requiresFineResolution[i]);
+			for (const FluidNeighbor& neighbor : particles[i].FluidNeighbors) {
+				if (fine) {
+					break;
+				}
+				if (neighbor.GetFluid() == fluid) {
+					fine = static_cast<bool>(requiresFineResolution[neighbor.GetIndex()]);
+				}
+			}
+			isFine[i] = static_cast<char>(fine);
+		});
+
+		// Coarse particles in the fine band split, fine particles in the bulk look for the nearest partner of the same scale
+		std::vector<char> split(numParticles);
+		std::vector<int> partner(numParticles, -1);
+		ParallelFor(numParticles, [&](int32 i) {
+			const Particle& f = particles[i];
+
+			if (f.IsRemoved) {
+				return;
+			}
+
+			if (isFine[i]) {
+				split[i] = static_cast<char>(f.SmoothingScale > 1.0 + 1e-6);
+				return;
+			}
+			if (f.IsScripted || f.SmoothingScale * levelFactor > maxSmoothingScale + 1e-6) {
+				return;
+			}
+
+			double minDistance = std::numeric_limits<double>::max();
+			for (const FluidNeighbor& neighbor : f.FluidNeighbors) {
+				const int j = neighbor.GetIndex();
+
+				if (j == i || neighbor.GetFluid() != fluid) {
+					continue;
+				}
+
+				const Particle& ff = particles[j];
+				if (isFine[j] || ff.IsScripted || fabs(ff.SmoothingScale - f.SmoothingScale) > 1e-6 * f.SmoothingScale) {
+					continue;
+				}
+
+				double distance = kernel->GetDistanceVector(f.Position, ff.Position).Size();
+				if (distance < minDistance) {
+					minDistance = distance;
+					partner[i] = j;
+				}
+			}
+		});
+
+		// Only mutual nearest partners merge, so every particle takes part in one merge at most
+		int numSplits = 0;
+		int numMerges = 0;
+		for (int i = 0; i < numParticles; i++) {
+			if (split[i]) {
+				numSplits++;
+			}
+			else if (partner[i] > i && partner[partner[i]] == i) {
+				numMerges++;
+			}
+		}
+
+		if (numSplits == 0 && numMerges == 0) {
+			continue;
+		}
+
+		// the particles are rebuilt anyway, so removed particles are dropped on the way
+		std::vector<Particle> adaptedParticles;
+		adaptedParticles.reserve(numParticles + numSplits - numMerges - fluid->GetNumRemovedParticles());
+
+		for (int i = 0; i < numParticles; i++) {
+			Particle& f = particles[i];
+
+			if (f.IsRemoved) {
+				continue;
+			}
+
+			if (split[i]) {
+				// Daughters are placed along the flow direction and keep the velocity of the parent
+				Vector3D direction = f.Velocity.Size() > 0 ? f.Velocity.Normalized() : Vector3D(1.0, 0.0, 0.0);
+				double smoothingScale = f.SmoothingScale / levelFactor;
+				Vector3D offset = direction * 0.5 * particleDistance * smoothingScale;
+
+				Particle daughter = std::move(f);
+				daughter.FluidNeighbors.clear();
+				daughter.StaticBorderNeighbors.clear();
+				daughter.Mass *= 0.5;
+				daughter.SmoothingScale = smoothingScale;
+				daughter.LastTimestep = 0.0;
+				daughter.TimestepLevel = 0;
+				daughter.IsActiveInStep = true;
+				daughter.IsSleeping = false;
+				daughter.RestingSteps = 0;
+
+				adaptedParticles.push_back(daughter);
+				adaptedParticles.back().Position += offset;
+				adaptedParticles.push_back(daughter);
+				adaptedParticles.back().Position -= offset;
+				// the first daughter continues the parent
+				adaptedParticles.back().Id = fluid->CreateParticleId();
+				continue;
+			}
+
+			const int j = partner[i];
+			if (j >= 0 && partner[j] == i) {
+				if (j < i) {
+					// already merged into the particle with the lower index
+					continue;
+				}
+
+				const Particle& ff = particles[j];
+				double mass = f.Mass + ff.Mass;
+
+				// mass weighted averages conserve the center of mass and the momentum of the pair
+				Particle merged = std::move(f);
+				merged.FluidNeighbors.clear();
+				merged.StaticBorderNeighbors.clear();
+				// the partner may lie across a periodic limit, so it is averaged at its nearest image
+				merged.Position = merged.Position + ff.Mass / mass * kernel->GetDistanceVector(ff.Position, merged.Position);
+				merged.Velocity = (merged.Mass * merged.Velocity + ff.Mass * ff.Velocity) / mass;
+				merged.Density = (merged.Mass * merged.Density + ff.Mass * ff.Density) / mass;
+				merged.Pressure = (merged.Mass * merged.Pressure + ff.Mass * ff.Pressure) / mass;
+				merged.Mass = mass;
+				merged.SmoothingScale *= levelFactor;
+				merged.LastTimestep = 0.0;
+				merged.TimestepLevel = 0;
+				merged.IsActiveInStep = true;
+				merged.IsSleeping = false;
+				merged.RestingSteps = 0;
+
+				adaptedParticles.push_back(std::move(merged));
+				continue;
+			}
+
+			adaptedParticles.push_back(std::move(f));
+		}
+
+		particles.swap(adaptedParticles);
+		fluid->RebuildParticleIndex();
+
+		LastSplitCount += numSplits;
+		LastMergeCount += numMerges;
+	}
+}
+
+float UAdaptiveResolution::GetMaxSmoothingScale() const
+{
+	return pow(GetLevelFactor(), MergeLevels);
+}
+
+int UAdaptiveResolution::GetLastSplitCount() const
+{
+	return LastSplitCount;
+}
+
+int UAdaptiveResolution::GetLastMergeCount() const
+{
+	return LastMergeCount;
+}
+
+bool UAdaptiveResolution::RequiresFineResolution(const Particle & particle) const
+{
+	if (!particle.StaticBorderNeighbors.empty()) {
+		return true;
+	}
+
+	// The density is underestimated at free surfaces due to missing neighbors
+	if (particle.Density < SurfaceDensityRatio * particle.Fluid->GetRestDensity()) {
+		return true;
+	}
+
+	for (AScriptedVolume * region : RegionsOfInterest) {
+		if (region->GetEnabled() && region->IsParticleAffected(particle)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+double UAdaptiveResolution::GetLevelFactor() const
+{
+	// doubling the mass stretches the particle spacing by the d-th root of two
+	switch (Dimensionality) {
+	case EDimensionality::One:
+		return 2.0;
+	case EDimensionality::Two:
+		return sqrt(2.0);
+	default:
+		return cbrt(2.0);
+	}
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <vector>
+#include <limits>
+
+#include "CoreMinimal.h"
+#include "ParticleContext/ParticleContext.h"
+#include "Volumes/ScriptedVolume.h"
+#include "Runtime/Core/Public/Async/ParallelFor.h"
+
+#include "AdaptiveResolution.generated.h"
+
+enum EDimensionality;
+
+// Spatially adaptive resolution. The particle distance of the context is the finest resolution. Particles in the bulk of the fluid merge pairwise into coarser particles,
+// near free surfaces, borders and regions of interest they split back. Mass and momentum are conserved, the kernel support follows the smoothing scale of each particle
+UCLASS(BlueprintType)
+class UAdaptiveResolution : public UObject {
+	GENERATED_BODY()
+public:
+
+	virtual ~UAdaptiveResolution();
+
+	// mergeLevels: how often particles can be merged, each level doubles the mass. surfaceDensityRatio: particles below this fraction of the rest density are treated as surface
+	UFUNCTION(BlueprintPure, Category = "Resolution")
+	static UAdaptiveResolution * CreateAdaptiveResolution(TArray<AScriptedVolume*> regionsOfInterest, int mergeLevels = 2, float surfaceDensityRatio = 0.9f, int adaptationInterval = 10);
+
+	void Build(EDimensionality dimensionality);
+
+	// Keeps the finest resolution inside the volume
+	void AddRegionOfInterest(AScriptedVolume * region);
+
+	// Counts the steps and returns true every adaptation interval
+	bool ShouldAdaptInThisStep();
+
+	// Splits and merges the particles of all fluids. Requires up to date neighborhoods, which are invalid afterwards
+	void AdaptResolution(UParticleContext& particleContext);
+
+	// Smoothing scale of particles that have been merged the maximum number of times
+	UFUNCTION(BlueprintPure, Category = "Resolution")
+	float GetMaxSmoothingScale() const;
+
+	UFUNCTION(BlueprintPure, Category = "Resolution")
+	int GetLastSplitCount() const;
+
+	UFUNCTION(BlueprintPure, Category = "Resolution")
+	int GetLastMergeCount() const;
+
+protected:
+
+	// Particles at free surfaces, near borders or inside regions of interest keep the finest resolution
+	bool RequiresFineResolution(const Particle& particle) const;
+
+	// Factor the smoothing scale changes with a single split or merge
+	double GetLevelFactor() const;
+
+	TArray<AScriptedVolume*> RegionsOfInterest;
+
+	int MergeLevels = 2;
+	double SurfaceDensityRatio = 0.9;
+	int AdaptationInterval = 10;
+
+	int StepsSinceAdaptation = 0;
+
+	int LastSplitCount = 0;
+	int LastMergeCount = 0;
+
+	EDimensionality Dimensionality;
+};
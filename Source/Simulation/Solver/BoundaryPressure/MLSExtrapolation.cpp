@@ -26,12 +26,12 @@ void UMLSExtrapolation::ComputeAllPressureValues(UParticleContext * particleCont
 			ParallelFor(border->Particles->size(), [&](int32 i) {
 				Particle& b = border->Particles->at(i);
 
-
+				// positions are relative to the border particle, so fluid neighbors across a periodic limit are at their nearest image
 				Vector3D sumWeightedPosition = { 0.0, 0.0, 0.0 };
 				double sumWeights = 0.0;
 
 				for (const Particle& bf : b.FluidNeighbors) {
-					sumWeightedPosition += bf.Position * bf.GetVolume() * kernel->ComputeValue(b, bf);
+					sumWeightedPosition += kernel->GetDistanceVector(bf.Position, b.Position) * bf.GetVolume() * kernel->ComputeValue(b, bf);
 					sumWeights += bf.GetVolume() * kernel->ComputeValue(b, bf);
 				}
 
@@ -47,7 +47,7 @@ void UMLSExtrapolation::ComputeAllPressureValues(UParticleContext * particleCont
 				double matrix = 0.0;
 
 				for (const Particle& bf : b.FluidNeighbors) {
-					Vector3D r = bf.Position - weightedPosition;
+					Vector3D r = kernel->GetDistanceVector(bf.Position, b.Position) - weightedPosition;
 					alpha += (bf.Pressure * bf.GetVolume() * kernel->ComputeValue(b, bf)) / sumWeights;
 					sourceTerm += r * (bf.Pressure * bf.GetVolume() * kernel->ComputeValue(b, bf));
 					matrix += r.X * r.X * bf.GetVolume() * kernel->ComputeValue(b, bf);
@@ -58,7 +58,7 @@ void UMLSExtrapolation::ComputeAllPressureValues(UParticleContext * particleCont
 				if (abs(matrix) > Epsilon1D) {
 					Vector3D planePitch = Vector3D(sourceTerm.X / matrix, 0.0, 0.0);
 
-					b.Pressure = alpha + (b.Position - weightedPosition) * planePitch;
+					b.Pressure = alpha - weightedPosition * planePitch;
 				}
 				else {
 					b.Pressure = alpha;
@@ -77,7 +77,7 @@ void UMLSExtrapolation::ComputeAllPressureValues(UParticleContext * particleCont
 				double sumWeights = 0.0;
 
 				for (const Particle& bf : b.FluidNeighbors) {
-					sumWeightedPosition += bf.Position * bf.GetVolume() * kernel->ComputeValue(b, bf);
+					sumWeightedPosition += kernel->GetDistanceVector(bf.Position, b.Position) * bf.GetVolume() * kernel->ComputeValue(b, bf);
 					sumWeights += bf.GetVolume() * kernel->ComputeValue(b, bf);
 				}
 
@@ -95,7 +95,7 @@ void UMLSExtrapolation::ComputeAllPressureValues(UParticleContext * particleCont
 				double zz = 0.0;
 
 				for (const Particle& bf : b.FluidNeighbors) {
-					Vector3D r = bf.Position - weightedPosition;
+					Vector3D r = kernel->GetDistanceVector(bf.Position, b.Position) - weightedPosition;
 					alpha += (bf.Pressure * bf.GetVolume() * kernel->ComputeValue(b, bf)) / sumWeights;
 					sourceTerm += r * (bf.Pressure * bf.GetVolume() * kernel->ComputeValue(b, bf));
 					xx += r.X * r.X * bf.GetVolume() * kernel->ComputeValue(b, bf);
@@ -114,7 +114,7 @@ void UMLSExtrapolation::ComputeAllPressureValues(UParticleContext * particleCont
 
 					Vector3D planePitch = Vector3D(inverse_xx * sourceTerm.X + inverse_xz * sourceTerm.Z, 0.0, inverse_xz * sourceTerm.X + inverse_zz * sourceTerm.Z);
 
-					b.Pressure = std::max(0.0, alpha + (b.Position - weightedPosition) * planePitch);
+					b.Pressure = std::max(0.0, alpha - weightedPosition * planePitch);
 				}
 				else {
 					b.Pressure = std::max(0.0, alpha);
@@ -133,7 +133,7 @@ void UMLSExtrapolation::ComputeAllPressureValues(UParticleContext * particleCont
 				double sumWeighted = 0.0;
 
 				for (const Particle& bf : b.FluidNeighbors) {
-					sumWeightedPositions += bf.Position * bf.GetVolume() * kernel->ComputeValue(b, bf);
+					sumWeightedPositions += kernel->GetDistanceVector(bf.Position, b.Position) * bf.GetVolume() * kernel->ComputeValue(b, bf);
 					sumWeighted += bf.GetVolume() * kernel->ComputeValue(b, bf);
 				}
 
@@ -149,7 +149,7 @@ void UMLSExtrapolation::ComputeAllPressureValues(UParticleContext * particleCont
 				Matrix3D pitchMatrix = Matrix3D::Zero;
 
 				for (const Particle& bf : b.FluidNeighbors) {
-					Vector3D r = bf.Position - weightedPosition;
+					Vector3D r = kernel->GetDistanceVector(bf.Position, b.Position) - weightedPosition;
 					alpha += (bf.Pressure * bf.GetVolume() * kernel->ComputeValue(b, bf)) / sumWeighted;
 					sourceTerm += r * (bf.Pressure * bf.GetVolume() * kernel->ComputeValue(b, bf));
 					pitchMatrix += Matrix3D::OuterProduct(r, r) * bf.GetVolume() * kernel->ComputeValue(b, bf);
@@ -160,7 +160,7 @@ void UMLSExtrapolation::ComputeAllPressureValues(UParticleContext * particleCont
 
 					Vector3D planePitch = pitchMatrix.GetInverse() * sourceTerm;
 
-					b.Pressure = std::max(0.0, alpha + (b.Position - weightedPosition) * planePitch);
+					b.Pressure = std::max(0.0, alpha - weightedPosition * planePitch);
 				}
 				else {
 					b.Pressure = std::max(0.0, alpha);
@@ -16,7 +16,8 @@ UDFSPHSolver * UDFSPHSolver::CreateDFSPHSolver(TArray<UAcceleration*> accelerati
 	int maxIterationDensity,
 	float jacobiFactor,
 	UBoundaryPressure * boundaryPressure,
-	UPressureGradient * pressureGradient)
+	UPressureGradient * pressureGradient,
+	UTimeIntegrator * timeIntegrator)
 {
 	UDFSPHSolver * dfsphsolver = NewObject<UDFSPHSolver>();
 	dfsphsolver->SolverType = ESolverMethod::DFSPH;
@@ -33,6 +34,12 @@ UDFSPHSolver * UDFSPHSolver::CreateDFSPHSolver(TArray<UAcceleration*> accelerati
 	dfsphsolver->Accelerations = accelerations;
 	dfsphsolver->BoundaryPressureComputer = boundaryPressure;
 	dfsphsolver->PressureGradientComputer = pressureGradient;
+	// the pressure solve predicts positions and densities with an euler-cromer drift, other schemes would break the density invariance
+	if (timeIntegrator != nullptr && timeIntegrator->GetIntegratorType() != ETimeIntegrator::EulerCromer) {
+		UE_LOG(LogTemp, Warning, TEXT("DFSPH only supports the Euler-Cromer time integrator, the given integrator is ignored."));
+		timeIntegrator = nullptr;
+	}
+	dfsphsolver->TimeIntegrator = timeIntegrator;
 
 	// prevent garbage collection
 	dfsphsolver->AddToRoot();
@@ -44,6 +51,11 @@ void UDFSPHSolver::Step()
 {
 	FDateTime totalStartTime = FDateTime::UtcNow();
 
+	// Split particles at surfaces and merge them in the bulk before the fluid is solved
+	if (AdaptiveResolution != nullptr) {
+		AdaptResolution();
+	}
+
 	InitializePeriodicCondition();
 
 	// Reserve space for all particle attirbutes required by the solver
@@ -55,6 +67,16 @@ void UDFSPHSolver::Step()
 	// Find Neighbors with specified NeighborhoodSearch method
 	FindNeighbors();
 
+	// Resting particles fall asleep, disturbed ones wake up
+	if (SleepingParticles) {
+		UpdateSleepingParticles();
+	}
+
+	// Reduce the fidelity outside of regions of interest
+	if (RegionsOfInterest.Num() > 0) {
+		ApplyRegionsOfInterest();
+	}
+
 	// Compute Densities
 	FDateTime densityCalculationStartTime = FDateTime::UtcNow();
 	ComputeDensitiesExplicit();
@@ -124,7 +146,7 @@ void UDFSPHSolver::Step()
 	FDateTime integrationStartTime = FDateTime::UtcNow();
 
 	// Applies the pressure values from the density invariance term to the intermediate velocities resulting in final velocities and performing a position update
-	IntegrateEulerCromerWithPressureAcceleration();
+	IntegrateWithPressureAcceleration();
 
 	ComputationTimes.IntegrationTime = (FDateTime::UtcNow() - integrationStartTime).GetTotalSeconds();
 
@@ -182,12 +204,12 @@ double UDFSPHSolver::MaxTimeStep()
 		CurrentTimestep = Simulator->GetMaxTimestep();
 	}
 	else {
-		CurrentTimestep = std::min(Simulator->GetCFLNumber() * Simulator->GetParticleContext()->GetParticleDistance() / maxVelocity, Simulator->GetMaxTimestep());
+		CurrentTimestep = std::min(GetCFLNumber() * Simulator->GetParticleContext()->GetParticleDistance() / maxVelocity, Simulator->GetMaxTimestep());
 	}
 
 	// sometimes volumes need to restrict the timestep
 	for (AScriptedVolume * scriptedVolume : Volumes) {
-		CurrentTimestep = std::min(CurrentTimestep, scriptedVolume->MaxTimeStep(Simulator->GetCFLNumber(), *Simulator->GetParticleContext()));
+		CurrentTimestep = std::min(CurrentTimestep, scriptedVolume->MaxTimeStep(GetCFLNumber(), *Simulator->GetParticleContext()));
 	}
 
 	CurrentTimestep = std::max(CurrentTimestep, Simulator->GetMinTimestep());
@@ -209,11 +231,6 @@ void UDFSPHSolver::ComputeNonPressureAccelerations()
 		acceleration->ApplyAcceleration(GetSimulator()->GetParticleContext());
 	}
 
-	// In the special case of a periodic setting update pressure of ghost particles
-	if (GetParticleContext()->GetPeriodicCondition() != nullptr) {
-		GetParticleContext()->GetPeriodicCondition()->UpdateGhostParticleAcceleration();
-	}
-
 	ComputationTimes.AccelerationComputationTime = (FDateTime::UtcNow() - startTime).GetTotalSeconds();
 }
 
@@ -248,8 +265,8 @@ void UDFSPHSolver::ComputeSourceTermsVelocityDivergence()
 		ParallelFor(fluid->Particles->size(), [&](int32 i) {
 			Particle& f = fluid->Particles->at(i);
 
-			// in DFSPH velocity divergence is only solved if neighborhood is full enough
-			if (!HasEnoughNeighbors(f)) {
+			// in DFSPH velocity divergence is only solved if neighborhood is full enough, sleeping particles are frozen and take no part in the solve
+			if (f.IsSleeping || !HasEnoughNeighbors(f)) {
 				Attributes[*fluid][i].SourceTerm = 0.0;
 				return;
 			}
@@ -275,7 +292,7 @@ void UDFSPHSolver::ComputeSourceTermsDensity()
 	for (UFluid * fluid : GetParticleContext()->GetFluids()) {
 		ParallelFor(fluid->Particles->size(), [&](int32 i) {
 			Particle& f = fluid->Particles->at(i);
-			Attributes[*fluid][i].SourceTerm = f.Fluid->GetRestDensity() - Attributes[*fluid][i].IntermediateDensity;
+			Attributes[*fluid][i].SourceTerm = f.IsSleeping ? 0.0 : f.Fluid->GetRestDensity() - Attributes[*fluid][i].IntermediateDensity;
 		});
 	}
 }
@@ -284,6 +301,14 @@ void UDFSPHSolver::ComputeDiagonalElement(bool clampAtZero) {
 	for (UFluid * fluid : GetParticleContext()->GetFluids()) {
 		ParallelFor(fluid->Particles->size(), [&](int32 i) {
 			Particle& f = fluid->Particles->at(i);
+			Attributes[*fluid][i].ToleranceFactor = f.ErrorToleranceFactor;
+
+			// sleeping particles have no pressure, so a zero diagonal element keeps it at zero
+			if (f.IsSleeping) {
+				Attributes[*fluid][i].Aff = 0.0;
+				return;
+			}
+
 			// we don't need the diagonal element for particles with no predicted density error
 			if (clampAtZero && Attributes[*fluid][i].SourceTerm >= 0) {
 				// return only exits Parallel call
@@ -349,25 +374,18 @@ void UDFSPHSolver::InitializePressureValues(bool clampAtZero) {
 
 	// boundary pressure
 	GetBoundaryPressure()->ComputeAllPressureValues(GetSimulator()->GetParticleContext(), GetKernel());
-
-	// In the special case of a periodic setting update pressure of ghost particles
-	if (GetParticleContext()->GetPeriodicCondition() != nullptr) {
-		GetParticleContext()->GetPeriodicCondition()->UpdateGhostParticlePressure();
-	}
 }
 
 void UDFSPHSolver::UpdatePressureAcceleration() {
 	for (UFluid * fluid : GetParticleContext()->GetFluids()) {
 		ParallelFor(fluid->Particles->size(), [&](int32 i) {
 			Particle& f = fluid->Particles->at(i);
+			if (f.IsSleeping) {
+				return;
+			}
 			f.Acceleration = - GetPressureGradient()->ComputePressureGradient(f, i) / f.Density;
 		});
 	}
-
-	// In the special case of a periodic setting update acceleration of ghost particles
-	if (GetParticleContext()->GetPeriodicCondition() != nullptr) {
-		GetParticleContext()->GetPeriodicCondition()->UpdateGhostParticleAcceleration();
-	}
 }
 
 
@@ -378,6 +396,9 @@ void UDFSPHSolver::ComputePressureAccelerationCorrection(bool clampToZeroIncompl
 			ParallelFor(fluid->Particles->size(), [&](int32 i) {
 				Particle& f = fluid->Particles->at(i);
 				Attributes[*fluid][i].Ap = 0;
+				if (f.IsSleeping) {
+					return;
+				}
 				for (const Particle& ff : f.FluidNeighbors) {
 					Attributes[*fluid][i].Ap += pow(CurrentTimestep, 2) * ff.Mass * (f.Acceleration - ff.Acceleration) * GetKernel()->ComputeGradient(f, ff);
 				}
@@ -394,6 +415,9 @@ void UDFSPHSolver::ComputePressureAccelerationCorrection(bool clampToZeroIncompl
 				Particle& f = fluid->Particles->at(i);
 
 				Attributes[*fluid][i].Ap = 0;
+				if (f.IsSleeping) {
+					return;
+				}
 				for (const Particle& ff : f.FluidNeighbors) {
 					Attributes[*fluid][i].Ap += pow(CurrentTimestep, 2) * ff.Mass * (f.Acceleration - ff.Acceleration) * GetKernel()->ComputeGradient(f, ff);
 				}
@@ -414,7 +438,7 @@ void UDFSPHSolver::RelaxedJacobiUpdatePressure(bool clampAtZero)
 			Particle& f = fluid->Particles->at(i);
 
 			// in DFSPH velocity divergence is only solved if neighborhood is full enough
-			if (!HasEnoughNeighbors(f)) {
+			if (f.IsSleeping || !HasEnoughNeighbors(f)) {
 				return;
 			}
 
@@ -437,11 +461,6 @@ void UDFSPHSolver::RelaxedJacobiUpdatePressure(bool clampAtZero)
 
 	// boundary pressure
 	GetBoundaryPressure()->ComputeAllPressureValues(GetSimulator()->GetParticleContext(), GetKernel());
-
-	// In the special case of a periodic setting update pressure of ghost particles
-	if (GetParticleContext()->GetPeriodicCondition() != nullptr) {
-		GetParticleContext()->GetPeriodicCondition()->UpdateGhostParticlePressure();
-	}
 }
 
 void UDFSPHSolver::ComputePredictedDensities()
@@ -450,6 +469,11 @@ void UDFSPHSolver::ComputePredictedDensities()
 		ParallelFor(fluid->Particles->size(), [&](int32 i) {
 			Particle& f = fluid->Particles->at(i);
 
+			if (f.IsSleeping) {
+				Attributes[*fluid][i].IntermediateDensity = f.Density;
+				return;
+			}
+
 			double velocityDivergence = 0.0;
 
 			for (FluidNeighbor& ff : f.FluidNeighbors) {
@@ -464,23 +488,25 @@ void UDFSPHSolver::ComputePredictedDensities()
 }
 
 
-void UDFSPHSolver::IntegrateEulerCromerWithPressureAcceleration() {
+void UDFSPHSolver::IntegrateWithPressureAcceleration() {
 	for (UFluid * fluid : GetParticleContext()->GetFluids()) {
 		ParallelFor(fluid->Particles->size(), [&](int32 i) {
 			Particle& f = fluid->Particles->at(i);
 
+			if (f.IsSleeping) {
+				return;
+			}
+
 			if (!f.IsScripted) {
-				// acceleration should only contain pressure acceleration
-				f.Velocity = Attributes[*fluid][i].IntermediateVelocity + CurrentTimestep * f.Acceleration;
-				f.Position = f.Position + CurrentTimestep * f.Velocity;
+				// acceleration should only contain pressure acceleration, the non-pressure part is contained in the intermediate velocity
+				Vector3D totalAcceleration = (Attributes[*fluid][i].IntermediateVelocity - f.Velocity) / CurrentTimestep + f.Acceleration;
+				GetTimeIntegrator()->IntegrateParticle(f, totalAcceleration, CurrentTimestep);
+			}
+			else {
+				f.LastTimestep = 0.0;
 			}
 		});
 	}
-
-	// In the special case of a periodic setting update positions
-	if (GetParticleContext()->GetPeriodicCondition() != nullptr) {
-		GetParticleContext()->GetPeriodicCondition()->UpdateGhostParticleAttributes(true);
-	}
 }
 
 bool UDFSPHSolver::CheckAveragePredictedVelocityDivergenceError()
@@ -491,13 +517,13 @@ bool UDFSPHSolver::CheckAveragePredictedVelocityDivergenceError()
 	for (UFluid * fluid : GetParticleContext()->GetFluids()) {
 
 		// check individual particle velocity error
-		if (ParallelExists<DFSPHParticleAttributes>(Attributes[*fluid], [this](const DFSPHParticleAttributes& attributes) {return (attributes.Ap - attributes.SourceTerm) > DesiredIndividualVelocityDivergenceError; })) {
+		if (ParallelExists<DFSPHParticleAttributes>(Attributes[*fluid], [this](const DFSPHParticleAttributes& attributes) {return (attributes.Ap - attributes.SourceTerm) > DesiredIndividualVelocityDivergenceError * attributes.ToleranceFactor; })) {
 			return false;
 		}
 
 		// check average particle velocity error
-		divergenceSum += ParallelSum<DFSPHParticleAttributes, double>(Attributes[*fluid], [](const DFSPHParticleAttributes& attributes) { return std::abs(attributes.Ap - attributes.SourceTerm); });
-		numParticles += fluid->Particles->size();
+		divergenceSum += ParallelSum<DFSPHParticleAttributes, double>(Attributes[*fluid], [](const DFSPHParticleAttributes& attributes) { return std::abs(attributes.Ap - attributes.SourceTerm) / attributes.ToleranceFactor; });
+		numParticles += fluid->GetNumLiveParticles();
 	}
 
 	double averageDivergenceError = divergenceSum / numParticles;
@@ -535,12 +561,12 @@ bool UDFSPHSolver::CheckAveragePredictedDensityError()
 	for (UFluid * fluid : GetParticleContext()->GetFluids()) {
 
 		// check individual particle density error
-		if (ParallelExists<DFSPHParticleAttributes>(Attributes[*fluid], [this](const DFSPHParticleAttributes& attributes) {return (attributes.Ap - attributes.SourceTerm) > DesiredIndividualDensityError; })) {
+		if (ParallelExists<DFSPHParticleAttributes>(Attributes[*fluid], [this](const DFSPHParticleAttributes& attributes) {return (attributes.Ap - attributes.SourceTerm) > DesiredIndividualDensityError * attributes.ToleranceFactor; })) {
 			return false;
 		}
 
-		densitySum += ParallelSum<DFSPHParticleAttributes, double>(Attributes[*fluid], [](const DFSPHParticleAttributes& attributes) { return std::max(attributes.Ap - attributes.SourceTerm, 0.0); }) / fluid->GetRestDensity();
-		numParticles += fluid->Particles->size();
+		densitySum += ParallelSum<DFSPHParticleAttributes, double>(Attributes[*fluid], [](const DFSPHParticleAttributes& attributes) { return std::max(attributes.Ap - attributes.SourceTerm, 0.0) / attributes.ToleranceFactor; }) / fluid->GetRestDensity();
+		numParticles += fluid->GetNumLiveParticles();
 	}
 
 	double averageDensityError = densitySum / numParticles;
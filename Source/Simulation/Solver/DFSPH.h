@@ -19,6 +19,7 @@ struct DFSPHParticleAttributes {
 	double Aff;
 	double IntermediateDensity;
 	Vector3D IntermediateVelocity;
+	double ToleranceFactor;
 };
 
 UCLASS(BlueprintType)
@@ -29,6 +30,7 @@ public:
 
 	~UDFSPHSolver() override;
 
+	// Only the Euler-Cromer time integrator is supported, others are ignored with a warning
 	UFUNCTION(BlueprintPure, Category = "Solver")
 	static UDFSPHSolver * CreateDFSPHSolver(TArray<UAcceleration*> accelerations,
 		float desiredAverageVelocityDivergenceError = 0.1,
@@ -41,7 +43,8 @@ public:
 		int maxIterationDensity = 100,
 		float jacobiFactor = 0.5,
 		UBoundaryPressure * boundaryPressure = nullptr,
-		UPressureGradient * pressureGradient = nullptr);
+		UPressureGradient * pressureGradient = nullptr,
+		UTimeIntegrator * timeIntegrator = nullptr);
 
 	void Step();
 	void ComputeSolverStatistics(bool computeSolverStats = true);
@@ -71,7 +74,7 @@ protected:
 	void ComputePredictedDensities();
 
 	// Apply final pressure acceleration from density invariance solving to velocity and position
-	void IntegrateEulerCromerWithPressureAcceleration();
+	void IntegrateWithPressureAcceleration();
 
 	// returns true if average density error is smaller than desired density error
 	bool CheckAveragePredictedDensityError();
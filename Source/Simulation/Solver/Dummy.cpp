@@ -12,7 +12,8 @@ UDummySolver * UDummySolver::CreateDummySolver(TArray<UAcceleration*> accelerati
 	UPressureGradient * pressureGradient,
 	bool computeNeighborhoods,
 	bool computeNonPressureAccelerations,
-	bool computeScriptedVolumes)
+	bool computeScriptedVolumes,
+	UTimeIntegrator * timeIntegrator)
 {
 	UDummySolver * dummySolver = NewObject<UDummySolver>();
 	dummySolver->SolverType = ESolverMethod::Dummy;
@@ -25,6 +26,7 @@ UDummySolver * UDummySolver::CreateDummySolver(TArray<UAcceleration*> accelerati
 
 	dummySolver->BoundaryPressureComputer = boundaryPressure;
 	dummySolver->PressureGradientComputer = pressureGradient;
+	dummySolver->TimeIntegrator = timeIntegrator;
 
 	// prevent garbage collection
 	dummySolver->AddToRoot();
@@ -106,7 +108,7 @@ void UDummySolver::Step()
 		if (ComputeScriptedVolumes)
 			ApplyScriptedVolumesBeforeIntegration();
 
-		IntegrateEulerCromer();
+		Integrate();
 
 		// Applies all behaviour defined by scripted volumes
 		if (ComputeScriptedVolumes)
@@ -168,12 +170,12 @@ double UDummySolver::MaxTimeStep()
 		CurrentTimestep = Simulator->GetMaxTimestep();
 	}
 	else {
-		CurrentTimestep = FMath::Max(FMath::Min(Simulator->GetCFLNumber() * Simulator->GetParticleContext()->GetParticleDistance() / maxVelocity, Simulator->GetMaxTimestep()), Simulator->GetMinTimestep());
+		CurrentTimestep = FMath::Max(FMath::Min(GetCFLNumber() * Simulator->GetParticleContext()->GetParticleDistance() / maxVelocity, Simulator->GetMaxTimestep()), Simulator->GetMinTimestep());
 	}
 
 	// sometimes volumes need to restrict the timestep
 	for (AScriptedVolume * scriptedVolume : Volumes) {
-		std::min(CurrentTimestep, scriptedVolume->MaxTimeStep(Simulator->GetCFLNumber(), *Simulator->GetParticleContext()));
+		CurrentTimestep = std::min(CurrentTimestep, scriptedVolume->MaxTimeStep(GetCFLNumber(), *Simulator->GetParticleContext()));
 	}
 
 	// Check if CurrentTimestep needs to be smaller because of incoming new recording-frame
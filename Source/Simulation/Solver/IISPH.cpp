@@ -12,7 +12,8 @@ UIISPHSolver * UIISPHSolver::CreateIISPHSolver(TArray<UAcceleration*> accelerati
 	int maxIteration,
 	float jacobiFactor,
 	UBoundaryPressure * boundaryPressure,
-	UPressureGradient * pressureGradient)
+	UPressureGradient * pressureGradient,
+	UTimeIntegrator * timeIntegrator)
 {
 	UIISPHSolver * iisphsolver = NewObject<UIISPHSolver>();
 	iisphsolver->SolverType = ESolverMethod::IISPH;
@@ -25,6 +26,12 @@ UIISPHSolver * UIISPHSolver::CreateIISPHSolver(TArray<UAcceleration*> accelerati
 	iisphsolver->Accelerations = accelerations;
 	iisphsolver->BoundaryPressureComputer = boundaryPressure;
 	iisphsolver->PressureGradientComputer = pressureGradient;
+	// the pressure solve predicts positions and densities with an euler-cromer drift, other schemes would break the density invariance
+	if (timeIntegrator != nullptr && timeIntegrator->GetIntegratorType() != ETimeIntegrator::EulerCromer) {
+		UE_LOG(LogTemp, Warning, TEXT("IISPH only supports the Euler-Cromer time integrator, the given integrator is ignored."));
+		timeIntegrator = nullptr;
+	}
+	iisphsolver->TimeIntegrator = timeIntegrator;
 
 
 	// prevent garbage collection
@@ -37,11 +44,26 @@ void UIISPHSolver::Step()
 {
 	FDateTime totalStartTime = FDateTime::UtcNow();
 		
+	// Split particles at surfaces and merge them in the bulk before the fluid is solved
+	if (AdaptiveResolution != nullptr) {
+		AdaptResolution();
+	}
+
 	FitSolverAttributeArray();
 	InitializePeriodicCondition();
 	ClearAcceleration();
 	FindNeighbors();
 
+	// Resting particles fall asleep, disturbed ones wake up
+	if (SleepingParticles) {
+		UpdateSleepingParticles();
+	}
+
+	// Reduce the fidelity outside of regions of interest
+	if (RegionsOfInterest.Num() > 0) {
+		ApplyRegionsOfInterest();
+	}
+
 	FDateTime densityCalculationStartTime = FDateTime::UtcNow();
 	ComputeDensitiesExplicit();
 	ComputeAverageDensityError();
@@ -77,7 +99,7 @@ void UIISPHSolver::Step()
 
 	// Add the pressure acceleration and integrate
 	FDateTime integrationStartTime = FDateTime::UtcNow();
-	IntegrateEulerCromerWithPressureAcceleration();
+	IntegrateWithPressureAcceleration();
 	ComputationTimes.IntegrationTime = (FDateTime::UtcNow() - integrationStartTime).GetTotalSeconds();
 
 	// Applies all behaviour defined by scripted volumes
@@ -135,12 +157,12 @@ double UIISPHSolver::MaxTimeStep()
 		CurrentTimestep = Simulator->GetMaxTimestep();
 	}
 	else {
-		CurrentTimestep = std::min(Simulator->GetCFLNumber() * Simulator->GetParticleContext()->GetParticleDistance() / maxVelocity, Simulator->GetMaxTimestep());
+		CurrentTimestep = std::min(GetCFLNumber() * Simulator->GetParticleContext()->GetParticleDistance() / maxVelocity, Simulator->GetMaxTimestep());
 	}
 
 	// sometimes volumes need to restrict the timestep
 	for (AScriptedVolume * scriptedVolume : Volumes) {
-		CurrentTimestep = std::min(CurrentTimestep, scriptedVolume->MaxTimeStep(Simulator->GetCFLNumber(), *Simulator->GetParticleContext()));
+		CurrentTimestep = std::min(CurrentTimestep, scriptedVolume->MaxTimeStep(GetCFLNumber(), *Simulator->GetParticleContext()));
 	}
 
 	CurrentTimestep = std::max(CurrentTimestep, Simulator->GetMinTimestep());
@@ -163,10 +185,6 @@ void UIISPHSolver::ComputeNonPressureAccelerations()
 	}
 
 	ComputationTimes.AccelerationComputationTime = (FDateTime::UtcNow() - startTime).GetTotalSeconds();
-
-	if (GetParticleContext()->GetPeriodicCondition() != nullptr) {
-		GetParticleContext()->GetPeriodicCondition()->UpdateGhostParticleAcceleration();
-	}
 }
 
 void UIISPHSolver::ComputeIntermediateVelocities()
@@ -184,6 +202,14 @@ void UIISPHSolver::ComputeSourceTerms()
 	for (UFluid * fluid : GetParticleContext()->GetFluids()) {
 		ParallelFor(fluid->Particles->size(), [&](int32 i) {
 			Particle& f = fluid->Particles->at(i);
+			Attributes[*fluid][i].ToleranceFactor = f.ErrorToleranceFactor;
+
+			// sleeping particles are frozen and take no part in the pressure solve
+			if (f.IsSleeping) {
+				Attributes[*fluid][i].SourceTerm = 0.0;
+				return;
+			}
+
 			double velocityDivergence = 0;
 
 			for (FluidNeighbor& ff : f.FluidNeighbors) {
@@ -204,6 +230,13 @@ void UIISPHSolver::ComputeDiagonalElement() {
 	for (UFluid * fluid : GetParticleContext()->GetFluids()) {
 		ParallelFor(fluid->Particles->size(), [&](int32 i) {
 			Particle& f = fluid->Particles->at(i);
+
+			// sleeping particles have no pressure, so a zero diagonal element keeps it at zero
+			if (f.IsSleeping) {
+				Attributes[*fluid][i].Aff = 0.0;
+				return;
+			}
+
 			// we don't need the diagonal element for particles with no predicted density error
 			if (Attributes[*fluid][i].SourceTerm >= 0) {
 				// return only exits Parallel call
@@ -270,11 +303,6 @@ void UIISPHSolver::InitializePressureValues(bool clampAtZero) {
 
 	// Static-border pressure
 	GetBoundaryPressure()->ComputeAllPressureValues(GetSimulator()->GetParticleContext(), GetKernel());
-
-	// In the special case of a periodic setting update pressure of ghost particles
-	if (GetParticleContext()->GetPeriodicCondition() != nullptr) {
-		GetParticleContext()->GetPeriodicCondition()->UpdateGhostParticlePressure();
-	}
 }
 
 
@@ -282,13 +310,12 @@ void UIISPHSolver::UpdatePressureAcceleration() {
 	for (UFluid * fluid : GetParticleContext()->GetFluids()) {
 		ParallelFor(fluid->Particles->size(), [&](int32 i) {
 			Particle& f = fluid->Particles->at(i);
+			if (f.IsSleeping) {
+				return;
+			}
 			f.Acceleration = -GetPressureGradient()->ComputePressureGradient(f, i) / f.Density;
 		});
 	}
-
-	if (GetParticleContext()->GetPeriodicCondition() != nullptr) {
-		GetParticleContext()->GetPeriodicCondition()->UpdateGhostParticleAcceleration();
-	}
 }
 
 void UIISPHSolver::ComputePressureAccelerationCorrection()
@@ -298,6 +325,9 @@ void UIISPHSolver::ComputePressureAccelerationCorrection()
 			Particle& f = fluid->Particles->at(i);
 
 			Attributes[*fluid][i].Ap = 0;
+			if (f.IsSleeping) {
+				return;
+			}
 			for (const Particle& ff : f.FluidNeighbors) {
 				Attributes[*fluid][i].Ap += pow(CurrentTimestep, 2) * ff.Mass * (f.Acceleration - ff.Acceleration) * GetKernel()->ComputeGradient(f, ff);
 			}
@@ -314,6 +344,9 @@ void UIISPHSolver::RelaxedJacobiUpdatePressure()
 	for (UFluid * fluid : GetParticleContext()->GetFluids()) {
 		ParallelFor(fluid->Particles->size(), [&](int32 i) {
 			Particle& f = fluid->Particles->at(i);
+			if (f.IsSleeping) {
+				return;
+			}
 			// update pressure only if Aff is not 0 (if Aff = 0, then there are no neighbors)
 			if (std::abs(Attributes[*fluid][i].Aff) > DBL_EPSILON) {
 				if (Attributes[*fluid][i].SourceTerm < 0) {
@@ -329,34 +362,23 @@ void UIISPHSolver::RelaxedJacobiUpdatePressure()
 	// Boundary pressure
 	GetBoundaryPressure()->ComputeAllPressureValues(GetSimulator()->GetParticleContext(), GetKernel());
 
-
-	// In the special case of a periodic setting update pressure of ghost particles
-	if (GetParticleContext()->GetPeriodicCondition() != nullptr) {
-		GetParticleContext()->GetPeriodicCondition()->UpdateGhostParticlePressure();
-	}
 }
 
 bool UIISPHSolver::CheckAveragePredictedDensityError()
 {
-	for (UFluid * fluid : GetParticleContext()->GetFluids()) {
-		ParallelFor(fluid->Particles->size(), [&](int32 i) {
-			Particle& f = fluid->Particles->at(i);
-
-		});
-	}
 	// compute predicted density errors and sum them
 	double densitySum = 0.0;
 	int numParticles = 0;
 	for (UFluid * fluid : GetParticleContext()->GetFluids()) {
 
 		// check individual particle density error
-		if (ParallelExists<IISPHParticleAttributes>(Attributes[*fluid], [this](const IISPHParticleAttributes& attributes) {return (attributes.Ap - attributes.SourceTerm) > DesiredIndividualDensityError; })) {
+		if (ParallelExists<IISPHParticleAttributes>(Attributes[*fluid], [this](const IISPHParticleAttributes& attributes) {return (attributes.Ap - attributes.SourceTerm) > DesiredIndividualDensityError * attributes.ToleranceFactor; })) {
 			return false;
 		}
 		
 		// check average density error
-		densitySum += ParallelSum<IISPHParticleAttributes, double>(Attributes[*fluid], [](const IISPHParticleAttributes& attributes) {return std::max(attributes.Ap - attributes.SourceTerm, 0.0); }) / fluid->GetRestDensity();
-		numParticles += fluid->Particles->size();
+		densitySum += ParallelSum<IISPHParticleAttributes, double>(Attributes[*fluid], [](const IISPHParticleAttributes& attributes) {return std::max(attributes.Ap - attributes.SourceTerm, 0.0) / attributes.ToleranceFactor; }) / fluid->GetRestDensity();
+		numParticles += fluid->GetNumLiveParticles();
 	}
 
 	double averageDensityError = densitySum / numParticles;
@@ -365,22 +387,28 @@ bool UIISPHSolver::CheckAveragePredictedDensityError()
 }
 
 
-void UIISPHSolver::IntegrateEulerCromerWithPressureAcceleration() {
+void UIISPHSolver::IntegrateWithPressureAcceleration() {
 	for (UFluid * fluid : GetParticleContext()->GetFluids()) {
 		ParallelFor(fluid->Particles->size(), [&](int32 i) {
 			Particle& particle = fluid->Particles->at(i);
 
+			if (particle.IsSleeping) {
+				return;
+			}
+
 			if (!particle.IsScripted) {
-				// acceleration should only contain pressure acceleration
-				particle.Velocity = Attributes[*fluid][i].IntermediateVelocity + CurrentTimestep * particle.Acceleration;
-				particle.Position = particle.Position + CurrentTimestep * particle.Velocity;
+				// acceleration should only contain pressure acceleration, the non-pressure part is contained in the intermediate velocity
+				Vector3D totalAcceleration = (Attributes[*fluid][i].IntermediateVelocity - particle.Velocity) / CurrentTimestep + particle.Acceleration;
+				GetTimeIntegrator()->IntegrateParticle(particle, totalAcceleration, CurrentTimestep);
+			}
+			else {
+				particle.LastTimestep = 0.0;
 			}
 		});
 	}
 
-	// In the special case of a periodic setting new particles are generated at necessary positions
+	// In the special case of a periodic setting particles leaving the domain enter it on the other side
 	if (GetParticleContext()->GetPeriodicCondition() != nullptr) {
 		GetParticleContext()->GetPeriodicCondition()->MoveOutOfBoundsParticles();
-		GetParticleContext()->GetPeriodicCondition()->UpdateGhostParticleAttributes(true);
 	}
 }
\ No newline at end of file
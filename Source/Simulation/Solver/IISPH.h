@@ -20,6 +20,7 @@ struct IISPHParticleAttributes {
 	double Aff;
 	double IntermediateDensity;
 	Vector3D IntermediateVelocity;
+	double ToleranceFactor;
 };
 
 UCLASS(BlueprintType)
@@ -30,6 +31,7 @@ public:
 
 	~UIISPHSolver() override;
 
+	// Only the Euler-Cromer time integrator is supported, others are ignored with a warning
 	UFUNCTION(BlueprintPure, Category = "Solver")
 	static UIISPHSolver * CreateIISPHSolver(TArray<UAcceleration*> accelerations,
 		float desiredDensityError = 0.001,
@@ -38,7 +40,8 @@ public:
 		int maxIteration = 100,
 		float jacobiFactor = 0.5,
 		UBoundaryPressure * boundaryPressure = nullptr,
-		UPressureGradient * pressureGradient = nullptr);
+		UPressureGradient * pressureGradient = nullptr,
+		UTimeIntegrator * timeIntegrator = nullptr);
 
 	void Step();
 	void ComputeSolverStatistics(bool computeSolverStats = true);
@@ -55,7 +58,7 @@ protected:
 	void ComputeDiagonalElement();
 	void InitializePressureValues(bool clampAtZero);
 	void UpdatePressureAcceleration();
-	void IntegrateEulerCromerWithPressureAcceleration();
+	void IntegrateWithPressureAcceleration();
 	void ComputePressureAccelerationCorrection();
 	void RelaxedJacobiUpdatePressure();
 
@@ -16,10 +16,10 @@ void UCorrectedKernelPressureGradient::PrecomputeAllGeometryData(const UParticle
 			Matrix3D correctionMatrix = Matrix3D::Zero;
 
 			for (Particle& ff : f.FluidNeighbors) {
-				correctionMatrix += Matrix3D::OuterProduct(ff.GetVolume() * GetKernel().ComputeGradient(f, ff), ff.Position - f.Position);
+				correctionMatrix += Matrix3D::OuterProduct(ff.GetVolume() * GetKernel().ComputeGradient(f, ff), GetKernel().GetDistanceVector(ff.Position, f.Position));
 			}
 			for (Particle& fb : f.StaticBorderNeighbors) {
-				correctionMatrix += Matrix3D::OuterProduct(fb.Mass / f.Density * GetKernel().ComputeGradient(f, fb), fb.Position - f.Position);
+				correctionMatrix += Matrix3D::OuterProduct(fb.Mass / f.Density * GetKernel().ComputeGradient(f, fb), GetKernel().GetDistanceVector(fb.Position, f.Position));
 			}
 			
 			// Invert correction matrix if possible. If no possile we use the identity matrix
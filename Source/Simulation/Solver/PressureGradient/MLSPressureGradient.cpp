@@ -7,15 +7,16 @@ Vector3D UMLSPressureGradient::ComputePressureGradient(Particle& f, int particle
 
 	case EDimensionality::One:
 	{
+		// positions are relative to the particle, so neighbors across a periodic limit are at their nearest image
 		Vector3D sumWeightedPosition = { 0.0, 0.0, 0.0 };
 		double sumWeights = 0.0;
 
 		for (const Particle& ff : f.FluidNeighbors) {
-			sumWeightedPosition += ff.Position * ff.GetVolume() * GetKernel().ComputeValue(f, ff);
+			sumWeightedPosition += GetKernel().GetDistanceVector(ff.Position, f.Position) * ff.GetVolume() * GetKernel().ComputeValue(f, ff);
 			sumWeights += ff.GetVolume() * GetKernel().ComputeValue(f, ff);
 		}
 		for (const Particle& fb : f.StaticBorderNeighbors) {
-			sumWeightedPosition += fb.Position * fb.GetVolume() * GetKernel().ComputeValue(f, fb);
+			sumWeightedPosition += GetKernel().GetDistanceVector(fb.Position, f.Position) * fb.GetVolume() * GetKernel().ComputeValue(f, fb);
 			sumWeights += fb.GetVolume() * GetKernel().ComputeValue(f, fb);
 		}
 
@@ -30,12 +31,12 @@ Vector3D UMLSPressureGradient::ComputePressureGradient(Particle& f, int particle
 		double matrix = 0.0;
 
 		for (const Particle& ff : f.FluidNeighbors) {
-			Vector3D r = ff.Position - weightedPosition;
+			Vector3D r = GetKernel().GetDistanceVector(ff.Position, f.Position) - weightedPosition;
 			sourceTerm += r * (ff.Pressure * ff.GetVolume() * GetKernel().ComputeValue(f, ff));
 			matrix += r.X * r.X * ff.GetVolume() * GetKernel().ComputeValue(f, ff);
 		}
 		for (const Particle& fb : f.StaticBorderNeighbors) {
-			Vector3D r = fb.Position - weightedPosition;
+			Vector3D r = GetKernel().GetDistanceVector(fb.Position, f.Position) - weightedPosition;
 			sourceTerm += r * (fb.Pressure * fb.GetVolume() * GetKernel().ComputeValue(f, fb));
 			matrix += r.X * r.X * fb.GetVolume() * GetKernel().ComputeValue(f, fb);
 		}
@@ -57,11 +58,11 @@ Vector3D UMLSPressureGradient::ComputePressureGradient(Particle& f, int particle
 		double sumWeights = 0.0;
 
 		for (const Particle& ff : f.FluidNeighbors) {
-			sumWeightedPosition += ff.Position * ff.GetVolume() * GetKernel().ComputeValue(f, ff);
+			sumWeightedPosition += GetKernel().GetDistanceVector(ff.Position, f.Position) * ff.GetVolume() * GetKernel().ComputeValue(f, ff);
 			sumWeights += ff.GetVolume() * GetKernel().ComputeValue(f, ff);
 		}
 		for (const Particle& fb : f.StaticBorderNeighbors) {
-			sumWeightedPosition += fb.Position * fb.GetVolume() * GetKernel().ComputeValue(f, fb);
+			sumWeightedPosition += GetKernel().GetDistanceVector(fb.Position, f.Position) * fb.GetVolume() * GetKernel().ComputeValue(f, fb);
 			sumWeights += fb.Mass * f.Density * GetKernel().ComputeValue(f, fb);
 		}
 
@@ -78,7 +79,7 @@ Vector3D UMLSPressureGradient::ComputePressureGradient(Particle& f, int particle
 		double zz = 0.0;
 
 		for (const Particle& ff : f.FluidNeighbors) {
-			Vector3D r = ff.Position - weightedPosition;
+			Vector3D r = GetKernel().GetDistanceVector(ff.Position, f.Position) - weightedPosition;
 			alpha += (ff.Pressure * ff.GetVolume() * GetKernel().ComputeValue(f, ff)) / sumWeights;
 			sourceTerm += r * (ff.Pressure * ff.GetVolume() * GetKernel().ComputeValue(f, ff));
 			xx += r.X * r.X * ff.GetVolume() * GetKernel().ComputeValue(f, ff);
@@ -86,7 +87,7 @@ Vector3D UMLSPressureGradient::ComputePressureGradient(Particle& f, int particle
 			zz += r.Z * r.Z * ff.GetVolume() * GetKernel().ComputeValue(f, ff);
 		}
 		for (const Particle& fb : f.StaticBorderNeighbors) {
-			Vector3D r = fb.Position - weightedPosition;
+			Vector3D r = GetKernel().GetDistanceVector(fb.Position, f.Position) - weightedPosition;
 			alpha += (fb.Pressure * fb.GetVolume() * GetKernel().ComputeValue(f, fb)) / sumWeights;
 			sourceTerm += r * (fb.Pressure * fb.GetVolume() * GetKernel().ComputeValue(f, fb));
 			xx += r.X * r.X * fb.Mass * f.Density * GetKernel().ComputeValue(f, fb);
@@ -119,11 +120,11 @@ Vector3D UMLSPressureGradient::ComputePressureGradient(Particle& f, int particle
 		double sumWeights = 0.0;
 
 		for (const Particle& ff : f.FluidNeighbors) {
-			sumWeightedPosition += ff.Position * ff.GetVolume() * GetKernel().ComputeValue(f, ff);
+			sumWeightedPosition += GetKernel().GetDistanceVector(ff.Position, f.Position) * ff.GetVolume() * GetKernel().ComputeValue(f, ff);
 			sumWeights += ff.GetVolume() * GetKernel().ComputeValue(f, ff);
 		}
 		for (const Particle& fb : f.StaticBorderNeighbors) {
-			sumWeightedPosition += fb.Position * fb.GetVolume() * GetKernel().ComputeValue(f, fb);
+			sumWeightedPosition += GetKernel().GetDistanceVector(fb.Position, f.Position) * fb.GetVolume() * GetKernel().ComputeValue(f, fb);
 			sumWeights += fb.GetVolume() * GetKernel().ComputeValue(f, fb);
 		}
 
@@ -138,14 +139,14 @@ Vector3D UMLSPressureGradient::ComputePressureGradient(Particle& f, int particle
 		Matrix3D pitchMatrix = Matrix3D::Zero;
 
 		for (const Particle& ff : f.FluidNeighbors) {
-			Vector3D r = ff.Position - weightedPosition;
+			Vector3D r = GetKernel().GetDistanceVector(ff.Position, f.Position) - weightedPosition;
 			alpha += (ff.Pressure * ff.GetVolume() * GetKernel().ComputeValue(f, ff)) / sumWeights;
 			sourceTerm += r * (ff.Pressure * ff.GetVolume() * GetKernel().ComputeValue(f, ff));
 			pitchMatrix += Matrix3D::OuterProduct(r, r) * ff.GetVolume() * GetKernel().ComputeValue(f, ff);
 		}
 
 		for (const Particle& fb : f.StaticBorderNeighbors) {
-			Vector3D r = fb.Position - weightedPosition;
+			Vector3D r = GetKernel().GetDistanceVector(fb.Position, f.Position) - weightedPosition;
 			alpha += (fb.Pressure * fb.GetVolume() * GetKernel().ComputeValue(f, fb)) / sumWeights;
 			sourceTerm += r * (fb.Pressure * fb.GetVolume() * GetKernel().ComputeValue(f, fb));
 			pitchMatrix += Matrix3D::OuterProduct(r, r) * fb.GetVolume() * GetKernel().ComputeValue(f, fb);
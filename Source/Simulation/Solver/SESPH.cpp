@@ -10,7 +10,8 @@ USESPHSolver::~USESPHSolver()
 USESPHSolver * USESPHSolver::CreateSESPHSolver(TArray<UAcceleration*> accelerations,
 	float fluidStiffness,
 	UBoundaryPressure * boundaryPressure,
-	UPressureGradient * pressureGradient)
+	UPressureGradient * pressureGradient,
+	UTimeIntegrator * timeIntegrator)
 {
 	USESPHSolver * sesphsolver = NewObject<USESPHSolver>();
 	sesphsolver->SolverType = ESolverMethod::SESPH;
@@ -20,6 +21,7 @@ USESPHSolver * USESPHSolver::CreateSESPHSolver(TArray<UAcceleration*> accelerati
 	sesphsolver->LastIterationCount = 1;
 	sesphsolver->BoundaryPressureComputer = boundaryPressure;
 	sesphsolver->PressureGradientComputer = pressureGradient;
+	sesphsolver->TimeIntegrator = timeIntegrator;
 
 
 	// prevent garbage collection
@@ -31,11 +33,35 @@ void USESPHSolver::Step()
 {
 	FDateTime startTime = FDateTime::UtcNow();
 
+	// Split particles at surfaces and merge them in the bulk before the fluid is solved
+	if (AdaptiveResolution != nullptr) {
+		AdaptResolution();
+	}
+
 	InitializePeriodicCondition();
 
 	// Find all neighbors using the specified neighborhood search method
 	FindNeighbors();
 
+	// Resting particles fall asleep, disturbed ones wake up
+	if (SleepingParticles) {
+		UpdateSleepingParticles();
+	}
+
+	// Reduce the fidelity outside of regions of interest
+	if (RegionsOfInterest.Num() > 0) {
+		ApplyRegionsOfInterest();
+	}
+
+	FDateTime integrationStartTime = FDateTime::UtcNow();
+	MaxTimeStep();
+
+	// Flag the particles which start a block in this step, only they and their neighbors need new densities
+	if (LocalTimeStepping) {
+		AssignTimestepLevels();
+	}
+	ComputationTimes.IntegrationTime = (FDateTime::UtcNow() - integrationStartTime).GetTotalSeconds();
+
 	// Calculate density errors
 	ComputeDensitiesExplicit();
 	ComputeAverageDensityError();
@@ -43,7 +69,6 @@ void USESPHSolver::Step()
 	// Computes pressure using a state equation
 	ComputePressure();
 
-
 	FDateTime accelerationStartTime = FDateTime::UtcNow();
 	ClearAcceleration();
 
@@ -56,18 +81,17 @@ void USESPHSolver::Step()
 
 	ComputationTimes.AccelerationComputationTime = (FDateTime::UtcNow() - accelerationStartTime).GetTotalSeconds();
 
-	FDateTime integrationStartTime = FDateTime::UtcNow();
-	MaxTimeStep();
+	integrationStartTime = FDateTime::UtcNow();
 
 	// Applies all behaviour defined by scripted volumes
 	ApplyScriptedVolumesBeforeIntegration();
 
-	IntegrateEulerCromer();
+	Integrate();
 
 	// Applies all behaviour defined by scripted volumes
 	ApplyScriptedVolumesAfterIntegration();
 
-	ComputationTimes.IntegrationTime = (FDateTime::UtcNow() - integrationStartTime).GetTotalSeconds();
+	ComputationTimes.IntegrationTime += (FDateTime::UtcNow() - integrationStartTime).GetTotalSeconds();
 
 	ComputationTimes.TotalTime = (FDateTime::UtcNow() - startTime).GetTotalSeconds();
 }
@@ -84,9 +108,18 @@ void USESPHSolver::ComputeSolverStatistics(bool computeSolverStats)
 			kineticEnergy += fluid->CalculateKineticEnergy();
 		}
 		OldKineticEnergies.push_back(kineticEnergy);
+
+		if (LocalTimeStepping) {
+			OldTimestepLevelPopulations.push_back(TimestepLevelPopulations);
+		}
 	}
 }
 
+bool USESPHSolver::SupportsLocalTimeStepping() const
+{
+	return true;
+}
+
 
 void USESPHSolver::ComputePressure()
 {
@@ -94,17 +127,15 @@ void USESPHSolver::ComputePressure()
 	for (UFluid * fluid : GetSimulator()->GetParticleContext()->GetFluids()) {
 		ParallelFor(fluid->Particles->size(), [fluid, this](int32 i) {
 			Particle& particle = fluid->Particles->at(i);
+			if (particle.IsSleeping || (LocalTimeStepping && !particle.RequiresDensity)) {
+				return;
+			}
 			particle.Pressure = FluidStiffness * std::max(pow(particle.Density / particle.Fluid->GetRestDensity(), 7) - 1, 0.0);
 		});
 	}
 
 	// boundary pressure
 	BoundaryPressureComputer->ComputeAllPressureValues(GetSimulator()->GetParticleContext(), GetKernel());
-
-	// In the special case of a periodic setting update pressure of ghost particles
-	if (GetParticleContext()->GetPeriodicCondition() != nullptr) {
-		GetParticleContext()->GetPeriodicCondition()->UpdateGhostParticlePressure();
-	}
 }
 
 void USESPHSolver::ApplyPressureAcceleration()
@@ -112,12 +143,19 @@ void USESPHSolver::ApplyPressureAcceleration()
 	for (UFluid * fluid : GetSimulator()->GetParticleContext()->GetFluids()) {
 		ParallelFor(fluid->Particles->size(), [fluid, this](int32 i) {
 			Particle& f = fluid->Particles->at(i);
-			f.Acceleration = -GetPressureGradient()->ComputePressureGradient(f, i) / f.Density;
-		});
-	}
 
-	if (GetParticleContext()->GetPeriodicCondition() != nullptr) {
-		GetParticleContext()->GetPeriodicCondition()->UpdateGhostParticleAcceleration();
+			if (!f.IsActiveInStep) {
+				return;
+			}
+
+			// the pressure acts in addition to the non-pressure accelerations
+			f.Acceleration -= GetPressureGradient()->ComputePressureGradient(f, i) / f.Density;
+
+			// with local time stepping the accelerations act for the whole block of the particle
+			if (LocalTimeStepping) {
+				f.Acceleration = static_cast<double>(1 << f.TimestepLevel) * f.Acceleration;
+			}
+		});
 	}
 }
 
@@ -141,12 +179,12 @@ double USESPHSolver::MaxTimeStep()
 		CurrentTimestep = Simulator->GetMaxTimestep();
 	}
 	else {
-		CurrentTimestep = FMath::Max(FMath::Min(Simulator->GetCFLNumber() * Simulator->GetParticleContext()->GetParticleDistance() / maxVelocity, Simulator->GetMaxTimestep()), Simulator->GetMinTimestep());
+		CurrentTimestep = FMath::Max(FMath::Min(GetCFLNumber() * Simulator->GetParticleContext()->GetParticleDistance() / maxVelocity, Simulator->GetMaxTimestep()), Simulator->GetMinTimestep());
 	}
 
 	// sometimes volumes need to restrict the timestep
 	for (AScriptedVolume * scriptedVolume : Volumes) {
-		std::min(CurrentTimestep, scriptedVolume->MaxTimeStep(Simulator->GetCFLNumber(), *Simulator->GetParticleContext()));
+		CurrentTimestep = std::min(CurrentTimestep, scriptedVolume->MaxTimeStep(GetCFLNumber(), *Simulator->GetParticleContext()));
 	}
 
 	// Check if CurrentTimestep needs to be smaller because of incoming new recording-frame
@@ -1,5 +1,7 @@
 #include "Solver.h"
 #include "Simulator.h"
+#include "TimeIntegrator/EulerCromerIntegrator.h"
+#include "Volumes/RegionOfInterestVolume.h"
 
 
 USolver::~USolver() {
@@ -16,10 +18,30 @@ void USolver::Build(ASimulator * simulator, TArray<AScriptedVolume*> volumes)
 	Simulator = simulator;
 	Volumes = volumes;
 
+	RegionsOfInterest.Empty();
+	for (AScriptedVolume * volume : Volumes) {
+		if (volume->GetVolumeType() == EVolumeType::RegionOfInterest) {
+			RegionsOfInterest.Add(Cast<ARegionOfInterestVolume>(volume));
+		}
+	}
+
 	for (UAcceleration * acceleration : Accelerations) {
 		acceleration->Build(this);
 	}
 
+	if (TimeIntegrator == nullptr) {
+		TimeIntegrator = UEulerCromerIntegrator::CreateEulerCromerIntegrator();
+	}
+
+	if (AdaptiveResolution != nullptr) {
+		AdaptiveResolution->Build(simulator->GetDimensionality());
+		for (ARegionOfInterestVolume * region : RegionsOfInterest) {
+			if (region->RefineInside) {
+				AdaptiveResolution->AddRegionOfInterest(region);
+			}
+		}
+	}
+
 	GetBoundaryPressure()->Build(simulator->GetDimensionality());
 	GetPressureGradient()->Build(this, simulator->GetDimensionality());
 }
@@ -36,7 +58,7 @@ double USolver::ComputeAverageDensityError()
 			return std::max(0.0, (particle.Density - particle.Fluid->GetRestDensity()));
 		}) / fluid->GetRestDensity();
 
-		totalParticles += fluid->Particles->size();
+		totalParticles += fluid->GetNumLiveParticles();
 	}
 
 	LastAverageDensityError = sum / totalParticles;
@@ -76,7 +98,15 @@ int USolver::GetLastIterationCount() const
 void USolver::FindNeighbors()
 {
 	FDateTime startTime = FDateTime::UtcNow();
+	// coarse particles of adaptive resolution have a larger support, fine particles keep their own
+	GetNeighborsFinder()->SetSearchRangeScale(AdaptiveResolution != nullptr ? AdaptiveResolution->GetMaxSmoothingScale() : 1.0);
 	GetNeighborsFinder()->FindNeighbors(*GetParticleContext(), Simulator->GetParticleContext()->GetParticleDistance(), GetBoundaryPressure()->GetRequiredNeighborhoods());
+
+	// volumes are rasterised into the same cells, so most particles are tested by a cell lookup
+	const double cellSize = GetNeighborsFinder()->GetCellSize(Simulator->GetParticleContext()->GetParticleDistance());
+	for (AScriptedVolume* volume : Volumes) {
+		volume->Rasterize(cellSize);
+	}
 	ComputationTimes.NeighborhoodSearchTime = (FDateTime::UtcNow() - startTime).GetTotalSeconds();
 
 	PressureGradientComputer->PrecomputeAllGeometryData(*GetParticleContext());
@@ -85,10 +115,256 @@ void USolver::FindNeighbors()
 
 void USolver::InitializePeriodicCondition()
 {
-	// In the special case of a periodic setting new particles are generated at necessary positions
+	// In the special case of a periodic setting particles leaving the domain enter it on the other side
 	if (GetParticleContext()->GetPeriodicCondition() != nullptr) {
 		GetParticleContext()->GetPeriodicCondition()->MoveOutOfBoundsParticles();
-		GetParticleContext()->GetPeriodicCondition()->UpdateGhostParticles();
+	}
+}
+
+void USolver::AdaptResolution()
+{
+	if (!AdaptiveResolution->ShouldAdaptInThisStep()) {
+		return;
+	}
+
+	// Surfaces and merge partners are detected on fresh neighborhoods
+	InitializePeriodicCondition();
+	FindNeighbors();
+
+	AdaptiveResolution->AdaptResolution(*GetParticleContext());
+}
+
+bool USolver::SupportsLocalTimeStepping() const
+{
+	return false;
+}
+
+void USolver::AssignTimestepLevels()
+{
+	const std::vector<UFluid*>& fluids = GetParticleContext()->GetFluids();
+	const double particleDistance = GetParticleContext()->GetParticleDistance();
+	const double cflNumber = GetCFLNumber();
+	const int step = LocalTimeSteppingStep++;
+
+	// desired levels are computed first, so the neighbor limitation always sees the levels of the last step
+	std::vector<std::vector<int>> desiredLevels(fluids.size());
+	for (int k = 0; k < fluids.size(); k++) {
+		desiredLevels[k].resize(fluids[k]->Particles->size());
+
+		ParallelFor(fluids[k]->Particles->size(), [&](int32 i) {
+			Particle& particle = fluids[k]->Particles->at(i);
+
+			int level = MaxTimestepLevel;
+			double velocity = particle.Velocity.Size();
+			if (velocity > 0) {
+				double ownTimestep = std::min(cflNumber * particleDistance / velocity, Simulator->GetMaxTimestep());
+				level = FMath::Clamp(FMath::FloorToInt(FMath::Log2(ownTimestep / CurrentTimestep)), 0, MaxTimestepLevel);
+			}
+
+			// neighbors differ by one level at most, so fast particles never interact with long outdated accelerations
+			for (const Particle& ff : particle.FluidNeighbors) {
+				level = std::min(level, ff.TimestepLevel + 1);
+			}
+
+			desiredLevels[k][i] = level;
+		});
+	}
+
+	for (int k = 0; k < fluids.size(); k++) {
+		ParallelFor(fluids[k]->Particles->size(), [&](int32 i) {
+			Particle& particle = fluids[k]->Particles->at(i);
+			int level = desiredLevels[k][i];
+
+			if (particle.IsSleeping) {
+				particle.IsActiveInStep = false;
+			}
+			// a level only ends at the end of its block, but a particle is allowed to switch to a shorter level at any time
+			else if (step % (1 << particle.TimestepLevel) == 0 || level < particle.TimestepLevel) {
+
+				// blocks have to be aligned to their length
+				while (level > 0 && step % (1 << level) != 0) {
+					level--;
+				}
+
+				particle.TimestepLevel = level;
+				particle.IsActiveInStep = true;
+			}
+			else {
+				particle.IsActiveInStep = false;
+			}
+		});
+	}
+
+	// a pair of particles interacts if one of them is active, both need their density and pressure then
+	for (int k = 0; k < fluids.size(); k++) {
+		ParallelFor(fluids[k]->Particles->size(), [&](int32 i) {
+			Particle& particle = fluids[k]->Particles->at(i);
+
+			bool requiresDensity = particle.IsActiveInStep;
+			for (const Particle& ff : particle.FluidNeighbors) {
+				if (requiresDensity) {
+					break;
+				}
+				requiresDensity = ff.IsActiveInStep;
+			}
+			particle.RequiresDensity = requiresDensity && !particle.IsSleeping;
+		});
+	}
+
+	TimestepLevelPopulations.assign(MaxTimestepLevel + 1, 0);
+	for (UFluid * fluid : fluids) {
+		for (const Particle& particle : *fluid->Particles) {
+			if (!particle.IsRemoved) {
+				TimestepLevelPopulations[particle.TimestepLevel]++;
+			}
+		}
+	}
+}
+
+void USolver::UpdateSleepingParticles()
+{
+	const std::vector<UFluid*>& fluids = GetParticleContext()->GetFluids();
+
+	// new states are decided first, so the decisions only depend on the states of the last step
+	std::vector<std::vector<char>> sleeping(fluids.size());
+	for (int k = 0; k < fluids.size(); k++) {
+		sleeping[k].resize(fluids[k]->Particles->size());
+
+		ParallelFor(fluids[k]->Particles->size(), [&](int32 i) {
+			Particle& particle = fluids[k]->Particles->at(i);
+
+			// scripted volumes disturb particles by scripting them or by changing their velocity
+			bool disturbed = particle.IsScripted || particle.Velocity.Size() > SleepVelocityThreshold;
+
+			if (particle.IsSleeping) {
+				for (const Particle& ff : particle.FluidNeighbors) {
+					if (disturbed) {
+						break;
+					}
+					disturbed = !ff.IsSleeping && ff.Velocity.Size() > SleepVelocityThreshold;
+				}
+
+				// only sleepers next to awake cells have neighborhoods, they wake up when they get compressed
+				if (!disturbed && !particle.FluidNeighbors.empty()) {
+					particle.Density = ComputeDensity(particle);
+					disturbed = particle.Density / particle.Fluid->GetRestDensity() - 1 > SleepDensityErrorThreshold;
+				}
+				sleeping[k][i] = !disturbed;
+			}
+			else {
+				bool resting = !disturbed && std::max(0.0, particle.Density / particle.Fluid->GetRestDensity() - 1) < SleepDensityErrorThreshold;
+				particle.RestingSteps = resting ? particle.RestingSteps + 1 : 0;
+				sleeping[k][i] = particle.RestingSteps >= RestingStepsUntilSleep;
+			}
+		});
+	}
+
+	std::atomic<bool> wokenWithoutNeighbors(false);
+	for (int k = 0; k < fluids.size(); k++) {
+		ParallelFor(fluids[k]->Particles->size(), [&](int32 i) {
+			Particle& particle = fluids[k]->Particles->at(i);
+
+			if (particle.IsSleeping && !sleeping[k][i] && particle.FluidNeighbors.empty()) {
+				wokenWithoutNeighbors = true;
+			}
+
+			if (static_cast<bool>(sleeping[k][i]) != particle.IsSleeping) {
+				// falling asleep freezes the particle, waking up starts without stale accelerations
+				if (sleeping[k][i]) {
+					particle.Velocity = Vector3D::Zero;
+				}
+				particle.Acceleration = Vector3D::Zero;
+				particle.LastTimestep = 0.0;
+				particle.RestingSteps = 0;
+				particle.IsSleeping = static_cast<bool>(sleeping[k][i]);
+			}
+
+			particle.IsActiveInStep = !particle.IsSleeping;
+		});
+	}
+
+	// particles inside of sleeping cells were skipped by the neighborhood search
+	if (wokenWithoutNeighbors) {
+		FindNeighbors();
+	}
+
+	SleepingParticleCount = 0;
+	for (UFluid * fluid : fluids) {
+		for (const Particle& particle : *fluid->Particles) {
+			SleepingParticleCount += particle.IsSleeping && !particle.IsRemoved ? 1 : 0;
+		}
+	}
+}
+
+void USolver::ApplyRegionsOfInterest()
+{
+	// the strictest of the enabled regions decides about the fidelity outside
+	bool anyEnabled = false;
+	bool freezeOutside = false;
+	double outsideToleranceFactor = DBL_MAX;
+	for (ARegionOfInterestVolume * region : RegionsOfInterest) {
+		if (region->GetEnabled()) {
+			anyEnabled = true;
+			freezeOutside = freezeOutside || region->FreezeOutside;
+			outsideToleranceFactor = std::min(outsideToleranceFactor, std::max(static_cast<double>(region->OutsideToleranceFactor), 1.0));
+		}
+	}
+
+	std::atomic<bool> wokenWithoutNeighbors(false);
+	for (UFluid * fluid : GetParticleContext()->GetFluids()) {
+		ParallelFor(fluid->Particles->size(), [&](int32 i) {
+			Particle& particle = fluid->Particles->at(i);
+
+			// removed particles sleep until their slot is reused
+			if (particle.IsRemoved) {
+				return;
+			}
+
+			bool inside = !anyEnabled;
+			for (ARegionOfInterestVolume * region : RegionsOfInterest) {
+				if (inside) {
+					break;
+				}
+				inside = region->GetEnabled() && region->IsParticleAffected(particle);
+			}
+
+			particle.ErrorToleranceFactor = inside ? 1.0 : outsideToleranceFactor;
+
+			if (freezeOutside && !inside && !particle.IsScripted) {
+				if (!particle.IsSleeping) {
+					particle.Velocity = Vector3D::Zero;
+					particle.Acceleration = Vector3D::Zero;
+					particle.LastTimestep = 0.0;
+					particle.RestingSteps = 0;
+					particle.IsSleeping = true;
+				}
+				particle.IsActiveInStep = false;
+			}
+			// without sleeping particles nothing else wakes up particles that entered the region
+			else if (particle.IsSleeping && !SleepingParticles) {
+				if (particle.FluidNeighbors.empty()) {
+					wokenWithoutNeighbors = true;
+				}
+				particle.Acceleration = Vector3D::Zero;
+				particle.LastTimestep = 0.0;
+				particle.IsSleeping = false;
+				particle.IsActiveInStep = true;
+			}
+		});
+	}
+
+	// particles inside of sleeping cells were skipped by the neighborhood search
+	if (wokenWithoutNeighbors) {
+		FindNeighbors();
+	}
+
+	if (freezeOutside || !SleepingParticles) {
+		SleepingParticleCount = 0;
+		for (UFluid * fluid : GetParticleContext()->GetFluids()) {
+			for (const Particle& particle : *fluid->Particles) {
+				SleepingParticleCount += particle.IsSleeping && !particle.IsRemoved ? 1 : 0;
+			}
+		}
 	}
 }
 
@@ -97,13 +373,10 @@ void USolver::ClearAcceleration()
 	for (UFluid* fluid : GetParticleContext()->GetFluids()) {
 		ParallelFor(fluid->Particles->size(), [&](int32 i) {
 			Particle& particle = fluid->Particles->at(i);
+
 			particle.Acceleration = Vector3D::Zero;
 		});
 	}
-
-	if (GetParticleContext()->GetPeriodicCondition() != nullptr) {
-		GetParticleContext()->GetPeriodicCondition()->UpdateGhostParticleAcceleration();
-	}
 }
 
 void USolver::ComputeDensitiesExplicit() {
@@ -111,46 +384,59 @@ void USolver::ComputeDensitiesExplicit() {
 		ParallelFor(fluid->Particles->size(), [&](int32 i) {
 			Particle& f = fluid->Particles->at(i);
 
-			f.Density = 0;
-			double fluidDensitySum = 0;
-			double staticDensitySum = 0;
-
-			for (const Particle& ff : f.FluidNeighbors) {
-				fluidDensitySum += ff.Mass  * GetKernel()->ComputeValue(f, ff);
+			// sleeping particles keep their density, with local time stepping only the particles of active pairs need a new one
+			if (f.IsSleeping || (LocalTimeStepping && !f.RequiresDensity)) {
+				return;
 			}
 
-			for (const Particle& fb : f.StaticBorderNeighbors) {
-				staticDensitySum += fb.Border->BorderDensityFactor * fb.Mass * GetKernel()->ComputeValue(f, fb);
-			}
-
-			// sum the contributions of neighbors
-			f.Density = fluidDensitySum + staticDensitySum;
+			f.Density = ComputeDensity(f);
 		});
 	}
+}
 
-	if (GetParticleContext()->GetPeriodicCondition() != nullptr) {
-		GetParticleContext()->GetPeriodicCondition()->UpdateGhostParticleDensity();
+double USolver::ComputeDensity(const Particle& f) const
+{
+	double fluidDensitySum = 0;
+	double staticDensitySum = 0;
+
+	for (const Particle& ff : f.FluidNeighbors) {
+		fluidDensitySum += ff.Mass  * GetKernel()->ComputeValue(f, ff);
+	}
+
+	for (const Particle& fb : f.StaticBorderNeighbors) {
+		staticDensitySum += fb.Border->BorderDensityFactor * fb.Mass * GetKernel()->ComputeValue(f, fb);
 	}
+
+	// sum the contributions of neighbors
+	return fluidDensitySum + staticDensitySum;
 }
 
-void USolver::IntegrateEulerCromer()
+void USolver::Integrate()
 {
 	for (UFluid* fluid : GetParticleContext()->GetFluids()) {
 		ParallelFor(fluid->Particles->size(), [&](int32 i) {
 			Particle& particle = fluid->Particles->at(i);
 
-			if (!particle.IsScripted) {
+			if (particle.IsSleeping) {
+				return;
+			}
+
+			if (!particle.IsScripted && LocalTimeStepping) {
+				// the acceleration already holds the velocity change of the blocks starting in this step, all particles drift every step so they stay at the same time
 				particle.Velocity += particle.Acceleration * CurrentTimestep;
 				particle.Position += particle.Velocity * CurrentTimestep;
+				particle.LastTimestep = 0.0;
+			}
+			else if (!particle.IsScripted) {
+				TimeIntegrator->IntegrateParticle(particle, particle.Acceleration, CurrentTimestep);
+			}
+			else {
+				// scripted motion invalidates the integration history
+				particle.LastTimestep = 0.0;
 			}
 
 		});
 	}
-
-	// In the special case of a periodic setting update positions
-	if (GetParticleContext()->GetPeriodicCondition() != nullptr) {
-		GetParticleContext()->GetPeriodicCondition()->UpdateGhostParticleAttributes(true);
-	}
 }
 
 void USolver::ApplyScriptedVolumesBeforeIntegration()
@@ -163,33 +449,91 @@ void USolver::ApplyScriptedVolumesBeforeIntegration()
 		});
 	}
 
-
 	// Apply the effects of the volumes
 	FDateTime ScriptedVolumeStartTime = FDateTime::UtcNow();
-	for (AScriptedVolume * volume : Volumes) {
-		volume->ApplyBeforeIntegration(*GetParticleContext(), GetCurrentTimestep(), GetSimulator()->GetSimulatedTime());
+	ComputationTimes.ScriptedVolumeTimes.Init(0.0f, Volumes.Num());
+
+	// consecutive volumes affecting single particles are applied in one pass over the particles. Volumes are applied block wise,
+	// so each block of particles stays in cache while all volumes are evaluated and the time per volume can be measured
+	const int blockSize = 1024;
+	const double timestep = GetCurrentTimestep();
+	const double simulationTime = GetSimulator()->GetSimulatedTime();
+	TArray<int> particleVolumes;
+	auto applyParticleVolumes = [&]() {
+		if (particleVolumes.Num() == 0) {
+			return;
+		}
+
+		for (UFluid* fluid : GetParticleContext()->GetFluids()) {
+			const int numParticles = fluid->Particles->size();
+			const int numBlocks = (numParticles + blockSize - 1) / blockSize;
+			std::vector<uint64> blockCycles(numBlocks * particleVolumes.Num(), 0);
+
+			ParallelFor(numBlocks, [&](int32 block) {
+				const int first = block * blockSize;
+				const int last = std::min(first + blockSize, numParticles);
+
+				for (int v = 0; v < particleVolumes.Num(); v++) {
+					AScriptedVolume * volume = Volumes[particleVolumes[v]];
+					const uint64 volumeStartCycles = FPlatformTime::Cycles64();
+
+					for (int i = first; i < last; i++) {
+						Particle& particle = fluid->Particles->at(i);
+						if (volume->IsParticleAffected(particle)) {
+							volume->ApplyToParticle(particle, timestep, simulationTime);
+						}
+					}
+					blockCycles[block * particleVolumes.Num() + v] = FPlatformTime::Cycles64() - volumeStartCycles;
+				}
+			});
+
+			// cost counters are summed over all blocks, so they add up to the thread time of each volume
+			for (int block = 0; block < numBlocks; block++) {
+				for (int v = 0; v < particleVolumes.Num(); v++) {
+					ComputationTimes.ScriptedVolumeTimes[particleVolumes[v]] += FPlatformTime::ToSeconds64(blockCycles[block * particleVolumes.Num() + v]);
+				}
+			}
+		}
+		particleVolumes.Empty();
+	};
+
+	// volumes with their own pass are applied in the order of the volumes, between the passes of the volumes before and after them
+	for (int v = 0; v < Volumes.Num(); v++) {
+		AScriptedVolume * volume = Volumes[v];
+		if (volume->GetAffectsParticles()) {
+			if (volume->GetEnabled()) {
+				particleVolumes.Add(v);
+			}
+		}
+		else {
+			applyParticleVolumes();
+
+			FDateTime volumeStartTime = FDateTime::UtcNow();
+			volume->ApplyBeforeIntegration(*GetParticleContext(), GetCurrentTimestep(), GetSimulator()->GetSimulatedTime());
+			ComputationTimes.ScriptedVolumeTimes[v] += (FDateTime::UtcNow() - volumeStartTime).GetTotalSeconds();
+		}
 	}
-	ComputationTimes.ScriptedTime = (FDateTime::UtcNow() - ScriptedVolumeStartTime).GetTotalSeconds();
+	applyParticleVolumes();
 
-	// In the special case of a periodic setting new particles are generated at necessary positions
-	if (GetParticleContext()->GetPeriodicCondition() != nullptr) {
-		GetParticleContext()->GetPeriodicCondition()->UpdateGhostParticleAttributes(true);
-	}
+	ComputationTimes.ScriptedTime = (FDateTime::UtcNow() - ScriptedVolumeStartTime).GetTotalSeconds();
 }
 
 void USolver::ApplyScriptedVolumesAfterIntegration()
 {
 	// Apply the effects of the volumes
 	FDateTime ScriptedVolumeStartTime = FDateTime::UtcNow();
-	for (AScriptedVolume * volume : Volumes) {
-		volume->ApplyAfterIntegration(*GetParticleContext(), GetCurrentTimestep(), GetSimulator()->GetSimulatedTime());
+	ComputationTimes.ScriptedVolumeTimes.SetNumZeroed(Volumes.Num());
+	for (int v = 0; v < Volumes.Num(); v++) {
+		FDateTime volumeStartTime = FDateTime::UtcNow();
+		Volumes[v]->ApplyAfterIntegration(*GetParticleContext(), GetCurrentTimestep(), GetSimulator()->GetSimulatedTime());
+		ComputationTimes.ScriptedVolumeTimes[v] += (FDateTime::UtcNow() - volumeStartTime).GetTotalSeconds();
 	}
-	ComputationTimes.ScriptedTime += (FDateTime::UtcNow() - ScriptedVolumeStartTime).GetTotalSeconds();
 
-	// In the special case of a periodic setting new particles are generated at necessary positions
-	if (GetParticleContext()->GetPeriodicCondition() != nullptr) {
-		GetParticleContext()->GetPeriodicCondition()->UpdateGhostParticleAttributes(true);
+	// removed particles are erased once they take up too many slots, sources refill the rest of them
+	for (UFluid * fluid : GetParticleContext()->GetFluids()) {
+		fluid->CompactParticles();
 	}
+	ComputationTimes.ScriptedTime += (FDateTime::UtcNow() - ScriptedVolumeStartTime).GetTotalSeconds();
 }
 
 ASimulator * USolver::GetSimulator() const
@@ -232,6 +576,29 @@ UPressureGradient * USolver::GetPressureGradient() const
 	return PressureGradientComputer;
 }
 
+UTimeIntegrator * USolver::GetTimeIntegrator() const
+{
+	return TimeIntegrator;
+}
+
+float USolver::GetCFLNumber() const
+{
+	const float recommendedCFLNumber = TimeIntegrator->GetRecommendedCFLNumber();
+	if (Simulator->GetCFLNumber() <= 0.0) {
+		return recommendedCFLNumber;
+	}
+
+	// larger CFL numbers are not stable with the integration scheme
+	if (Simulator->GetCFLNumber() > recommendedCFLNumber) {
+		if (ClampedCFLNumber != Simulator->GetCFLNumber()) {
+			UE_LOG(LogTemp, Warning, TEXT("The CFL number %f is clamped to %f, the largest one the time integrator is stable with."), Simulator->GetCFLNumber(), recommendedCFLNumber);
+			ClampedCFLNumber = Simulator->GetCFLNumber();
+		}
+		return recommendedCFLNumber;
+	}
+	return Simulator->GetCFLNumber();
+}
+
 TArray<UAcceleration*> USolver::GetAccelerations() const
 {
 	return Accelerations;
@@ -242,3 +609,98 @@ TArray<AScriptedVolume*> USolver::GetScriptedVolumes() const
 	return Volumes;
 }
 
+void USolver::SetLocalTimeStepping(bool enabled, int maxTimestepLevel)
+{
+	if (enabled && !SupportsLocalTimeStepping()) {
+		UE_LOG(LogTemp, Warning, TEXT("Local time stepping is only supported by solvers with explicit pressure computation, it stays disabled."));
+		return;
+	}
+
+	LocalTimeStepping = enabled;
+	MaxTimestepLevel = std::max(maxTimestepLevel, 0);
+	LocalTimeSteppingStep = 0;
+	TimestepLevelPopulations.clear();
+
+	// all particles restart on the shortest level and are active in the next step, removed particles stay inactive
+	if (Simulator != nullptr) {
+		for (UFluid* fluid : GetParticleContext()->GetFluids()) {
+			ParallelFor(fluid->Particles->size(), [&](int32 i) {
+				Particle& particle = fluid->Particles->at(i);
+				particle.TimestepLevel = 0;
+				if (particle.IsRemoved) {
+					return;
+				}
+				particle.IsActiveInStep = true;
+				particle.RequiresDensity = true;
+			});
+		}
+	}
+}
+
+void USolver::SetSleepingParticles(bool enabled, float velocityThreshold, float densityErrorThreshold, int restingStepsUntilSleep)
+{
+	SleepingParticles = enabled;
+	SleepVelocityThreshold = velocityThreshold;
+	SleepDensityErrorThreshold = densityErrorThreshold;
+	RestingStepsUntilSleep = std::max(restingStepsUntilSleep, 1);
+	SleepingParticleCount = 0;
+
+	// all particles start awake, removed particles sleep until their slot is reused
+	if (Simulator != nullptr) {
+		for (UFluid* fluid : GetParticleContext()->GetFluids()) {
+			ParallelFor(fluid->Particles->size(), [&](int32 i) {
+				Particle& particle = fluid->Particles->at(i);
+				if (particle.IsRemoved) {
+					return;
+				}
+				particle.IsSleeping = false;
+				particle.RestingSteps = 0;
+				particle.IsActiveInStep = true;
+			});
+		}
+	}
+}
+
+void USolver::SetAdaptiveResolution(UAdaptiveResolution * adaptiveResolution)
+{
+	AdaptiveResolution = adaptiveResolution;
+
+	if (AdaptiveResolution != nullptr && Simulator != nullptr) {
+		AdaptiveResolution->Build(Simulator->GetDimensionality());
+		for (ARegionOfInterestVolume * region : RegionsOfInterest) {
+			if (region->RefineInside) {
+				AdaptiveResolution->AddRegionOfInterest(region);
+			}
+		}
+	}
+}
+
+UAdaptiveResolution * USolver::GetAdaptiveResolution() const
+{
+	return AdaptiveResolution;
+}
+
+bool USolver::IsSleepingParticlesEnabled() const
+{
+	return SleepingParticles;
+}
+
+int USolver::GetSleepingParticleCount() const
+{
+	return SleepingParticleCount;
+}
+
+bool USolver::IsLocalTimeSteppingEnabled() const
+{
+	return LocalTimeStepping;
+}
+
+TArray<int> USolver::GetTimestepLevelPopulations() const
+{
+	TArray<int> populations;
+	for (int population : TimestepLevelPopulations) {
+		populations.Add(population);
+	}
+	return populations;
+}
+
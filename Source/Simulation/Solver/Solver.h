@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vector>
+#include <atomic>
 
 #include "CoreMinimal.h"
 
@@ -9,6 +10,8 @@
 #include "Accelerations/Acceleration.h"
 #include "BoundaryPressure/BoundaryPressure.h"
 #include "PressureGradient/PressureGradient.h"
+#include "TimeIntegrator/TimeIntegrator.h"
+#include "AdaptiveResolution/AdaptiveResolution.h"
 #include "ParticleContext/SceneComponents/Fluid.h"
 #include "Kernels/Kernel.h"
 #include "NeighborsFinders/NeighborsFinder.h"
@@ -19,6 +22,7 @@
 #include "Solver.generated.h"
 
 class ASimulator;
+class ARegionOfInterestVolume;
 
 UENUM(BlueprintType)
 enum ESolverMethod {
@@ -54,6 +58,10 @@ struct FComputationTimesPerStep {
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Struct")
 		float ScriptedTime;
 
+	// Time spent in each scripted volume, in the order of the solvers volumes
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Struct")
+		TArray<float> ScriptedVolumeTimes;
+
 	FComputationTimesPerStep(float totalTime, float neighborhoodSearchTime, float densityComputationTime, float pressureComputationTime, float accelerationComputationTime, float integrationTime, float scriptedTime) :
 		TotalTime(totalTime),
 		NeighborhoodSearchTime(neighborhoodSearchTime),
@@ -126,11 +134,49 @@ public:
 	UBoundaryPressure * GetBoundaryPressure() const;
 	UPressureGradient * GetPressureGradient() const;
 
+	UFUNCTION(BlueprintPure)
+	UTimeIntegrator * GetTimeIntegrator() const;
+
+	// CFL number of the simulator, at most the recommendation of the time integrator. Non-positive simulator CFL numbers take the recommendation
+	UFUNCTION(BlueprintPure)
+	float GetCFLNumber() const;
+
 	UFUNCTION(BlueprintPure)
 	TArray<UAcceleration*> GetAccelerations() const;
 
 	UFUNCTION(BlueprintPure)
 	TArray<AScriptedVolume*> GetScriptedVolumes() const;
+
+	// Enables local time stepping. Particles are binned into power-of-two timestep levels by their own CFL condition and are only kicked at the start of each block of their level. The accelerations are the same as without local time stepping and the particles are integrated with Euler-Cromer
+	UFUNCTION(BlueprintCallable)
+	void SetLocalTimeStepping(bool enabled, int maxTimestepLevel = 3);
+
+	UFUNCTION(BlueprintPure)
+	bool IsLocalTimeSteppingEnabled() const;
+
+	// Number of particles in each timestep level during the last step
+	UFUNCTION(BlueprintPure)
+	TArray<int> GetTimestepLevelPopulations() const;
+
+	std::vector<std::vector<int>> OldTimestepLevelPopulations;
+
+	// Enables detection of resting particles. Particles below both thresholds for the given number of steps fall asleep, freeze and are skipped by the solver until they are disturbed
+	UFUNCTION(BlueprintCallable)
+	void SetSleepingParticles(bool enabled, float velocityThreshold = 0.01, float densityErrorThreshold = 0.01, int restingStepsUntilSleep = 20);
+
+	UFUNCTION(BlueprintPure)
+	bool IsSleepingParticlesEnabled() const;
+
+	// Number of sleeping fluid particles after the last step
+	UFUNCTION(BlueprintPure)
+	int GetSleepingParticleCount() const;
+
+	// Enables adaptive resolution. Passing nullptr runs the whole domain at the particle distance of the context again
+	UFUNCTION(BlueprintCallable)
+	void SetAdaptiveResolution(UAdaptiveResolution * adaptiveResolution);
+
+	UFUNCTION(BlueprintPure)
+	UAdaptiveResolution * GetAdaptiveResolution() const;
 protected:
 
 	ESolverMethod SolverType;
@@ -141,16 +187,34 @@ protected:
 	// Initialize periodic condition
 	void InitializePeriodicCondition();
 
+	// Only solvers which compute all accelerations explicitly can apply them for several steps
+	virtual bool SupportsLocalTimeStepping() const;
+
+	// Assigns timestep levels and flags the particles which start a block in this step and the ones which need their density for it
+	void AssignTimestepLevels();
+
+	// Puts resting particles to sleep and wakes sleeping particles which are disturbed by active neighbors, compression or scripted volumes
+	void UpdateSleepingParticles();
+
+	// Splits and merges particles at the start of a step, the neighborhoods of the step are searched afterwards
+	void AdaptResolution();
+
+	// Loosens the error tolerances and optionally freezes particles outside of all regions of interest
+	void ApplyRegionsOfInterest();
+
 	// Reset Accelerations to zero
 	void ClearAcceleration();
 
 	// Computes the density at each particle using positions and current neighborhoods
 	void ComputeDensitiesExplicit();
 
-	// Applies current acceleration to velocity and performs a position update with the new velocity
-	void IntegrateEulerCromer();
+	// Density of a single particle from its current neighborhoods
+	double ComputeDensity(const Particle& f) const;
+
+	// Advances velocities and positions with the current acceleration using the selected time integrator
+	void Integrate();
 
-	// Applies the effect of all scripted volumes
+	// Applies the effect of all scripted volumes in their order. Consecutive volumes affecting single particles are applied in one pass over the particles
 	void ApplyScriptedVolumesBeforeIntegration();
 
 	// Appllies effects of volumes like spawning or deleting particles
@@ -166,14 +230,38 @@ protected:
 
 	UPressureGradient * PressureGradientComputer;
 
+	UTimeIntegrator * TimeIntegrator;
+
+	// CFL number of the simulator the last clamping was reported for
+	mutable float ClampedCFLNumber = 0.0f;
+
+	UAdaptiveResolution * AdaptiveResolution = nullptr;
+
 	bool FixedNextTimestep = false;
 
 	TArray<UAcceleration*> Accelerations;
 	TArray<AScriptedVolume*> Volumes;
 
+	// Regions of interest among the scripted volumes
+	TArray<ARegionOfInterestVolume*> RegionsOfInterest;
+
 	// stores the last computed density error for one simulation step so multiple uses don't need to recalculate it
 	double LastAverageDensityError;
 
 	// stores the last iteration count of the solver. Always 1 for SESPH
 	int LastIterationCount;
+
+	bool LocalTimeStepping = false;
+	int MaxTimestepLevel = 0;
+
+	// counts the steps since local time stepping was enabled, levels only change at steps aligned to their length
+	int LocalTimeSteppingStep = 0;
+
+	std::vector<int> TimestepLevelPopulations;
+
+	bool SleepingParticles = false;
+	double SleepVelocityThreshold = 0.01;
+	double SleepDensityErrorThreshold = 0.01;
+	int RestingStepsUntilSleep = 20;
+	int SleepingParticleCount = 0;
 };
\ No newline at end of file
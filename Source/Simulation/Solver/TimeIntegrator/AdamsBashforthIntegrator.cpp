@@ -0,0 +1,35 @@
+#include "AdamsBashforthIntegrator.h"
+
+void UAdamsBashforthIntegrator::IntegrateParticle(Particle & particle, const Vector3D & acceleration, double timestep) const
+{
+	Vector3D oldVelocity = particle.Velocity;
+
+	// two-step Adams-Bashforth, falls back to an euler step without acceleration history
+	if (particle.LastTimestep > 0.0) {
+		particle.Velocity += timestep * (acceleration + timestep / (2.0 * particle.LastTimestep) * (acceleration - particle.LastAcceleration));
+	}
+	else {
+		particle.Velocity += timestep * acceleration;
+	}
+
+	// trapezoidal rule of old and new velocity
+	particle.Position += 0.5 * timestep * (oldVelocity + particle.Velocity);
+
+	particle.LastAcceleration = acceleration;
+	particle.LastTimestep = timestep;
+}
+
+float UAdamsBashforthIntegrator::GetRecommendedCFLNumber() const
+{
+	return 0.5f;
+}
+
+UAdamsBashforthIntegrator * UAdamsBashforthIntegrator::CreateAdamsBashforthIntegrator()
+{
+	UAdamsBashforthIntegrator * adamsBashforth = NewObject<UAdamsBashforthIntegrator>();
+	adamsBashforth->IntegratorType = ETimeIntegrator::AdamsBashforth;
+
+	// prevent garbage collection
+	adamsBashforth->AddToRoot();
+	return adamsBashforth;
+}
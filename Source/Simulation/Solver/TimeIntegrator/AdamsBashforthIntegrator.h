@@ -0,0 +1,23 @@
+#pragma once
+
+#include "TimeIntegrator.h"
+#include "CoreMinimal.h"
+
+#include "AdamsBashforthIntegrator.generated.h"
+
+// Second order scheme with one acceleration evaluation per step.
+// The velocity is extrapolated with a variable step two-step Adams-Bashforth rule of the accelerations,
+// the position is advanced with the trapezoidal rule of old and new velocity. There is no corrector evaluation.
+UCLASS()
+class UAdamsBashforthIntegrator : public UTimeIntegrator {
+	GENERATED_BODY()
+
+public:
+
+	void IntegrateParticle(Particle& particle, const Vector3D& acceleration, double timestep) const override;
+
+	float GetRecommendedCFLNumber() const override;
+
+	UFUNCTION(BlueprintPure, Category = "Integrator")
+	static UAdamsBashforthIntegrator * CreateAdamsBashforthIntegrator();
+};
@@ -0,0 +1,25 @@
+#include "EulerCromerIntegrator.h"
+
+void UEulerCromerIntegrator::IntegrateParticle(Particle & particle, const Vector3D & acceleration, double timestep) const
+{
+	particle.Velocity += acceleration * timestep;
+	particle.Position += particle.Velocity * timestep;
+
+	particle.LastAcceleration = acceleration;
+	particle.LastTimestep = timestep;
+}
+
+float UEulerCromerIntegrator::GetRecommendedCFLNumber() const
+{
+	return 0.4f;
+}
+
+UEulerCromerIntegrator * UEulerCromerIntegrator::CreateEulerCromerIntegrator()
+{
+	UEulerCromerIntegrator * eulerCromer = NewObject<UEulerCromerIntegrator>();
+	eulerCromer->IntegratorType = ETimeIntegrator::EulerCromer;
+
+	// prevent garbage collection
+	eulerCromer->AddToRoot();
+	return eulerCromer;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "TimeIntegrator.h"
+#include "CoreMinimal.h"
+
+#include "EulerCromerIntegrator.generated.h"
+
+// Semi-implicit Euler: the velocity is updated first and the new velocity moves the particle. First order, but symplectic
+UCLASS()
+class UEulerCromerIntegrator : public UTimeIntegrator {
+	GENERATED_BODY()
+
+public:
+
+	void IntegrateParticle(Particle& particle, const Vector3D& acceleration, double timestep) const override;
+
+	float GetRecommendedCFLNumber() const override;
+
+	UFUNCTION(BlueprintPure, Category = "Integrator")
+	static UEulerCromerIntegrator * CreateEulerCromerIntegrator();
+};
@@ -0,0 +1,16 @@
+#include "TimeIntegrator.h"
+
+void UTimeIntegrator::IntegrateParticle(Particle & particle, const Vector3D & acceleration, double timestep) const
+{
+	throw("This is an abstract base class. This should never be called!");
+}
+
+float UTimeIntegrator::GetRecommendedCFLNumber() const
+{
+	throw("This is an abstract base class. This should never be called!");
+}
+
+ETimeIntegrator UTimeIntegrator::GetIntegratorType() const
+{
+	return IntegratorType;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Particles/Particle.h"
+#include "CoreMinimal.h"
+
+#include "TimeIntegrator.generated.h"
+
+UENUM(BlueprintType)
+enum ETimeIntegrator {
+	EulerCromer,
+	VelocityVerlet,
+	AdamsBashforth
+};
+
+// Interface for all time integration schemes. Solvers hand over the total acceleration of a particle and the integrator advances velocity and position
+UCLASS(BlueprintType)
+class UTimeIntegrator : public UObject {
+	GENERATED_BODY()
+
+public:
+
+	// Advances velocity and position of the particle by one timestep under the given total acceleration
+	virtual void IntegrateParticle(Particle& particle, const Vector3D& acceleration, double timestep) const;
+
+	// Largest CFL number the integration scheme is recommended to run with
+	UFUNCTION(BlueprintPure, Category = "Integrator")
+	virtual float GetRecommendedCFLNumber() const;
+
+	UFUNCTION(BlueprintPure, Category = "Integrator")
+	ETimeIntegrator GetIntegratorType() const;
+
+protected:
+
+	ETimeIntegrator IntegratorType;
+};
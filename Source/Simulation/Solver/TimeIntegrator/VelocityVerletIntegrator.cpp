@@ -0,0 +1,32 @@
+#include "VelocityVerletIntegrator.h"
+
+void UVelocityVerletIntegrator::IntegrateParticle(Particle & particle, const Vector3D & acceleration, double timestep) const
+{
+	// finish the closing half kick of the last step with the acceleration at the current position
+	if (particle.LastTimestep > 0.0) {
+		particle.Velocity += 0.5 * particle.LastTimestep * (acceleration - particle.LastAcceleration);
+	}
+
+	// kick, drift and a predicted closing kick, which gets corrected in the next step
+	particle.Velocity += 0.5 * timestep * acceleration;
+	particle.Position += particle.Velocity * timestep;
+	particle.Velocity += 0.5 * timestep * acceleration;
+
+	particle.LastAcceleration = acceleration;
+	particle.LastTimestep = timestep;
+}
+
+float UVelocityVerletIntegrator::GetRecommendedCFLNumber() const
+{
+	return 0.6f;
+}
+
+UVelocityVerletIntegrator * UVelocityVerletIntegrator::CreateVelocityVerletIntegrator()
+{
+	UVelocityVerletIntegrator * velocityVerlet = NewObject<UVelocityVerletIntegrator>();
+	velocityVerlet->IntegratorType = ETimeIntegrator::VelocityVerlet;
+
+	// prevent garbage collection
+	velocityVerlet->AddToRoot();
+	return velocityVerlet;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "TimeIntegrator.h"
+#include "CoreMinimal.h"
+
+#include "VelocityVerletIntegrator.generated.h"
+
+// Velocity Verlet (kick-drift-kick leapfrog). Second order and symplectic.
+// Solvers evaluate accelerations only once per step, so the closing half kick of a step is corrected
+// with the acceleration of the following step as soon as it is known.
+UCLASS()
+class UVelocityVerletIntegrator : public UTimeIntegrator {
+	GENERATED_BODY()
+
+public:
+
+	void IntegrateParticle(Particle& particle, const Vector3D& acceleration, double timestep) const override;
+
+	float GetRecommendedCFLNumber() const override;
+
+	UFUNCTION(BlueprintPure, Category = "Integrator")
+	static UVelocityVerletIntegrator * CreateVelocityVerletIntegrator();
+};
@@ -1,6 +1,13 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "ParticleCloudActor.h"
+
+#include <unordered_map>
+
+#include "Async/TaskGraphInterfaces.h"
+#include "GameFramework/PlayerController.h"
+#include "Camera/PlayerCameraManager.h"
+
 #include "ParticleContext/ParticleContext.h"
 #include "Simulator.h"
 
@@ -11,6 +18,7 @@ AParticleCloudActor::AParticleCloudActor() {
 	PointCloud->SectionSize = FVector(100000, 100000, 100000);
 	PointCloud->MinimumSectionPointCount = 0;
 	PointCloud->bUseLowPrecision = false;
+	PointCloud->bDynamicVertexBuffer = true;
 	PointCloud->DensityReductionDistance = 0;
 	PointCloud->NoiseReductionDensity = 0;
 	PointCloud->NoiseReductionDistance = 0;
@@ -36,6 +44,17 @@ AParticleCloudActor::AParticleCloudActor() {
 	SetCastDynamicShadow(true);
 	SetPointCloud(PointCloud);
 
+	// only ticks while the surface render mode is used
+	SurfaceComponent = CreateDefaultSubobject<UPointCloudSurfaceComponent>(TEXT("Surface"));
+	SurfaceComponent->SetupAttachment(RootComponent);
+	SurfaceComponent->PrimaryComponentTick.bStartWithTickEnabled = false;
+
+	// composites the surface into the whole view, only enabled while the surface is shown
+	SurfacePostProcess = CreateDefaultSubobject<UPostProcessComponent>(TEXT("SurfacePostProcess"));
+	SurfacePostProcess->SetupAttachment(RootComponent);
+	SurfacePostProcess->bUnbound = true;
+	SurfacePostProcess->bEnabled = false;
+
 	UpdatePointCloud();
 
 }
@@ -47,261 +66,479 @@ void AParticleCloudActor::Build(UParticleContext * particleContext, FVisualisati
 }
 
 void AParticleCloudActor::UpdatePointCloud() {
-	
+	FDateTime uploadStartTime = FDateTime::UtcNow();
+
 	PointCloud->ApplyRenderingParameters();
-	GetPointCloud()->SetPointCloudData(Points);
-	GetPointCloud()->Rebuild(true);
-}
 
+	// only uploads the new locations and colors if the number of points did not change, rebuilds the whole cloud otherwise
+	if (Scalars.Num() > 0 && Scalars.Num() == Points.Num()) {
+		GetPointCloud()->UpdatePointCloudData(Points, Scalars);
+	}
+	else {
+		GetPointCloud()->UpdatePointCloudData(Points);
+	}
 
+	LastUploadTime = (FDateTime::UtcNow() - uploadStartTime).GetTotalSeconds();
+}
 
-template <typename ParticleType>
-void AParticleCloudActor::VisualiseParticles(const std::vector<ParticleType>& particles, double size, EColorVisualisation colorMethod, double restDensity)
-{
-	Points.Empty();
-	Points.Reserve(particles.size());
-	PointCloud->SpriteSize = FVector2D(size * 10, size * 10);
+namespace {
+	const FLinearColor FluidColor(0.f, 1.f, 0.9f);
+	const FLinearColor StaticBorderColor(1.f, 0.4f, 0.f);
+	const FLinearColor GhostColor(1.f, 0.4f, 1.f);
 
-	switch (colorMethod) {
+	// white for 0, red for 1
+	FORCEINLINE FLinearColor RedRamp(float percentage) {
+		return FLinearColor(1.f, 1.f - percentage, 1.f - percentage);
+	}
 
-	case EColorVisualisation::Normal:
-		for (const ParticleType& particle : particles) {
+	// unreal uses a left handed coordinate system in centimeters
+	FORCEINLINE FVector ToUnrealLocation(const Vector3D& position) {
+		return FVector(static_cast<float>(-position.X) * 10, static_cast<float>(position.Y) * 10, static_cast<float>(position.Z) * 10);
+	}
 
-			Points.Emplace(static_cast<float>(-particle.Position.X) * 10, static_cast<float>(particle.Position.Y) * 10, static_cast<float>(particle.Position.Z) * 10, 0.f, 1.f, 0.9f);
-		}
-		break;
-	case EColorVisualisation::Density:
-	{
-		double maxDensity = particles.size() > 0 ? ParallelMax<ParticleType, double>(particles, [](const ParticleType& particle) { return particle.Density; }) : 0.0;
+	// Sum over the far particles of one cell
+	struct FCellAggregate {
+		Vector3D Position = Vector3D(0.0);
+		FLinearColor Color = FLinearColor(0.f, 0.f, 0.f, 0.f);
+		// components without a value sum up to minus infinity and stay without a value
+		FVector4 Scalars = FVector4(0.f, 0.f, 0.f, 0.f);
+		int Count = 0;
+		// lowest index of the particles in the cell, its point shows the cell
+		int FirstParticle = 0;
+	};
 
-		double range = maxDensity - restDensity;
+	// scalars of points which are not colored by the ramp, like ghosts
+	const FVector4 NoScalars(PC_NO_SCALAR, PC_NO_SCALAR, PC_NO_SCALAR, PC_NO_SCALAR);
 
-		// if range is zero all particles have the same density and are all colored blue
-		if (range == 0) {
-			for (const ParticleType& particle : particles) {
-				Points.Emplace(static_cast<float>(-particle.Position.X) * 10, static_cast<float>(particle.Position.Y) * 10, static_cast<float>(particle.Position.Z) * 10, 0.f, 1.f, 0.9f);
+	// Grows the limits by the components of the scalars which have a value
+	FORCEINLINE void ExpandScalarLimits(const FVector4& scalars, FVector4& scalarMin, FVector4& scalarMax) {
+		for (int component = 0; component < 4; component++) {
+			if (scalars[component] > PC_NO_SCALAR) {
+				scalarMin[component] = std::min(scalarMin[component], scalars[component]);
+				scalarMax[component] = std::max(scalarMax[component], scalars[component]);
 			}
 		}
-		// else the density of each particle is used to determine color
-		else {
-			for (const ParticleType& particle : particles) {
-				// on a scale from 0 to 1, how high is the density of this particle in relation to all other densities
-				float percentage = (std::max(particle.Density, restDensity) - restDensity) / range;
-				Points.Emplace(static_cast<float>(-particle.Position.X) * 10, static_cast<float>(particle.Position.Y) * 10, static_cast<float>(particle.Position.Z) * 10, 1, (1.0 - percentage), (1 - percentage));
-			}
+	}
+
+	FORCEINLINE void MergeScalarLimits(const FVector4& otherMin, const FVector4& otherMax, FVector4& scalarMin, FVector4& scalarMax) {
+		for (int component = 0; component < 4; component++) {
+			scalarMin[component] = std::min(scalarMin[component], otherMin[component]);
+			scalarMax[component] = std::max(scalarMax[component], otherMax[component]);
 		}
+	}
 
-		break;
+	// Batches for loops which reduce something while converting, a few per worker thread at most
+	int GetNumBatches(int numItems) {
+		return std::max(1, std::min(numItems / 4096, FTaskGraphInterface::Get().GetNumWorkerThreads() + 1));
 	}
-	case EColorVisualisation::Velocity:
-	{
-		double maxVelocity = sqrt(ParallelMax<ParticleType, double>(particles, [](const ParticleType& particle) { return particle.Velocity.LengthSquared(); }));
 
-		// if maxVelocity is zero all particles stand still
-		if (maxVelocity == 0) {
-			for (const ParticleType& particle : particles) {
-				Points.Emplace(static_cast<float>(-particle.Position.X) * 10, static_cast<float>(particle.Position.Y) * 10, static_cast<float>(particle.Position.Z) * 10, 0.f, 1.f, 0.9f);
-			}
-		}
-		// else the velcity of each particle is used to determine color
-		else {
-			for (const ParticleType& particle : particles) {
-				// on a scale from 0 to 1, how high is the density of this particle in relation to all other densities
-				float percentage = particle.Velocity.Length() / maxVelocity;
-				Points.Emplace(static_cast<float>(-particle.Position.X) * 10, static_cast<float>(particle.Position.Y) * 10, static_cast<float>(particle.Position.Z) * 10, percentage, (1 - percentage), 0.9f * (1 - percentage));
+	// Packs the coordinates of a cell into a key. Unlike the hash of the neighbor search, cells can't collide within 2^20 cells from the origin
+	FORCEINLINE long long GetCellKey(int x, int y, int z) {
+		const long long bias = 1 << 20;
+		return ((x + bias) & 0x1FFFFF) << 42 | ((y + bias) & 0x1FFFFF) << 21 | ((z + bias) & 0x1FFFFF);
+	}
+
+	// Writes the positions in parallel into the already sized points
+	void ConvertPositions(const std::vector<Vector3D>& positions, FPointCloudPoint* points, const FColor& color) {
+		ParallelFor(positions.size(), [&](int32 i) {
+			const Vector3D& position = positions[i];
+			points[i].Location = FVector(-position.X, position.Y, position.Z) * 10;
+			points[i].OriginalLocation = points[i].Location;
+			points[i].Color = color;
+			points[i].bEnabled = true;
+		});
+	}
+}
+
+template <typename ParticleType, typename ColorFunction>
+void AParticleCloudActor::ConvertParticles(const std::vector<ParticleType>& particles, int offset, const ColorFunction& colorFunction)
+{
+	FPointCloudPoint* points = Points.GetData() + offset;
+
+	ParallelFor(particles.size(), [&](int32 i) {
+		const ParticleType& particle = particles[i];
+		FPointCloudPoint& point = points[i];
+
+		// unreal uses a left handed coordinate system in centimeters
+		point.Location = FVector(static_cast<float>(-particle.Position.X) * 10, static_cast<float>(particle.Position.Y) * 10, static_cast<float>(particle.Position.Z) * 10);
+		point.OriginalLocation = point.Location;
+		point.Color = colorFunction(particle, offset + i).ToFColor(false);
+		// removed particles keep their slot until it is reused
+		point.bEnabled = !particle.IsRemoved;
+	});
+}
+
+template <typename ParticleType, typename ColorFunction, typename ScalarFunction>
+void AParticleCloudActor::ConvertParticles(const std::vector<ParticleType>& particles, int offset, const ColorFunction& colorFunction, const ScalarFunction& scalarFunction)
+{
+	FPointCloudPoint* points = Points.GetData() + offset;
+	FVector4* scalars = Scalars.GetData() + offset;
+
+	// the limits are reduced per batch while converting, so they need no pass of their own
+	const int numParticles = particles.size();
+	const int numBatches = GetNumBatches(numParticles);
+	const int batchSize = (numParticles + numBatches - 1) / numBatches;
+
+	std::vector<FVector4> batchMin(numBatches, ScalarMin);
+	std::vector<FVector4> batchMax(numBatches, ScalarMax);
+
+	ParallelFor(numBatches, [&](int32 batch) {
+		const int end = std::min(numParticles, (batch + 1) * batchSize);
+
+		for (int i = batch * batchSize; i < end; i++) {
+			const ParticleType& particle = particles[i];
+			FPointCloudPoint& point = points[i];
+
+			point.Location = ToUnrealLocation(particle.Position);
+			point.OriginalLocation = point.Location;
+			point.Color = colorFunction(particle, offset + i).ToFColor(false);
+			point.bEnabled = !particle.IsRemoved;
+
+			scalars[i] = scalarFunction(particle, offset + i);
+			if (point.bEnabled) {
+				ExpandScalarLimits(scalars[i], batchMin[batch], batchMax[batch]);
 			}
 		}
-		break;
+	});
 
+	for (int batch = 0; batch < numBatches; batch++) {
+		MergeScalarLimits(batchMin[batch], batchMax[batch], ScalarMin, ScalarMax);
 	}
-	case EColorVisualisation::Pressure:
-	{
-		double maxPressure = 0;
-		if (particles.size() > 0)
-			maxPressure = std::max(500.0, ParallelMax<ParticleType, double>(particles, [](const ParticleType& particle) { return particle.Pressure; }));
+}
 
-		// if maxVelocity is zero all particles stand still
-		if (maxPressure == 0) {
-			for (const ParticleType& particle : particles) {
-				Points.Emplace(static_cast<float>(-particle.Position.X) * 10, static_cast<float>(particle.Position.Y) * 10, static_cast<float>(particle.Position.Z) * 10, 1.f, 1.f, 1.f);
+template <typename ColorFunction, typename ScalarFunction>
+void AParticleCloudActor::ConvertFluidWithLOD(const std::vector<Particle>& particles, int offset, int fluidOffset, const FVector& cameraLocation, double lodDistance, const ColorFunction& colorFunction, const ScalarFunction& scalarFunction)
+{
+	const int numParticles = particles.size();
+	if (numParticles == 0) {
+		return;
+	}
+
+	// the cells of the neighbor search, so the level is chosen once per cell and not per particle
+	const UNeighborsFinder * neighborsFinder = ParticleContext->GetSimulator()->GetNeighborsFinder();
+	const double particleDistance = ParticleContext->GetParticleDistance();
+	const double lodDistanceSquared = lodDistance * lodDistance;
+
+	// every batch collects its far cells on its own, so no locking is needed
+	const int numBatches = GetNumBatches(numParticles);
+	const int batchSize = (numParticles + numBatches - 1) / numBatches;
+
+	FPointCloudPoint* points = Points.GetData() + offset;
+	FVector4* scalars = Scalars.GetData() + offset;
+
+	std::vector<FVector4> batchMin(numBatches, ScalarMin);
+	std::vector<FVector4> batchMax(numBatches, ScalarMax);
+	std::vector<std::unordered_map<long long, FCellAggregate>> batchCells(numBatches);
+
+	// every particle keeps its point, so the number of points does not change with the camera and the cloud is updated in place.
+	// Near particles are written as they are, far ones are disabled and their cell is drawn in the point of its first particle below
+	ParallelFor(numBatches, [&](int32 batch) {
+		std::unordered_map<long long, FCellAggregate>& cells = batchCells[batch];
+		const int end = std::min(numParticles, (batch + 1) * batchSize);
+
+		for (int i = batch * batchSize; i < end; i++) {
+			const Particle& particle = particles[i];
+			FPointCloudPoint& point = points[i];
+
+			point.Location = ToUnrealLocation(particle.Position);
+			point.OriginalLocation = point.Location;
+			point.bEnabled = false;
+
+			// removed particles are neither near points nor part of a cell
+			if (particle.IsRemoved) {
+				scalars[i] = NoScalars;
+				continue;
+			}
+
+			int x, y, z;
+			neighborsFinder->GetCellCoordinates(particle.Position, particleDistance, x, y, z);
+
+			// the distance of the cell center decides for all particles in the cell, so cells are never split
+			const FVector cellCenter = ToUnrealLocation(neighborsFinder->GetCellCenter(x, y, z, particleDistance));
+			const FLinearColor color = colorFunction(particle, fluidOffset + i);
+			point.Color = color.ToFColor(false);
+
+			// the limits are taken from the particles and not from the means of the cells, so the ramp is the same as without the level of detail
+			scalars[i] = scalarFunction(particle, fluidOffset + i);
+			ExpandScalarLimits(scalars[i], batchMin[batch], batchMax[batch]);
+
+			if (FVector::DistSquared(cellCenter, cameraLocation) <= lodDistanceSquared) {
+				point.bEnabled = true;
+			}
+			else {
+				FCellAggregate& cell = cells[GetCellKey(x, y, z)];
+				if (cell.Count == 0) {
+					cell.FirstParticle = i;
+				}
+				cell.Position += particle.Position;
+				cell.Color += color;
+				cell.Scalars += scalars[i];
+				cell.Count++;
 			}
 		}
-		// else the velcity of each particle is used to determine color
-		else {
-			for (const ParticleType& particle : particles) {
-				// on a scale from 0 to 1, how high is the density of this particle in relation to all other densities
-				float percentage = particle.Pressure / maxPressure;
-				Points.Emplace(static_cast<float>(-particle.Position.X) * 10, static_cast<float>(particle.Position.Y) * 10, static_cast<float>(particle.Position.Z) * 10, 1, (1.0 - percentage) , (1 - percentage));
+	});
+
+	// cells spanning several batches are merged, there are far fewer cells than particles. Batches are in particle order, so the first particle stays the one of the first batch
+	std::unordered_map<long long, FCellAggregate>& cells = batchCells[0];
+	for (int batch = 1; batch < numBatches; batch++) {
+		for (const std::pair<const long long, FCellAggregate>& batchCell : batchCells[batch]) {
+			FCellAggregate& cell = cells[batchCell.first];
+			if (cell.Count == 0) {
+				cell.FirstParticle = batchCell.second.FirstParticle;
 			}
+			cell.Position += batchCell.second.Position;
+			cell.Color += batchCell.second.Color;
+			cell.Scalars += batchCell.second.Scalars;
+			cell.Count += batchCell.second.Count;
 		}
-		break;
+	}
+
+	// one point at the mean position with the mean color and scalars of each far cell. Every cell has its own point, so the order of the map does not matter
+	for (const std::pair<const long long, FCellAggregate>& cell : cells) {
+		const int index = cell.second.FirstParticle;
+		FPointCloudPoint& point = points[index];
+		point.Location = ToUnrealLocation(cell.second.Position / cell.second.Count);
+		point.OriginalLocation = point.Location;
+		point.Color = (cell.second.Color / cell.second.Count).ToFColor(false);
+		point.bEnabled = true;
 
+		scalars[index] = cell.second.Scalars * (1.f / cell.second.Count);
 	}
+
+	for (int batch = 0; batch < numBatches; batch++) {
+		MergeScalarLimits(batchMin[batch], batchMax[batch], ScalarMin, ScalarMax);
 	}
-	// use the new points and rebuild the particle cloud
-	UpdatePointCloud();
 
+	LastAggregatedCellCount += cells.size();
 }
 
-template void AParticleCloudActor::VisualiseParticles(const std::vector<Particle>& particles, double size, EColorVisualisation colorMethod, double restDensity);
+template <typename ParticleType>
+void AParticleCloudActor::VisualiseParticles(const std::vector<ParticleType>& particles, double size, EColorVisualisation colorMethod, double restDensity)
+{
+	VisualiseParticleVectors<ParticleType>({ &particles }, size, colorMethod, restDensity);
+}
+
+template <typename ParticleType>
+void AParticleCloudActor::VisualiseParticles(const std::vector<std::vector<ParticleType>*>& particles, double size, EColorVisualisation colorMethod, double restDensity)
+{
+	VisualiseParticleVectors<ParticleType>(std::vector<const std::vector<ParticleType>*>(particles.begin(), particles.end()), size, colorMethod, restDensity);
+}
 
 template <typename ParticleType>
-void VisualizeParticles(const std::vector<std::vector<ParticleType>*>& particles, double size, EColorVisualisation colorMethod, double restDensity = 0) {
-	Points.Empty();
+void AParticleCloudActor::VisualiseParticleVectors(const std::vector<const std::vector<ParticleType>*>& particles, double size, EColorVisualisation colorMethod, double restDensity)
+{
+	FDateTime conversionStartTime = FDateTime::UtcNow();
+
 	int numParticles = 0;
-	for (std::vector<ParticleType>* particleVec : particles) {
-		numParticles += particleVec->size();
+	if (colorMethod == EColorVisualisation::Normal || colorMethod == EColorVisualisation::Density || colorMethod == EColorVisualisation::Velocity || colorMethod == EColorVisualisation::Pressure) {
+		for (const std::vector<ParticleType>* particleVector : particles) {
+			numParticles += particleVector->size();
+		}
 	}
 
-	Points.Reserve(numParticles);
+	// keep the allocation, the number of particles rarely changes between frames
+	Points.SetNumUninitialized(numParticles, false);
+	// colored on the cpu
+	Scalars.SetNum(0, false);
 	PointCloud->SpriteSize = FVector2D(size * 10, size * 10);
 
-	for (std::vector<ParticleType>* particlesFromComp : particles) {
-		for (const ParticleType& particle : particles) {
-			switch
+	// maximum of a value over all particle vectors
+	auto maxValue = [&particles](std::function<double(const ParticleType&)> valueGetter) {
+		double max = 0.0;
+		for (const std::vector<ParticleType>* particleVector : particles) {
+			if (particleVector->size() > 0) {
+				max = std::max(max, ParallelMax<ParticleType, double>(*particleVector, valueGetter));
+			}
+		}
+		return max;
+	};
+
+	// every color mode instantiates the conversion loop with its own color function, so the color is computed inline for each point
+	auto convert = [&](const auto& colorFunction) {
+		if (numParticles == 0) {
+			return;
 		}
-	}
+		int offset = 0;
+		for (const std::vector<ParticleType>* particleVector : particles) {
+			ConvertParticles(*particleVector, offset, colorFunction);
+			offset += particleVector->size();
+		}
+	};
+
 	switch (colorMethod) {
 	case EColorVisualisation::Normal:
-			for (const ParticleType& particle : particles) {
-				Points.Emplace(static_cast<float>(-particle.Position.X) * 10, static_cast<float>(particle.Position.Y) * 10, static_cast<float>(particle.Position.Z) * 10, 1.f, 0.4f, 0.f);
-			}
+		convert([](const ParticleType& particle, int index) { return FluidColor; });
 		break;
 
-	case EColorVisualisation::DefaultFluid:
-			for (const ParticleType& particle : particles) {
-				Points.Emplace(static_cast<float>(-particle.Position.X) * 10, static_cast<float>(particle.Position.Y) * 10, static_cast<float>(particle.Position.Z) * 10, 0.f, 1.f, 0.9f);
-			}
-
-		break;
 	case EColorVisualisation::Density:
 	{
-		double maxDensity = particles.size() > 0 ? ParallelMax<ParticleType, double>(particles, [](const ParticleType& particle) { return particle.Density; }) : 0.0;
-
-		double range = maxDensity - restDensity;
+		double range = maxValue([](const ParticleType& particle) { return particle.Density; }) - restDensity;
 
 		// if range is zero all particles have the same density and are all colored blue
 		if (range == 0) {
-			for (const ParticleType& particle : particles) {
-				Points.Emplace(static_cast<float>(-particle.Position.X) * 10, static_cast<float>(particle.Position.Y) * 10, static_cast<float>(particle.Position.Z) * 10, 0.f, 1.f, 0.9f);
-			}
+			convert([](const ParticleType& particle, int index) { return FluidColor; });
 		}
 		// else the density of each particle is used to determine color
 		else {
-			for (const ParticleType& particle : particles) {
+			convert([restDensity, range](const ParticleType& particle, int index) {
 				// on a scale from 0 to 1, how high is the density of this particle in relation to all other densities
-				float percentage = (std::max(particle.Density, restDensity) - restDensity) / range;
-				Points.Emplace(static_cast<float>(-particle.Position.X) * 10, static_cast<float>(particle.Position.Y) * 10, static_cast<float>(particle.Position.Z) * 10, 1, (1.0 - percentage), (1 - percentage));
-			}
+				return RedRamp((std::max(particle.Density, restDensity) - restDensity) / range);
+			});
 		}
-
 		break;
 	}
 	case EColorVisualisation::Velocity:
 	{
-		double maxVelocity = sqrt(ParallelMax<ParticleType, double>(particles, [](const ParticleType& particle) { return particle.Velocity.LengthSquared(); }));
+		double maxVelocity = sqrt(maxValue([](const ParticleType& particle) { return particle.Velocity.LengthSquared(); }));
 
 		// if maxVelocity is zero all particles stand still
 		if (maxVelocity == 0) {
-			for (const ParticleType& particle : particles) {
-				Points.Emplace(static_cast<float>(-particle.Position.X) * 10, static_cast<float>(particle.Position.Y) * 10, static_cast<float>(particle.Position.Z) * 10, 0.f, 1.f, 0.9f);
-			}
+			convert([](const ParticleType& particle, int index) { return FluidColor; });
 		}
 		// else the velcity of each particle is used to determine color
 		else {
-			for (const ParticleType& particle : particles) {
-				// on a scale from 0 to 1, how high is the density of this particle in relation to all other densities
+			convert([maxVelocity](const ParticleType& particle, int index) {
 				float percentage = particle.Velocity.Length() / maxVelocity;
-				Points.Emplace(static_cast<float>(-particle.Position.X) * 10, static_cast<float>(particle.Position.Y) * 10, static_cast<float>(particle.Position.Z) * 10, percentage, (1 - percentage), 0.9f * (1 - percentage));
-			}
+				return FLinearColor(percentage, 1.f - percentage, 0.9f * (1.f - percentage));
+			});
 		}
 		break;
-
 	}
 	case EColorVisualisation::Pressure:
 	{
-		double maxPressure = 0;
-		if (particles.size() > 0)
-			maxPressure = std::max(500.0, ParallelMax<ParticleType, double>(particles, [](const ParticleType& particle) { return particle.Pressure; }));
+		double maxPressure = numParticles > 0 ? std::max(500.0, maxValue([](const ParticleType& particle) { return particle.Pressure; })) : 0.0;
 
-		// if maxVelocity is zero all particles stand still
 		if (maxPressure == 0) {
-			for (const ParticleType& particle : particles) {
-				Points.Emplace(static_cast<float>(-particle.Position.X) * 10, static_cast<float>(particle.Position.Y) * 10, static_cast<float>(particle.Position.Z) * 10, 1.f, 1.f, 1.f);
-			}
+			convert([](const ParticleType& particle, int index) { return FLinearColor::White; });
 		}
-		// else the velcity of each particle is used to determine color
 		else {
-			for (const ParticleType& particle : particles) {
-				// on a scale from 0 to 1, how high is the density of this particle in relation to all other densities
-				float percentage = particle.Pressure / maxPressure;
-				Points.Emplace(static_cast<float>(-particle.Position.X) * 10, static_cast<float>(particle.Position.Y) * 10, static_cast<float>(particle.Position.Z) * 10, 1, (1.0 - percentage), (1 - percentage));
-			}
+			convert([maxPressure](const ParticleType& particle, int index) { return RedRamp(particle.Pressure / maxPressure); });
 		}
 		break;
-
 	}
 	}
-	// use the new points and rebuild the particle cloud
-	UpdatePointCloud();
 
+	LastConversionTime = (FDateTime::UtcNow() - conversionStartTime).GetTotalSeconds();
+
+	// use the new points and update the particle cloud
+	UpdatePointCloud();
 }
 
+template void AParticleCloudActor::VisualiseParticles(const std::vector<Particle>& particles, double size, EColorVisualisation colorMethod, double restDensity);
+
+template void AParticleCloudActor::VisualiseParticles(const std::vector<std::vector<Particle>*>& particles, double size, EColorVisualisation colorMethod, double restDensity);
 
 void AParticleCloudActor::VisualisePositions(const std::vector<Vector3D>& positions, const std::vector<Vector3D>& velocities, double size, EColorVisualisation colorMethod)
 {
-	Points.Empty();
-	Points.Reserve(positions.size());
-	PointCloud->SpriteSize = FVector2D(size * 10, size * 10);
-
-	for (const Vector3D& position : positions) {
+	FDateTime conversionStartTime = FDateTime::UtcNow();
 
-		FVector Uposition = FVector(-position.X, position.Y, position.Z) * 10;
+	Points.SetNumUninitialized(positions.size(), false);
+	// colored on the cpu
+	Scalars.SetNum(0, false);
+	PointCloud->SpriteSize = FVector2D(size * 10, size * 10);
 
-		FPointCloudPoint point = FPointCloudPoint(Uposition, FVector(0, 1, 1));
+	ConvertPositions(positions, Points.GetData(), FLinearColor(0.f, 1.f, 1.f).ToFColor(true));
 
-		Points.Add(point);
-	}
+	LastConversionTime = (FDateTime::UtcNow() - conversionStartTime).GetTotalSeconds();
 
 	UpdatePointCloud();
 }
 
 void AParticleCloudActor::VisualisePositions(const std::vector<std::vector<Vector3D>>& positions, const std::vector<std::vector<Vector3D>>& velocities, double size, EColorVisualisation colorMethod) {
-	Points.Empty();
-	Points.Reserve(positions.size());
-	PointCloud->SpriteSize = FVector2D(size * 10, size * 10);
+	FDateTime conversionStartTime = FDateTime::UtcNow();
 
-	for (int i = 0; i < positions.size(); i++) {
-		for (const Vector3D& position : positions[i]) {
+	int numPoints = 0;
+	for (const std::vector<Vector3D>& positionVector : positions) {
+		numPoints += positionVector.size();
+	}
 
-			FVector Uposition = FVector(-position.X, position.Y, position.Z) * 10;
+	Points.SetNumUninitialized(numPoints, false);
+	// colored on the cpu
+	Scalars.SetNum(0, false);
+	PointCloud->SpriteSize = FVector2D(size * 10, size * 10);
 
-			FPointCloudPoint point = FPointCloudPoint(Uposition, FVector(0, 1, 1));
+	const FColor color = FLinearColor(0.f, 1.f, 1.f).ToFColor(true);
 
-			Points.Add(point);
-		}
+	int offset = 0;
+	for (const std::vector<Vector3D>& positionVector : positions) {
+		ConvertPositions(positionVector, Points.GetData() + offset, color);
+		offset += positionVector.size();
 	}
 
+	LastConversionTime = (FDateTime::UtcNow() - conversionStartTime).GetTotalSeconds();
+
 	UpdatePointCloud();
 }
 
 
 void AParticleCloudActor::VisualisePositions(const TArray<FVector>& positions, const std::vector<Vector3D>& velocities, double size, EColorVisualisation colorMethod)
 {
-	Points.Empty();
-	Points.Reserve(positions.Num());
+	FDateTime conversionStartTime = FDateTime::UtcNow();
+
+	Points.SetNumUninitialized(positions.Num(), false);
+	// colored on the cpu
+	Scalars.SetNum(0, false);
+	PointCloud->SpriteSize = FVector2D(size * 10, size * 10);
+
+	const FColor color = FLinearColor(0.f, 1.f, 1.f).ToFColor(true);
+
+	ParallelFor(positions.Num(), [&](int32 i) {
+		const FVector& position = positions[i];
+		Points[i].Location = FVector(-position.X, position.Y, position.Z) * 10;
+		Points[i].OriginalLocation = Points[i].Location;
+		Points[i].Color = color;
+		Points[i].bEnabled = true;
+	});
+
+	LastConversionTime = (FDateTime::UtcNow() - conversionStartTime).GetTotalSeconds();
+
+	UpdatePointCloud();
+}
+
+void AParticleCloudActor::VisualiseVertices(const TArray<FPointCloudVertex>& vertices, const TArray<FVector4>& scalars, const FVector4& scalarMin, const FVector4& scalarMax, double size)
+{
+	FDateTime uploadStartTime = FDateTime::UtcNow();
+
+	const bool hasScalars = scalars.Num() > 0 && scalars.Num() == vertices.Num();
+
+	ScalarMin = scalarMin;
+	ScalarMax = scalarMax;
+	CurlComputed = false;
+
 	PointCloud->SpriteSize = FVector2D(size * 10, size * 10);
+	if (ParticleContext != nullptr) {
+		ApplyColorRamp(ParticleContext->GetVisualisationInformation());
+	}
+	else {
+		PointCloud->ApplyRenderingParameters();
+	}
+
+	LastConversionTime = 0.0;
 
-	for (const FVector& position : positions) {
+	if (!GetPointCloud()->UpdatePointCloudVertices(vertices.GetData(), vertices.Num(), hasScalars ? scalars.GetData() : nullptr)) {
+		FDateTime conversionStartTime = FDateTime::UtcNow();
 
-		FVector Uposition = FVector(-position.X, position.Y, position.Z) * 10;
+		Points.SetNumUninitialized(vertices.Num(), false);
+		ParallelFor(vertices.Num(), [&](int32 i) {
+			Points[i].Location = vertices[i].Location;
+			Points[i].OriginalLocation = vertices[i].Location;
+			Points[i].Color = vertices[i].Color;
+			Points[i].bEnabled = true;
+		});
+
+		if (hasScalars) {
+			Scalars = scalars;
+		}
+		else {
+			Scalars.SetNum(0, false);
+		}
 
-		FPointCloudPoint point = FPointCloudPoint(Uposition, FVector(0, 1, 1));
+		LastConversionTime = (FDateTime::UtcNow() - conversionStartTime).GetTotalSeconds();
 
-		Points.Add(point);
+		UpdatePointCloud();
 	}
 
-	UpdatePointCloud();
+	LastUploadTime = (FDateTime::UtcNow() - uploadStartTime).GetTotalSeconds() - LastConversionTime;
 }
 
 void AParticleCloudActor::SetVisibilityOfCloud(bool newVisibility)
@@ -316,368 +553,385 @@ void AParticleCloudActor::SetVisibilityOfCloud(bool newVisibility)
 	}
 }
 
-void AParticleCloudActor::UpdateParticleContextVisualisation(FVisualisationInformation visualisationInformation)
+void AParticleCloudActor::ConvertGhostParticles(const std::vector<Vector3D>& positions, int offset)
 {
-	Points.Empty();
-	int numParticles = 0;
+	FPointCloudPoint* points = Points.GetData() + offset;
+	FVector4* scalars = Scalars.GetData() + offset;
+	const FColor ghostColor = GhostColor.ToFColor(false);
+
+	ParallelFor(positions.size(), [&](int32 i) {
+		FPointCloudPoint& point = points[i];
+
+		point.Location = ToUnrealLocation(positions[i]);
+		point.OriginalLocation = point.Location;
+		point.Color = ghostColor;
+		point.bEnabled = true;
+
+		scalars[i] = NoScalars;
+	});
+}
+
+template <typename FluidColorFunction, typename FluidScalarFunction>
+void AParticleCloudActor::ConvertParticleContext(const FVisualisationInformation& visualisationInformation, const FluidColorFunction& fluidColor, const FluidScalarFunction& fluidScalars)
+{
+	const bool showGhosts = visualisationInformation.ShowFluids && visualisationInformation.ShowPeriodicGhostBorders && ParticleContext->GetPeriodicCondition() != nullptr;
+
+	FVector cameraLocation;
+	const bool useLOD = visualisationInformation.LODDistance > 0 && GetCameraLocation(cameraLocation);
+	LastAggregatedCellCount = 0;
+
+	// the limits are grown while converting
+	ScalarMin = FVector4(MAX_FLT, MAX_FLT, MAX_FLT, MAX_FLT);
+	ScalarMax = FVector4(-MAX_FLT, -MAX_FLT, -MAX_FLT, -MAX_FLT);
+
+	int offset = 0;
 	if (visualisationInformation.ShowFluids) {
-		for (UFluid* fluid : ParticleContext->GetFluids()) {
-			numParticles += fluid->GetNumParticles();
-		}
-		if (visualisationInformation.ShowPeriodicGhostBorders && ParticleContext->GetPeriodicCondition() != nullptr) {
-			numParticles += ParticleContext->GetPeriodicCondition()->GetGhostParticles().size();
+		int fluidOffset = 0;
+		for (UFluid * fluid : ParticleContext->GetFluids()) {
+			if (useLOD) {
+				ConvertFluidWithLOD(*fluid->Particles, offset, fluidOffset, cameraLocation, visualisationInformation.LODDistance, fluidColor, fluidScalars);
+			}
+			else {
+				ConvertParticles(*fluid->Particles, offset, fluidColor, fluidScalars);
+			}
+			offset += fluid->GetNumParticles();
+			fluidOffset += fluid->GetNumParticles();
 		}
 	}
+	if (showGhosts) {
+		const std::vector<Vector3D>& ghostPositions = ParticleContext->GetPeriodicCondition()->GetGhostPositions();
+		ConvertGhostParticles(ghostPositions, offset);
+		offset += ghostPositions.size();
+	}
+	// only the pressure of static borders is meaningful
+	auto staticBorderColor = [](const Particle& particle, int index) { return StaticBorderColor; };
+	auto staticBorderScalars = [](const Particle& particle, int index) { return FVector4(PC_NO_SCALAR, PC_NO_SCALAR, particle.Pressure, PC_NO_SCALAR); };
+
 	if (visualisationInformation.ShowStaticBorders) {
 		for (UStaticBorder * staticBorder : ParticleContext->GetStaticBorders()) {
-			numParticles += staticBorder->GetNumParticles();
+			ConvertParticles(*staticBorder->Particles, offset, staticBorderColor, staticBorderScalars);
+			offset += staticBorder->GetNumParticles();
 		}
 	}
 
+	// the limits always span the fluids and the pressure of the static borders, so hiding one of them does not change the ramp of the other
+	if (!visualisationInformation.ShowFluids) {
+		int fluidOffset = 0;
+		for (UFluid * fluid : ParticleContext->GetFluids()) {
+			GrowScalarLimits(*fluid->Particles, fluidOffset, fluidScalars);
+			fluidOffset += fluid->GetNumParticles();
+		}
+	}
+	if (!visualisationInformation.ShowStaticBorders) {
+		for (UStaticBorder * staticBorder : ParticleContext->GetStaticBorders()) {
+			GrowScalarLimits(*staticBorder->Particles, 0, staticBorderScalars);
+		}
+	}
+}
 
-	Points.Reserve(numParticles);
-	PointCloud->SpriteSize = FVector2D(ParticleContext->GetParticleDistance() * 10, ParticleContext->GetParticleDistance() * 10);
+template <typename ScalarFunction>
+void AParticleCloudActor::GrowScalarLimits(const std::vector<Particle>& particles, int indexOffset, const ScalarFunction& scalarFunction)
+{
+	const int numParticles = particles.size();
+	const int numBatches = GetNumBatches(numParticles);
+	const int batchSize = (numParticles + numBatches - 1) / numBatches;
 
-	switch (visualisationInformation.ColorCode) {
-	case EColorVisualisation::None:
+	std::vector<FVector4> batchMin(numBatches, ScalarMin);
+	std::vector<FVector4> batchMax(numBatches, ScalarMax);
 
-		break;
-	case EColorVisualisation::Normal:
-		if (visualisationInformation.ShowFluids) {
-			for (UFluid * fluid : ParticleContext->GetFluids()) {
-				for (const Particle& particle : *fluid->Particles) {
-					Points.Emplace(static_cast<float>(-particle.Position.X) * 10, static_cast<float>(particle.Position.Y) * 10, static_cast<float>(particle.Position.Z) * 10, 0.f, 1.f, 0.9f);
-				}
+	ParallelFor(numBatches, [&](int32 batch) {
+		const int end = std::min(numParticles, (batch + 1) * batchSize);
+		for (int i = batch * batchSize; i < end; i++) {
+			if (!particles[i].IsRemoved) {
+				ExpandScalarLimits(scalarFunction(particles[i], indexOffset + i), batchMin[batch], batchMax[batch]);
 			}
+		}
+	});
 
-			if (visualisationInformation.ShowPeriodicGhostBorders && ParticleContext->GetPeriodicCondition() != nullptr) {
-				for (const Particle& particle : ParticleContext->GetPeriodicCondition()->GetGhostParticles()) {
-					Points.Emplace(static_cast<float>(-particle.Position.X) * 10, static_cast<float>(particle.Position.Y) * 10, static_cast<float>(particle.Position.Z) * 10, 1.f, 0.4f, 1.f);
-				}
-			}
+	for (int batch = 0; batch < numBatches; batch++) {
+		MergeScalarLimits(batchMin[batch], batchMax[batch], ScalarMin, ScalarMax);
+	}
+}
 
-		}
-		if (visualisationInformation.ShowStaticBorders) {
-			for (UStaticBorder * staticBorder : ParticleContext->GetStaticBorders()) {
-				for (const Particle& particle : *staticBorder->Particles) {
-					Points.Emplace(static_cast<float>(-particle.Position.X) * 10, static_cast<float>(particle.Position.Y) * 10, static_cast<float>(particle.Position.Z) * 10, 1.f, 0.4f, 0.f);
-				}
-			}
-		}
+bool AParticleCloudActor::GetCameraLocation(FVector& cameraLocation) const
+{
+	UWorld * world = GetWorld();
+	APlayerController * playerController = world != nullptr ? world->GetFirstPlayerController() : nullptr;
 
-		break;
-	case EColorVisualisation::Density:
-	{
-		double maxDensity = 0.0;
-		double minDensity = DBL_MAX;
-		double range = 0.0;
+	if (playerController == nullptr || playerController->PlayerCameraManager == nullptr) {
+		return false;
+	}
 
+	// the points are relative to the actor
+	cameraLocation = GetActorTransform().InverseTransformPosition(playerController->PlayerCameraManager->GetCameraLocation());
+	return true;
+}
 
-		if (visualisationInformation.AutoLimits) {
-			// compute max and min
-			for (UFluid * fluid : ParticleContext->GetFluids()) {
-				if (fluid->GetNumParticles() > 0) {
-					maxDensity = std::max(maxDensity, ParallelMax<Particle, double>(*fluid->Particles, [](const Particle& particle) { return particle.Density; }));
-					minDensity = std::min(minDensity, ParallelMin<Particle, double>(*fluid->Particles, [](const Particle& particle) { return particle.Density; }));
-				}
-			}
-			range = maxDensity - minDensity;
-		}
-		else {
-			// jut set max and min to the user specified values
-			maxDensity = visualisationInformation.Max;
-			minDensity = visualisationInformation.Min;
-			range = maxDensity - minDensity;
+void AParticleCloudActor::UpdateSurface(const FVisualisationInformation& visualisationInformation)
+{
+	FDateTime conversionStartTime = FDateTime::UtcNow();
+
+	int numParticles = 0;
+	if (visualisationInformation.ShowFluids) {
+		for (UFluid* fluid : ParticleContext->GetFluids()) {
+			numParticles += fluid->GetNumParticles();
 		}
+	}
 
-		if (visualisationInformation.ShowFluids) {
+	SurfacePositions.SetNumUninitialized(numParticles, false);
 
-			// if range is zero all fluid particles have the same density and are all colored blue. StaticBorder is anyway colored yellow
-			if (range == 0.0) {
-				for (UFluid * fluid : ParticleContext->GetFluids()) {
-					for (const Particle& particle : *fluid->Particles) {
-						Points.Emplace(static_cast<float>(-particle.Position.X) * 10, static_cast<float>(particle.Position.Y) * 10, static_cast<float>(particle.Position.Z) * 10, 0.f, 1.f, 0.9f);
-					}
-				}
-			}
-			// else the density of each particle is used to determine color
-			else {
-				for (UFluid * fluid : ParticleContext->GetFluids()) {
-					for (const Particle& particle : *fluid->Particles) {
-						// on a scale from 0 to 1, how high is the density of this particle in relation to all other densities
-						float percentage = (std::max(particle.Density, minDensity) - minDensity) / range;
-						Points.Emplace(static_cast<float>(-particle.Position.X) * 10, static_cast<float>(particle.Position.Y) * 10, static_cast<float>(particle.Position.Z) * 10, 1, (1.0 - percentage), (1 - percentage));
+	int offset = 0;
+	if (visualisationInformation.ShowFluids) {
+		for (UFluid * fluid : ParticleContext->GetFluids()) {
+			const std::vector<Particle>& particles = *fluid->Particles;
+			FVector* positions = SurfacePositions.GetData() + offset;
+			ParallelFor(particles.size(), [&](int32 i) {
+				positions[i] = FVector(static_cast<float>(-particles[i].Position.X) * 10, static_cast<float>(particles[i].Position.Y) * 10, static_cast<float>(particles[i].Position.Z) * 10);
+			});
+
+			// removed particles are moved out, there are few of them
+			if (fluid->GetNumRemovedParticles() > 0) {
+				int numLive = 0;
+				for (int i = 0; i < particles.size(); i++) {
+					if (!particles[i].IsRemoved) {
+						positions[numLive++] = positions[i];
 					}
 				}
 			}
-
-			if (visualisationInformation.ShowPeriodicGhostBorders && ParticleContext->GetPeriodicCondition() != nullptr) {
-				for (const Particle& particle : ParticleContext->GetPeriodicCondition()->GetGhostParticles()) {
-					Points.Emplace(static_cast<float>(-particle.Position.X) * 10, static_cast<float>(particle.Position.Y) * 10, static_cast<float>(particle.Position.Z) * 10, 1.f, 0.4f, 1.f);
-				}
-			}
-		}
-		if (visualisationInformation.ShowStaticBorders) {
-			// Static Borders are not color coded with density
-			for (UStaticBorder * staticBorder : ParticleContext->GetStaticBorders()) {
-				for (const Particle& particle : *staticBorder->Particles) {
-					Points.Emplace(static_cast<float>(-particle.Position.X) * 10, static_cast<float>(particle.Position.Y) * 10, static_cast<float>(particle.Position.Z) * 10, 1.f, 0.4f, 0.f);
-				}
-			}
+			offset += fluid->GetNumLiveParticles();
 		}
+	}
+	SurfacePositions.SetNum(offset, false);
 
-		break;
+	LastConversionTime = (FDateTime::UtcNow() - conversionStartTime).GetTotalSeconds();
+
+	FDateTime uploadStartTime = FDateTime::UtcNow();
+
+	// neighboring spheres overlap, so the splats close into a surface
+	SurfaceComponent->ParticleRadius = ParticleContext->GetParticleDistance() * 10;
+	SurfaceComponent->SetPositions(SurfacePositions.GetData(), SurfacePositions.Num());
+
+	LastUploadTime = (FDateTime::UtcNow() - uploadStartTime).GetTotalSeconds();
+}
+
+void AParticleCloudActor::UpdateSurfaceMaterial(bool showSurface)
+{
+	SurfacePostProcess->bEnabled = showSurface;
+	if (!showSurface) {
+		return;
 	}
-	case EColorVisualisation::Velocity:
-	{
-		double maxVelocity = 0.0;
-		double minVelocity = DBL_MAX;
-		double range = 0.0;
 
+	if (SurfaceMaterialInstance == nullptr || SurfaceMaterialInstance->Parent != SurfaceMaterial) {
+		SurfaceMaterialInstance = UMaterialInstanceDynamic::Create(SurfaceMaterial, this);
+		SurfacePostProcess->Settings.WeightedBlendables.Array.Empty();
+		SurfacePostProcess->Settings.AddBlendable(SurfaceMaterialInstance, 1.0f);
+	}
 
-		if (visualisationInformation.AutoLimits) {
-			// compute max and min
-			for (UFluid * fluid : ParticleContext->GetFluids()) {
-				if (fluid->GetNumParticles() > 0) {
-					maxVelocity = std::max(maxVelocity, sqrt(ParallelMax<Particle, double>(*fluid->Particles, [](const Particle& particle) { return particle.Velocity.LengthSquared(); })));
-					minVelocity = std::min(minVelocity, sqrt(ParallelMin<Particle, double>(*fluid->Particles, [](const Particle& particle) { return particle.Velocity.LengthSquared(); })));
-				}
-			}
-			range = maxVelocity - minVelocity;
+	// the target is created by the surface component when it is registered
+	SurfaceMaterialInstance->SetTextureParameterValue(TEXT("SurfaceDepth"), SurfaceComponent->SurfaceTarget);
+}
+
+void AParticleCloudActor::UpdateParticleContextVisualisation(FVisualisationInformation visualisationInformation)
+{
+	// without a material nothing shades the surface, so the particles stay visible as sprites
+	const bool showSurface = visualisationInformation.RenderMode == EParticleRenderMode::ScreenSpaceSurface && SurfaceMaterial != nullptr;
+	if (visualisationInformation.RenderMode == EParticleRenderMode::ScreenSpaceSurface && SurfaceMaterial == nullptr && !SurfaceMaterialWarningShown) {
+		UE_LOG(LogTemp, Warning, TEXT("The screen space surface needs a SurfaceMaterial on the particle cloud, the particles are drawn as sprites."));
+		SurfaceMaterialWarningShown = true;
+	}
+	SurfaceComponent->SetComponentTickEnabled(showSurface);
+	UpdateSurfaceMaterial(showSurface);
+
+	if (showSurface) {
+		// the point cloud is emptied once when switching to the surface
+		if (Points.Num() > 0) {
+			Points.SetNum(0, false);
+			Scalars.SetNum(0, false);
+			UpdatePointCloud();
+		}
+		UpdateSurface(visualisationInformation);
+		return;
+	}
+	if (SurfacePositions.Num() > 0) {
+		SurfacePositions.SetNum(0, false);
+		SurfaceComponent->SetPositions(nullptr, 0);
+	}
+
+	FDateTime conversionStartTime = FDateTime::UtcNow();
+
+	if (visualisationInformation.ColorCode == EColorVisualisation::None) {
+		visualisationInformation.ShowFluids = false;
+		visualisationInformation.ShowStaticBorders = false;
+	}
+
+	int numFluidParticles = 0;
+	for (UFluid* fluid : ParticleContext->GetFluids()) {
+		numFluidParticles += fluid->GetNumParticles();
+	}
+
+	int numParticles = 0;
+	if (visualisationInformation.ShowFluids) {
+		numParticles += numFluidParticles;
+		if (visualisationInformation.ShowPeriodicGhostBorders && ParticleContext->GetPeriodicCondition() != nullptr) {
+			// the solver does not need ghost particles, they are only generated to be shown
+			ParticleContext->GetPeriodicCondition()->UpdateGhostParticles();
+			numParticles += ParticleContext->GetPeriodicCondition()->GetNumGhostParticles();
 		}
-		else {
-			// jut set max and min to the user specified values
-			maxVelocity = visualisationInformation.Max;
-			minVelocity = visualisationInformation.Min;
-			range = maxVelocity - minVelocity;
+	}
+	if (visualisationInformation.ShowStaticBorders) {
+		for (UStaticBorder * staticBorder : ParticleContext->GetStaticBorders()) {
+			numParticles += staticBorder->GetNumParticles();
 		}
+	}
 
-		if (visualisationInformation.ShowFluids) {
+	// keep the allocation, the number of particles rarely changes between frames
+	Points.SetNumUninitialized(numParticles, false);
+	Scalars.SetNumUninitialized(numParticles, false);
+	PointCloud->SpriteSize = FVector2D(ParticleContext->GetParticleDistance() * 10, ParticleContext->GetParticleDistance() * 10);
 
-			// if range is zero all fluid particles have the same velocity and are all colored blue. StaticBorder is anyway colored yellow
-			if (range == 0.0) {
-				for (UFluid * fluid : ParticleContext->GetFluids()) {
-					for (const Particle& particle : *fluid->Particles) {
-						Points.Emplace(static_cast<float>(-particle.Position.X) * 10, static_cast<float>(particle.Position.Y) * 10, static_cast<float>(particle.Position.Z) * 10, 0.f, 1.f, 0.9f);
-					}
-				}
-			}
-			// else the velocity of each particle is used to determine color
-			else {
-				for (UFluid * fluid : ParticleContext->GetFluids()) {
-					for (const Particle& particle : *fluid->Particles) {
-						// on a scale from 0 to 1, how high is the velocity of this particle in relation to all other densities
-						float percentage = (std::max(particle.Velocity.Size(), minVelocity) - minVelocity) / range;
-						Points.Emplace(static_cast<float>(-particle.Position.X) * 10, static_cast<float>(particle.Position.Y) * 10, static_cast<float>(particle.Position.Z) * 10, 1, (1.0 - percentage), (1 - percentage));
-					}
+	// curl is the only scalar which is not stored in the particles, it is only computed while it is shown
+	CurlComputed = visualisationInformation.ColorCode == EColorVisualisation::Curl && visualisationInformation.ShowFluids;
+
+	// calculate all curl values and store them, the scalar functions of fluids get the index of the particle in all fluids
+	std::vector<double> curlValues(CurlComputed ? numFluidParticles : 0);
+
+	if (CurlComputed) {
+		UKernel * kernel = ParticleContext->GetSimulator()->GetKernel();
+		int offset = 0;
+		for (UFluid * fluid : ParticleContext->GetFluids()) {
+			const std::vector<Particle>& particles = *fluid->Particles;
+			ParallelFor(particles.size(), [&](int32 i) {
+				double curl = 0.0;
+				for (const FluidNeighbor& ff : particles[i].FluidNeighbors) {
+					curl += ff.GetParticle()->Mass / ff.GetParticle()->Density * Vector3D::CrossProduct(ff.GetParticle()->Velocity, kernel->ComputeGradient(particles[i], *ff.GetParticle())).Y;
 				}
-			}
-			if (visualisationInformation.ShowPeriodicGhostBorders && ParticleContext->GetPeriodicCondition() != nullptr) {
-				for (const Particle& particle : ParticleContext->GetPeriodicCondition()->GetGhostParticles()) {
-					Points.Emplace(static_cast<float>(-particle.Position.X) * 10, static_cast<float>(particle.Position.Y) * 10, static_cast<float>(particle.Position.Z) * 10, 1.f, 0.4f, 1.f);
-				}
-			}
+				curlValues[offset + i] = curl;
+			});
+			offset += particles.size();
 		}
+	}
 
-		if (visualisationInformation.ShowStaticBorders) {
-			// velocity can't be used to color static Borders
-			for (UStaticBorder * staticBorder : ParticleContext->GetStaticBorders()) {
-				for (const Particle& particle : *staticBorder->Particles) {
-					Points.Emplace(static_cast<float>(-particle.Position.X) * 10, static_cast<float>(particle.Position.Y) * 10, static_cast<float>(particle.Position.Z) * 10, 1.f, 0.4f, 0.f);
-				}
-			}
-		}
+	// all scalars are uploaded with the points, so switching between density, velocity and pressure only changes the ramp
+	auto fluidScalars = [&curlValues](const Particle& particle, int index) {
+		return FVector4(particle.Density, particle.Velocity.Length(), particle.Pressure, curlValues.size() > 0 ? curlValues[index] : PC_NO_SCALAR);
+	};
+
+	switch (visualisationInformation.ColorCode) {
+	case EColorVisualisation::None:
 		break;
 
-	}
 	case EColorVisualisation::VelocityDirection:
+		ConvertParticleContext(visualisationInformation, [](const Particle& particle, int index) {
+			FVector color = (static_cast<FVector>(particle.Velocity.Normalized()) + FVector(1.f, 1.f, 1.f)) * 0.5;
+			return FLinearColor(color.X, color.Y, color.Z);
+		}, fluidScalars);
+		break;
 
-		if (visualisationInformation.ShowFluids) {
-			for (UFluid * fluid : ParticleContext->GetFluids()) {
-				for (const Particle& particle : *fluid->Particles) {
-					FVector color = (static_cast<FVector>(particle.Velocity.Normalized()) + FVector(1.f, 1.f, 1.f)) * 0.5;
-					Points.Emplace(static_cast<float>(-particle.Position.X) * 10, static_cast<float>(particle.Position.Y) * 10, static_cast<float>(particle.Position.Z) * 10, color.X, color.Y, color.Z);
-				}
-			}
+	default:
+		// the ramp is applied on the gpu, fluids keep their color where it doesn't apply
+		ConvertParticleContext(visualisationInformation, [](const Particle& particle, int index) { return FluidColor; }, fluidScalars);
+		break;
+	}
 
-			if (visualisationInformation.ShowPeriodicGhostBorders && ParticleContext->GetPeriodicCondition() != nullptr) {
-				for (const Particle& particle : ParticleContext->GetPeriodicCondition()->GetGhostParticles()) {
-					Points.Emplace(static_cast<float>(-particle.Position.X) * 10, static_cast<float>(particle.Position.Y) * 10, static_cast<float>(particle.Position.Z) * 10, 1.f, 0.4f, 1.f);
-				}
-			}
+	LastConversionTime = (FDateTime::UtcNow() - conversionStartTime).GetTotalSeconds();
 
-		}
-		if (visualisationInformation.ShowStaticBorders) {
-			for (UStaticBorder * staticBorder : ParticleContext->GetStaticBorders()) {
-				for (const Particle& particle : *staticBorder->Particles) {
-					Points.Emplace(static_cast<float>(-particle.Position.X) * 10, static_cast<float>(particle.Position.Y) * 10, static_cast<float>(particle.Position.Z) * 10, 1.f, 0.4f, 0.f);
-				}
-			}
-		}
+	ApplyColorRamp(visualisationInformation);
+
+	// use the new points and update the particle cloud
+	UpdatePointCloud();
+}
+
+void AParticleCloudActor::ApplyColorRamp(const FVisualisationInformation& visualisationInformation)
+{
+	FPointCloudScalarRamp ramp;
 
+	switch (visualisationInformation.ColorCode) {
+	case EColorVisualisation::Density:
+		ramp.ScalarIndex = EParticleScalar::DensityScalar;
+		break;
+
+	case EColorVisualisation::Velocity:
+		ramp.ScalarIndex = EParticleScalar::SpeedScalar;
 		break;
 
 	case EColorVisualisation::Pressure:
-	{
-		double maxPressure = 0.0;
-		double minPressure = DBL_MAX;
-		double range = 0.0;
+		ramp.ScalarIndex = EParticleScalar::PressureScalar;
+		break;
+
+	case EColorVisualisation::Curl:
+		// without curl values the points keep the FluidColor of their fluid
+		ramp.ScalarIndex = CurlComputed ? EParticleScalar::CurlScalar : INDEX_NONE;
+		ramp.LowColor = FLinearColor(0.f, 1.f, 1.f);
+		ramp.MidColor = FLinearColor::White;
+		break;
 
+	default:
+		ramp.ScalarIndex = INDEX_NONE;
+		break;
+	}
 
+	if (ramp.ScalarIndex != INDEX_NONE) {
 		if (visualisationInformation.AutoLimits) {
-			// compute max and min
-			for (UFluid * fluid : ParticleContext->GetFluids()) {
-				if (fluid->GetNumParticles() > 0) {
-					maxPressure = std::max(maxPressure, ParallelMax<Particle, double>(*fluid->Particles, [](const Particle& particle) { return particle.Pressure; }));
-					minPressure = std::min(minPressure, ParallelMin<Particle, double>(*fluid->Particles, [](const Particle& particle) { return particle.Pressure; }));
-				}
-			}
+			ramp.Min = ScalarMin[ramp.ScalarIndex];
+			ramp.Max = ScalarMax[ramp.ScalarIndex];
 
-			for (UStaticBorder * staticBorder : ParticleContext->GetStaticBorders()) {
-				if (staticBorder->GetNumParticles() > 0) {
-					maxPressure = std::max(maxPressure, ParallelMax<Particle, double>(*staticBorder->Particles, [](const Particle& particle) { return particle.Pressure; }));
-					minPressure = std::min(minPressure, ParallelMin<Particle, double>(*staticBorder->Particles, [](const Particle& particle) { return particle.Pressure; }));
-				}
+			// white is no curl, so the limits are symmetric
+			if (ramp.ScalarIndex == EParticleScalar::CurlScalar) {
+				ramp.Max = std::max(FMath::Abs(ramp.Min), FMath::Abs(ramp.Max));
+				ramp.Min = -ramp.Max;
 			}
-			range = maxPressure - minPressure;
 		}
 		else {
 			// jut set max and min to the user specified values
-			maxPressure = visualisationInformation.Max;
-			minPressure = visualisationInformation.Min;
-			range = maxPressure - minPressure;
-		}
-
-		// if range is zero all particles have the same pressure and are all colored blue. StaticBorder is anyway colored yellow
-		if (range == 0.0) {
-			if (visualisationInformation.ShowFluids) {
-				for (UFluid * fluid : ParticleContext->GetFluids()) {
-					for (const Particle& particle : *fluid->Particles) {
-						Points.Emplace(static_cast<float>(-particle.Position.X) * 10, static_cast<float>(particle.Position.Y) * 10, static_cast<float>(particle.Position.Z) * 10, 1.f, 1.f, 1.f);
-					}
-				}
-			}
-			if (visualisationInformation.ShowStaticBorders) {
-				for (UStaticBorder * staticBorder : ParticleContext->GetStaticBorders()) {
-					for (const Particle& particle : *staticBorder->Particles) {
-						// on a scale from 0 to 1, how high is the pressure of this particle in relation to all other pressures
-						float percentage = (std::max(particle.Pressure, minPressure) - minPressure) / range;
-						Points.Emplace(static_cast<float>(-particle.Position.X) * 10, static_cast<float>(particle.Position.Y) * 10, static_cast<float>(particle.Position.Z) * 10, 1.f, 1.f, 1.f);
-					}
-				}
-			}
-			if (visualisationInformation.ShowPeriodicGhostBorders && ParticleContext->GetPeriodicCondition() != nullptr) {
-				for (const Particle& particle : ParticleContext->GetPeriodicCondition()->GetGhostParticles()) {
-					Points.Emplace(static_cast<float>(-particle.Position.X) * 10, static_cast<float>(particle.Position.Y) * 10, static_cast<float>(particle.Position.Z) * 10, 1.f, 0.4f, 1.f);
-				}
-			}
-		}
-		// else the pressure of each particle is used to determine color
-		else {
-			if (visualisationInformation.ShowFluids) {
-				for (UFluid * fluid : ParticleContext->GetFluids()) {
-					for (const Particle& particle : *fluid->Particles) {
-						// on a scale from 0 to 1, how high is the pressure of this particle in relation to all other densities
-						float percentage = (std::max(particle.Pressure, minPressure) - minPressure) / range;
-						Points.Emplace(static_cast<float>(-particle.Position.X) * 10, static_cast<float>(particle.Position.Y) * 10, static_cast<float>(particle.Position.Z) * 10, 1, (1.0 - percentage), (1 - percentage));
-					}
-				}
-			}
-			if (visualisationInformation.ShowStaticBorders) {
-				for (UStaticBorder * staticBorder : ParticleContext->GetStaticBorders()) {
-					for (const Particle& particle : *staticBorder->Particles) {
-						// on a scale from 0 to 1, how high is the pressure of this particle in relation to all other densities
-						float percentage = (std::max(particle.Pressure, minPressure) - minPressure) / range;
-						Points.Emplace(static_cast<float>(-particle.Position.X) * 10, static_cast<float>(particle.Position.Y) * 10, static_cast<float>(particle.Position.Z) * 10, 1, (1.0 - percentage), (1 - percentage));
-					}
-				}
-			}
+			ramp.Min = visualisationInformation.Min;
+			ramp.Max = visualisationInformation.Max;
 		}
-
-		break;
 	}
 
-	case EColorVisualisation::Curl:
-	{
-		if (visualisationInformation.ShowFluids) {
-
-			// calculate all curl values and store them
-			UKernel * kernel = ParticleContext->GetSimulator()->GetKernel();
-			std::vector<double> curlValues;
-			for (UFluid * fluid : ParticleContext->GetFluids()) {
-				for (const Particle& particle : *fluid->Particles) {
-					double curl = 0.0;
-					for (const FluidNeighbor& ff : particle.FluidNeighbors) {
-						curl += ff.GetParticle()->Mass / ff.GetParticle()->Density * Vector3D::CrossProduct(ff.GetParticle()->Velocity, kernel->ComputeGradient(particle, *ff.GetParticle())).Y;
-					}
-					curlValues.push_back(curl);
-				}
-			}
+	// the scalars are dropped in low precision, so the points keep their own color
+	if (ramp.ScalarIndex != INDEX_NONE && PointCloud->UsesLowPrecision() && !ColorRampWarningShown) {
+		UE_LOG(LogTemp, Warning, TEXT("Color coding the particles needs the point cloud in full precision, the particles keep their fluid color."));
+		ColorRampWarningShown = true;
+	}
 
-			double maxCurl = 0.0;
-			double minCurl = DBL_MAX;
-			double range = 0.0;
+	// a ramp without range leaves all points in their own color
+	PointCloud->ScalarRamp = ramp;
+	PointCloud->ApplyRenderingParameters();
+}
 
+void AParticleCloudActor::GetScalarLimits(const TArray<FVector4>& scalars, FVector4& scalarMin, FVector4& scalarMax)
+{
+	const int numBatches = GetNumBatches(scalars.Num());
+	const int batchSize = (scalars.Num() + numBatches - 1) / numBatches;
 
-			if (visualisationInformation.AutoLimits && curlValues.size() > 0) {
-				// compute max and min
-				maxCurl = ParallelMax<double>(curlValues);
-				minCurl = ParallelMin<double>(curlValues);
-				range = maxCurl - minCurl;
-			}
-			else {
-				// jut set max and min to the user specified values
-				maxCurl = visualisationInformation.Max;
-				minCurl = visualisationInformation.Min;
-				range = maxCurl - minCurl;
-			}
+	std::vector<FVector4> batchMin(numBatches, FVector4(MAX_FLT, MAX_FLT, MAX_FLT, MAX_FLT));
+	std::vector<FVector4> batchMax(numBatches, FVector4(-MAX_FLT, -MAX_FLT, -MAX_FLT, -MAX_FLT));
 
-			// if range is zero all fluid particles have the same curl and are all colored white.
-			if (range == 0.0) {
-				if (visualisationInformation.ShowFluids) {
-					for (UFluid * fluid : ParticleContext->GetFluids()) {
-						for (const Particle& particle : *fluid->Particles) {
-							Points.Emplace(static_cast<float>(-particle.Position.X) * 10, static_cast<float>(particle.Position.Y) * 10, static_cast<float>(particle.Position.Z) * 10, 1.f, 1.f, 1.f);
-						}
-					}
-				}
-			}
-			// else the curl of each fluid particle is used to determine color
-			else {
-				int i = 0;
-				if (visualisationInformation.ShowFluids) {
-					for (UFluid * fluid : ParticleContext->GetFluids()) {
-						for (const Particle& particle : *fluid->Particles) {
-							// on a scale from 0 to 2, how high is the pressure of this particle in relation to all other densities
-							float percentage = (std::max(curlValues[i], minCurl) / range + 1);
-							Points.Emplace(static_cast<float>(-particle.Position.X) * 10, static_cast<float>(particle.Position.Y) * 10, static_cast<float>(particle.Position.Z) * 10, std::min(percentage, 1.0f), std::min(2.f - percentage, 1.0f), std::min(2.f - percentage, 1.0f));
-							i++;
-						}
-					}
-				}
-			}
+	ParallelFor(numBatches, [&](int32 batch) {
+		const int end = std::min(scalars.Num(), (batch + 1) * batchSize);
+		for (int i = batch * batchSize; i < end; i++) {
+			ExpandScalarLimits(scalars[i], batchMin[batch], batchMax[batch]);
 		}
+	});
 
-		// StaticBorder is anyway colored yellow
-		if (visualisationInformation.ShowStaticBorders) {
-			for (UStaticBorder * staticBorder : ParticleContext->GetStaticBorders()) {
-				for (const Particle& particle : *staticBorder->Particles) {
-					Points.Emplace(static_cast<float>(-particle.Position.X) * 10, static_cast<float>(particle.Position.Y) * 10, static_cast<float>(particle.Position.Z) * 10, 1.f, 0.4f, 0.f);
-				}
-			}
-		}
+	scalarMin = batchMin[0];
+	scalarMax = batchMax[0];
+	for (int batch = 1; batch < numBatches; batch++) {
+		MergeScalarLimits(batchMin[batch], batchMax[batch], scalarMin, scalarMax);
+	}
+}
 
-		// Ghost particles are colored pink
-		if (visualisationInformation.ShowPeriodicGhostBorders && ParticleContext->GetPeriodicCondition() != nullptr) {
-			for (const Particle& particle : ParticleContext->GetPeriodicCondition()->GetGhostParticles()) {
-				Points.Emplace(static_cast<float>(-particle.Position.X) * 10, static_cast<float>(particle.Position.Y) * 10, static_cast<float>(particle.Position.Z) * 10, 1.f, 0.4f, 1.f);
-			}
-		}
+float AParticleCloudActor::GetLastConversionTime() const
+{
+	return LastConversionTime;
+}
 
-		break;
-		}
-	}
-	// use the new points and rebuild the particle cloud
-	UpdatePointCloud();
-	
+float AParticleCloudActor::GetLastUploadTime() const
+{
+	return LastUploadTime;
+}
+
+int AParticleCloudActor::GetLastAggregatedCellCount() const
+{
+	return LastAggregatedCellCount;
 }
@@ -10,8 +10,12 @@
 #include "PointCloud.h"
 #include "PointCloudShared.h"
 #include "PointCloudActor.h"
+#include "PointCloudSurfaceComponent.h"
+#include "Components/PostProcessComponent.h"
+#include "Materials/MaterialInstanceDynamic.h"
 
 #include "DataStructures/Utility.h"
+#include "Runtime/Core/Public/Async/ParallelFor.h"
 
 #include "Particles/Particle.h"
 
@@ -32,6 +36,24 @@ enum EColorVisualisation {
 };
 
 
+UENUM(BlueprintType)
+enum EParticleRenderMode {
+	// every particle is drawn as a sprite of the point cloud
+	PointSprites,
+	// the fluid surface is reconstructed in screen space from the raw positions, no points are built
+	ScreenSpaceSurface
+};
+
+
+// Components of the scalar attributes each point carries. The color ramp of the point cloud colors one of them on the gpu
+enum EParticleScalar {
+	DensityScalar,
+	SpeedScalar,
+	PressureScalar,
+	CurlScalar
+};
+
+
 USTRUCT(BlueprintType)
 struct FVisualisationInformation {
 	GENERATED_BODY()
@@ -55,6 +77,13 @@ struct FVisualisationInformation {
 
 	UPROPERTY(BlueprintReadWrite)
 		bool ShowPeriodicGhostBorders = true;
+
+	UPROPERTY(BlueprintReadWrite)
+		TEnumAsByte<EParticleRenderMode> RenderMode = EParticleRenderMode::PointSprites;
+
+	// Fluid particles in cells of the neighbor search further away from the camera than this distance (in cm) are drawn as one averaged point per cell. 0 draws all particles
+	UPROPERTY(BlueprintReadWrite)
+		float LODDistance = 0.0;
 };
 
 
@@ -81,14 +110,110 @@ public:
 
 	void VisualisePositions(const std::vector<std::vector<Vector3D>>& positions, const std::vector<std::vector<Vector3D>>& velocities, double size, EColorVisualisation colorMethod);
 
+	// Shows vertices that are already in the layout of the vertex buffer. They are written straight into the vertex buffer if the number of points did not change,
+	// otherwise the cloud is rebuilt from them once. The scalars, one per vertex or none, are colored with the limits given
+	void VisualiseVertices(const TArray<FPointCloudVertex>& vertices, const TArray<FVector4>& scalars, const FVector4& scalarMin, const FVector4& scalarMax, double size);
+
 	void SetVisibilityOfCloud(bool newVisibility);
 
 	void UpdateParticleContextVisualisation(FVisualisationInformation visualisationInformations);
 
+	// Colors the points of the last update by the color code and limits on the gpu, without converting them again.
+	// Modes that are not based on the scalars of the points, like velocity direction, show the plain colors until the next update
+	void ApplyColorRamp(const FVisualisationInformation& visualisationInformation);
+
+	// Minimum and maximum of each component over the scalars which have a value
+	static void GetScalarLimits(const TArray<FVector4>& scalars, FVector4& scalarMin, FVector4& scalarMax);
+
+	// Time in seconds the last conversion of particles to points took
+	UFUNCTION(BlueprintPure)
+		float GetLastConversionTime() const;
+
+	// Time in seconds the last update of the point cloud took
+	UFUNCTION(BlueprintPure)
+		float GetLastUploadTime() const;
+
+	// Number of cells drawn as a single point in the last conversion
+	UFUNCTION(BlueprintPure)
+		int GetLastAggregatedCellCount() const;
+
+	// Post process material shading the surface depth, which it gets as its SurfaceDepth texture parameter. The screen space surface mode keeps drawing sprites until it is set
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+		UMaterialInterface * SurfaceMaterial = nullptr;
+
 protected:
 
+	template <typename ParticleType>
+	void VisualiseParticleVectors(const std::vector<const std::vector<ParticleType>*>& particles, double size, EColorVisualisation colorMethod, double restDensity);
+
+	// Writes the particles in parallel into the already sized points, starting at offset. The color function gets the particle and the index of its point
+	template <typename ParticleType, typename ColorFunction>
+	void ConvertParticles(const std::vector<ParticleType>& particles, int offset, const ColorFunction& colorFunction);
+
+	// Also writes the scalars of the particles and grows the scalar limits by them
+	template <typename ParticleType, typename ColorFunction, typename ScalarFunction>
+	void ConvertParticles(const std::vector<ParticleType>& particles, int offset, const ColorFunction& colorFunction, const ScalarFunction& scalarFunction);
+
+	// Writes the particles of a fluid near the camera as points and the ones in far cells of the neighbor search as one averaged point per cell, starting at offset.
+	// Like ConvertParticles every particle has a point, the averaged point is the one of the first particle in the cell and the other points of far particles are disabled.
+	// The color and scalar functions get the index of the particle in all fluids
+	template <typename ColorFunction, typename ScalarFunction>
+	void ConvertFluidWithLOD(const std::vector<Particle>& particles, int offset, int fluidOffset, const FVector& cameraLocation, double lodDistance, const ColorFunction& colorFunction, const ScalarFunction& scalarFunction);
+
+	// Grows the scalar limits by the particles without converting them. The scalar function gets the particle and its index plus indexOffset
+	template <typename ScalarFunction>
+	void GrowScalarLimits(const std::vector<Particle>& particles, int indexOffset, const ScalarFunction& scalarFunction);
+
+	// Writes the positions of the periodic ghost particles without scalars, starting at offset
+	void ConvertGhostParticles(const std::vector<Vector3D>& positions, int offset);
+
+	// Writes fluids, periodic ghosts and static borders of the particle context in this order into the already sized points and scalars
+	template <typename FluidColorFunction, typename FluidScalarFunction>
+	void ConvertParticleContext(const FVisualisationInformation& visualisationInformation, const FluidColorFunction& fluidColor, const FluidScalarFunction& fluidScalars);
+
+	// Uploads the fluid positions to the surface component, bypassing the point cloud
+	void UpdateSurface(const FVisualisationInformation& visualisationInformation);
+
+	// Blends the surface material into the view while the surface is shown
+	void UpdateSurfaceMaterial(bool showSurface);
+
+	// Returns false if there is no player camera to measure the distance of the particles to
+	bool GetCameraLocation(FVector& cameraLocation) const;
+
+	double LastConversionTime = 0.0;
+	double LastUploadTime = 0.0;
+	int LastAggregatedCellCount = 0;
+
 	TArray<FPointCloudPoint> Points;
 
+	// density, speed, pressure and curl of each point, see EParticleScalar. Empty if the points are only colored on the cpu
+	TArray<FVector4> Scalars;
+
+	// limits of the scalars of the last update, used for automatic limits
+	FVector4 ScalarMin;
+	FVector4 ScalarMax;
+
+	// the curl needs a loop over the neighbors of each particle, so it is only computed while it is shown
+	bool CurlComputed = false;
+
+	// raw positions for the screen space surface, kept to reuse the allocation
+	TArray<FVector> SurfacePositions;
+
+	UPROPERTY()
+		UPointCloudSurfaceComponent * SurfaceComponent;
+
+	UPROPERTY()
+		UPostProcessComponent * SurfacePostProcess;
+
+	UPROPERTY()
+		UMaterialInstanceDynamic * SurfaceMaterialInstance = nullptr;
+
+	// the missing surface material is only reported once
+	bool SurfaceMaterialWarningShown = false;
+
+	// the missing color coding in low precision is only reported once
+	bool ColorRampWarningShown = false;
+
 	UPointCloud * PointCloud;
 
 	// The particle Context this point cloud should visualize
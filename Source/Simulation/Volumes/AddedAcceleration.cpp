@@ -2,6 +2,7 @@
 
 AAddedAcceleration::AAddedAcceleration() {
 	VolumeType = EVolumeType::AddedAcceleration;
+	AffectsParticles = true;
 	Acceleration = { 0, 0 ,0 };
 
 	ArrowComponent = CreateDefaultSubobject<UArrowComponent>(TEXT("Arrow"));
@@ -14,20 +15,10 @@ AAddedAcceleration::~AAddedAcceleration()
 {
 }
 
-void AAddedAcceleration::ApplyBeforeIntegration(UParticleContext & particleContext, double timestep, double simulationTime)
+void AAddedAcceleration::ApplyToParticle(Particle & particle, double timestep, double simulationTime)
 {
-	if (IsEnabled) {
-		for (UFluid * fluid : particleContext.GetFluids()) {
-			ParallelFor(fluid->Particles->size(), [&](int32 i) {
-				Particle& particle = fluid->Particles->at(i);
-
-				if (IsParticleAffected(particle)) {
-					particle.Velocity += timestep * static_cast<Vector3D>(Acceleration);
-					particle.Position += pow(timestep, 2) * static_cast<Vector3D>(Acceleration);
-				}
-			});
-		}
-	}
+	particle.Velocity += timestep * static_cast<Vector3D>(Acceleration);
+	particle.Position += pow(timestep, 2) * static_cast<Vector3D>(Acceleration);
 }
 
 void AAddedAcceleration::OnConstruction(const FTransform & Transform)
@@ -13,7 +13,7 @@ public:
 
 	~AAddedAcceleration() override;
 
-	void ApplyBeforeIntegration(UParticleContext & particleContext, double timestep, double simulationTime) override;
+	void ApplyToParticle(Particle& particle, double timestep, double simulationTime) override;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	FVector Acceleration;
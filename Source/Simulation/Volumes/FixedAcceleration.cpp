@@ -2,6 +2,7 @@
 
 AFixedAcceleration::AFixedAcceleration() {
 	VolumeType = EVolumeType::FixedAcceleration;
+	AffectsParticles = true;
 	Acceleration = { 0, 0 ,0 };
 
 	ArrowComponent = CreateDefaultSubobject<UArrowComponent>(TEXT("Arrow"));
@@ -14,23 +15,13 @@ AFixedAcceleration::~AFixedAcceleration()
 {
 }
 
-void AFixedAcceleration::ApplyBeforeIntegration(UParticleContext & particleContext, double timestep, double simulationTime)
+void AFixedAcceleration::ApplyToParticle(Particle & particle, double timestep, double simulationTime)
 {
-	if (IsEnabled) {
-		for (UFluid * fluid : particleContext.GetFluids()) {
-			ParallelFor(fluid->Particles->size(), [&](int32 i) {
-				Particle& particle = fluid->Particles->at(i);
-
-				if (IsParticleAffected(particle)) {
-					particle.IsScripted = true;
-					particle.Acceleration = Acceleration;
-					if (Integrate) {
-						particle.Velocity += timestep * static_cast<Vector3D>(Acceleration);
-						particle.Position += timestep * particle.Velocity;
-					}
-				}
-			});
-		}
+	particle.IsScripted = true;
+	particle.Acceleration = Acceleration;
+	if (Integrate) {
+		particle.Velocity += timestep * static_cast<Vector3D>(Acceleration);
+		particle.Position += timestep * particle.Velocity;
 	}
 }
 
@@ -17,7 +17,7 @@ public:
 
 	~AFixedAcceleration() override;
 
-	void ApplyBeforeIntegration(UParticleContext & particleContext, double timestep, double simulationTime) override;
+	void ApplyToParticle(Particle& particle, double timestep, double simulationTime) override;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	FVector Acceleration;
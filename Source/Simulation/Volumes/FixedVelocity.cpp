@@ -2,6 +2,7 @@
 
 AFixedVelocity::AFixedVelocity() {
 	VolumeType = EVolumeType::FixedVelocity;
+	AffectsParticles = true;
 	Velocity = { 0, 0 ,0 };
 
 	ArrowComponent = CreateDefaultSubobject<UArrowComponent>(TEXT("Arrow"));
@@ -14,23 +15,13 @@ AFixedVelocity::~AFixedVelocity()
 {
 }
 
-void AFixedVelocity::ApplyBeforeIntegration(UParticleContext & particleContext, double timestep, double simulationTime)
+void AFixedVelocity::ApplyToParticle(Particle & particle, double timestep, double simulationTime)
 {
-	if (IsEnabled) {
-		for (UFluid * fluid : particleContext.GetFluids()) {
-			ParallelFor(fluid->Particles->size(), [&](int32 i) {
-				Particle& particle = fluid->Particles->at(i);
-
-				if (IsParticleAffected(particle)) {
-					particle.IsScripted = true;
-					particle.Acceleration = Vector3D(0.0);
-					particle.Velocity = Velocity;
-					if (Integrate) {
-						particle.Position += timestep * particle.Velocity;
-					}
-				}
-			});
-		}
+	particle.IsScripted = true;
+	particle.Acceleration = Vector3D(0.0);
+	particle.Velocity = Velocity;
+	if (Integrate) {
+		particle.Position += timestep * particle.Velocity;
 	}
 }
 
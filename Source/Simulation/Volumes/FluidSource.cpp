@@ -2,6 +2,7 @@
 
 AFluidSource::AFluidSource() : LastSpawnTime(0.0f), NextSpawnTime(0.0f) {
 	VolumeType = EVolumeType::FixedVelocity;
+	AffectsParticles = true;
 	Velocity = 1;
 	FirstSpawn = true;
 
@@ -66,23 +67,13 @@ void AFluidSource::Build(UWorld * world, UParticleContext & particleContext)
 }
 
 
-void AFluidSource::ApplyBeforeIntegration(UParticleContext & particleContext, double timestep, double simulationTime)
+void AFluidSource::ApplyToParticle(Particle & particle, double timestep, double simulationTime)
 {
-	if (IsEnabled) {
-		// move particles with specified velocity
-		for (UFluid * fluid : particleContext.GetFluids()) {
-			ParallelFor(fluid->Particles->size(), [&](int32 i) {
-				Particle& particle = fluid->Particles->at(i);
-
-				if (IsParticleAffected(particle)) {
-					particle.IsScripted = true;
-					particle.Acceleration = Vector3D(0, 0, 0);
-					particle.Velocity = GetActorUpVector() * Velocity;
-					particle.Position += timestep * particle.Velocity;
-				}
-			});
-		}
-	}
+	// move particles with specified velocity
+	particle.IsScripted = true;
+	particle.Acceleration = Vector3D(0, 0, 0);
+	particle.Velocity = GetActorUpVector() * Velocity;
+	particle.Position += timestep * particle.Velocity;
 }
 
 void AFluidSource::ApplyAfterIntegration(UParticleContext & particleContext, double timestep, double simulationTime)
@@ -15,7 +15,7 @@ public:
 
 	void Build(UWorld * world, UParticleContext & particleContext) override;
 
-	void ApplyBeforeIntegration(UParticleContext & particleContext, double timestep, double simulationTime) override;
+	void ApplyToParticle(Particle& particle, double timestep, double simulationTime) override;
 	void ApplyAfterIntegration(UParticleContext & particleContext, double timestep, double simulationTime) override;
 
 	double MaxTimeStep(double timestepFactor, const UParticleContext & particleContext) const override;
@@ -2,6 +2,7 @@
 
 APointGravityVolume::APointGravityVolume() {
 	VolumeType = EVolumeType::AddedAcceleration;
+	AffectsParticles = true;
 	Midpoint = { 0, 0 ,0 };
 	Magnitude = 10.0;
 
@@ -16,20 +17,10 @@ APointGravityVolume::APointGravityVolume() {
 APointGravityVolume::~APointGravityVolume() {
 }
 
-void APointGravityVolume::ApplyBeforeIntegration(UParticleContext & particleContext, double timestep, double simulationTime)
+void APointGravityVolume::ApplyToParticle(Particle & particle, double timestep, double simulationTime)
 {
-	if (IsEnabled) {
-		for (UFluid * fluid : particleContext.GetFluids()) {
-			ParallelFor(fluid->Particles->size(), [&](int32 i) {
-				Particle& particle = fluid->Particles->at(i);
-
-				if (IsParticleAffected(particle)) {
-					particle.Velocity += timestep * (static_cast<Vector3D>(Midpoint) - particle.Position).Normalized() * Magnitude;
-					particle.Position += pow(timestep, 2) * (static_cast<Vector3D>(Midpoint) - particle.Position).Normalized() * Magnitude;
-				}
-			});
-		}
-	}
+	particle.Velocity += timestep * (static_cast<Vector3D>(Midpoint) - particle.Position).Normalized() * Magnitude;
+	particle.Position += pow(timestep, 2) * (static_cast<Vector3D>(Midpoint) - particle.Position).Normalized() * Magnitude;
 }
 
 void APointGravityVolume::OnConstruction(const FTransform & Transform)
@@ -0,0 +1,10 @@
+#include "RegionOfInterestVolume.h"
+
+ARegionOfInterestVolume::ARegionOfInterestVolume() {
+	VolumeType = EVolumeType::RegionOfInterest;
+	SetActorHiddenInGame(true);
+}
+
+ARegionOfInterestVolume::~ARegionOfInterestVolume()
+{
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include "ScriptedVolume.h"
+
+#include "CoreMinimal.h"
+
+#include "RegionOfInterestVolume.generated.h"
+
+// Marks the region the simulation is observed in. Inside full accuracy applies, outside the solver may run at reduced fidelity
+UCLASS()
+class ARegionOfInterestVolume : public AScriptedVolume {
+	GENERATED_BODY()
+public:
+	ARegionOfInterestVolume();
+
+	~ARegionOfInterestVolume() override;
+
+	// Factor the density and divergence error tolerances of pressure solvers are loosened with outside of the region
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float OutsideToleranceFactor = 10.0f;
+
+	// Freezes particles outside of the region. They are put to sleep and only woken by active neighbors if sleeping particles are enabled
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	bool FreezeOutside = false;
+
+	// Keeps the finest particle resolution inside of the region if adaptive resolution is used
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	bool RefineInside = true;
+};
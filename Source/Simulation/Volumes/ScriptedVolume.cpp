@@ -35,6 +35,21 @@ void AScriptedVolume::Build(UWorld * world, UParticleContext & particleContext)
 }
 
 void AScriptedVolume::ApplyBeforeIntegration(UParticleContext & particleContext, double timestep, double simulationTime)
+{
+	if (IsEnabled && AffectsParticles) {
+		for (UFluid * fluid : particleContext.GetFluids()) {
+			ParallelFor(fluid->Particles->size(), [&](int32 i) {
+				Particle& particle = fluid->Particles->at(i);
+
+				if (IsParticleAffected(particle)) {
+					ApplyToParticle(particle, timestep, simulationTime);
+				}
+			});
+		}
+	}
+}
+
+void AScriptedVolume::ApplyToParticle(Particle & particle, double timestep, double simulationTime)
 {
 }
 
@@ -55,19 +70,20 @@ EVolumeType AScriptedVolume::GetVolumeType()
 
 bool AScriptedVolume::IsAffected(const Vector3D & position) const
 {
-
-	const FVector fPosition = position * 10;
-	// Multiply by 10 since transforms and positions of Volumes are given in unreal units (10cm)
-	const FVector temp = GetActorTransform().InverseTransformPosition(fPosition);
-	
 	bool inside = true;
-	switch (VolumeForm) {
-	case Cuboid:
-		inside = temp.X < 100 && temp.X > -100 && temp.Y < 100 && temp.Y > -100 && temp.Z < 100 && temp.Z > -100;
+	switch (GetCellCoverage(position)) {
+	case ECellCoverage::Inside:
+		inside = true;
 		break;
 
-	case Cylinder:
-		inside = (temp.X * temp.X) + (temp.Y * temp.Y) < 10000 && temp.Z < 100 && temp.Z > -100;
+	case ECellCoverage::Outside:
+		inside = false;
+		break;
+
+	case ECellCoverage::Boundary:
+		// Multiply by 10 since transforms and positions of Volumes are given in unreal units (10cm)
+		const FVector fPosition = position * 10;
+		inside = IsInsideShape(VolumeForm, GetActorTransform().InverseTransformPosition(fPosition));
 		break;
 	}
 
@@ -81,7 +97,112 @@ bool AScriptedVolume::IsAffected(const Vector3D & position) const
 
 bool AScriptedVolume::IsParticleAffected(const Particle & particle) const
 {
-	return IsAffected(particle.Position);
+	// removed particles must not be woken up by scripting them
+	return !particle.IsRemoved && IsAffected(particle.Position);
+}
+
+void AScriptedVolume::Rasterize(double cellSize)
+{
+	if (IsRasterized(cellSize)) {
+		return;
+	}
+
+	CellSize = cellSize;
+	RasterizedForm = VolumeForm;
+	RasterizedTransform = GetActorTransform();
+
+	// bounds of the volume in simulation units
+	const FBox bounds = FBox(FVector(-100.f), FVector(100.f)).TransformBy(RasterizedTransform);
+	const Vector3D boundsMin = Vector3D(bounds.Min) / 10.0;
+	const Vector3D boundsMax = Vector3D(bounds.Max) / 10.0;
+
+	CellMin[0] = floor(boundsMin.X / cellSize);
+	CellMin[1] = floor(boundsMin.Y / cellSize);
+	CellMin[2] = floor(boundsMin.Z / cellSize);
+	CellCounts[0] = (int)floor(boundsMax.X / cellSize) - CellMin[0] + 1;
+	CellCounts[1] = (int)floor(boundsMax.Y / cellSize) - CellMin[1] + 1;
+	CellCounts[2] = (int)floor(boundsMax.Z / cellSize) - CellMin[2] + 1;
+
+	// huge volumes are not rasterised, all their particles get the precise test
+	const int64 numCells = (int64)CellCounts[0] * CellCounts[1] * CellCounts[2];
+	if (numCells > MaxRasterizedCells) {
+		CellCoverage.clear();
+		return;
+	}
+	CellCoverage.resize(numCells);
+
+	// a sphere around a cell is an axis aligned ellipsoid in the local space of the volume, its bounding box is tested against the shape
+	const FVector scale = RasterizedTransform.GetScale3D();
+	const float cellRadius = 0.5f * FMath::Sqrt(3.f) * cellSize * 10;
+	const FVector localExtent(cellRadius / FMath::Max(FMath::Abs(scale.X), KINDA_SMALL_NUMBER),
+		cellRadius / FMath::Max(FMath::Abs(scale.Y), KINDA_SMALL_NUMBER),
+		cellRadius / FMath::Max(FMath::Abs(scale.Z), KINDA_SMALL_NUMBER));
+
+	ParallelFor(numCells, [&](int32 cell) {
+		const int x = cell % CellCounts[0];
+		const int y = (cell / CellCounts[0]) % CellCounts[1];
+		const int z = cell / (CellCounts[0] * CellCounts[1]);
+		const FVector cellMin = FVector(CellMin[0] + x, CellMin[1] + y, CellMin[2] + z) * cellSize * 10;
+
+		const FVector localCenter = RasterizedTransform.InverseTransformPosition(cellMin + FVector(0.5f * cellSize * 10));
+		if (!OverlapsShape(RasterizedForm, localCenter, localExtent)) {
+			CellCoverage[cell] = ECellCoverage::Outside;
+			return;
+		}
+
+		// the shapes are convex, so a cell is inside if all its corners are
+		bool allCornersInside = true;
+		for (int corner = 0; corner < 8 && allCornersInside; corner++) {
+			const FVector cornerPosition = cellMin + FVector(corner & 1, (corner >> 1) & 1, (corner >> 2) & 1) * cellSize * 10;
+			allCornersInside = IsInsideShape(RasterizedForm, RasterizedTransform.InverseTransformPosition(cornerPosition));
+		}
+		CellCoverage[cell] = allCornersInside ? ECellCoverage::Inside : ECellCoverage::Boundary;
+	});
+}
+
+bool AScriptedVolume::IsInsideShape(EVolumeForm form, const FVector& localPosition)
+{
+	switch (form) {
+	case Cylinder:
+		return (localPosition.X * localPosition.X) + (localPosition.Y * localPosition.Y) < 10000 && localPosition.Z < 100 && localPosition.Z > -100;
+
+	default:
+		return localPosition.X < 100 && localPosition.X > -100 && localPosition.Y < 100 && localPosition.Y > -100 && localPosition.Z < 100 && localPosition.Z > -100;
+	}
+}
+
+bool AScriptedVolume::OverlapsShape(EVolumeForm form, const FVector& localCenter, const FVector& localExtent)
+{
+	switch (form) {
+	case Cylinder:
+		return FMath::Abs(localCenter.Z) - localExtent.Z < 100 && FVector2D(localCenter.X, localCenter.Y).Size() - FMath::Max(localExtent.X, localExtent.Y) < 100;
+
+	default:
+		return FMath::Abs(localCenter.X) - localExtent.X < 100 && FMath::Abs(localCenter.Y) - localExtent.Y < 100 && FMath::Abs(localCenter.Z) - localExtent.Z < 100;
+	}
+}
+
+bool AScriptedVolume::IsRasterized(double cellSize) const
+{
+	return cellSize == CellSize && VolumeForm == RasterizedForm && GetActorTransform().Equals(RasterizedTransform, 0.f);
+}
+
+ECellCoverage AScriptedVolume::GetCellCoverage(const Vector3D& position) const
+{
+	// volumes which are not rasterised or were changed or moved since test every particle precisely. The cells are looked up with the size they were rasterised for
+	if (CellCoverage.empty() || !IsRasterized(CellSize)) {
+		return ECellCoverage::Boundary;
+	}
+
+	const int x = (int)floor(position.X / CellSize) - CellMin[0];
+	const int y = (int)floor(position.Y / CellSize) - CellMin[1];
+	const int z = (int)floor(position.Z / CellSize) - CellMin[2];
+
+	// cells outside the bounds of the volume are outside
+	if (x < 0 || y < 0 || z < 0 || x >= CellCounts[0] || y >= CellCounts[1] || z >= CellCounts[2]) {
+		return ECellCoverage::Outside;
+	}
+	return CellCoverage[x + CellCounts[0] * (y + CellCounts[1] * z)];
 }
 
 void AScriptedVolume::SetEnabled(bool enabled)
@@ -94,6 +215,11 @@ bool AScriptedVolume::GetEnabled() const
 	return IsEnabled;
 }
 
+bool AScriptedVolume::GetAffectsParticles() const
+{
+	return AffectsParticles;
+}
+
 void AScriptedVolume::OnConstruction(const FTransform& Transform) {
 	
 	switch (VolumeForm) {
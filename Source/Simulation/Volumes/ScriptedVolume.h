@@ -15,7 +15,8 @@ enum EVolumeType {
 	FixedVelocity,
 	ShearWaveVelocity,
 	Source,
-	Kill
+	Kill,
+	RegionOfInterest
 };
 
 UENUM(BlueprintType)
@@ -24,6 +25,13 @@ enum EVolumeForm {
 	Cylinder
 };
 
+// How a cell of the neighbor search is covered by a volume
+enum class ECellCoverage : uint8 {
+	Outside,
+	Boundary,
+	Inside
+};
+
 UCLASS()
 class AScriptedVolume : public AActor {
 	GENERATED_BODY()
@@ -38,6 +46,9 @@ public:
 	// For modifications that influence fluid dynamics
 	virtual void ApplyBeforeIntegration(UParticleContext& particleContext, double timestep, double simulationTime);
 
+	// Effect on a single affected particle. The solver applies all volumes with such an effect in one pass over the particles
+	virtual void ApplyToParticle(Particle& particle, double timestep, double simulationTime);
+
 	// for adding / removing particles what can not happen during a simulation step
 	virtual void ApplyAfterIntegration(UParticleContext& particleContext, double timestep, double simulationTime);
 
@@ -56,16 +67,25 @@ public:
 	bool IsAffected(const Vector3D& position) const;
 	bool IsParticleAffected(const Particle& particle) const;
 
+	// Sorts the cells of the neighbor search into cells inside, outside and at the boundary of the volume. Particles in inside and outside cells
+	// are decided by their cell, only particles in boundary cells are transformed into the volume. Only rasterises again if the volume moved
+	void Rasterize(double cellSize);
+
 	UFUNCTION(BlueprintCallable)
 	void SetEnabled(bool enabled);
 
 	UFUNCTION(BlueprintPure)
 	bool GetEnabled() const;
 
+	bool GetAffectsParticles() const;
+
 protected:
 	
 	TEnumAsByte<EVolumeType> VolumeType;
 
+	// true if the volume implements ApplyToParticle instead of ApplyBeforeIntegration
+	bool AffectsParticles = false;
+
 	UStaticMeshComponent * MeshComponent;
 
 	UStaticMesh * CuboidMesh;
@@ -75,4 +95,26 @@ protected:
 
 	UPROPERTY(BlueprintReadWrite, EditAnywhere)
 	bool IsEnabled = true;
+
+	// Precise test if a position in the local space of a volume of the given form is inside, in unreal units
+	static bool IsInsideShape(EVolumeForm form, const FVector& localPosition);
+
+	// Conservative test if a box in the local space of a volume of the given form touches the volume
+	static bool OverlapsShape(EVolumeForm form, const FVector& localCenter, const FVector& localExtent);
+
+	ECellCoverage GetCellCoverage(const Vector3D& position) const;
+
+	// True if the cells were rasterised with the cell size for the current form and transform of the volume
+	bool IsRasterized(double cellSize) const;
+
+	// Coverage of the cells in the bounds of the volume, x fastest. Empty if the volume is not rasterised
+	std::vector<ECellCoverage> CellCoverage;
+	static const int64 MaxRasterizedCells = 1 << 24;
+	int CellMin[3] = { 0, 0, 0 };
+	int CellCounts[3] = { 0, 0, 0 };
+	double CellSize = 0.0;
+
+	// State of the volume the cells were rasterised for
+	FTransform RasterizedTransform;
+	EVolumeForm RasterizedForm = EVolumeForm::Cuboid;
 };
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 AShearWaveVelocity::AShearWaveVelocity() {
 	VolumeType = EVolumeType::ShearWaveVelocity;
+	AffectsParticles = true;
 	MaxVelocity = 10.0f;
 
 	PositiveArrowComponent = CreateDefaultSubobject<UArrowComponent>(TEXT("PosArrow"));
@@ -21,29 +22,19 @@ AShearWaveVelocity::~AShearWaveVelocity()
 {
 }
 
-void AShearWaveVelocity::ApplyBeforeIntegration(UParticleContext & particleContext, double timestep, double simulationTime)
+void AShearWaveVelocity::ApplyToParticle(Particle & particle, double timestep, double simulationTime)
 {
-	if (IsEnabled) {
-		for (UFluid * fluid : particleContext.GetFluids()) {
-			ParallelFor(fluid->Particles->size(), [&](int32 i) {
-				Particle& particle = fluid->Particles->at(i);
-
-				if (IsParticleAffected(particle)) {
-					particle.IsScripted = true;
-
-					// Project particle on the up vector to determine magnitude
-					double projected = Vector3D::ProjectScalar(static_cast<Vector3D>(GetActorUpVector()), particle.Position - static_cast<Vector3D>(GetActorLocation()) * 0.1);
-
-					double velocityMagnitude = sin(projected * 0.1 * PI) * MaxVelocity;
-					particle.Acceleration = Vector3D(0.0);
-					particle.Velocity = GetActorForwardVector() * velocityMagnitude;
-					if (Integrate) {
-						particle.Position += timestep * particle.Velocity;
-					} 		
-				}
-			});
-		}
-	}
+	particle.IsScripted = true;
+
+	// Project particle on the up vector to determine magnitude
+	double projected = Vector3D::ProjectScalar(static_cast<Vector3D>(GetActorUpVector()), particle.Position - static_cast<Vector3D>(GetActorLocation()) * 0.1);
+
+	double velocityMagnitude = sin(projected * 0.1 * PI) * MaxVelocity;
+	particle.Acceleration = Vector3D(0.0);
+	particle.Velocity = GetActorForwardVector() * velocityMagnitude;
+	if (Integrate) {
+		particle.Position += timestep * particle.Velocity;
+	} 		
 }
 
 double AShearWaveVelocity::MaxTimeStep(double timestepFactor, const UParticleContext & particleContext) const
@@ -13,7 +13,7 @@ public:
 
 	~AShearWaveVelocity() override;
 
-	void ApplyBeforeIntegration(UParticleContext & particleContext, double timestep, double simulationTime) override;
+	void ApplyToParticle(Particle& particle, double timestep, double simulationTime) override;
 
 	double MaxTimeStep(double timestepFactor, const UParticleContext & particleContext) const override;
 